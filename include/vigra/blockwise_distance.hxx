@@ -0,0 +1,321 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_BLOCKWISE_DISTANCE_HXX
+#define VIGRA_BLOCKWISE_DISTANCE_HXX
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "multi_distance.hxx"
+#include "multi_blocking.hxx"
+#include "multi_blockwise.hxx"
+#include "multi_array_chunked.hxx"
+#include "threadpool.hxx"
+#include "metaprogramming.hxx"
+
+namespace vigra
+{
+
+namespace blockwise_distance_detail
+{
+
+    // Apply the 1-dimensional parabola transform to all lines of 'buffer'
+    // along dimension d, using the caller's scratch memory.
+template <unsigned int N, class T>
+void
+distParabolaAlongAxis(MultiArrayView<N, T> buffer, unsigned int d, double sigma,
+                      ArrayVector<T> & line,
+                      std::vector<detail::DistParabolaStackEntry<T> > & stack)
+{
+    typedef typename MultiArrayView<N, T>::traverser Traverser;
+    typedef MultiArrayNavigator<Traverser, N> Navigator;
+
+    line.resize(buffer.shape(d));
+    for(Navigator nav(buffer.traverser_begin(), buffer.shape(), d); nav.hasMore(); nav++)
+    {
+        std::copy(nav.begin(), nav.end(), line.begin());
+        detail::distParabola(line.begin(), line.end(),
+                             typename AccessorTraits<T>::default_const_accessor(),
+                             nav.begin(), typename AccessorTraits<T>::default_accessor(),
+                             sigma, stack);
+    }
+}
+
+template <unsigned int N, class T1, class T2, class Array>
+void
+chunkedDistSquared(ChunkedArray<N, T1> const & source, ChunkedArray<N, T2> & dest,
+                   bool background, Array const & pixelPitch,
+                   BlockwiseOptions const & options, bool takeRoot)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename NumericTraits<T2>::RealPromote Real;
+    typedef MultiBlocking<N> Blocking;
+
+    Shape shape(source.shape());
+
+    vigra_precondition(shape == dest.shape(),
+        "separableMultiDistSquaredBlockwise(): shape mismatch between input and output.");
+    vigra_precondition(pixelPitch.size() == N,
+        "separableMultiDistSquaredBlockwise(): pixelPitch has wrong length.");
+
+    double dmax = 0.0;
+    bool pixelPitchIsReal = false;
+    for(unsigned int k=0; k<N; ++k)
+    {
+        if(int(pixelPitch[k]) != pixelPitch[k])
+            pixelPitchIsReal = true;
+        dmax += sq(pixelPitch[k]*shape[k]);
+    }
+    // intermediate results are stored in 'dest', so there is no way around
+    // overflow as in separableMultiDistSquared()
+    vigra_precondition(!NumericTraits<T2>::isIntegral::value ||
+                       (!pixelPitchIsReal && dmax <= NumericTraits<T2>::max()),
+        "separableMultiDistSquaredBlockwise(): destination value type cannot hold the squared distances.");
+
+    // lines along each dimension are processed in slabs ("pencils") that span the
+    // entire array in this dimension and are aligned with the destination chunks
+    // in the others
+    Shape crossSection = options.getBlockShape().size() == 0
+                             ? dest.chunkShape()
+                             : options.template getBlockShapeN<N>();
+
+    T1 zero = NumericTraits<T1>::zero();
+    Real maxDist = (Real)(NumericTraits<T2>::isIntegral::value ? std::ceil(dmax) : dmax),
+         rzero   = (Real)0.0;
+
+    ThreadPool pool(options);
+    int nThreads = std::max<int>(1, pool.nThreads());
+    ArrayVector<ArrayVector<Real> > lines(nThreads);
+    ArrayVector<std::vector<detail::DistParabolaStackEntry<Real> > > stacks(nThreads);
+
+    using namespace vigra::functor;
+
+    for(unsigned int d=0; d<N; ++d)
+    {
+        Shape pencilShape(crossSection);
+        pencilShape[d] = shape[d];
+        Blocking blocking(shape, pencilShape);
+
+        parallel_foreach(pool,
+            blocking.blockBegin(), blocking.blockEnd(),
+            [&](int threadId, typename Blocking::Block pencil)
+            {
+                MultiArray<N, Real> buffer(pencil.size());
+                if(d == 0)
+                {
+                    // threshold the mask so that all objects are at infinite distance
+                    MultiArray<N, T1> mask(pencil.size());
+                    source.checkoutSubarray(pencil.begin(), mask);
+                    if(background)
+                        transformMultiArray(mask, buffer,
+                            ifThenElse(Arg1() == Param(zero), Param(maxDist), Param(rzero)));
+                    else
+                        transformMultiArray(mask, buffer,
+                            ifThenElse(Arg1() != Param(zero), Param(maxDist), Param(rzero)));
+                }
+                else
+                {
+                    dest.checkoutSubarray(pencil.begin(), buffer);
+                }
+
+                distParabolaAlongAxis(buffer, d, pixelPitch[d], lines[threadId], stacks[threadId]);
+
+                if(takeRoot && d == N-1)
+                    transformMultiArray(buffer, buffer, sqrt(Arg1()));
+                dest.commitSubarray(pencil.begin(), buffer);
+            },
+            blocking.numBlocks());
+    }
+}
+
+} // namespace blockwise_distance_detail
+
+/** \addtogroup DistanceTransform
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*         separableMultiDistSquaredBlockwise           */
+/*                                                      */
+/********************************************************/
+
+/** \brief Euclidean distance squared on chunked arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        // explicitly specify pixel pitch for each coordinate
+        template <unsigned int N, class T1, class T2, class Array>
+        void
+        separableMultiDistSquaredBlockwise(ChunkedArray<N, T1> const & source,
+                                           ChunkedArray<N, T2> & dest,
+                                           bool background,
+                                           Array const & pixelPitch,
+                                           BlockwiseOptions const & options = BlockwiseOptions());
+
+        // use default pixel pitch = 1.0 for each coordinate
+        template <unsigned int N, class T1, class T2>
+        void
+        separableMultiDistSquaredBlockwise(ChunkedArray<N, T1> const & source,
+                                           ChunkedArray<N, T2> & dest,
+                                           bool background,
+                                           BlockwiseOptions const & options = BlockwiseOptions());
+    }
+    \endcode
+
+    This function computes the same exact distance transform as \ref separableMultiDistSquared(),
+    but does not require the arrays to fit into memory. Dimensions are processed
+    one after the other. For each dimension, the array is divided into slabs
+    which cover the entire array along the current dimension and a single chunk of
+    <tt>dest</tt> along the others (or a block of shape <tt>options.getBlockShape()</tt>, if given).
+    Each slab is checked out of the chunked array, transformed, and committed back, so that
+    only <tt>options.getNumThreads()</tt> slabs reside in memory at any time, and the chunk cache
+    can stream the data to and from disk (e.g. with \ref ChunkedArrayHDF5 or \ref ChunkedArrayTmpFile).
+
+    Since intermediate results are stored in <tt>dest</tt>, its value type must be able to hold
+    the squared distances, which means that it should be <tt>float</tt> or <tt>double</tt>,
+    unless the pixel pitch is integer and <tt>N * M*M</tt> (where M is the size of the largest
+    dimension of the array) fits into the integer type. The function may work in-place,
+    i.e. <tt>source</tt> and <tt>dest</tt> may refer to the same array.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/blockwise_distance.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    Shape3 shape(2048, 2048, 2048);
+    ChunkedArrayHDF5<3, UInt8> mask(HDF5File("mask.h5", HDF5File::Open), "mask");
+    ChunkedArrayHDF5<3, float> dist(HDF5File("dist.h5", HDF5File::New), "dist", HDF5File::New, shape);
+
+    // distance of every background voxel to the nearest object, using 8 threads
+    separableMultiDistanceBlockwise(mask, dist, true, BlockwiseOptions().numThreads(8));
+    \endcode
+
+    \see separableMultiDistSquared(), separableMultiDistanceBlockwise()
+*/
+doxygen_overloaded_function(template <...> void separableMultiDistSquaredBlockwise)
+
+template <unsigned int N, class T1, class T2, class Array>
+inline typename enable_if<!IsDerivedFrom<Array, ParallelOptions>::value>::type
+separableMultiDistSquaredBlockwise(ChunkedArray<N, T1> const & source,
+                                   ChunkedArray<N, T2> & dest,
+                                   bool background,
+                                   Array const & pixelPitch,
+                                   BlockwiseOptions const & options = BlockwiseOptions())
+{
+    blockwise_distance_detail::chunkedDistSquared(source, dest, background, pixelPitch, options, false);
+}
+
+template <unsigned int N, class T1, class T2>
+inline void
+separableMultiDistSquaredBlockwise(ChunkedArray<N, T1> const & source,
+                                   ChunkedArray<N, T2> & dest,
+                                   bool background,
+                                   BlockwiseOptions const & options = BlockwiseOptions())
+{
+    TinyVector<double, N> pixelPitch(1.0);
+    blockwise_distance_detail::chunkedDistSquared(source, dest, background, pixelPitch, options, false);
+}
+
+/********************************************************/
+/*                                                      */
+/*           separableMultiDistanceBlockwise            */
+/*                                                      */
+/********************************************************/
+
+/** \brief Euclidean distance on chunked arrays.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        // explicitly specify pixel pitch for each coordinate
+        template <unsigned int N, class T1, class T2, class Array>
+        void
+        separableMultiDistanceBlockwise(ChunkedArray<N, T1> const & source,
+                                        ChunkedArray<N, T2> & dest,
+                                        bool background,
+                                        Array const & pixelPitch,
+                                        BlockwiseOptions const & options = BlockwiseOptions());
+
+        // use default pixel pitch = 1.0 for each coordinate
+        template <unsigned int N, class T1, class T2>
+        void
+        separableMultiDistanceBlockwise(ChunkedArray<N, T1> const & source,
+                                        ChunkedArray<N, T2> & dest,
+                                        bool background,
+                                        BlockwiseOptions const & options = BlockwiseOptions());
+    }
+    \endcode
+
+    Works like \ref separableMultiDistSquaredBlockwise() (see there for details), but
+    takes the square root of the result. The root is computed during the last pass,
+    so that no additional pass over the data is needed.
+*/
+doxygen_overloaded_function(template <...> void separableMultiDistanceBlockwise)
+
+template <unsigned int N, class T1, class T2, class Array>
+inline typename enable_if<!IsDerivedFrom<Array, ParallelOptions>::value>::type
+separableMultiDistanceBlockwise(ChunkedArray<N, T1> const & source,
+                                ChunkedArray<N, T2> & dest,
+                                bool background,
+                                Array const & pixelPitch,
+                                BlockwiseOptions const & options = BlockwiseOptions())
+{
+    blockwise_distance_detail::chunkedDistSquared(source, dest, background, pixelPitch, options, true);
+}
+
+template <unsigned int N, class T1, class T2>
+inline void
+separableMultiDistanceBlockwise(ChunkedArray<N, T1> const & source,
+                                ChunkedArray<N, T2> & dest,
+                                bool background,
+                                BlockwiseOptions const & options = BlockwiseOptions())
+{
+    TinyVector<double, N> pixelPitch(1.0);
+    blockwise_distance_detail::chunkedDistSquared(source, dest, background, pixelPitch, options, true);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_BLOCKWISE_DISTANCE_HXX
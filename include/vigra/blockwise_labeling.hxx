@@ -278,6 +278,121 @@ blockwiseLabeling(DataBlocksIterator data_blocks_begin, DataBlocksIterator data_
 }
 
 
+template <class Equal, class Label>
+struct ConcurrentBorderVisitor
+{
+    Label u_label_offset;
+    Label v_label_offset;
+    ConcurrentUnionFindArray<Label>* global_unions;
+    Equal* equal;
+
+    template <class Data, class Shape>
+    void operator()(const Data& u_data, Label& u_label, const Data& v_data, Label& v_label, const Shape& diff)
+    {
+        // local label zero denotes background, which is never merged
+        if(u_label != 0 && v_label != 0 &&
+           labeling_equality::callEqual(*equal, u_data, v_data, diff))
+        {
+            global_unions->makeUnion(u_label + u_label_offset, v_label + v_label_offset);
+        }
+    }
+};
+
+    // Label all blocks in parallel, merge the labels across block borders in parallel
+    // by means of a lock-free union-find structure, and finally replace local with
+    // consecutive global labels in a single parallel pass.
+template <class DataBlocksIterator, class LabelBlocksIterator, class Equal>
+typename BlockwiseLabelingResult<LabelBlocksIterator>::type
+blockwiseLabelingParallel(DataBlocksIterator data_blocks_begin, DataBlocksIterator data_blocks_end,
+                          LabelBlocksIterator label_blocks_begin, LabelBlocksIterator label_blocks_end,
+                          BlockwiseLabelOptions const & options,
+                          Equal equal)
+{
+    typedef typename LabelBlocksIterator::value_type::value_type Label;
+    typedef typename DataBlocksIterator::shape_type Shape;
+    typedef typename LabelBlocksIterator::value_type LabelBlock;
+
+    Shape blocks_shape = data_blocks_begin.shape();
+    vigra_precondition(blocks_shape == label_blocks_begin.shape(),
+                       "shapes of blocks of blocks do not match");
+    vigra_precondition(std::distance(data_blocks_begin,data_blocks_end) == std::distance(label_blocks_begin,label_blocks_end),
+                       "the sizes of input ranges are different");
+
+    static const unsigned int Dimensions = DataBlocksIterator::dimension + 1;
+    std::ptrdiff_t block_count = std::distance(data_blocks_begin, data_blocks_end);
+
+    ThreadPool pool(options);
+
+    // label each block independently
+    std::vector<Label> block_labels(block_count);
+    parallel_foreach(pool, block_count,
+        [&](const int /*threadId*/, const uint64_t i){
+            block_labels[i] = labelMultiArray(data_blocks_begin[i], label_blocks_begin[i],
+                                              options, equal);
+        }
+    );
+
+    // global index of local label l in block i is label_offsets[i] + l,
+    // index zero is reserved for the background
+    MultiArray<Dimensions, Label> label_offsets(blocks_shape);
+    Label current_offset = 0;
+    for(std::ptrdiff_t i=0; i<block_count; ++i)
+    {
+        label_offsets[i] = current_offset;
+        vigra_precondition(current_offset <= NumericTraits<Label>::max() - block_labels[i],
+            "labelMultiArrayBlockwise(): Need more labels than can be represented in the destination type.");
+        current_offset += block_labels[i];
+    }
+
+    // merge labels along the block borders
+    ConcurrentUnionFindArray<Label> global_unions((std::size_t)current_offset + 1);
+
+    typedef GridGraph<Dimensions, undirected_tag> Graph;
+    typedef typename Graph::edge_iterator EdgeIterator;
+    Graph blocks_graph(blocks_shape, options.getNeighborhood());
+    std::vector<std::pair<Shape, Shape> > block_pairs;
+    for(EdgeIterator it = blocks_graph.get_edge_iterator(); it != blocks_graph.get_edge_end_iterator(); ++it)
+        block_pairs.push_back(std::make_pair(blocks_graph.u(*it), blocks_graph.v(*it)));
+
+    parallel_foreach(pool, block_pairs.size(),
+        [&](const int /*threadId*/, const uint64_t k){
+            Shape u = block_pairs[k].first;
+            Shape v = block_pairs[k].second;
+
+            ConcurrentBorderVisitor<Equal, Label> border_visitor;
+            border_visitor.u_label_offset = label_offsets[u];
+            border_visitor.v_label_offset = label_offsets[v];
+            border_visitor.global_unions = &global_unions;
+            border_visitor.equal = &equal;
+            visitBorder(data_blocks_begin[u], label_blocks_begin[u],
+                        data_blocks_begin[v], label_blocks_begin[v],
+                        v - u, options.getNeighborhood(), border_visitor);
+        }
+    );
+
+    // index zero becomes label zero, so the remaining regions are numbered from one
+    std::vector<Label> mapping(global_unions.size());
+    Label last_label = global_unions.makeContiguous(mapping) - 1;
+
+    parallel_foreach(pool, block_count,
+        [&](const int /*threadId*/, const uint64_t i){
+            // keep the iterator alive while writing, so that the block
+            // (e.g. a chunk of a ChunkedArray) cannot be evicted meanwhile
+            LabelBlocksIterator block_it(label_blocks_begin);
+            block_it += i;
+            Label offset = label_offsets[i];
+            for(typename LabelBlock::iterator labels_it = block_it->begin();
+                labels_it != block_it->end();
+                ++labels_it)
+            {
+                if(*labels_it != 0)
+                    *labels_it = mapping[*labels_it + offset];
+            }
+        }
+    );
+    return last_label;
+}
+
 template <class LabelBlocksIterator, class MappingIterator>
 void toGlobalLabels(LabelBlocksIterator label_blocks_begin, LabelBlocksIterator label_blocks_end,
                     MappingIterator mapping_begin, MappingIterator mapping_end)
@@ -355,6 +470,10 @@ void toGlobalLabels(LabelBlocksIterator label_blocks_begin, LabelBlocksIterator
     \endcode
 
     The resulting labeling is equivalent to a labeling by \ref labelMultiArray, that is, the connected components are the same but may have different ids.
+    When no \a mapping is requested, all stages run in parallel: the blocks are labeled independently,
+    labels touching across block borders are merged concurrently by a lock-free union-find structure
+    (\ref ConcurrentUnionFindArray), and a final parallel pass replaces the local labels with consecutive
+    global labels.
     \ref NeighborhoodType and background value (if any) can be specified with the LabelOptions object.
     If the \a mapping parameter is provided, each chunk is labeled seperately and contiguously (starting at one, zero for background),
     with \a mapping containing a mapping of local labels to global labels for each chunk.
@@ -433,14 +552,9 @@ Label labelMultiArrayBlockwise(const MultiArrayView<N, Data, S1>& data,
 
     MultiArray<N, MultiArrayView<N, Data, S1> > data_blocks = blockify(data, block_shape);
     MultiArray<N, MultiArrayView<N, Label, S2> > label_blocks = blockify(labels, block_shape);
-    MultiArray<N, std::vector<Label> > mapping(data_blocks.shape());
-    Label last_label = blockwiseLabeling(data_blocks.begin(), data_blocks.end(),
-                                         label_blocks.begin(), label_blocks.end(),
-                                         options, equal, mapping);
-
-    // replace local labels by global labels
-    toGlobalLabels(label_blocks.begin(), label_blocks.end(), mapping.begin(), mapping.end());
-    return last_label;
+    return blockwiseLabelingParallel(data_blocks.begin(), data_blocks.end(),
+                                     label_blocks.begin(), label_blocks.end(),
+                                     options, equal);
 }
 
 template <unsigned int N, class Data, class S1,
@@ -486,11 +600,24 @@ Label labelMultiArrayBlockwise(const ChunkedArray<N, Data>& data,
                                Equal equal)
 {
     using namespace blockwise_labeling_detail;
-    MultiArray<N, std::vector<Label> > mapping(data.chunkArrayShape());
-    Label result = labelMultiArrayBlockwise(data, labels, options, equal, mapping);
+
+    vigra_precondition(options.getBlockShape().size() == 0,
+        "labelMultiArrayBlockwise(ChunkedArray, ...): custom block shapes not supported "
+        "(always uses the array's chunk shape).");
+    vigra_precondition(data.shape() == labels.shape() && data.chunkShape() == labels.chunkShape(),
+        "labelMultiArrayBlockwise(ChunkedArray, ...): shapes and chunk shapes of data and labels must agree.");
+
     typedef typename ChunkedArray<N, Data>::shape_type Shape;
-    toGlobalLabels(labels.chunk_begin(Shape(0), data.shape()), labels.chunk_end(Shape(0), data.shape()), mapping.begin(), mapping.end());
-    return result;
+
+    typedef typename ChunkedArray<N, Data>::chunk_const_iterator DataChunkIterator;
+    typedef typename ChunkedArray<N, Label>::chunk_iterator LabelChunkIterator;
+
+    DataChunkIterator data_chunks_begin = data.chunk_begin(Shape(0), data.shape());
+    LabelChunkIterator label_chunks_begin = labels.chunk_begin(Shape(0), labels.shape());
+
+    return blockwiseLabelingParallel(data_chunks_begin, data_chunks_begin.getEndIterator(),
+                                     label_chunks_begin, label_chunks_begin.getEndIterator(),
+                                     options, equal);
 }
 
 template <unsigned int N, class Data, class Label>
@@ -43,8 +43,12 @@
 #include "blockwise_labeling.hxx"
 #include "metaprogramming.hxx"
 #include "overlapped_blocks.hxx"
+#include "watersheds.hxx"
+#include "priority_queue.hxx"
 
 #include <limits>
+#include <utility>
+#include <vector>
 
 namespace vigra
 {
@@ -131,6 +135,285 @@ struct UnionFindWatershedsEquality
     {};
 };
 
+    // Blocks are processed in 2^N phases such that blocks processed concurrently
+    // are never adjacent (not even diagonally). A block only writes its inner region
+    // and reads a halo of width one, so concurrent blocks never touch the same voxel.
+template <unsigned int N>
+inline unsigned int
+blockColor(TinyVector<MultiArrayIndex, N> const & blockCoord)
+{
+    unsigned int color = 0;
+    for(unsigned int k=0; k<N; ++k)
+        color |= (unsigned int)(blockCoord[k] & 1) << k;
+    return color;
+}
+
+    // State shared by the two relaxation phases of seededWatershedsBlockwise().
+template <unsigned int N, class T, class S1, class Label, class S2>
+struct SeededWatershedsBlockwise
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef GridGraph<N, undirected_tag>      Graph;
+    typedef typename Graph::OutArcIt          neighbor_iterator;
+    typedef std::pair<T, MultiArrayIndex>     Key;
+
+    MultiArrayView<N, T, S1> data;
+    MultiArrayView<N, Label, S2> labels;
+    MultiArray<N, T> cost;         // minimax path cost from the nearest seed
+    MultiArray<N, MultiArrayIndex> distance; // steps since the path reached 'cost'
+    MultiArray<N, UInt8> reached;  // whether 'cost' and 'distance' are valid
+    MultiArray<N, UInt8> isSeed;
+    WatershedOptions const & options;
+    BlockwiseLabelOptions const & blockwise_options;
+    Shape blockShape, blocksPerAxis;
+
+    SeededWatershedsBlockwise(MultiArrayView<N, T, S1> const & d,
+                              MultiArrayView<N, Label, S2> const & l,
+                              WatershedOptions const & o,
+                              BlockwiseLabelOptions const & bo)
+    : data(d),
+      labels(l),
+      cost(d.shape()),
+      distance(d.shape()),
+      reached(d.shape()),
+      isSeed(d.shape()),
+      options(o),
+      blockwise_options(bo),
+      blockShape(bo.getBlockShapeN<N>()),
+      blocksPerAxis()
+    {
+        for(unsigned int k=0; k<N; ++k)
+            blocksPerAxis[k] = (data.shape(k) + blockShape[k] - 1) / blockShape[k];
+    }
+
+        // a voxel reached at cost 'c' may be used to flood its neighbors
+    bool expandable(T c) const
+    {
+        return !(options.terminate & StopAtThreshold) || c <= options.max_cost;
+    }
+
+        // Key of a voxel with data value 'v' when flooded from a neighbor with key 'k'.
+        // Keys are compared lexicographically: on a plateau of equal cost, the voxel
+        // belongs to the region that entered the plateau at the smallest distance,
+        // like in the breadth-first order of the serial flooding.
+    static Key floodedKey(T v, Key const & k)
+    {
+        return v > k.first
+                   ? Key(v, 0)
+                   : Key(k.first, k.second + 1);
+    }
+
+        // Flood a single block, using the current costs in the halo as boundary condition.
+        // Returns true if a voxel at the block border changed.
+    bool floodBlock(Shape const & begin, Shape const & end,
+                    Shape const & windowBegin, Shape const & windowEnd)
+    {
+        MultiArrayView<N, T, S1> d = data.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, T> c = cost.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, MultiArrayIndex> dist = distance.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, UInt8> r = reached.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, UInt8> seeds = isSeed.subarray(windowBegin, windowEnd);
+        Shape innerBegin = begin - windowBegin,
+              innerEnd   = end - windowBegin;
+
+        Graph g(d.shape(), blockwise_options.getNeighborhood());
+        PriorityQueue<Shape, Key, true> pqueue;
+
+        MultiCoordinateIterator<N> i(d.shape()), iend = i.getEndIterator();
+        for(; i != iend; ++i)
+            if(r[*i] && expandable(c[*i]))
+                pqueue.push(*i, Key(c[*i], dist[*i]));
+
+        bool borderChanged = false;
+        while(!pqueue.empty())
+        {
+            Shape node = pqueue.top();
+            Key priority = pqueue.topPriority();
+            pqueue.pop();
+
+            if(priority != Key(c[node], dist[node])) // outdated entry
+                continue;
+
+            for(neighbor_iterator arc(g, node); arc != lemon::INVALID; ++arc)
+            {
+                Shape target = g.target(*arc);
+                if(seeds[target] || !allLessEqual(innerBegin, target) || !allLess(target, innerEnd))
+                    continue;
+                Key candidate = floodedKey(d[target], priority);
+                if(r[target] && !(candidate < Key(c[target], dist[target])))
+                    continue;
+                c[target] = candidate.first;
+                dist[target] = candidate.second;
+                r[target] = 1;
+                if(expandable(candidate.first))
+                    pqueue.push(target, candidate);
+                borderChanged = borderChanged || isBorder(target, innerBegin, innerEnd);
+            }
+        }
+        return borderChanged;
+    }
+
+        // Assign the smallest label among the neighbors with minimal (cost, distance),
+        // iterating until the labels in this block are stable.
+        // Returns true if a voxel at the block border changed.
+    bool labelBlock(Shape const & begin, Shape const & end,
+                    Shape const & windowBegin, Shape const & windowEnd)
+    {
+        MultiArrayView<N, T> c = cost.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, MultiArrayIndex> dist = distance.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, Label, S2> l = labels.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, UInt8> r = reached.subarray(windowBegin, windowEnd);
+        MultiArrayView<N, UInt8> seeds = isSeed.subarray(windowBegin, windowEnd);
+        Shape innerBegin = begin - windowBegin,
+              innerEnd   = end - windowBegin;
+
+        Graph g(c.shape(), blockwise_options.getNeighborhood());
+        MultiArray<N, UInt8> queued(c.shape());
+        std::vector<Shape> worklist;
+
+        MultiCoordinateIterator<N> i(innerEnd - innerBegin), iend = i.getEndIterator();
+        for(; i != iend; ++i)
+        {
+            Shape node = *i + innerBegin;
+            if(r[node] && !seeds[node])
+            {
+                worklist.push_back(node);
+                queued[node] = 1;
+            }
+        }
+
+        bool borderChanged = false;
+        while(!worklist.empty())
+        {
+            Shape node = worklist.back();
+            worklist.pop_back();
+            queued[node] = 0;
+
+            // find the neighbors from which the serial algorithm may have flooded 'node'
+            // (since floodedKey() is monotone, these are the neighbors with minimal key)
+            bool found = false;
+            Key minKey;
+            Label newLabel = 0;
+            for(neighbor_iterator arc(g, node); arc != lemon::INVALID; ++arc)
+            {
+                Shape source = g.target(*arc);
+                if(!r[source] || !expandable(c[source]))
+                    continue;
+                Key key(c[source], dist[source]);
+                if(!found || key < minKey)
+                {
+                    found = true;
+                    minKey = key;
+                    newLabel = l[source];
+                }
+                else if(key == minKey && l[source] != 0 &&
+                        (newLabel == 0 || l[source] < newLabel))
+                {
+                    newLabel = l[source];
+                }
+            }
+            if(newLabel == 0 || (l[node] != 0 && !(newLabel < l[node])))
+                continue;
+
+            l[node] = newLabel;
+            borderChanged = borderChanged || isBorder(node, innerBegin, innerEnd);
+            for(neighbor_iterator arc(g, node); arc != lemon::INVALID; ++arc)
+            {
+                Shape target = g.target(*arc);
+                if(r[target] && !seeds[target] && !queued[target] &&
+                   allLessEqual(innerBegin, target) && allLess(target, innerEnd))
+                {
+                    worklist.push_back(target);
+                    queued[target] = 1;
+                }
+            }
+        }
+        return borderChanged;
+    }
+
+    static bool isBorder(Shape const & p, Shape const & begin, Shape const & end)
+    {
+        for(unsigned int k=0; k<N; ++k)
+            if(p[k] == begin[k] || p[k] == end[k]-1)
+                return true;
+        return false;
+    }
+
+        // Repeat sweeps over all blocks whose halo changed until nothing changes.
+        // 'phase' is 0 for flooding and 1 for labeling.
+    void relax(ThreadPool & pool, int phase)
+    {
+        static const unsigned int colors = 1u << N;
+        MultiArray<N, UInt8> dirty(blocksPerAxis), borderChanged(blocksPerAxis);
+        dirty.init(1);
+        bool anyDirty = true;
+
+        while(anyDirty)
+        {
+            borderChanged.init(0);
+            for(unsigned int color = 0; color < colors; ++color)
+            {
+                std::vector<Shape> todo;
+                MultiCoordinateIterator<N> i(blocksPerAxis), iend = i.getEndIterator();
+                for(; i != iend; ++i)
+                    if(dirty[*i] && blockColor<N>(*i) == color)
+                        todo.push_back(*i);
+
+                parallel_foreach(pool, todo.size(),
+                    [&](int /*threadId*/, std::size_t k)
+                    {
+                        Shape begin = todo[k]*blockShape,
+                              end   = min(begin + blockShape, data.shape()),
+                              windowBegin = max(begin - Shape(1), Shape(0)),
+                              windowEnd   = min(end + Shape(1), data.shape());
+                        bool changed = phase == 0
+                                           ? floodBlock(begin, end, windowBegin, windowEnd)
+                                           : labelBlock(begin, end, windowBegin, windowEnd);
+                        borderChanged[todo[k]] = changed ? 1 : 0;
+                    });
+            }
+
+            // blocks must be revisited when any adjacent block changed its border
+            anyDirty = false;
+            dirty.init(0);
+            MultiCoordinateIterator<N> i(blocksPerAxis), iend = i.getEndIterator();
+            for(; i != iend; ++i)
+            {
+                if(!borderChanged[*i])
+                    continue;
+                Shape nbegin = max(*i - Shape(1), Shape(0)),
+                      nend   = min(*i + Shape(2), blocksPerAxis);
+                dirty.subarray(nbegin, nend).init(1);
+                anyDirty = true;
+            }
+        }
+    }
+
+    Label run()
+    {
+        Label maxRegionLabel = 0;
+        for(MultiArrayIndex k=0; k<data.size(); ++k)
+        {
+            Shape p;
+            detail::ScanOrderToCoordinate<N>::exec(k, data.shape(), p);
+            if(labels[p] != 0)
+            {
+                isSeed[p] = 1;
+                reached[p] = 1;
+                cost[p] = data[p];
+                distance[p] = 0;
+                if(maxRegionLabel < labels[p])
+                    maxRegionLabel = labels[p];
+            }
+        }
+
+        ThreadPool pool(blockwise_options);
+        relax(pool, 0);
+        relax(pool, 1);
+        return maxRegionLabel;
+    }
+};
+
 } // namespace blockwise_watersheds_detail
 
 /*************************************************************/
@@ -257,6 +540,102 @@ unionFindWatershedsBlockwise(const ChunkedArray<N, Data>& data,
     return unionFindWatershedsBlockwise(data, labels, options, directions);
 }
 
+/*************************************************************/
+/*                                                           */
+/*                  seededWatershedsBlockwise                */
+/*                                                           */
+/*************************************************************/
+
+/** \weakgroup ParallelProcessing
+    \sa seededWatershedsBlockwise <B>(...)</B>
+*/
+
+/** \brief Parallel seeded region-growing watersheds for MultiArrays.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T, class S1,
+                                  class Label, class S2>
+        Label
+        seededWatershedsBlockwise(MultiArrayView<N, T, S1> const & data,
+                                  MultiArrayView<N, Label, S2> labels,
+                                  WatershedOptions const & options = WatershedOptions(),
+                                  BlockwiseLabelOptions const & blockwise_options = BlockwiseLabelOptions());
+    }
+    \endcode
+
+    Computes the same segmentation as \ref watershedsMultiArray() with
+    <tt>WatershedOptions().regionGrowing()</tt>, but distributes the work over
+    blocks of shape <tt>blockwise_options.getBlockShape()</tt> which are flooded in parallel
+    by <tt>blockwise_options.getNumThreads()</tt> threads. On input, \a labels must contain
+    the seeds (e.g. from \ref generateWatershedSeeds() or \ref labelMultiArrayBlockwise()),
+    all other voxels must be zero. The neighborhood is taken from
+    <tt>blockwise_options.getNeighborhood()</tt>.
+
+    The algorithm works in two phases, each of which repeatedly sweeps over the blocks
+    whose one-voxel halo changed until a fixpoint is reached. The first phase floods every block
+    with a local priority queue, using the costs in the halo as boundary condition, and computes
+    for each voxel the cost at which the serial flooding reaches it (i.e. the minimal
+    highest data value along any path from a seed), and the number of steps since such a
+    path reached this cost. These costs are unique, so the set of labeled voxels is always
+    identical to the serial result. The second phase assigns each voxel the label of the
+    neighbor with minimal (cost, steps) through which it was flooded.
+
+    <b>Tie-breaking:</b> Plateaus of equal cost are divided by the distance from where
+    the regions entered them, like the breadth-first order in which the serial algorithm
+    floods them with a FIFO queue. When several neighbors with different labels still
+    yield the same cost and distance, the serial algorithm chooses according to the
+    internal order of its priority queue, whereas this function deterministically
+    chooses the smallest label that can reach the voxel along such neighbors.
+    The result does not depend on the block shape or number of threads.
+
+    The options <tt>WatershedOptions::stopAtThreshold()</tt> and <tt>completeGrow()</tt>
+    are supported, while <tt>keepContours()</tt>, biased labels and seed computation are not.
+
+    Return: the largest seed label.
+
+    <b> Usage: </b>
+
+    <b>\#include </b> \<vigra/blockwise_watersheds.hxx\><br>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, float> boundaryIndicator(shape);
+    MultiArray<3, UInt32> labels(shape);
+    ... // compute boundaryIndicator and seeds
+
+    seededWatershedsBlockwise(boundaryIndicator, labels, WatershedOptions(),
+                              BlockwiseLabelOptions().blockShape(Shape3(64)).numThreads(8));
+    \endcode
+    */
+doxygen_overloaded_function(template <...> unsigned int seededWatershedsBlockwise)
+
+template <unsigned int N, class T, class S1,
+                          class Label, class S2>
+Label
+seededWatershedsBlockwise(MultiArrayView<N, T, S1> const & data,
+                          MultiArrayView<N, Label, S2> labels,
+                          WatershedOptions const & options = WatershedOptions(),
+                          BlockwiseLabelOptions const & blockwise_options = BlockwiseLabelOptions())
+{
+    vigra_precondition(data.shape() == labels.shape(),
+        "seededWatershedsBlockwise(): shape mismatch between input and output.");
+    vigra_precondition(options.method == WatershedOptions::RegionGrowing,
+        "seededWatershedsBlockwise(): only the region growing method is supported.");
+    vigra_precondition((options.terminate & KeepContours) == 0,
+        "seededWatershedsBlockwise(): keepContours() is not supported.");
+    vigra_precondition(options.biased_label == 0,
+        "seededWatershedsBlockwise(): biased labels are not supported.");
+    vigra_precondition(options.seed_options.mini == SeedOptions::Unspecified,
+        "seededWatershedsBlockwise(): seeds must be provided in 'labels'.");
+
+    blockwise_watersheds_detail::SeededWatershedsBlockwise<N, T, S1, Label, S2>
+        watersheds(data, labels, options, blockwise_options);
+    return watersheds.run();
+}
+
 //@}
 
 } // namespace vigra
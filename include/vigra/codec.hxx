@@ -47,6 +47,8 @@
 #ifndef VIGRA_CODEC_HXX
 #define VIGRA_CODEC_HXX
 
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
@@ -203,6 +205,67 @@ namespace vigra
         virtual const void * currentScanlineOfBand( unsigned int ) const = 0;
         virtual void nextScanline() = 0;
 
+        // Virtual functions added after the original interface are declared below,
+        // in the order of their introduction, to keep the vtable layout of existing
+        // codecs and clients intact.
+
+        // Restrict decoding to the rectangle [upperLeft, upperLeft+size) of the image.
+        // Must be called before the first nextScanline(). On success, the decoder only
+        // delivers the rectangle's size.y scanlines, and currentScanlineOfBand() points to
+        // the pixel in column upperLeft.x (getWidth() and getHeight() still refer to the
+        // full image). Codecs that cannot do this return false and deliver the full image.
+        virtual bool setRegionOfInterest( const vigra::Diff2D & /*upperLeft*/, const vigra::Size2D & /*size*/ )
+        {
+            return false;
+        }
+
+        // Decode the next 'count' scanlines directly into 'buffer', replacing 'count' calls
+        // of nextScanline() and currentScanlineOfBand(). Sample 'b' of pixel 'x' in row 'y'
+        // (counted from the first pixel a scanline delivers) is stored at byte offset
+        // y*rowStride + x*pixelStride + b*bandStride, with the type given by getPixelType().
+        // All getNumBands() bands are written, so both interleaved and planar buffers can be
+        // filled. The default implementation copies from the scanline buffers; codecs
+        // override it to decode into the buffer without intermediate copies.
+        virtual void readScanlines( void * buffer, unsigned int width, unsigned int count,
+                                    std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                    std::ptrdiff_t rowStride )
+        {
+            const std::string pixeltype = getPixelType();
+            const std::size_t samplesize =
+                pixeltype == "DOUBLE"
+                    ? 8
+                    : (pixeltype == "FLOAT" || pixeltype == "UINT32" || pixeltype == "INT32")
+                        ? 4
+                        : (pixeltype == "UINT16" || pixeltype == "INT16")
+                            ? 2
+                            : 1;
+            const unsigned int bands = getNumBands();
+            const std::ptrdiff_t offset = getOffset() * samplesize;
+
+            for (unsigned int y = 0; y < count; ++y)
+            {
+                nextScanline();
+                char * row = static_cast<char *>(buffer) + y * rowStride;
+                const char * first = static_cast<const char *>(currentScanlineOfBand(0));
+
+                // interleaved bands in both the scanline and the buffer: copy the whole row
+                if (pixelStride == offset && bandStride == (std::ptrdiff_t)samplesize &&
+                    (bands == 1 || currentScanlineOfBand(bands - 1) == first + (bands - 1) * samplesize))
+                {
+                    std::memcpy(row, first, width * offset);
+                    continue;
+                }
+
+                for (unsigned int b = 0; b < bands; ++b)
+                {
+                    const char * src = static_cast<const char *>(currentScanlineOfBand(b));
+                    char * dest = row + b * bandStride;
+                    for (unsigned int x = 0; x < width; ++x, src += offset, dest += pixelStride)
+                        std::memcpy(dest, src, samplesize);
+                }
+            }
+        }
+
         typedef ArrayVector<unsigned char> ICCProfile;
 
         const ICCProfile & getICCProfile() const
@@ -260,6 +323,54 @@ namespace vigra
         virtual void nextScanline() = 0;
 
         struct TIFFCompressionException {};
+
+        // Virtual functions added after the original interface are declared below,
+        // in the order of their introduction, to keep the vtable layout of existing
+        // codecs and clients intact.
+
+        // Allow the codec to compress with up to 'n' threads where the format permits
+        // (called before finalizeSettings(), values <= 1 mean sequential encoding).
+        virtual void setNumThreads( int /* n */ )
+        {
+        }
+
+        // Encode the next 'count' scanlines from 'buffer', replacing 'count' calls of
+        // currentScanlineOfBand() and nextScanline(). Sample 'b' of pixel 'x' in row 'y'
+        // is read from byte offset y*rowStride + x*pixelStride + b*bandStride. 'bands'
+        // and 'sampleSize' must match setNumBands() and setPixelType(). The default
+        // implementation copies into the scanline buffers; codecs override it to avoid
+        // the copy or to encode several rows at once.
+        virtual void writeScanlines( const void * buffer, unsigned int width, unsigned int count,
+                                     unsigned int bands, unsigned int sampleSize,
+                                     std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                     std::ptrdiff_t rowStride )
+        {
+            const std::ptrdiff_t offset = getOffset() * sampleSize;
+
+            for (unsigned int y = 0; y < count; ++y)
+            {
+                const char * row = static_cast<const char *>(buffer) + y * rowStride;
+                char * first = static_cast<char *>(currentScanlineOfBand(0));
+
+                // interleaved bands in both the scanline and the buffer: copy the whole row
+                if (pixelStride == offset && bandStride == (std::ptrdiff_t)sampleSize &&
+                    (bands == 1 || currentScanlineOfBand(bands - 1) == first + (bands - 1) * sampleSize))
+                {
+                    std::memcpy(first, row, width * offset);
+                }
+                else
+                {
+                    for (unsigned int b = 0; b < bands; ++b)
+                    {
+                        const char * src = row + b * bandStride;
+                        char * dest = static_cast<char *>(currentScanlineOfBand(b));
+                        for (unsigned int x = 0; x < width; ++x, src += pixelStride, dest += offset)
+                            std::memcpy(dest, src, sampleSize);
+                    }
+                }
+                nextScanline();
+            }
+        }
     };
 
     // codec factory for registration at the codec manager
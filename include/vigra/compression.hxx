@@ -67,6 +67,12 @@ VIGRA_EXPORT void compress(char const * source, std::size_t size, std::vector<ch
 VIGRA_EXPORT void uncompress(char const * source, std::size_t srcSize, 
                              char * dest, std::size_t destSize, CompressionMethod method);
 
+/** Check if VIGRA was compiled with support for the given compression method.
+
+    (The zlib methods are only available when VIGRA was built with ZLIB.)
+*/
+VIGRA_EXPORT bool compressionAvailable(CompressionMethod method);
+
 
 } // namespace vigra
 
@@ -0,0 +1,607 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_CSR_GRAPH_HXX
+#define VIGRA_CSR_GRAPH_HXX
+
+/*std*/
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+/*vigra*/
+#include "graphs.hxx"
+#include "graph_maps.hxx"
+#include "iteratorfacade.hxx"
+#include "graph_item_impl.hxx"
+#include "adjacency_list_graph.hxx"
+
+
+namespace vigra{
+
+/** \addtogroup GraphDataStructures
+*/
+//@{
+
+    namespace detail_csr_graph{
+
+        // iterates over the adjacency row of a single node
+        template<class GRAPH,class FILTER>
+        class IncItemIt
+        : public ForwardIteratorFacade<
+            IncItemIt<GRAPH,FILTER>,
+            typename FILTER::ResultType,true
+        >
+        {
+        public:
+            typedef GRAPH Graph;
+            typedef typename Graph::index_type index_type;
+            typedef typename Graph::Node Node;
+            typedef typename Graph::NodeIt NodeIt;
+            typedef typename FILTER::ResultType ResultItem;
+            typedef typename FILTER::AdjacencyElement AdjacencyElement;
+
+            IncItemIt(const lemon::Invalid & /*invalid*/ = lemon::INVALID)
+            :   graph_(NULL),
+                ownNodeId_(-1),
+                current_(NULL),
+                end_(NULL),
+                resultItem_(lemon::INVALID){
+            }
+
+            IncItemIt(const Graph & g, const Node & node)
+            :   graph_(&g),
+                ownNodeId_(g.id(node)),
+                current_(g.adjacencyBegin(g.id(node))),
+                end_(g.adjacencyEnd(g.id(node))),
+                resultItem_(lemon::INVALID){
+                skipInvalid();
+            }
+
+            IncItemIt(const Graph & g, const NodeIt & nodeIt)
+            :   graph_(&g),
+                ownNodeId_(g.id(*nodeIt)),
+                current_(g.adjacencyBegin(g.id(*nodeIt))),
+                end_(g.adjacencyEnd(g.id(*nodeIt))),
+                resultItem_(lemon::INVALID){
+                skipInvalid();
+            }
+
+        private:
+            friend class vigra::IteratorFacadeCoreAccess;
+
+            void skipInvalid(){
+                if(FILTER::IsFilter){
+                    while(current_!=end_ && !FILTER::valid(*graph_,*current_,ownNodeId_))
+                        ++current_;
+                }
+            }
+
+            bool isEnd()const{
+                return current_==end_;
+            }
+
+            bool equal(const IncItemIt & other)const{
+                if(isEnd() && other.isEnd())
+                    return true;
+                return current_==other.current_;
+            }
+
+            void increment(){
+                ++current_;
+                skipInvalid();
+            }
+
+            const ResultItem & dereference()const{
+                resultItem_ = FILTER::transform(*graph_,*current_,ownNodeId_);
+                return resultItem_;
+            }
+
+            const GRAPH * graph_;
+            index_type ownNodeId_;
+            const AdjacencyElement * current_;
+            const AdjacencyElement * end_;
+            mutable ResultItem resultItem_;
+        };
+
+    } // namespace detail_csr_graph
+
+
+    /** \brief immutable undirected graph in compressed sparse row layout (LEMON API)
+
+        <b>\#include</b> \<vigra/csr_graph.hxx\><br>
+        Namespace: vigra
+
+        CsrGraph is a read-only copy of another graph (typically an
+        \ref vigra::AdjacencyListGraph or a \ref vigra::GridGraph). The neighbors of all
+        nodes are stored in one contiguous array, sorted by node id and indexed by an
+        offset array, and the end nodes of all edges in a second array. This avoids the
+        per-node allocations of AdjacencyListGraph and makes traversal cache friendly,
+        while providing the same LEMON API, iterators and property maps, so that
+        algorithms like \ref ShortestPathDijkstra, edgeWeightedWatershedsSegmentation(),
+        felzenszwalbSegmentation() and hierarchicalClustering() run unchanged.
+
+        Node, edge and arc ids are copied from the source graph, so a property map
+        of the source graph can be transferred by id. Arc ids follow the convention of
+        AdjacencyListGraph (<tt>edgeId</tt> for the forward arc and
+        <tt>edgeId + maxEdgeId() + 1</tt> for the backward arc).
+
+        <b>Usage:</b>
+
+        \code
+        AdjacencyListGraph rag;
+        AdjacencyListGraph::EdgeMap<std::vector<GridGraph<3>::Edge> > affiliatedEdges;
+        makeRegionAdjacencyGraph(gridGraph, labels, rag, affiliatedEdges);
+
+        CsrGraph staticRag(rag);   // ids and edge maps of 'rag' stay valid
+        \endcode
+    */
+    class CsrGraph
+    {
+    public:
+        typedef Int64                                                     index_type;
+    private:
+        typedef CsrGraph                                                  GraphType;
+
+        // adjacency rows store (neighbor id, edge id) pairs like AdjacencyListGraph,
+        // so that the iterator filters of graph_item_impl.hxx can be shared
+        struct NodeStorage{
+            typedef detail::Adjacency<index_type> AdjacencyElement;
+        };
+        typedef NodeStorage::AdjacencyElement                             AdjacencyElement;
+
+        typedef detail::NeighborNodeFilter<GraphType>                     NnFilter;
+        typedef detail::IncEdgeFilter<GraphType>                          IncFilter;
+        typedef detail::IsInFilter<GraphType>                             InFlter;
+        typedef detail::IsOutFilter<GraphType>                            OutFilter;
+        typedef detail::IsBackOutFilter<GraphType>                        BackOutFilter;
+    public:
+        /// node descriptor
+        typedef detail::GenericNode<index_type>                           Node;
+        /// edge descriptor
+        typedef detail::GenericEdge<index_type>                           Edge;
+        /// arc descriptor
+        typedef detail::GenericArc<index_type>                            Arc;
+        /// edge iterator
+        typedef detail_adjacency_list_graph::ItemIter<GraphType,Edge>     EdgeIt;
+        /// node iterator
+        typedef detail_adjacency_list_graph::ItemIter<GraphType,Node>     NodeIt;
+        /// arc iterator
+        typedef detail_adjacency_list_graph::ArcIt<GraphType>             ArcIt;
+
+        /// incident edge iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,IncFilter>          IncEdgeIt;
+        /// incoming arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,InFlter>            InArcIt;
+        /// outgoing arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,OutFilter>          OutArcIt;
+        /// neighbor node iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,NnFilter>           NeighborNodeIt;
+        /// outgoing back arc iterator
+        typedef detail_csr_graph::IncItemIt<GraphType,BackOutFilter>      OutBackArcIt;
+
+        // BOOST GRAPH API TYPEDEFS
+        typedef directed_tag            directed_category;
+        typedef NeighborNodeIt          adjacency_iterator;
+        typedef EdgeIt                  edge_iterator;
+        typedef NodeIt                  vertex_iterator;
+        typedef IncEdgeIt               in_edge_iterator;
+        typedef IncEdgeIt               out_edge_iterator;
+        typedef size_t                  degree_size_type;
+        typedef size_t                  edge_size_type;
+        typedef size_t                  vertex_size_type;
+        typedef Edge                    edge_descriptor;
+        typedef Node                    vertex_descriptor;
+
+        /// default edge map
+        template<class T>
+        struct EdgeMap : DenseEdgeReferenceMap<GraphType,T> {
+            EdgeMap(): DenseEdgeReferenceMap<GraphType,T>(){
+            }
+            EdgeMap(const GraphType & g)
+            : DenseEdgeReferenceMap<GraphType,T>(g){
+            }
+            EdgeMap(const GraphType & g,const T & val)
+            : DenseEdgeReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+        /// default node map
+        template<class T>
+        struct NodeMap : DenseNodeReferenceMap<GraphType,T> {
+            NodeMap(): DenseNodeReferenceMap<GraphType,T>(){
+            }
+            NodeMap(const GraphType & g)
+            : DenseNodeReferenceMap<GraphType,T>(g){
+            }
+            NodeMap(const GraphType & g,const T & val)
+            : DenseNodeReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+        /// default arc map
+        template<class T>
+        struct ArcMap : DenseArcReferenceMap<GraphType,T> {
+            ArcMap(): DenseArcReferenceMap<GraphType,T>(){
+            }
+            ArcMap(const GraphType & g)
+            : DenseArcReferenceMap<GraphType,T>(g){
+            }
+            ArcMap(const GraphType & g,const T & val)
+            : DenseArcReferenceMap<GraphType,T>(g,val){
+            }
+        };
+
+        /** \brief Construct an empty graph.
+        */
+        CsrGraph()
+        :   offsets_(1, 0),
+            nodeNum_(0),
+            edgeNum_(0)
+        {}
+
+        /** \brief Copy the structure of \a g in a single sweep over its edges.
+
+            \a g may be any undirected graph with the LEMON API (e.g.
+            AdjacencyListGraph or GridGraph). Ids are preserved.
+        */
+        template<class GRAPH>
+        explicit CsrGraph(const GRAPH & g);
+
+        /** \brief Get the number of edges in this graph (API: LEMON).
+        */
+        index_type edgeNum()const{
+            return edgeNum_;
+        }
+        /** \brief Get the number of nodes in this graph (API: LEMON).
+        */
+        index_type nodeNum()const{
+            return nodeNum_;
+        }
+        /** \brief Get the number of arcs in this graph (API: LEMON).
+        */
+        index_type arcNum()const{
+            return 2*edgeNum_;
+        }
+
+        /** \brief Get the maximum ID of any edge in this graph (API: LEMON).
+        */
+        index_type maxEdgeId()const{
+            return static_cast<index_type>(edgeNodes_.size()/2) - 1;
+        }
+        /** \brief Get the maximum ID of any node in this graph (API: LEMON).
+        */
+        index_type maxNodeId()const{
+            return static_cast<index_type>(offsets_.size()) - 2;
+        }
+        /** \brief Get the maximum ID of any arc in this graph (API: LEMON).
+        */
+        index_type maxArcId()const{
+            return 2*maxEdgeId()+1;
+        }
+
+        /** \brief Create an arc for the given edge \a e, oriented along the
+            edge's natural (<tt>forward = true</tt>) or reversed
+            (<tt>forward = false</tt>) direction (API: LEMON).
+        */
+        Arc direct(const Edge & edge,const bool forward)const{
+            if(edge==lemon::INVALID)
+                return Arc(lemon::INVALID);
+            return forward ? Arc(edge.id(),edge.id())
+                           : Arc(edge.id()+maxEdgeId()+1,edge.id());
+        }
+
+        /** \brief Create an arc for the given edge \a e oriented
+            so that node \a n is the starting node of the arc (API: LEMON), or
+            return <tt>lemon::INVALID</tt> if the edge is not incident to this node.
+        */
+        Arc direct(const Edge & edge,const Node & node)const{
+            if(u(edge)==node)
+                return Arc(edge.id(),edge.id());
+            else if(v(edge)==node)
+                return Arc(edge.id()+maxEdgeId()+1,edge.id());
+            else
+                return Arc(lemon::INVALID);
+        }
+
+        /** \brief Return <tt>true</tt> when the arc is looking on the underlying
+            edge in its natural (i.e. forward) direction, <tt>false</tt> otherwise (API: LEMON).
+        */
+        bool direction(const Arc & arc)const{
+            return arc.id()<=maxEdgeId();
+        }
+
+        /** \brief Get the start node of the given edge \a e (API: LEMON).
+        */
+        Node u(const Edge & edge)const{
+            return Node(edgeNodes_[2*edge.id()]);
+        }
+        /** \brief Get the end node of the given edge \a e (API: LEMON).
+        */
+        Node v(const Edge & edge)const{
+            return Node(edgeNodes_[2*edge.id()+1]);
+        }
+        /** \brief Get the start node of the given arc \a a (API: LEMON).
+        */
+        Node source(const Arc & arc)const{
+            return Node(edgeNodes_[2*arc.edgeId() + (direction(arc) ? 0 : 1)]);
+        }
+        /** \brief Get the end node of the given arc \a a (API: LEMON).
+        */
+        Node target(const Arc & arc)const{
+            return Node(edgeNodes_[2*arc.edgeId() + (direction(arc) ? 1 : 0)]);
+        }
+        /** \brief Return the opposite node of the given node \a n
+            along edge \a e (API: LEMON), or return <tt>lemon::INVALID</tt>
+            if the edge is not incident to this node.
+        */
+        Node oppositeNode(Node const & n, const Edge & e)const{
+            const Node uNode = u(e);
+            const Node vNode = v(e);
+            if(uNode==n)
+                return vNode;
+            else if(vNode==n)
+                return uNode;
+            else
+                return Node(lemon::INVALID);
+        }
+
+        /** \brief Return the start node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node baseNode(const IncEdgeIt & iter)const{
+            return u(*iter);
+        }
+        /** \brief Return the start node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node baseNode(const OutArcIt & iter)const{
+            return source(*iter);
+        }
+        /** \brief Return the end node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node runningNode(const IncEdgeIt & iter)const{
+            return v(*iter);
+        }
+        /** \brief Return the end node of the edge the given iterator is referring to (API: LEMON).
+        */
+        Node runningNode(const OutArcIt & iter)const{
+            return target(*iter);
+        }
+
+        /** \brief Get the ID for node desciptor \a v (API: LEMON).
+        */
+        index_type id(const Node & node)const{
+            return node.id();
+        }
+        /** \brief Get the ID for edge desciptor \a v (API: LEMON).
+        */
+        index_type id(const Edge & edge)const{
+            return edge.id();
+        }
+        /** \brief Get the ID for arc desciptor \a v (API: LEMON).
+        */
+        index_type id(const Arc & arc)const{
+            return arc.id();
+        }
+
+        /** \brief Get edge descriptor for given edge ID \a i (API: LEMON).
+            Return <tt>Edge(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Edge edgeFromId(const index_type id)const{
+            if(id>=0 && id<=maxEdgeId() && edgeNodes_[2*id]!=-1)
+                return Edge(id);
+            else
+                return Edge(lemon::INVALID);
+        }
+        /** \brief Get node descriptor for given node ID \a i (API: LEMON).
+            Return <tt>Node(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Node nodeFromId(const index_type id)const{
+            if(id>=0 && id<=maxNodeId() && nodeExists_[id])
+                return Node(id);
+            else
+                return Node(lemon::INVALID);
+        }
+        /** \brief Get arc descriptor for given arc ID \a i (API: LEMON).
+            Return <tt>Arc(lemon::INVALID)</tt> when the ID does not exist in this graph.
+        */
+        Arc arcFromId(const index_type id)const{
+            const index_type edgeId = id<=maxEdgeId() ? id : id-(maxEdgeId()+1);
+            if(edgeFromId(edgeId)==lemon::INVALID)
+                return Arc(lemon::INVALID);
+            return Arc(id,edgeId);
+        }
+
+        /** \brief Get a descriptor for the edge connecting vertices \a u and \a v,<br/>or <tt>lemon::INVALID</tt> if no such edge exists (API: LEMON).
+        */
+        Edge findEdge(const Node & a,const Node & b)const{
+            if(a==lemon::INVALID || b==lemon::INVALID || a==b)
+                return Edge(lemon::INVALID);
+            const AdjacencyElement * end = adjacencyEnd(a.id());
+            const AdjacencyElement * found =
+                std::lower_bound(adjacencyBegin(a.id()), end, AdjacencyElement(b.id(),0));
+            if(found!=end && found->nodeId()==b.id())
+                return Edge(found->edgeId());
+            return Edge(lemon::INVALID);
+        }
+        /** \brief Get a descriptor for the arc connecting vertices \a u and \a v,<br/>or <tt>lemon::INVALID</tt> if no such edge exists (API: LEMON).
+        */
+        Arc findArc(const Node & uNode,const Node & vNode)const{
+            const Edge e = findEdge(uNode,vNode);
+            if(e==lemon::INVALID)
+                return Arc(lemon::INVALID);
+            return direct(e,u(e)==uNode);
+        }
+
+        /** \brief Get the number of edges incident to \a node.
+        */
+        degree_size_type degree(const Node & node)const{
+            return offsets_[node.id()+1]-offsets_[node.id()];
+        }
+
+        /** \brief Get the maximum degree over all nodes.
+        */
+        size_t maxDegree()const{
+            size_t md=0;
+            for(index_type n=0; n<=maxNodeId(); ++n)
+                md = std::max(md, size_t(offsets_[n+1]-offsets_[n]));
+            return md;
+        }
+
+        static const bool is_directed = false;
+
+    private:
+        template<class G>
+        friend struct detail::NeighborNodeFilter;
+        template<class G>
+        friend struct detail::IncEdgeFilter;
+        template<class G>
+        friend struct detail::IsOutFilter;
+        template<class G>
+        friend struct detail::IsBackOutFilter;
+        template<class G>
+        friend struct detail::IsInFilter;
+        template<class G,class F>
+        friend class detail_csr_graph::IncItemIt;
+
+        const AdjacencyElement * adjacencyBegin(const index_type nodeId)const{
+            return adjacency_.data()+offsets_[nodeId];
+        }
+        const AdjacencyElement * adjacencyEnd(const index_type nodeId)const{
+            return adjacency_.data()+offsets_[nodeId+1];
+        }
+
+        // adjacency row of node n is adjacency_[offsets_[n] ... offsets_[n+1])
+        std::vector<index_type>       offsets_;
+        std::vector<AdjacencyElement> adjacency_;
+        // (u, v) per edge id, -1 for unused ids
+        std::vector<index_type>       edgeNodes_;
+        std::vector<UInt8>            nodeExists_;
+
+        index_type nodeNum_;
+        index_type edgeNum_;
+    };
+
+#ifndef DOXYGEN  // doxygen doesn't like out-of-line definitions
+
+    template<class GRAPH>
+    CsrGraph::CsrGraph(const GRAPH & g)
+    :   offsets_(1, 0),
+        nodeNum_(g.nodeNum()),
+        edgeNum_(g.edgeNum())
+    {
+        typedef typename GRAPH::NodeIt NodeItIn;
+        typedef typename GRAPH::EdgeIt EdgeItIn;
+
+        const index_type maxNode = nodeNum_==0 ? -1 : static_cast<index_type>(g.maxNodeId());
+        const index_type maxEdge = edgeNum_==0 ? -1 : static_cast<index_type>(g.maxEdgeId());
+
+        offsets_.resize(maxNode+2, 0);
+        nodeExists_.resize(maxNode+1, 0);
+        edgeNodes_.resize(2*(maxEdge+1), -1);
+
+        for(NodeItIn n(g); n!=lemon::INVALID; ++n)
+            nodeExists_[g.id(*n)] = 1;
+
+        // the only sweep over the source graph: record end nodes and count degrees
+        for(EdgeItIn e(g); e!=lemon::INVALID; ++e){
+            const index_type eid = g.id(*e);
+            const index_type uid = g.id(g.u(*e));
+            const index_type vid = g.id(g.v(*e));
+            edgeNodes_[2*eid]   = uid;
+            edgeNodes_[2*eid+1] = vid;
+            ++offsets_[uid+1];
+            ++offsets_[vid+1];
+        }
+        std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+        adjacency_.resize(offsets_.back(), AdjacencyElement(-1,-1));
+        std::vector<index_type> fill(offsets_.begin(), offsets_.end()-1);
+        for(index_type eid=0; eid<=maxEdge; ++eid){
+            const index_type uid = edgeNodes_[2*eid];
+            if(uid==-1)
+                continue;
+            const index_type vid = edgeNodes_[2*eid+1];
+            adjacency_[fill[uid]++] = AdjacencyElement(vid,eid);
+            adjacency_[fill[vid]++] = AdjacencyElement(uid,eid);
+        }
+        for(index_type n=0; n<=maxNode; ++n)
+            std::sort(adjacency_.begin()+offsets_[n], adjacency_.begin()+offsets_[n+1]);
+    }
+
+#endif //DOXYGEN
+
+//@}
+
+} // namespace vigra
+
+
+// boost free functions specialized for the CSR graph
+namespace boost{
+
+    inline vigra::CsrGraph::vertex_size_type
+    num_vertices(const vigra::CsrGraph & g){
+        return g.nodeNum();
+    }
+    inline vigra::CsrGraph::edge_size_type
+    num_edges(const vigra::CsrGraph & g){
+        return g.edgeNum();
+    }
+
+    inline vigra::CsrGraph::degree_size_type
+    degree(const vigra::CsrGraph::vertex_descriptor & v , const vigra::CsrGraph & g){
+        return g.degree(v);
+    }
+    inline vigra::CsrGraph::degree_size_type
+    in_degree(const vigra::CsrGraph::vertex_descriptor & v , const vigra::CsrGraph & g){
+        return g.degree(v);
+    }
+    inline vigra::CsrGraph::degree_size_type
+    out_degree(const vigra::CsrGraph::vertex_descriptor & v , const vigra::CsrGraph & g){
+        return g.degree(v);
+    }
+
+    inline vigra::CsrGraph::vertex_descriptor
+    source(const vigra::CsrGraph::edge_descriptor & e , const vigra::CsrGraph & g){
+        return g.u(e);
+    }
+    inline vigra::CsrGraph::vertex_descriptor
+    target(const vigra::CsrGraph::edge_descriptor & e , const vigra::CsrGraph & g){
+        return g.v(e);
+    }
+
+}  // namespace boost
+
+#endif /*VIGRA_CSR_GRAPH_HXX*/
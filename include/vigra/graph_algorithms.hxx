@@ -55,6 +55,7 @@
 #include "union_find.hxx"
 #include "adjacency_list_graph.hxx"
 #include "graph_maps.hxx"
+#include "threadpool.hxx"
 
 #include "timing.hxx"
 //#include "openmp_helper.hxx"
@@ -88,6 +89,60 @@ namespace vigra{
             const GRAPH_MAP & map_;
             const COMPERATOR & comperator_;
         };
+
+        // order edges by weight and break ties by edge id, so that the order
+        // (and everything derived from it) does not depend on the sort algorithm
+        template <class GRAPH,class WEIGHTS>
+        struct EdgeWeightIdLess
+        {
+            EdgeWeightIdLess(const GRAPH & graph,const WEIGHTS & weights)
+            : graph_(graph),
+              weights_(weights){
+            }
+
+            bool operator()(const typename GRAPH::Edge & a, const typename GRAPH::Edge & b) const{
+                return weights_[a] < weights_[b] ||
+                       (weights_[a] == weights_[b] && graph_.id(a) < graph_.id(b));
+            }
+
+            const GRAPH & graph_;
+            const WEIGHTS & weights_;
+        };
+
+        // one boundary edge of the input graph, keyed by its (ordered) label pair
+        template <class LABEL>
+        struct RagEdgeCandidate
+        {
+            LABEL u, v;
+            Int64 edgeId;
+
+            bool operator<(RagEdgeCandidate const & o) const
+            {
+                return u < o.u || (u == o.u && (v < o.v || (v == o.v && edgeId < o.edgeId)));
+            }
+
+            bool sameLabels(RagEdgeCandidate const & o) const
+            {
+                return u == o.u && v == o.v;
+            }
+        };
+
+        // an edge of the input graph for the parallel Felzenszwalb segmentation:
+        // sorted by block (internal edges of block b first, seam edges last), then by weight
+        template <class WEIGHT>
+        struct FelzenszwalbEdge
+        {
+            Int64  block;
+            WEIGHT weight;
+            Int64  u, v, edgeId;
+
+            bool operator<(FelzenszwalbEdge const & o) const
+            {
+                return block < o.block ||
+                       (block == o.block && (weight < o.weight ||
+                                             (weight == o.weight && edgeId < o.edgeId)));
+            }
+        };
     } // namespace detail_graph_algorithms
 
     /// \brief get a vector of Edge descriptors
@@ -213,6 +268,153 @@ namespace vigra{
         }
     }
 
+    /// \brief make a region adjacency graph from a graph and labels w.r.t. that graph in parallel
+    ///
+    /// Same result as the serial version above (up to the order of the edges in \a rag
+    /// and of the affiliated edges), but the input graph is scanned in parallel:
+    /// every thread collects the (u, v) label pairs of the boundary edges in its
+    /// range of edge ids, the pairs are deduplicated with a parallel sort, and
+    /// \a rag is then built in one sweep over the sorted pairs. Since the pairs arrive
+    /// ordered by node id, all adjacency insertions are appends. RAG edge ids are
+    /// assigned in lexicographic order of their (smaller, larger) label pair, and the
+    /// affiliated edges of each RAG edge are sorted by their id in \a graphIn.
+    ///
+    /// \a graphIn must provide <tt>maxNodeId()</tt>, <tt>nodeFromId()</tt>, <tt>maxEdgeId()</tt>
+    /// and <tt>edgeFromId()</tt> (e.g. GridGraph or AdjacencyListGraph), and concurrent
+    /// read access to \a labels must be safe.
+    ///
+    /// \param graphIn  : input graph
+    /// \param labels   : labels w.r.t. graphIn
+    /// \param[out] rag  : region adjacency graph
+    /// \param[out] affiliatedEdges : a vector of edges of graphIn for each edge in rag
+    /// \param options  : number of threads (ParallelOptions)
+    /// \param      ignoreLabel : optional label to ignore (default: -1 means no label will be ignored)
+    ///
+    template<
+        class GRAPH_IN,
+        class GRAPH_IN_NODE_LABEL_MAP
+    >
+    void makeRegionAdjacencyGraph(
+        GRAPH_IN const &           graphIn,
+        GRAPH_IN_NODE_LABEL_MAP    labels,
+        AdjacencyListGraph & rag,
+        typename AdjacencyListGraph:: template EdgeMap< std::vector<typename GRAPH_IN::Edge> > & affiliatedEdges,
+        ParallelOptions const & options,
+        const Int64   ignoreLabel=-1
+    ){
+        typedef typename GraphMapTypeTraits<GRAPH_IN_NODE_LABEL_MAP>::Value LabelType;
+        typedef typename GRAPH_IN::Node  NodeGraphIn;
+        typedef typename GRAPH_IN::Edge  EdgeGraphIn;
+        typedef typename AdjacencyListGraph::Edge EdgeGraphOut;
+        typedef detail_graph_algorithms::RagEdgeCandidate<LabelType> Candidate;
+
+        ThreadPool pool(options);
+        const std::ptrdiff_t sliceSize = 1 << 16;
+
+        auto ignored = [ignoreLabel](LabelType l)
+        {
+            return ignoreLabel != -1 && static_cast<Int64>(l) == ignoreLabel;
+        };
+
+        // collect node labels and boundary edges slice by slice
+        const Int64 nodeIdEnd = graphIn.maxNodeId() + 1;
+        const std::ptrdiff_t nodeSlices = (nodeIdEnd + sliceSize - 1) / sliceSize;
+        std::vector<std::vector<LabelType> > sliceLabels(nodeSlices);
+        parallel_foreach(pool, nodeSlices,
+            [&](size_t, std::ptrdiff_t k)
+            {
+                std::vector<LabelType> & found = sliceLabels[k];
+                const Int64 end = std::min<Int64>(nodeIdEnd, (k+1)*sliceSize);
+                for(Int64 id = k*sliceSize; id < end; ++id)
+                {
+                    const NodeGraphIn node(graphIn.nodeFromId(id));
+                    if(node == lemon::INVALID)
+                        continue;
+                    const LabelType l = labels[node];
+                    // neighbouring nodes mostly share a label
+                    if(!ignored(l) && (found.empty() || found.back() != l))
+                        found.push_back(l);
+                }
+                std::sort(found.begin(), found.end());
+                found.erase(std::unique(found.begin(), found.end()), found.end());
+            });
+
+        const Int64 edgeIdEnd = graphIn.maxEdgeId() + 1;
+        const std::ptrdiff_t edgeSlices = (edgeIdEnd + sliceSize - 1) / sliceSize;
+        std::vector<std::vector<Candidate> > sliceEdges(edgeSlices);
+        parallel_foreach(pool, edgeSlices,
+            [&](size_t, std::ptrdiff_t k)
+            {
+                std::vector<Candidate> & found = sliceEdges[k];
+                const Int64 end = std::min<Int64>(edgeIdEnd, (k+1)*sliceSize);
+                for(Int64 id = k*sliceSize; id < end; ++id)
+                {
+                    const EdgeGraphIn edge(graphIn.edgeFromId(id));
+                    if(edge == lemon::INVALID)
+                        continue;
+                    const LabelType lu = labels[graphIn.u(edge)];
+                    const LabelType lv = labels[graphIn.v(edge)];
+                    if(lu == lv || ignored(lu) || ignored(lv))
+                        continue;
+                    Candidate c;
+                    c.u = std::min(lu, lv);
+                    c.v = std::max(lu, lv);
+                    c.edgeId = id;
+                    found.push_back(c);
+                }
+            });
+
+        // concatenate and deduplicate
+        std::vector<LabelType> nodeLabels;
+        for(std::size_t k=0; k<sliceLabels.size(); ++k)
+        {
+            nodeLabels.insert(nodeLabels.end(), sliceLabels[k].begin(), sliceLabels[k].end());
+            std::vector<LabelType>().swap(sliceLabels[k]);
+        }
+        parallel_sort(pool, nodeLabels.begin(), nodeLabels.end());
+        nodeLabels.erase(std::unique(nodeLabels.begin(), nodeLabels.end()), nodeLabels.end());
+
+        std::size_t candidateCount = 0;
+        for(std::size_t k=0; k<sliceEdges.size(); ++k)
+            candidateCount += sliceEdges[k].size();
+        std::vector<Candidate> candidates;
+        candidates.reserve(candidateCount);
+        for(std::size_t k=0; k<sliceEdges.size(); ++k)
+        {
+            candidates.insert(candidates.end(), sliceEdges[k].begin(), sliceEdges[k].end());
+            std::vector<Candidate>().swap(sliceEdges[k]);
+        }
+        parallel_sort(pool, candidates.begin(), candidates.end());
+
+        // bulk-build the RAG: runs of equal label pairs become one RAG edge
+        std::vector<std::size_t> runStart;
+        for(std::size_t i=0; i<candidates.size(); ++i)
+            if(i == 0 || !candidates[i].sameLabels(candidates[i-1]))
+                runStart.push_back(i);
+        runStart.push_back(candidates.size());
+
+        rag = AdjacencyListGraph(0, runStart.size()-1);
+        if(!nodeLabels.empty())
+            rag.reserveMaxNodeId(static_cast<AdjacencyListGraph::index_type>(nodeLabels.back()));
+        for(std::size_t k=0; k<nodeLabels.size(); ++k)
+            rag.addNode(nodeLabels[k]);
+        for(std::size_t r=0; r+1<runStart.size(); ++r)
+        {
+            const Candidate & c = candidates[runStart[r]];
+            rag.addEdge(rag.nodeFromId(c.u), rag.nodeFromId(c.v));
+        }
+
+        affiliatedEdges.assign(rag);
+        parallel_foreach(pool, runStart.size()-1,
+            [&](size_t, std::ptrdiff_t r)
+            {
+                std::vector<EdgeGraphIn> & aff = affiliatedEdges[EdgeGraphOut(r)];
+                aff.reserve(runStart[r+1] - runStart[r]);
+                for(std::size_t i=runStart[r]; i<runStart[r+1]; ++i)
+                    aff.push_back(graphIn.edgeFromId(candidates[i].edgeId));
+            });
+    }
+
     template<unsigned int DIM, class DTAG, class AFF_EDGES>
     size_t affiliatedEdgesSerializationSize(
         const GridGraph<DIM,DTAG> &,
@@ -586,6 +788,342 @@ namespace vigra{
         Node target_;
     };
 
+    /// \brief shortest path engine for many queries on the same graph
+    ///
+    /// In contrast to ShortestPathDijkstra, all per-node state (distances,
+    /// predecessors, visited flags) lives in plain arrays indexed by node id that
+    /// are allocated once and never cleared: every query increments an epoch
+    /// counter, and an entry is only valid if its stamp equals the current epoch.
+    /// The cost of a query is therefore proportional to the number of nodes it
+    /// visits, not to the size of the graph. The priority queue is a binary heap
+    /// with lazy deletion whose storage is also reused between queries.
+    ///
+    /// Three kinds of queries are supported:
+    /// <ul>
+    /// <li> <tt>run()</tt>: single source, optionally stopping at a target or a maximum distance,
+    /// <li> <tt>runBidirectional()</tt>: point-to-point search from both ends, which usually
+    ///      visits far fewer nodes (the graph must be undirected, as all vigra graphs are),
+    /// <li> <tt>runMultiSource()</tt>: one search from many sources, recording for each
+    ///      node the nearest source.
+    /// </ul>
+    /// After a query, <tt>distance()</tt>, <tt>predecessor()</tt>, <tt>nearestSource()</tt>
+    /// and <tt>path()</tt> describe its result.
+    ///
+    /// \code
+    /// ShortestPathQueryEngine<GridGraph<2>, float> engine(graph);
+    /// for(...)
+    /// {
+    ///     float d = engine.runBidirectional(edgeWeights, source, target);
+    ///     std::vector<GridGraph<2>::Node> nodes;
+    ///     engine.path(nodes);    // source ... target
+    /// }
+    /// \endcode
+    template<class GRAPH,class WEIGHT_TYPE>
+    class ShortestPathQueryEngine{
+    public:
+        typedef GRAPH Graph;
+        typedef typename Graph::Node Node;
+        typedef typename Graph::Edge Edge;
+        typedef typename Graph::OutArcIt OutArcIt;
+        typedef typename Graph::index_type index_type;
+        typedef WEIGHT_TYPE WeightType;
+
+        /// \brief constructor from graph
+        ShortestPathQueryEngine(const Graph & g)
+        :   graph_(g),
+            epoch_(0),
+            source_(lemon::INVALID),
+            target_(lemon::INVALID),
+            meetNode_(-1)
+        {
+            const std::size_t n = g.maxNodeId()+1;
+            for(int side=0; side<2; ++side)
+            {
+                dist_[side].resize(n);
+                pred_[side].resize(n, -1);
+                reached_[side].resize(n, 0);
+                settled_[side].resize(n, 0);
+            }
+            origin_.resize(n, -1);
+        }
+
+        /// \brief single-source query
+        ///
+        /// Visits nodes in order of increasing distance from \a source until \a target is
+        /// reached (if given) or all nodes within \a maxDistance have been visited.
+        /// Returns the distance of \a target, or <tt>NumericTraits<WeightType>::max()</tt>
+        /// if no target was given or it was not reached.
+        template<class WEIGHTS>
+        WeightType run(const WEIGHTS & weights, const Node & source,
+                       const Node & target = lemon::INVALID,
+                       WeightType maxDistance = NumericTraits<WeightType>::max())
+        {
+            startQuery(source, target);
+            visit(0, graph_.id(source), 0, -1, graph_.id(source));
+            const index_type targetId = target == lemon::INVALID ? -1 : graph_.id(target);
+            while(!heap_[0].empty())
+            {
+                const index_type node = settleNext(0, weights, maxDistance);
+                if(node < 0)
+                    break;
+                if(node == targetId)
+                {
+                    meetNode_ = node;
+                    return dist_[0][node];
+                }
+            }
+            return NumericTraits<WeightType>::max();
+        }
+
+        /// \brief point-to-point query searching from both ends
+        ///
+        /// Returns the length of the shortest path between \a source and \a target, or
+        /// <tt>NumericTraits<WeightType>::max()</tt> if there is none within \a maxDistance.
+        template<class WEIGHTS>
+        WeightType runBidirectional(const WEIGHTS & weights, const Node & source, const Node & target,
+                                    WeightType maxDistance = NumericTraits<WeightType>::max())
+        {
+            startQuery(source, target);
+            const index_type s = graph_.id(source),
+                             t = graph_.id(target);
+            visit(0, s, 0, -1, s);
+            visit(1, t, 0, -1, t);
+            best_ = s == t ? WeightType(0) : NumericTraits<WeightType>::max();
+            meetNode_ = s == t ? s : -1;
+
+            while(true)
+            {
+                const bool forwardOpen  = topDistance(0) < NumericTraits<WeightType>::max(),
+                           backwardOpen = topDistance(1) < NumericTraits<WeightType>::max();
+                if(!forwardOpen || !backwardOpen)
+                    break;
+                if(meetNode_ >= 0 && topDistance(0) + topDistance(1) >= best_)
+                    break;
+                // expand the side with the smaller frontier
+                const int side = heap_[0].size() <= heap_[1].size() ? 0 : 1;
+                if(settleNext(side, weights, maxDistance) < 0)
+                    break;
+            }
+            if(best_ > maxDistance)
+            {
+                // both halves are within maxDistance, but the whole path is not
+                meetNode_ = -1;
+                return NumericTraits<WeightType>::max();
+            }
+            return best_;
+        }
+
+        /// \brief multi-source query
+        ///
+        /// All nodes in <tt>[sourceBegin, sourceEnd)</tt> start at distance zero. Afterwards,
+        /// <tt>nearestSource(n)</tt> returns the source closest to each visited node \a n.
+        template<class WEIGHTS, class ITER>
+        void runMultiSource(const WEIGHTS & weights, ITER sourceBegin, ITER sourceEnd,
+                            WeightType maxDistance = NumericTraits<WeightType>::max())
+        {
+            startQuery(lemon::INVALID, lemon::INVALID);
+            for(; sourceBegin != sourceEnd; ++sourceBegin)
+            {
+                const index_type id = graph_.id(*sourceBegin);
+                visit(0, id, 0, -1, id);
+            }
+            while(!heap_[0].empty())
+            {
+                if(settleNext(0, weights, maxDistance) < 0)
+                    break;
+            }
+        }
+
+        /// \brief point-to-point distances for a batch of (source, target) pairs
+        ///
+        /// Runs runBidirectional() for every pair in <tt>[pairBegin, pairEnd)</tt>
+        /// (the pairs must provide <tt>first</tt> and <tt>second</tt>) and writes the
+        /// distances to \a out.
+        template<class WEIGHTS, class PAIR_ITER, class OUT_ITER>
+        void runBatch(const WEIGHTS & weights, PAIR_ITER pairBegin, PAIR_ITER pairEnd, OUT_ITER out,
+                      WeightType maxDistance = NumericTraits<WeightType>::max())
+        {
+            for(; pairBegin != pairEnd; ++pairBegin, ++out)
+                *out = runBidirectional(weights, pairBegin->first, pairBegin->second, maxDistance);
+        }
+
+        /// \brief true if \a node was settled by the forward search of the last query
+        bool reached(const Node & node)const{
+            return settled_[0][graph_.id(node)] == epoch_;
+        }
+
+        /// \brief distance of \a node in the last single- or multi-source query
+        ///        (<tt>NumericTraits<WeightType>::max()</tt> if it was not reached)
+        WeightType distance(const Node & node)const{
+            const index_type id = graph_.id(node);
+            return settled_[0][id] == epoch_ ? dist_[0][id] : NumericTraits<WeightType>::max();
+        }
+
+        /// \brief predecessor of \a node in the last single- or multi-source query
+        ///        (<tt>lemon::INVALID</tt> for sources and unreached nodes)
+        Node predecessor(const Node & node)const{
+            const index_type id = graph_.id(node);
+            if(settled_[0][id] != epoch_ || pred_[0][id] < 0)
+                return Node(lemon::INVALID);
+            return graph_.nodeFromId(pred_[0][id]);
+        }
+
+        /// \brief the source closest to \a node in the last query
+        ///        (<tt>lemon::INVALID</tt> if it was not reached)
+        Node nearestSource(const Node & node)const{
+            const index_type id = graph_.id(node);
+            return settled_[0][id] == epoch_ ? graph_.nodeFromId(origin_[id]) : Node(lemon::INVALID);
+        }
+
+        /// \brief the nodes of the shortest path from source to target found by the
+        ///        last call to <tt>run()</tt> with target or <tt>runBidirectional()</tt>
+        ///
+        /// \a nodes is empty if the target was not reached.
+        void path(std::vector<Node> & nodes)const{
+            nodes.clear();
+            if(meetNode_ < 0)
+                return;
+            for(index_type n = meetNode_; n >= 0; n = pred_[0][n])
+                nodes.push_back(graph_.nodeFromId(n));
+            std::reverse(nodes.begin(), nodes.end());
+            if(reached_[1][meetNode_] == epoch_)
+                for(index_type n = pred_[1][meetNode_]; n >= 0; n = pred_[1][n])
+                    nodes.push_back(graph_.nodeFromId(n));
+        }
+
+        /// \brief the nodes settled by the last query, in the order they were settled
+        ///
+        /// For bidirectional queries, this includes the nodes of both searches.
+        const std::vector<index_type> & discoveryOrder()const{
+            return discoveryOrder_;
+        }
+
+        /// \brief get the graph
+        const Graph & graph()const{
+            return graph_;
+        }
+
+    private:
+        struct HeapEntry
+        {
+            HeapEntry(WeightType d, index_type n)
+            : dist(d), node(n)
+            {}
+
+            bool operator>(HeapEntry const & o) const
+            {
+                return dist > o.dist || (dist == o.dist && node > o.node);
+            }
+
+            WeightType dist;
+            index_type node;
+        };
+
+        void startQuery(Node const & source, Node const & target)
+        {
+            if(++epoch_ == 0)
+            {
+                // the counter wrapped around: invalidate all stamps once
+                for(int side=0; side<2; ++side)
+                {
+                    std::fill(reached_[side].begin(), reached_[side].end(), 0);
+                    std::fill(settled_[side].begin(), settled_[side].end(), 0);
+                }
+                epoch_ = 1;
+            }
+            for(int side=0; side<2; ++side)
+                heap_[side].clear();
+            discoveryOrder_.clear();
+            source_ = source;
+            target_ = target;
+            meetNode_ = -1;
+            best_ = NumericTraits<WeightType>::max();
+        }
+
+        // label 'node' on 'side' with a tentative distance (if it improves)
+        bool visit(int side, index_type node, WeightType d, index_type pred, index_type origin)
+        {
+            if(reached_[side][node] == epoch_ && dist_[side][node] <= d)
+                return false;
+            reached_[side][node] = epoch_;
+            dist_[side][node] = d;
+            pred_[side][node] = pred;
+            if(side == 0)
+                origin_[node] = origin;
+            heap_[side].push_back(HeapEntry(d, node));
+            std::push_heap(heap_[side].begin(), heap_[side].end(), std::greater<HeapEntry>());
+            return true;
+        }
+
+        // drop outdated entries and return the smallest tentative distance of 'side'
+        WeightType topDistance(int side)
+        {
+            std::vector<HeapEntry> & heap = heap_[side];
+            while(!heap.empty())
+            {
+                const HeapEntry & top = heap.front();
+                if(settled_[side][top.node] != epoch_ && top.dist == dist_[side][top.node])
+                    return top.dist;
+                std::pop_heap(heap.begin(), heap.end(), std::greater<HeapEntry>());
+                heap.pop_back();
+            }
+            return NumericTraits<WeightType>::max();
+        }
+
+        // settle the closest node of 'side' and relax its arcs;
+        // returns its id, or -1 when the queue is exhausted or maxDistance is exceeded
+        template<class WEIGHTS>
+        index_type settleNext(int side, const WEIGHTS & weights, WeightType maxDistance)
+        {
+            const WeightType d = topDistance(side);
+            if(heap_[side].empty() || d > maxDistance)
+                return -1;
+            const index_type node = heap_[side].front().node;
+            std::pop_heap(heap_[side].begin(), heap_[side].end(), std::greater<HeapEntry>());
+            heap_[side].pop_back();
+            settled_[side][node] = epoch_;
+            discoveryOrder_.push_back(node);
+
+            const Node current(graph_.nodeFromId(node));
+            for(OutArcIt arc(graph_, current); arc != lemon::INVALID; ++arc)
+            {
+                const index_type other = graph_.id(graph_.target(*arc));
+                if(settled_[side][other] == epoch_)
+                    continue;
+                const WeightType alternative = d + weights[Edge(*arc)];
+                if(alternative > maxDistance)
+                    continue;
+                visit(side, other, alternative, node, side == 0 ? origin_[node] : -1);
+                // bidirectional: check whether the searches meet in 'other'
+                if(reached_[1-side][other] == epoch_ && target_ != lemon::INVALID)
+                {
+                    const WeightType through = dist_[0][other] + dist_[1][other];
+                    if(through < best_)
+                    {
+                        best_ = through;
+                        meetNode_ = other;
+                    }
+                }
+            }
+            return node;
+        }
+
+        const Graph & graph_;
+        UInt32 epoch_;
+        std::vector<WeightType> dist_[2];
+        std::vector<index_type> pred_[2];
+        std::vector<UInt32>     reached_[2];
+        std::vector<UInt32>     settled_[2];
+        std::vector<index_type> origin_;
+        std::vector<HeapEntry>  heap_[2];
+        std::vector<index_type> discoveryOrder_;
+
+        Node       source_;
+        Node       target_;
+        index_type meetNode_;
+        WeightType best_;
+    };
+
     /// \brief get the length in node units of a path
     template<class NODE,class PREDECESSORS>
     size_t pathLength(
@@ -912,6 +1450,8 @@ namespace vigra{
     /// \param k : free parameter of felzenszwalb algorithm
     /// \param[out] nodeLabeling :  nodeLabeling (not necessarily dense)
     /// \param nodeNumStopCond      : optional stopping condition
+    ///
+    /// Edges of equal weight are visited in order of increasing edge id.
     template< class GRAPH , class EDGE_WEIGHTS, class NODE_SIZE,class NODE_LABEL_MAP>
     void felzenszwalbSegmentation(
         const GRAPH &         graph,
@@ -940,10 +1480,13 @@ namespace vigra{
 
         // initlaize internal node diff map
 
-        // sort the edges by their weights
+        // sort the edges by their weights (ties by edge id)
         std::vector<Edge> sortedEdges;
-        std::less<WeightType> comperator;
-        edgeSort(graph,edgeWeights,comperator,sortedEdges);
+        sortedEdges.reserve(graph.edgeNum());
+        for(typename Graph::EdgeIt e(graph);e!=lemon::INVALID;++e)
+            sortedEdges.push_back(*e);
+        detail_graph_algorithms::EdgeWeightIdLess<Graph,EDGE_WEIGHTS> edgeComperator(graph,edgeWeights);
+        std::sort(sortedEdges.begin(),sortedEdges.end(),edgeComperator);
 
         // make the ufd
         UnionFindArray<UInt64> ufdArray(graph.maxNodeId()+1);
@@ -1006,6 +1549,391 @@ namespace vigra{
 
 
 
+    /// \brief parallel felzenszwalb segmentation
+    ///
+    /// Blockwise variant of the function above: the nodes are split into one block
+    /// of consecutive node ids per thread (for a GridGraph, these are slabs along the
+    /// last axis). All edges are collected in parallel and sorted with parallel_sort(),
+    /// grouped into the internal edges of each block and the seam edges between blocks.
+    /// The blocks are then segmented concurrently with the usual criterion, and the
+    /// seam edges are processed afterwards in order of increasing weight, using the
+    /// region sizes and internal differences found inside the blocks. Both versions
+    /// visit edges of equal weight in order of increasing edge id, so without threads
+    /// (or with a single thread) the result is identical to the serial version, as long
+    /// as the graph has more than \a nodeNumStopCond nodes.
+    ///
+    /// The stopping condition behaves as in the serial version: merging stops as soon
+    /// as the number of regions has dropped to \a nodeNumStopCond, and if a pass over
+    /// all edges ends with more regions, \a k is increased by 20% and the edges are
+    /// visited again. With several threads, the blocks share a counter of the regions,
+    /// so that which merges happen before the count is reached depends on scheduling.
+    ///
+    /// \a graph must provide <tt>maxEdgeId()</tt> and <tt>edgeFromId()</tt>
+    /// (e.g. GridGraph and AdjacencyListGraph).
+    ///
+    /// \param graph: input graph
+    /// \param edgeWeights : edge weights / edge indicator
+    /// \param nodeSizes : size of each node
+    /// \param k : free parameter of felzenszwalb algorithm
+    /// \param[out] nodeLabeling :  nodeLabeling (not necessarily dense)
+    /// \param options : number of threads (ParallelOptions)
+    /// \param nodeNumStopCond      : optional stopping condition
+    template< class GRAPH , class EDGE_WEIGHTS, class NODE_SIZE,class NODE_LABEL_MAP>
+    void felzenszwalbSegmentation(
+        const GRAPH &         graph,
+        const EDGE_WEIGHTS &  edgeWeights,
+        const NODE_SIZE    &  nodeSizes,
+        float           k,
+        NODE_LABEL_MAP     &  nodeLabeling,
+        ParallelOptions const & options,
+        const int             nodeNumStopCond = -1
+    ){
+        typedef GRAPH Graph;
+        typedef typename Graph::Edge Edge;
+        typedef typename Graph::NodeIt NodeIt;
+        typedef typename EDGE_WEIGHTS::Value WeightType;
+        typedef typename EDGE_WEIGHTS::Value NodeSizeType;
+        typedef detail_graph_algorithms::FelzenszwalbEdge<WeightType> FzEdge;
+
+        ThreadPool pool(options);
+        const Int64 nodeIdEnd = graph.maxNodeId()+1;
+        const Int64 blockCount = std::max<Int64>(1, std::min<Int64>(options.getActualNumThreads(), nodeIdEnd));
+        auto blockOf = [nodeIdEnd, blockCount](Int64 id)
+        {
+            return id * blockCount / nodeIdEnd;
+        };
+
+        // per-node state, indexed by node id (disjoint per block)
+        std::vector<NodeSizeType> nodeSizeAcc(nodeIdEnd);
+        std::vector<WeightType>   internalDiff(nodeIdEnd, static_cast<WeightType>(0.0));
+        for(NodeIt n(graph); n!=lemon::INVALID; ++n)
+            nodeSizeAcc[graph.id(*n)] = nodeSizes[*n];
+
+        // collect and sort the edges
+        const std::ptrdiff_t sliceSize = 1 << 16;
+        const Int64 edgeIdEnd = graph.maxEdgeId()+1;
+        const std::ptrdiff_t sliceCount = (edgeIdEnd + sliceSize - 1) / sliceSize;
+        std::vector<std::vector<FzEdge> > sliceEdges(sliceCount);
+        parallel_foreach(pool, sliceCount,
+            [&](size_t, std::ptrdiff_t s)
+            {
+                const Int64 end = std::min<Int64>(edgeIdEnd, (s+1)*sliceSize);
+                for(Int64 id = s*sliceSize; id < end; ++id)
+                {
+                    const Edge e(graph.edgeFromId(id));
+                    if(e == lemon::INVALID)
+                        continue;
+                    FzEdge fe;
+                    fe.u = graph.id(graph.u(e));
+                    fe.v = graph.id(graph.v(e));
+                    fe.weight = edgeWeights[e];
+                    fe.edgeId = id;
+                    const Int64 bu = blockOf(fe.u), bv = blockOf(fe.v);
+                    fe.block = bu == bv ? bu : blockCount;
+                    sliceEdges[s].push_back(fe);
+                }
+            });
+        std::vector<FzEdge> edges;
+        edges.reserve(graph.edgeNum());
+        for(std::size_t s=0; s<sliceEdges.size(); ++s)
+        {
+            edges.insert(edges.end(), sliceEdges[s].begin(), sliceEdges[s].end());
+            std::vector<FzEdge>().swap(sliceEdges[s]);
+        }
+        parallel_sort(pool, edges.begin(), edges.end());
+
+        std::vector<std::size_t> blockBegin(blockCount+2, edges.size());
+        for(std::size_t i=edges.size(); i-- > 0; )
+            blockBegin[edges[i].block] = i;
+        for(Int64 b=blockCount; b-- > 0; )
+            blockBegin[b] = std::min(blockBegin[b], blockBegin[b+1]);
+
+        UnionFindArray<UInt64> ufdArray(nodeIdEnd);
+        // number of regions, only needed for the stopping condition
+        threading::atomic<Int64> nodeNum(static_cast<Int64>(graph.nodeNum()));
+        auto mergeRange = [&](std::size_t begin, std::size_t end)
+        {
+            for(std::size_t i=begin; i<end; ++i)
+            {
+                const FzEdge & e = edges[i];
+                const UInt64 ru = ufdArray.findIndex(e.u);
+                const UInt64 rv = ufdArray.findIndex(e.v);
+                if(ru == rv)
+                    continue;
+                const WeightType tauRu = static_cast<WeightType>(k)/static_cast<WeightType>(nodeSizeAcc[ru]);
+                const WeightType tauRv = static_cast<WeightType>(k)/static_cast<WeightType>(nodeSizeAcc[rv]);
+                if(e.weight <= std::min(internalDiff[ru]+tauRu, internalDiff[rv]+tauRv))
+                {
+                    if(nodeNumStopCond >= 0)
+                    {
+                        // claim the merge, unless another block has already
+                        // reduced the regions to the requested number
+                        Int64 current = nodeNum.load();
+                        do
+                        {
+                            if(current <= nodeNumStopCond)
+                                return;
+                        }
+                        while(!nodeNum.compare_exchange_weak(current, current-1));
+                    }
+                    const UInt64 r = ufdArray.makeUnion(ru, rv);
+                    internalDiff[r] = e.weight;
+                    nodeSizeAcc[r] = nodeSizeAcc[ru] + nodeSizeAcc[rv];
+                }
+            }
+        };
+
+        while(true)
+        {
+            // blocks in parallel (they touch disjoint union-find entries), then the seams
+            parallel_foreach(pool, blockCount,
+                [&](size_t, std::ptrdiff_t b)
+                {
+                    mergeRange(blockBegin[b], blockBegin[b+1]);
+                });
+            mergeRange(blockBegin[blockCount], edges.size());
+
+            if(nodeNumStopCond < 0 || nodeNum.load() <= nodeNumStopCond)
+                break;
+            k *= 1.2f;
+        }
+
+        ufdArray.makeContiguous();
+        for(NodeIt n(graph); n!=lemon::INVALID; ++n)
+            nodeLabeling[*n] = ufdArray.findLabel(graph.id(*n));
+    }
+
+    /// \brief minimum spanning tree (forest) by Kruskal's algorithm, as a merge tree
+    ///
+    /// Edges are visited in order of increasing weight (see edgeSort()) and added to
+    /// the tree whenever they connect two different components. If the graph is not
+    /// connected, the result is a minimum spanning forest. Works for all vigra graphs,
+    /// including MergeGraphAdaptor (where it spans the current, contracted graph).
+    ///
+    /// The tree edges are returned in the order in which they are added, i.e. by
+    /// increasing weight. Merging their endpoints in this order reproduces single-linkage
+    /// clustering; the edge weights are the merge heights.
+    ///
+    /// \param g : input graph
+    /// \param weights : edge weights
+    /// \param[out] treeEdges : the tree edges in merge order
+    template<class GRAPH, class WEIGHTS>
+    void minimumSpanningTreeEdges(
+        const GRAPH   & g,
+        const WEIGHTS & weights,
+        std::vector<typename GRAPH::Edge> & treeEdges
+    ){
+        typedef typename GRAPH::Edge Edge;
+        typedef typename WEIGHTS::Value WeightType;
+
+        std::vector<Edge> sortedEdges;
+        edgeSort(g, weights, std::less<WeightType>(), sortedEdges);
+
+        UnionFindArray<UInt64> ufdArray(g.maxNodeId()+1);
+        treeEdges.clear();
+        for(std::size_t i=0; i<sortedEdges.size(); ++i)
+        {
+            const Edge e(sortedEdges[i]);
+            const UInt64 ru = ufdArray.findIndex(g.id(g.u(e)));
+            const UInt64 rv = ufdArray.findIndex(g.id(g.v(e)));
+            if(ru != rv)
+            {
+                ufdArray.makeUnion(ru, rv);
+                treeEdges.push_back(e);
+            }
+        }
+    }
+
+    /// \brief minimum spanning tree (forest) by Kruskal's algorithm, as an edge mask
+    ///
+    /// \param g : input graph
+    /// \param weights : edge weights
+    /// \param[out] treeEdges : edge map set to 1 for tree edges and 0 otherwise
+    /// \return the number of tree edges
+    template<class GRAPH, class WEIGHTS, class EDGE_MAP>
+    std::size_t minimumSpanningTree(
+        const GRAPH   & g,
+        const WEIGHTS & weights,
+        EDGE_MAP      & treeEdges
+    ){
+        typedef typename GRAPH::Edge Edge;
+        std::vector<Edge> edges;
+        minimumSpanningTreeEdges(g, weights, edges);
+        for(typename GRAPH::EdgeIt e(g); e!=lemon::INVALID; ++e)
+            treeEdges[*e] = 0;
+        for(std::size_t i=0; i<edges.size(); ++i)
+            treeEdges[edges[i]] = 1;
+        return edges.size();
+    }
+
+    namespace detail_graph_algorithms{
+
+        // Boruvka: atomically replace 'best' by 'edgeId' if the latter is lighter
+        // (ties are broken by edge id, which makes the minimum spanning tree unique)
+        template<class WEIGHT_AT>
+        inline void boruvkaUpdate(threading::atomic<Int64> & best, Int64 edgeId, WEIGHT_AT const & weightAt)
+        {
+            Int64 current = best.load();
+            while(current < 0 ||
+                  weightAt(edgeId) < weightAt(current) ||
+                  (!(weightAt(current) < weightAt(edgeId)) && edgeId < current))
+            {
+                if(best.compare_exchange_weak(current, edgeId))
+                    return;
+            }
+        }
+
+    } // namespace detail_graph_algorithms
+
+    /// \brief parallel minimum spanning tree (forest) by Boruvka's algorithm
+    ///
+    /// Each round, all edges are scanned in parallel to find the lightest edge leaving
+    /// every component, and all these edges are then contracted in parallel by means of
+    /// a ConcurrentUnionFindArray. The number of components at least halves per round.
+    /// Ties are broken by edge id, so the result is the unique minimum spanning forest
+    /// under this order (it coincides with the Kruskal result when all weights are distinct).
+    ///
+    /// \a g must provide <tt>maxEdgeId()</tt> and <tt>edgeFromId()</tt>
+    /// (e.g. GridGraph, AdjacencyListGraph and MergeGraphAdaptor).
+    ///
+    /// \param g : input graph
+    /// \param weights : edge weights
+    /// \param[out] treeEdges : edge map set to 1 for tree edges and 0 otherwise
+    /// \param options : number of threads (ParallelOptions)
+    /// \return the number of tree edges
+    template<class GRAPH, class WEIGHTS, class EDGE_MAP>
+    std::size_t minimumSpanningTree(
+        const GRAPH   & g,
+        const WEIGHTS & weights,
+        EDGE_MAP      & treeEdges,
+        ParallelOptions const & options
+    ){
+        typedef typename GRAPH::Edge Edge;
+
+        ThreadPool pool(options);
+        const Int64 nodeIdEnd = g.maxNodeId()+1;
+        const Int64 edgeIdEnd = g.maxEdgeId()+1;
+        const std::ptrdiff_t sliceSize = 1 << 16;
+        const std::ptrdiff_t nodeSlices = (nodeIdEnd + sliceSize - 1) / sliceSize;
+        const std::ptrdiff_t edgeSlices = (edgeIdEnd + sliceSize - 1) / sliceSize;
+
+        auto weightAt = [&](Int64 id)
+        {
+            return weights[g.edgeFromId(id)];
+        };
+
+        parallel_foreach(pool, edgeSlices,
+            [&](size_t, std::ptrdiff_t s)
+            {
+                const Int64 end = std::min<Int64>(edgeIdEnd, (s+1)*sliceSize);
+                for(Int64 id = s*sliceSize; id < end; ++id)
+                {
+                    const Edge e(g.edgeFromId(id));
+                    if(e != lemon::INVALID)
+                        treeEdges[e] = 0;
+                }
+            });
+
+        ConcurrentUnionFindArray<Int64> ufd(nodeIdEnd);
+        std::vector<Int64> component(nodeIdEnd);
+        std::vector<threading::atomic<Int64> > best(nodeIdEnd);
+        std::size_t treeEdgeCount = 0;
+
+        while(true)
+        {
+            // snapshot of the components, and reset of the candidate edges
+            parallel_foreach(pool, nodeSlices,
+                [&](size_t, std::ptrdiff_t s)
+                {
+                    const Int64 end = std::min<Int64>(nodeIdEnd, (s+1)*sliceSize);
+                    for(Int64 id = s*sliceSize; id < end; ++id)
+                    {
+                        component[id] = ufd.findIndex(id);
+                        best[id].store(-1);
+                    }
+                });
+
+            // lightest edge leaving each component
+            parallel_foreach(pool, edgeSlices,
+                [&](size_t, std::ptrdiff_t s)
+                {
+                    const Int64 end = std::min<Int64>(edgeIdEnd, (s+1)*sliceSize);
+                    for(Int64 id = s*sliceSize; id < end; ++id)
+                    {
+                        const Edge e(g.edgeFromId(id));
+                        if(e == lemon::INVALID)
+                            continue;
+                        const Int64 cu = component[g.id(g.u(e))],
+                                    cv = component[g.id(g.v(e))];
+                        if(cu == cv)
+                            continue;
+                        detail_graph_algorithms::boruvkaUpdate(best[cu], id, weightAt);
+                        detail_graph_algorithms::boruvkaUpdate(best[cv], id, weightAt);
+                    }
+                });
+
+            // contract the selected edges; an edge chosen by both of its
+            // components is recorded by the smaller one only
+            std::vector<std::size_t> added(pool.nThreads()+1, 0);
+            parallel_foreach(pool, nodeSlices,
+                [&](size_t thread, std::ptrdiff_t s)
+                {
+                    const Int64 end = std::min<Int64>(nodeIdEnd, (s+1)*sliceSize);
+                    for(Int64 id = s*sliceSize; id < end; ++id)
+                    {
+                        const Int64 edgeId = best[id].load();
+                        if(component[id] != id || edgeId < 0)
+                            continue;
+                        const Edge e(g.edgeFromId(edgeId));
+                        const Int64 cu = component[g.id(g.u(e))],
+                                    cv = component[g.id(g.v(e))];
+                        const Int64 other = cu == id ? cv : cu;
+                        if(other < id && best[other].load() == edgeId)
+                            continue;
+                        treeEdges[e] = 1;
+                        ufd.makeUnion(id, other);
+                        ++added[thread];
+                    }
+                });
+
+            std::size_t addedThisRound = 0;
+            for(std::size_t t=0; t<added.size(); ++t)
+                addedThisRound += added[t];
+            if(addedThisRound == 0)
+                break;
+            treeEdgeCount += addedThisRound;
+        }
+        return treeEdgeCount;
+    }
+
+    /// \brief parallel minimum spanning tree (forest) as a merge tree
+    ///
+    /// Computes the tree with the parallel Boruvka algorithm and returns its edges
+    /// sorted by increasing weight (ties by edge id), i.e. in single-linkage merge order.
+    template<class GRAPH, class WEIGHTS>
+    void minimumSpanningTreeEdges(
+        const GRAPH   & g,
+        const WEIGHTS & weights,
+        std::vector<typename GRAPH::Edge> & treeEdges,
+        ParallelOptions const & options
+    ){
+        typedef typename GRAPH::Edge Edge;
+        typename GRAPH::template EdgeMap<UInt8> inTree(g);
+        const std::size_t count = minimumSpanningTree(g, weights, inTree, options);
+
+        treeEdges.clear();
+        treeEdges.reserve(count);
+        for(typename GRAPH::EdgeIt e(g); e!=lemon::INVALID; ++e)
+            if(inTree[*e])
+                treeEdges.push_back(*e);
+        parallel_sort(options.getActualNumThreads(), treeEdges.begin(), treeEdges.end(),
+            [&](Edge const & a, Edge const & b)
+            {
+                return weights[a] < weights[b] ||
+                       (!(weights[b] < weights[a]) && g.id(a) < g.id(b));
+            });
+    }
+
     namespace detail_graph_smoothing{
 
     template<
@@ -1326,8 +2254,161 @@ namespace vigra{
         }
         return edgePoints;
     }
+    namespace detail_graph_algorithms{
+
+        // tell array-backed node/edge maps (GridGraph::NodeMap, EdgeMap, MultiArrayView)
+        // apart from other property maps
+        template<unsigned int N, class T, class S>
+        VigraTrueType isMultiArrayViewMap(MultiArrayView<N, T, S> const *);
+        template<unsigned int N>
+        VigraFalseType isMultiArrayViewMap(...);
+
+        template<unsigned int N, class DirectedTag, class NODEMAP, class EDGEMAP, class FUNCTOR>
+        void edgeWeightsFromNodeWeightsImpl(
+            const GridGraph<N, DirectedTag> & g,
+            const NODEMAP  & nodeWeights,
+            EDGEMAP & edgeWeights,
+            bool euclidean,
+            FUNCTOR const & func,
+            VigraTrueType /* array maps */)
+        {
+            typedef typename MultiArrayShape<N>::type CoordType;
+            typedef typename NODEMAP::value_type NodeValue;
+            typedef typename EDGEMAP::value_type EdgeValue;
+            MultiArrayView<N+1, EdgeValue, StridedArrayTag> edgeView(edgeWeights);
+            if(!euclidean)
+            {
+                transformGridGraphEdges(g, nodeWeights, edgeView, func);
+                return;
+            }
+            gridGraphEdgeSlices(g,
+                [&](MultiArrayIndex k, CoordType const & start, CoordType const & stop, CoordType const & offset)
+                {
+                    const double length = norm(offset);
+                    auto scaled = [&](NodeValue const & a, NodeValue const & b)
+                    {
+                        return length * func(a, b);
+                    };
+                    MultiArrayView<N, NodeValue, StridedArrayTag>
+                        u(nodeWeights.subarray(start, stop)),
+                        v(nodeWeights.subarray(start+offset, stop+offset));
+                    MultiArrayView<N, EdgeValue, StridedArrayTag> e(edgeView.bindOuter(k).subarray(start, stop));
+                    detail::GridGraphEdgeSliceLoop<N-1>::exec(u.data(), v.data(), e.data(), e.shape(),
+                                                              u.stride(), v.stride(), e.stride(), scaled);
+                });
+        }
+
+        template<unsigned int N, class DirectedTag, class NODEMAP, class EDGEMAP, class FUNCTOR>
+        void edgeWeightsFromNodeWeightsImpl(
+            const GridGraph<N, DirectedTag> & g,
+            const NODEMAP  & nodeWeights,
+            EDGEMAP & edgeWeights,
+            bool euclidean,
+            FUNCTOR const & func,
+            VigraFalseType /* generic maps */)
+        {
+            typedef GridGraph<N, DirectedTag> Graph;
+            typedef typename Graph::Edge Edge;
+            typedef typename Graph::EdgeIt EdgeIt;
+            typedef typename MultiArrayShape<N>::type CoordType;
+
+            for (EdgeIt iter(g); iter!=lemon::INVALID; ++iter)
+            {
+                const Edge edge(*iter);
+                const CoordType uCoord(g.u(edge));
+                const CoordType vCoord(g.v(edge));
+                if (euclidean)
+                {
+                    edgeWeights[edge] = norm(uCoord-vCoord) * func(nodeWeights[uCoord], nodeWeights[vCoord]);
+                }
+                else
+                {
+                    edgeWeights[edge] = func(nodeWeights[uCoord], nodeWeights[vCoord]);
+                }
+            }
+        }
+
+        template<unsigned int N, class DirectedTag, class T, class EDGEMAP>
+        void edgeWeightsFromInterpolatedImageImpl(
+            const GridGraph<N, DirectedTag> & g,
+            const MultiArrayView<N, T>  & interpolatedImage,
+            EDGEMAP & edgeWeights,
+            bool euclidean,
+            VigraTrueType /* array map */)
+        {
+            typedef typename MultiArrayShape<N>::type CoordType;
+            typedef typename EDGEMAP::value_type EdgeValue;
+            MultiArrayView<N+1, EdgeValue, StridedArrayTag> edgeView(edgeWeights);
+            // the edge (u, u+offset) reads interpolatedImage[2*u+offset]
+            MultiArrayView<N, T, StridedArrayTag> image(interpolatedImage);
+            gridGraphEdgeSlices(g,
+                [&](MultiArrayIndex k, CoordType const & start, CoordType const & stop, CoordType const & offset)
+                {
+                    MultiArrayView<N, EdgeValue, StridedArrayTag> e(edgeView.bindOuter(k).subarray(start, stop));
+                    MultiArrayView<N, T, StridedArrayTag>
+                        src(image.subarray(2*start+offset, 2*stop+offset-CoordType(1)).stridearray(CoordType(2)));
+                    // convert element by element (and multiply in double precision)
+                    // exactly like the per-edge loop, MultiArrayView assignment
+                    // would round instead of truncate for integral EdgeValue
+                    if(euclidean)
+                    {
+                        const double length = norm(offset);
+                        auto scaled = [&](T const & a, T const &)
+                        {
+                            return length * a;
+                        };
+                        detail::GridGraphEdgeSliceLoop<N-1>::exec(src.data(), src.data(), e.data(), e.shape(),
+                                                                  src.stride(), src.stride(), e.stride(), scaled);
+                    }
+                    else
+                    {
+                        auto copied = [](T const & a, T const &)
+                        {
+                            return a;
+                        };
+                        detail::GridGraphEdgeSliceLoop<N-1>::exec(src.data(), src.data(), e.data(), e.shape(),
+                                                                  src.stride(), src.stride(), e.stride(), copied);
+                    }
+                });
+        }
+
+        template<unsigned int N, class DirectedTag, class T, class EDGEMAP>
+        void edgeWeightsFromInterpolatedImageImpl(
+            const GridGraph<N, DirectedTag> & g,
+            const MultiArrayView<N, T>  & interpolatedImage,
+            EDGEMAP & edgeWeights,
+            bool euclidean,
+            VigraFalseType /* generic map */)
+        {
+            typedef GridGraph<N, DirectedTag> Graph;
+            typedef typename Graph::Edge Edge;
+            typedef typename Graph::EdgeIt EdgeIt;
+            typedef typename MultiArrayShape<N>::type CoordType;
+
+            for (EdgeIt iter(g); iter!=lemon::INVALID; ++iter)
+            {
+                const Edge edge(*iter);
+                const CoordType uCoord(g.u(edge));
+                const CoordType vCoord(g.v(edge));
+                if (euclidean)
+                {
+                    edgeWeights[edge] = norm(uCoord-vCoord) * interpolatedImage[uCoord+vCoord];
+                }
+                else
+                {
+                    edgeWeights[edge] = interpolatedImage[uCoord+vCoord];
+                }
+            }
+        }
+
+    } // namespace detail_graph_algorithms
+
     /// \brief create edge weights from node weights
     ///
+    /// When both maps are backed by arrays (e.g. <tt>GridGraph::NodeMap</tt>,
+    /// <tt>GridGraph::EdgeMap</tt> or suitable MultiArrayViews), the edges are processed
+    /// in bulk by transformGridGraphEdges(), otherwise by a loop over all edges.
+    ///
     /// \param g : input graph
     /// \param nodeWeights : node property map holding node weights
     /// \param[out] edgeWeights : resulting edge weights
@@ -1345,28 +2426,14 @@ namespace vigra{
             bool euclidean,
             FUNCTOR const & func)
     {
-        typedef GridGraph<N, DirectedTag> Graph;
-        typedef typename Graph::Edge Edge;
-        typedef typename Graph::EdgeIt EdgeIt;
-        typedef typename MultiArrayShape<N>::type CoordType;
-
         vigra_precondition(nodeWeights.shape() == g.shape(), 
              "edgeWeightsFromNodeWeights(): shape mismatch between graph and nodeWeights.");
-        
-        for (EdgeIt iter(g); iter!=lemon::INVALID; ++iter)
-        {
-            const Edge edge(*iter);
-            const CoordType uCoord(g.u(edge));
-            const CoordType vCoord(g.v(edge));
-            if (euclidean)
-            {
-                edgeWeights[edge] = norm(uCoord-vCoord) * func(nodeWeights[uCoord], nodeWeights[vCoord]);
-            }
-            else
-            {
-                edgeWeights[edge] = func(nodeWeights[uCoord], nodeWeights[vCoord]);
-            }
-        }
+
+        typedef decltype(detail_graph_algorithms::isMultiArrayViewMap<N>(&nodeWeights)) NodeMapIsArray;
+        typedef decltype(detail_graph_algorithms::isMultiArrayViewMap<N+1>(&edgeWeights)) EdgeMapIsArray;
+        typedef typename And<NodeMapIsArray, EdgeMapIsArray>::result UseBulkPass;
+        detail_graph_algorithms::edgeWeightsFromNodeWeightsImpl(g, nodeWeights, edgeWeights,
+                                                                euclidean, func, UseBulkPass());
     }
 
     template<unsigned int N, class DirectedTag,
@@ -1393,6 +2460,7 @@ namespace vigra{
     /// 
     /// For each edge, the function reads the weight from <tt>interpolatedImage[u+v]</tt>,
     /// where <tt>u</tt> and <tt>v</tt> are the coordinates of the edge's end points.
+    /// Array-backed edge maps are filled slice by slice (see gridGraphEdgeSlices()).
     template<unsigned int N, class DirectedTag,
             class T, class EDGEMAP>
     void 
@@ -1402,28 +2470,14 @@ namespace vigra{
             EDGEMAP & edgeWeights,
             bool euclidean = false)
     {
-        typedef GridGraph<N, DirectedTag> Graph;
-        typedef typename Graph::Edge Edge;
-        typedef typename Graph::EdgeIt EdgeIt;
         typedef typename MultiArrayShape<N>::type CoordType;
 
         vigra_precondition(interpolatedImage.shape() == 2*g.shape()-CoordType(1), 
              "edgeWeightsFromInterpolatedImage(): interpolated shape must be shape*2-1");
-        
-        for (EdgeIt iter(g); iter!=lemon::INVALID; ++iter)
-        {
-            const Edge edge(*iter);
-            const CoordType uCoord(g.u(edge));
-            const CoordType vCoord(g.v(edge));
-            if (euclidean)
-            {
-                edgeWeights[edge] = norm(uCoord-vCoord) * interpolatedImage[uCoord+vCoord];
-            }
-            else
-            {
-                edgeWeights[edge] = interpolatedImage[uCoord+vCoord];
-            }
-        }
+
+        typedef decltype(detail_graph_algorithms::isMultiArrayViewMap<N+1>(&edgeWeights)) EdgeMapIsArray;
+        detail_graph_algorithms::edgeWeightsFromInterpolatedImageImpl(g, interpolatedImage, edgeWeights,
+                                                                      euclidean, EdgeMapIsArray());
     }
 
     template<class GRAPH>
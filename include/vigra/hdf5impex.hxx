@@ -74,12 +74,27 @@
 # include <hdf5_hl.h>
 #endif
 
+// H5Dread_chunk() and H5Dwrite_chunk() are available since HDF5 1.10.3
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 10 || \
+                          (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 3)))
+# define VIGRA_HDF5_DIRECT_CHUNK_IO
+#endif
+
+// H5Pset_file_locking() is available since HDF5 1.10.7 and 1.12.1
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && (H5_VERS_MINOR > 12 || \
+                          (H5_VERS_MINOR == 12 && H5_VERS_RELEASE >= 1) || \
+                          (H5_VERS_MINOR == 10 && H5_VERS_RELEASE >= 7)))
+# define VIGRA_HDF5_FILE_LOCKING
+#endif
+
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_iterator_coupled.hxx"
 #include "multi_impex.hxx"
 #include "utilities.hxx"
 #include "error.hxx"
+#include "compression.hxx"
+#include "threadpool.hxx"
 
 #if defined(_MSC_VER)
 #  include <io.h>
@@ -904,6 +919,252 @@ inline hid_t getH5DataType<FFTWComplex<double> >()
 }
 #endif
 
+    /* Encoder/decoder for the raw chunks of a dataset, used by the direct
+       chunk I/O functions of HDF5File and by ChunkedArrayHDF5. It
+       re-implements the HDF5 filter pipeline for the deflate and shuffle
+       filters, so that (de-)compression can run outside of the HDF5 library
+       (which serializes all calls) in parallel threads. Datasets with other
+       filters, non-chunked layout, or a file type that differs from the
+       memory type are marked as unsupported, and callers must fall back to
+       H5Dread()/H5Dwrite().
+    */
+class HDF5ChunkCodec
+{
+  public:
+    HDF5ChunkCodec()
+    : supported_(false),
+      typeSize_(0),
+      chunkBytes_(0)
+    {}
+
+    HDF5ChunkCodec(hid_t dataset, hid_t datatype, int numBandsOfType,
+                   unsigned int ndim, std::size_t elementSize)
+    : supported_(false),
+      typeSize_(0),
+      chunkBytes_(0)
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        HDF5Handle filetype(H5Dget_type(dataset), &H5Tclose,
+                            "HDF5ChunkCodec(): unable to get dataset type.");
+        if(H5Tequal(filetype, datatype) <= 0)
+            return;
+        typeSize_ = H5Tget_size(datatype);
+        if(typeSize_*numBandsOfType != elementSize)
+            return;
+
+        HDF5Handle plist(H5Dget_create_plist(dataset), &H5Pclose,
+                         "HDF5ChunkCodec(): unable to get dataset creation property list.");
+        if(H5Pget_layout(plist) != H5D_CHUNKED)
+            return;
+
+        unsigned int dimensions = numBandsOfType > 1 ? ndim + 1 : ndim;
+        if(H5Pget_chunk(plist, 0, 0) != (int)dimensions)
+            return;
+        chunkShape_.resize(dimensions);
+        H5Pget_chunk(plist, dimensions, chunkShape_.data());
+        if(numBandsOfType > 1 && chunkShape_[ndim] != (hsize_t)numBandsOfType)
+            return;
+        chunkBytes_ = typeSize_;
+        for(unsigned int k=0; k<dimensions; ++k)
+            chunkBytes_ *= chunkShape_[k];
+
+        int nfilters = H5Pget_nfilters(plist);
+        for(int k=0; k<nfilters; ++k)
+        {
+            unsigned int flags = 0, config = 0, values[8];
+            std::size_t nvalues = 8;
+            char name[64];
+            H5Z_filter_t id = H5Pget_filter2(plist, k, &flags, &nvalues, values,
+                                             sizeof(name), name, &config);
+            if(id == H5Z_FILTER_DEFLATE)
+            {
+                // without zlib in vigraimpex, let H5Dread() decode the chunks
+                // with HDF5's own zlib
+                if(!compressionAvailable(ZLIB))
+                    return;
+                unsigned int level = nvalues > 0 ? values[0] : 6;
+                filters_.push_back(level == 0
+                                      ? ZLIB_NONE
+                                      : level <= 3
+                                          ? ZLIB_FAST
+                                          : level <= 7
+                                              ? ZLIB
+                                              : ZLIB_BEST);
+            }
+            else if(id == H5Z_FILTER_SHUFFLE)
+            {
+                filters_.push_back(NO_COMPRESSION);
+            }
+            else
+            {
+                return;
+            }
+        }
+
+        fillValue_.resize(typeSize_, 0);
+        if(H5Pget_fill_value(plist, datatype, fillValue_.data()) < 0)
+            std::fill(fillValue_.begin(), fillValue_.end(), 0);
+
+        supported_ = true;
+#else
+        (void)dataset; (void)datatype; (void)numBandsOfType;
+        (void)ndim; (void)elementSize;
+#endif
+    }
+
+        // true if chunks of the dataset can be transferred directly
+    bool supported() const
+    {
+        return supported_;
+    }
+
+        // chunk shape in HDF5 axis order (including the band axis)
+    ArrayVector<hsize_t> const & chunkShape() const
+    {
+        return chunkShape_;
+    }
+
+        // size of a decoded chunk in bytes
+    std::size_t chunkBytes() const
+    {
+        return chunkBytes_;
+    }
+
+        // initialize a decoded chunk with the dataset's fill value
+    void fill(char * dest) const
+    {
+        for(std::size_t k=0; k<chunkBytes_; k += typeSize_)
+            std::memcpy(dest + k, fillValue_.data(), typeSize_);
+    }
+
+        // undo the filter pipeline, skipping filters whose bit is set in 'filterMask'
+    void decode(char const * source, std::size_t size, unsigned int filterMask,
+                char * dest, ArrayVector<char> & scratch) const
+    {
+        ArrayVector<int> active;
+        for(int k=(int)filters_.size()-1; k>=0; --k)
+            if((filterMask & (1u << k)) == 0)
+                active.push_back(k);
+
+        if(active.size() > 1)
+            scratch.resize(2*chunkBytes_);
+        for(unsigned int k=0; k<active.size(); ++k)
+        {
+            char * target = k+1 == active.size()
+                                ? dest
+                                : scratch.data() + (k % 2)*chunkBytes_;
+            if(filters_[active[k]] == NO_COMPRESSION)
+            {
+                vigra_postcondition(size == chunkBytes_,
+                    "HDF5ChunkCodec::decode(): chunk has wrong size.");
+                unshuffle(source, target);
+            }
+            else
+            {
+                uncompress(source, size, target, chunkBytes_, filters_[active[k]]);
+                size = chunkBytes_;
+            }
+            source = target;
+        }
+        if(active.size() == 0)
+        {
+            vigra_postcondition(size == chunkBytes_,
+                "HDF5ChunkCodec::decode(): chunk has wrong size.");
+            std::memcpy(dest, source, chunkBytes_);
+        }
+    }
+
+        // apply the filter pipeline to a decoded chunk
+    void encode(char const * source, ArrayVector<char> & dest,
+                ArrayVector<char> & scratch) const
+    {
+        std::size_t size = chunkBytes_;
+        for(unsigned int k=0; k<filters_.size(); ++k)
+        {
+            ArrayVector<char> & target = (filters_.size() - k) % 2 == 1
+                                              ? dest
+                                              : scratch;
+            if(filters_[k] == NO_COMPRESSION)
+            {
+                target.resize(size);
+                shuffle(source, target.data());
+            }
+            else
+            {
+                compress(source, size, target, filters_[k]);
+                size = target.size();
+            }
+            source = target.data();
+        }
+        if(filters_.size() == 0)
+            dest = ArrayVector<char>(source, source + size);
+    }
+
+        // read the raw chunk starting at 'offset' (in HDF5 axis order),
+        // return false if the chunk has not been allocated in the file
+    bool readRaw(hid_t dataset, hsize_t const * offset,
+                 ArrayVector<char> & buffer, unsigned int & filterMask) const
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        hsize_t size = 0;
+        {
+            // fails when no chunk of the dataset has been allocated yet
+            HDF5DisableErrorOutput disable_error;
+            if(H5Dget_chunk_storage_size(dataset, offset, &size) < 0 || size == 0)
+                return false;
+        }
+        buffer.resize(size);
+        uint32_t mask = 0;
+        herr_t status = H5Dread_chunk(dataset, H5P_DEFAULT, offset, &mask, buffer.data());
+        vigra_postcondition(status >= 0,
+            "HDF5ChunkCodec::readRaw(): H5Dread_chunk() failed.");
+        filterMask = mask;
+        return true;
+#else
+        (void)dataset; (void)offset; (void)buffer; (void)filterMask;
+        vigra_fail("HDF5ChunkCodec::readRaw(): direct chunk I/O requires HDF5 1.10.3 or later.");
+        return false;
+#endif
+    }
+
+        // write an encoded chunk starting at 'offset' (in HDF5 axis order)
+    void writeRaw(hid_t dataset, hsize_t const * offset,
+                  ArrayVector<char> const & buffer) const
+    {
+#ifdef VIGRA_HDF5_DIRECT_CHUNK_IO
+        herr_t status = H5Dwrite_chunk(dataset, H5P_DEFAULT, 0, offset,
+                                       buffer.size(), buffer.data());
+        vigra_postcondition(status >= 0,
+            "HDF5ChunkCodec::writeRaw(): H5Dwrite_chunk() failed.");
+#else
+        (void)dataset; (void)offset; (void)buffer;
+        vigra_fail("HDF5ChunkCodec::writeRaw(): direct chunk I/O requires HDF5 1.10.3 or later.");
+#endif
+    }
+
+  private:
+    void shuffle(char const * source, char * dest) const
+    {
+        std::size_t count = chunkBytes_ / typeSize_;
+        for(std::size_t b=0; b<typeSize_; ++b)
+            for(std::size_t k=0; k<count; ++k)
+                dest[b*count + k] = source[k*typeSize_ + b];
+    }
+
+    void unshuffle(char const * source, char * dest) const
+    {
+        std::size_t count = chunkBytes_ / typeSize_;
+        for(std::size_t b=0; b<typeSize_; ++b)
+            for(std::size_t k=0; k<count; ++k)
+                dest[k*typeSize_ + b] = source[b*count + k];
+    }
+
+    bool supported_;
+    std::size_t typeSize_, chunkBytes_;
+    ArrayVector<hsize_t> chunkShape_;
+    ArrayVector<CompressionMethod> filters_;  // NO_COMPRESSION denotes the shuffle filter
+    ArrayVector<char> fillValue_;
+};
 
 } // namespace detail
 
@@ -969,6 +1230,11 @@ class HDF5File
 
     bool read_only_;
 
+    // chunk cache parameters of datasets opened or created via this object,
+    // (size_t)-1 and -1.0 mean 'use the file's default'
+    std::size_t cache_nslots_, cache_nbytes_;
+    double cache_w0_;
+
     // helper classes for ls() and listAttributes()
     struct ls_closure
     {
@@ -1011,6 +1277,14 @@ class HDF5File
             OpenMode::ReadWrite opens a file for reading/writing. The file will be created if it doesn't exist.
 
             OpenMode::ReadOnly opens a file for reading. The file as well as any dataset to be accessed must already exist.
+
+            OpenMode::ReadOnlyShared is like ReadOnly, but tuned for many processes reading the same
+            file concurrently: the file is opened for SWMR reading (single-writer/multiple-reader)
+            when the HDF5 library supports it, and file locking is disabled where possible.
+
+            OpenMode::CopyOnWrite opens the file like ReadOnlyShared. When passed to ChunkedArrayHDF5,
+            the array becomes writable, but modified chunks are kept in a scratch store and never
+            written back to the file.
         */
     enum OpenMode {
         New,              // Create new empty file (existing file will be deleted).
@@ -1019,9 +1293,12 @@ class HDF5File
         OpenReadOnly,     // Open file in read-only mode.
         ReadOnly = OpenReadOnly, // Alias for OpenReadOnly
         Replace,          // for ChunkedArrayHDF5: replace dataset if it exists, create otherwise
-        Default           // for ChunkedArrayHDF5: use New if file doesn't exist,
+        Default,          // for ChunkedArrayHDF5: use New if file doesn't exist,
                           //                           ReadOnly if file and dataset exist
                           //                           Open otherwise
+        ReadOnlyShared,   // Open file read-only for many concurrent readers (SWMR read, no file locking).
+        CopyOnWrite       // for ChunkedArrayHDF5: open file like ReadOnlyShared and keep
+                          //                       modified chunks in a scratch store
     };
 
         /** \brief Default constructor.
@@ -1029,7 +1306,10 @@ class HDF5File
         A file can later be opened via the open() function. Time tagging of datasets is disabled.
         */
     HDF5File()
-    : track_time(0)
+    : track_time(0),
+      cache_nslots_((std::size_t)-1),
+      cache_nbytes_((std::size_t)-1),
+      cache_w0_(-1.0)
     {}
 
         /** \brief Construct with time tagging of datasets enabled.
@@ -1038,7 +1318,10 @@ class HDF5File
         */
     explicit HDF5File(bool track_creation_times)
     : track_time(track_creation_times ? 1 : 0),
-      read_only_(true)
+      read_only_(true),
+      cache_nslots_((std::size_t)-1),
+      cache_nbytes_((std::size_t)-1),
+      cache_w0_(-1.0)
     {}
 
         /** \brief Open or create an HDF5File object.
@@ -1047,7 +1330,10 @@ class HDF5File
         The current group is set to "/". By default, the files is opened in read-only mode.
         */
     explicit HDF5File(std::string filePath, OpenMode mode = ReadOnly, bool track_creation_times = false)
-        : track_time(track_creation_times ? 1 : 0)
+        : track_time(track_creation_times ? 1 : 0),
+          cache_nslots_((std::size_t)-1),
+          cache_nbytes_((std::size_t)-1),
+          cache_w0_(-1.0)
     {
         open(filePath, mode);
     }
@@ -1058,7 +1344,10 @@ class HDF5File
         The current group is set to "/". By default, the files is opened in read-only mode.
         */
     explicit HDF5File(char const * filePath, OpenMode mode = ReadOnly, bool track_creation_times = false)
-        : track_time(track_creation_times ? 1 : 0)
+        : track_time(track_creation_times ? 1 : 0),
+          cache_nslots_((std::size_t)-1),
+          cache_nbytes_((std::size_t)-1),
+          cache_w0_(-1.0)
     {
         open(std::string(filePath), mode);
     }
@@ -1083,7 +1372,10 @@ class HDF5File
                       const std::string & pathname = "",
                       bool read_only = false)
     : fileHandle_(fileHandle),
-      read_only_(read_only)
+      read_only_(read_only),
+      cache_nslots_((std::size_t)-1),
+      cache_nbytes_((std::size_t)-1),
+      cache_w0_(-1.0)
 
     {
         // get group handle for given pathname
@@ -1110,7 +1402,10 @@ class HDF5File
     HDF5File(HDF5File const & other)
     : fileHandle_(other.fileHandle_),
       track_time(other.track_time),
-      read_only_(other.read_only_)
+      read_only_(other.read_only_),
+      cache_nslots_(other.cache_nslots_),
+      cache_nbytes_(other.cache_nbytes_),
+      cache_w0_(other.cache_w0_)
     {
         cGroupHandle_ = HDF5Handle(openCreateGroup_(other.currentGroupName_()), &H5Gclose,
                                    "HDF5File(HDF5File const &): Failed to open group.");
@@ -1141,6 +1436,9 @@ class HDF5File
                                        "HDF5File::operator=(): Failed to open group.");
             track_time = other.track_time;
             read_only_ = other.read_only_;
+            cache_nslots_ = other.cache_nslots_;
+            cache_nbytes_ = other.cache_nbytes_;
+            cache_w0_ = other.cache_w0_;
         }
         return *this;
     }
@@ -1165,6 +1463,38 @@ class HDF5File
         read_only_ = stat;
     }
 
+        /** \brief Configure the HDF5 chunk cache of datasets.
+
+            The settings apply to all datasets subsequently opened or created
+            via this object (including copies of it, e.g. in ChunkedArrayHDF5).
+            \a nbytes is the total cache size per dataset in bytes, \a nslots
+            the number of hash table slots (should be a prime number about
+            100 times the number of chunks fitting into the cache), and \a w0
+            the preemption policy (0 = evict least recently used chunks,
+            1 = evict fully read/written chunks first). Setting \a nbytes to
+            zero disables the cache, which is appropriate when each chunk is
+            accessed only once or the application caches chunks itself.
+            The default arguments keep the library's default for the respective
+            parameter (1 MB, 521 slots, and 0.75 respectively).
+        */
+    void setChunkCache(std::size_t nbytes,
+                       std::size_t nslots = (std::size_t)-1,
+                       double w0 = -1.0)
+    {
+        vigra_precondition(w0 == -1.0 || (w0 >= 0.0 && w0 <= 1.0),
+            "HDF5File::setChunkCache(): w0 must be in [0, 1].");
+        cache_nbytes_ = nbytes;
+        cache_nslots_ = nslots;
+        cache_w0_ = w0;
+    }
+
+        /** \brief Get the chunk cache size in bytes ((size_t)-1 means 'library default').
+        */
+    std::size_t chunkCacheBytes() const
+    {
+        return cache_nbytes_;
+    }
+
         /** \brief Open or create the given file in the given mode and set the group to "/".
             If another file is currently open, it is first closed.
          */
@@ -1175,7 +1505,7 @@ class HDF5File
         std::string errorMessage = "HDF5File.open(): Could not open or create file '" + filePath + "'.";
         fileHandle_ = HDF5HandleShared(createFile_(filePath, mode), &H5Fclose, errorMessage.c_str());
         cGroupHandle_ = HDF5Handle(openCreateGroup_("/"), &H5Gclose, "HDF5File.open(): Failed to open root group.");
-        setReadOnly(mode == OpenReadOnly);
+        setReadOnly(isReadOnlyMode_(mode));
     }
 
         /** \brief Close the current file.
@@ -1809,6 +2139,38 @@ class HDF5File
                            TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
     }
 
+        /** \brief Write a multi array into a larger volume, compressing chunks in parallel.
+
+            Like writeBlock() above, but the affected HDF5 chunks are encoded
+            by the threads given in \a options and passed to the file with
+            <tt>H5Dwrite_chunk()</tt>, bypassing the (single-threaded) HDF5 filter
+            pipeline. Chunks only partially covered by the block are read, updated,
+            and written back. This requires HDF5 1.10.3 or later and a chunked
+            dataset whose type equals <tt>T</tt>'s type and whose filters
+            are restricted to deflate and shuffle. Otherwise, the function falls back
+            to the ordinary writeBlock().
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void writeBlock(std::string datasetName,
+                           typename MultiArrayShape<N>::type blockOffset,
+                           const MultiArrayView<N, T, Stride> & array,
+                           ParallelOptions const & options)
+    {
+        datasetName = get_absolute_path(datasetName);
+        std::string errorMessage = "HDF5File::writeBlock(): Error opening dataset '" + datasetName + "'.";
+        HDF5HandleShared dataset(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+        writeBlockDirect_(dataset, blockOffset, array, options);
+    }
+
+    template<unsigned int N, class T, class Stride>
+    inline void writeBlock(HDF5HandleShared dataset,
+                           typename MultiArrayShape<N>::type blockOffset,
+                           const MultiArrayView<N, T, Stride> & array,
+                           ParallelOptions const & options)
+    {
+        writeBlockDirect_(dataset, blockOffset, array, options);
+    }
+
     // non-scalar (TinyVector) and unstrided multi arrays
     template<unsigned int N, class T, int SIZE, class Stride>
     inline void write(std::string datasetName,
@@ -2034,6 +2396,38 @@ class HDF5File
                           TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
     }
 
+        /** \brief Read a block of data into a multi array, decompressing chunks in parallel.
+
+            Like readBlock() above, but the raw HDF5 chunks overlapping the block
+            are fetched with <tt>H5Dread_chunk()</tt> and decoded by the threads
+            given in \a options, bypassing the (single-threaded) HDF5 filter pipeline.
+            This requires HDF5 1.10.3 or later and a chunked dataset whose type equals
+            <tt>T</tt>'s type and whose filters are restricted to deflate and shuffle.
+            Otherwise, the function falls back to the ordinary readBlock().
+        */
+    template<unsigned int N, class T, class Stride>
+    inline void readBlock(std::string datasetName,
+                          typename MultiArrayShape<N>::type blockOffset,
+                          typename MultiArrayShape<N>::type blockShape,
+                          MultiArrayView<N, T, Stride> array,
+                          ParallelOptions const & options)
+    {
+        datasetName = get_absolute_path(datasetName);
+        std::string errorMessage ("HDF5File::readBlock(): Unable to open dataset '" + datasetName + "'.");
+        HDF5HandleShared dataset(getDatasetHandle_(datasetName), &H5Dclose, errorMessage.c_str());
+        readBlockDirect_(dataset, blockOffset, blockShape, array, options);
+    }
+
+    template<unsigned int N, class T, class Stride>
+    inline void readBlock(HDF5HandleShared dataset,
+                          typename MultiArrayShape<N>::type blockOffset,
+                          typename MultiArrayShape<N>::type blockShape,
+                          MultiArrayView<N, T, Stride> array,
+                          ParallelOptions const & options)
+    {
+        readBlockDirect_(dataset, blockOffset, blockShape, array, options);
+    }
+
     // non-scalar (TinyVector) and unstrided target MultiArrayView
     template<unsigned int N, class T, int SIZE, class Stride>
     inline void read(std::string datasetName, MultiArrayView<N, TinyVector<T, SIZE>, Stride> array)
@@ -2347,6 +2741,33 @@ class HDF5File
         return std::string(name.begin());
     }
 
+    static bool isReadOnlyMode_(OpenMode mode)
+    {
+        return mode == OpenReadOnly || mode == ReadOnlyShared || mode == CopyOnWrite;
+    }
+
+        /* open an existing file for many concurrent readers
+         */
+    static hid_t openFileShared_(std::string const & filePath)
+    {
+        HDF5Handle fapl(H5Pcreate(H5P_FILE_ACCESS), &H5Pclose,
+                        "HDF5File::open(): unable to create file access property list.");
+#ifdef VIGRA_HDF5_FILE_LOCKING
+        // readers never modify the file, so locking only costs time (and fails on some network file systems)
+        H5Pset_file_locking(fapl, 0, 1);
+#endif
+        hid_t fileId = -1;
+#ifdef H5F_ACC_SWMR_READ
+        {
+            HDF5DisableErrorOutput disable_error;
+            fileId = H5Fopen(filePath.c_str(), H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, fapl);
+        }
+#endif
+        if(fileId < 0)
+            fileId = H5Fopen(filePath.c_str(), H5F_ACC_RDONLY, fapl);
+        return fileId;
+    }
+
         /* create an empty file or open an existing one
          */
     inline hid_t createFile_(std::string filePath, OpenMode mode = Open)
@@ -2359,7 +2780,7 @@ class HDF5File
         // check if opening was successful (= file exists)
         if ( pFile == NULL )
         {
-            vigra_precondition(mode != OpenReadOnly,
+            vigra_precondition(!isReadOnlyMode_(mode),
                 "HDF5File::open(): cannot open non-existing file in read-only mode.");
             fileId = H5Fcreate(filePath.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
         }
@@ -2370,6 +2791,10 @@ class HDF5File
             {
                 fileId = H5Fopen(filePath.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
             }
+            else if(mode == ReadOnlyShared || mode == CopyOnWrite)
+            {
+                fileId = openFileShared_(filePath);
+            }
             else if(mode == New)
             {
                 std::remove(filePath.c_str());
@@ -2500,7 +2925,19 @@ class HDF5File
         // Open parent group
         HDF5Handle groupHandle(openGroup_(groupname), &H5Gclose, "HDF5File::getDatasetHandle_(): Internal error");
 
-        return H5Dopen(groupHandle, setname.c_str(), H5P_DEFAULT);
+        return H5Dopen(groupHandle, setname.c_str(), datasetAccessPlist_());
+    }
+
+        /* create a dataset access property list holding the chunk cache parameters
+         */
+    HDF5Handle datasetAccessPlist_() const
+    {
+        HDF5Handle plist(H5Pcreate(H5P_DATASET_ACCESS), &H5Pclose,
+                         "HDF5File: unable to create dataset access property list.");
+#ifdef H5D_CHUNK_CACHE_NSLOTS_DEFAULT
+        H5Pset_chunk_cache(plist, cache_nslots_, cache_nbytes_, cache_w0_);
+#endif
+        return plist;
     }
 
         /* get the type of an object specified by a string
@@ -2707,6 +3144,36 @@ class HDF5File
                       typename MultiArrayShape<N>::type &blockShape,
                       MultiArrayView<N, T, Stride> array,
                       const hid_t datatype, const int numBandsOfType);
+
+        /* read a sub-block of a dataset by direct chunk transfer and parallel decoding,
+           falls back to readBlock_() when the dataset's chunks cannot be decoded by us.
+        */
+    template<unsigned int N, class T, class Stride>
+    void readBlockDirect_(HDF5HandleShared dataset,
+                          typename MultiArrayShape<N>::type const & blockOffset,
+                          typename MultiArrayShape<N>::type const & blockShape,
+                          MultiArrayView<N, T, Stride> array,
+                          ParallelOptions const & options);
+
+        /* write a sub-block of a dataset by parallel encoding and direct chunk transfer,
+           falls back to writeBlock_() when the dataset's chunks cannot be encoded by us.
+        */
+    template<unsigned int N, class T, class Stride>
+    void writeBlockDirect_(HDF5HandleShared dataset,
+                           typename MultiArrayShape<N>::type const & blockOffset,
+                           const MultiArrayView<N, T, Stride> & array,
+                           ParallelOptions const & options);
+
+        /* determine the dataset shape and the chunks overlapping a block for
+           direct chunk I/O (all shapes in vigra axis order).
+        */
+    template<unsigned int N>
+    void blockChunks_(HDF5HandleShared dataset, detail::HDF5ChunkCodec const & codec,
+                      typename MultiArrayShape<N>::type const & blockOffset,
+                      typename MultiArrayShape<N>::type const & blockShape,
+                      typename MultiArrayShape<N>::type & datasetShape,
+                      typename MultiArrayShape<N>::type & chunkShape,
+                      ArrayVector<typename MultiArrayShape<N>::type> & chunkStarts) const;
 };  /* class HDF5File */
 
 /********************************************************************/
@@ -2778,7 +3245,8 @@ HDF5File::createDataset(std::string datasetName,
     //create the dataset.
     HDF5HandleShared datasetHandle(H5Dcreate(parent, setname.c_str(),
                                              TypeTraits::getH5DataType(),
-                                             dataspaceHandle, H5P_DEFAULT, plist, H5P_DEFAULT),
+                                             dataspaceHandle, H5P_DEFAULT, plist,
+                                             datasetAccessPlist_()),
                                    &H5Dclose,
                                    "HDF5File::createDataset(): unable to create dataset.");
     if(parent != cGroupHandle_)
@@ -2842,7 +3310,7 @@ void HDF5File::write_(std::string &datasetName,
     }
 
     // create dataset
-    HDF5Handle datasetHandle(H5Dcreate(groupHandle, setname.c_str(), datatype, dataspace,H5P_DEFAULT, plist, H5P_DEFAULT),
+    HDF5Handle datasetHandle(H5Dcreate(groupHandle, setname.c_str(), datatype, dataspace,H5P_DEFAULT, plist, datasetAccessPlist_()),
                              &H5Dclose, "HDF5File::write(): Can not create dataset.");
 
     herr_t status = 0;
@@ -3256,6 +3724,219 @@ herr_t HDF5File::readBlock_(HDF5HandleShared datasetHandle,
 
 /********************************************************************/
 
+template<unsigned int N>
+void HDF5File::blockChunks_(HDF5HandleShared datasetHandle, detail::HDF5ChunkCodec const & codec,
+                            typename MultiArrayShape<N>::type const & blockOffset,
+                            typename MultiArrayShape<N>::type const & blockShape,
+                            typename MultiArrayShape<N>::type & datasetShape,
+                            typename MultiArrayShape<N>::type & chunkShape,
+                            ArrayVector<typename MultiArrayShape<N>::type> & chunkStarts) const
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<hsize_t> fileShape(codec.chunkShape().size());
+    HDF5Handle dataspaceHandle(H5Dget_space(datasetHandle), &H5Sclose,
+                               "Unable to get dataspace");
+    H5Sget_simple_extent_dims(dataspaceHandle, fileShape.data(), NULL);
+
+    for(unsigned int k = 0; k < N; ++k)
+    {
+        // vigra and hdf5 use different indexing
+        datasetShape[k] = fileShape[N-1-k];
+        chunkShape[k] = codec.chunkShape()[N-1-k];
+    }
+    vigra_precondition(allLessEqual(Shape(), blockOffset) &&
+                       allLessEqual(blockOffset + blockShape, datasetShape),
+        "HDF5File: block is outside of the dataset.");
+
+    chunkStarts.clear();
+    if(prod(blockShape) == 0)
+        return;
+    Shape first = blockOffset / chunkShape,
+          last  = (blockOffset + blockShape - Shape(1)) / chunkShape;
+    MultiCoordinateIterator<N> i(last - first + Shape(1)),
+                               end = i.getEndIterator();
+    for(; i != end; ++i)
+        chunkStarts.push_back((first + *i) * chunkShape);
+}
+
+/********************************************************************/
+
+template<unsigned int N, class T, class Stride>
+void HDF5File::readBlockDirect_(HDF5HandleShared datasetHandle,
+                                typename MultiArrayShape<N>::type const & blockOffset,
+                                typename MultiArrayShape<N>::type const & blockShape,
+                                MultiArrayView<N, T, Stride> array,
+                                ParallelOptions const & options)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef detail::HDF5TypeTraits<T> TypeTraits;
+
+    vigra_precondition(blockShape == array.shape(),
+         "HDF5File::readBlock(): Array shape disagrees with block size.");
+
+    detail::HDF5ChunkCodec codec(datasetHandle, TypeTraits::getH5DataType(),
+                                 TypeTraits::numberOfBands(), N, sizeof(T));
+    if(!codec.supported())
+    {
+        Shape offset(blockOffset), shape(blockShape);
+        herr_t status = readBlock_(datasetHandle, offset, shape, array,
+                                   TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
+        vigra_postcondition(status >= 0,
+            "HDF5File::readBlock(): read from dataset via H5Dread() failed.");
+        return;
+    }
+
+    Shape datasetShape, chunkShape;
+    ArrayVector<Shape> chunkStarts;
+    blockChunks_<N>(datasetHandle, codec, blockOffset, blockShape,
+                    datasetShape, chunkShape, chunkStarts);
+
+    ThreadPool pool(options);
+    std::size_t threadCount = std::max<std::size_t>(pool.nThreads(), 1),
+                batchSize   = 4*threadCount;
+
+    // decoded chunks are held per thread, raw chunks per batch
+    std::vector<MultiArray<N, T> > buffers(threadCount, MultiArray<N, T>(chunkShape));
+    std::vector<ArrayVector<char> > raw(batchSize), scratch(threadCount);
+    std::vector<unsigned int> filterMasks(batchSize);
+    std::vector<char> allocated(batchSize);
+    ArrayVector<hsize_t> fileOffset(codec.chunkShape().size(), 0);
+
+    for(std::size_t first = 0; first < chunkStarts.size(); first += batchSize)
+    {
+        std::size_t count = std::min(batchSize, chunkStarts.size() - first);
+
+        // the HDF5 library is not reentrant, so fetch the raw chunks sequentially ...
+        for(std::size_t k = 0; k < count; ++k)
+        {
+            for(unsigned int d = 0; d < N; ++d)
+                fileOffset[N-1-d] = chunkStarts[first+k][d];
+            allocated[k] = codec.readRaw(datasetHandle, fileOffset.data(),
+                                         raw[k], filterMasks[k]);
+        }
+
+        // ... and decode them in parallel
+        parallel_foreach(pool, count,
+            [&](std::size_t thread_id, std::ptrdiff_t k)
+            {
+                MultiArray<N, T> & buffer = buffers[thread_id];
+                if(allocated[k])
+                    codec.decode(raw[k].data(), raw[k].size(), filterMasks[k],
+                                 reinterpret_cast<char *>(buffer.data()), scratch[thread_id]);
+                else
+                    codec.fill(reinterpret_cast<char *>(buffer.data()));
+
+                Shape const & start = chunkStarts[first+k];
+                Shape begin = max(start, blockOffset),
+                      end   = min(start + chunkShape, blockOffset + blockShape);
+                array.subarray(begin - blockOffset, end - blockOffset) =
+                    buffer.subarray(begin - start, end - start);
+            });
+    }
+}
+
+/********************************************************************/
+
+template<unsigned int N, class T, class Stride>
+void HDF5File::writeBlockDirect_(HDF5HandleShared datasetHandle,
+                                 typename MultiArrayShape<N>::type const & blockOffset,
+                                 const MultiArrayView<N, T, Stride> & array,
+                                 ParallelOptions const & options)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef detail::HDF5TypeTraits<T> TypeTraits;
+
+    vigra_precondition(!isReadOnly(),
+        "HDF5File::writeBlock(): file is read-only.");
+
+    detail::HDF5ChunkCodec codec(datasetHandle, TypeTraits::getH5DataType(),
+                                 TypeTraits::numberOfBands(), N, sizeof(T));
+    if(!codec.supported())
+    {
+        Shape offset(blockOffset);
+        herr_t status = writeBlock_(datasetHandle, offset, array,
+                                    TypeTraits::getH5DataType(), TypeTraits::numberOfBands());
+        vigra_postcondition(status >= 0,
+            "HDF5File::writeBlock(): write to dataset via H5Dwrite() failed.");
+        return;
+    }
+
+    Shape datasetShape, chunkShape;
+    ArrayVector<Shape> chunkStarts;
+    blockChunks_<N>(datasetHandle, codec, blockOffset, array.shape(),
+                    datasetShape, chunkShape, chunkStarts);
+    Shape blockEnd = blockOffset + array.shape();
+
+    ThreadPool pool(options);
+    std::size_t threadCount = std::max<std::size_t>(pool.nThreads(), 1),
+                batchSize   = 4*threadCount;
+
+    // 'raw' holds the old contents of partially overwritten chunks,
+    // and afterwards the encoded chunks to be written
+    std::vector<MultiArray<N, T> > buffers(threadCount, MultiArray<N, T>(chunkShape));
+    std::vector<ArrayVector<char> > raw(batchSize), scratch(threadCount);
+    std::vector<unsigned int> filterMasks(batchSize);
+    std::vector<char> init(batchSize);
+    ArrayVector<hsize_t> fileOffset(codec.chunkShape().size(), 0);
+    enum { InitNone, InitFill, InitDecode };
+
+    for(std::size_t first = 0; first < chunkStarts.size(); first += batchSize)
+    {
+        std::size_t count = std::min(batchSize, chunkStarts.size() - first);
+
+        for(std::size_t k = 0; k < count; ++k)
+        {
+            Shape const & start = chunkStarts[first+k];
+            Shape chunkEnd = min(start + chunkShape, datasetShape);
+            if(allLessEqual(blockOffset, start) && allLessEqual(chunkEnd, blockEnd))
+            {
+                // chunk is completely overwritten, only the padding of
+                // chunks crossing the dataset border needs a defined value
+                init[k] = chunkEnd == start + chunkShape
+                              ? InitNone
+                              : InitFill;
+            }
+            else
+            {
+                for(unsigned int d = 0; d < N; ++d)
+                    fileOffset[N-1-d] = start[d];
+                init[k] = codec.readRaw(datasetHandle, fileOffset.data(), raw[k], filterMasks[k])
+                              ? InitDecode
+                              : InitFill;
+            }
+        }
+
+        parallel_foreach(pool, count,
+            [&](std::size_t thread_id, std::ptrdiff_t k)
+            {
+                MultiArray<N, T> & buffer = buffers[thread_id];
+                if(init[k] == InitDecode)
+                    codec.decode(raw[k].data(), raw[k].size(), filterMasks[k],
+                                 reinterpret_cast<char *>(buffer.data()), scratch[thread_id]);
+                else if(init[k] == InitFill)
+                    codec.fill(reinterpret_cast<char *>(buffer.data()));
+
+                Shape const & start = chunkStarts[first+k];
+                Shape begin = max(start, blockOffset),
+                      end   = min(start + chunkShape, blockEnd);
+                buffer.subarray(begin - start, end - start) =
+                    array.subarray(begin - blockOffset, end - blockOffset);
+                codec.encode(reinterpret_cast<char const *>(buffer.data()),
+                             raw[k], scratch[thread_id]);
+            });
+
+        for(std::size_t k = 0; k < count; ++k)
+        {
+            for(unsigned int d = 0; d < N; ++d)
+                fileOffset[N-1-d] = chunkStarts[first+k][d];
+            codec.writeRaw(datasetHandle, fileOffset.data(), raw[k]);
+        }
+    }
+}
+
+/********************************************************************/
+
 template<unsigned int N, class T, class Stride>
 void HDF5File::read_attribute_(std::string datasetName,
                                std::string attributeName,
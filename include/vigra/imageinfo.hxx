@@ -48,8 +48,10 @@
 #ifndef VIGRA_IMAGEINFO_HXX
 #define VIGRA_IMAGEINFO_HXX
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include "config.hxx"
 #include "error.hxx"
 #include "diff2d.hxx"
@@ -361,8 +363,24 @@ class ImageExportInfo
          **/
     VIGRA_EXPORT ImageExportInfo & setICCProfile(const ICCProfile & profile);
 
+        /** Set the number of threads used to compress the image.
+
+            Currently used by PNG (deflate of independent row blocks) and by TIFF
+            with compression "DEFLATE" and at least 8 bits per sample (strips are
+            compressed concurrently). Other formats and compression modes encode
+            sequentially. Values follow the convention of
+            \ref ParallelOptions::numThreads(): -1 means one thread per core,
+            0 or 1 (the default) means sequential encoding in the calling thread.
+         **/
+    VIGRA_EXPORT ImageExportInfo & setNumThreads(int n);
+
+        /** Get the number of threads requested by setNumThreads().
+         **/
+    VIGRA_EXPORT int getNumThreads() const;
+
   private:
     std::string m_filename, m_filetype, m_pixeltype, m_comp, m_mode;
+    int m_num_threads;
     float m_x_res, m_y_res;
     Diff2D m_pos;
     ICCProfile m_icc_profile;
@@ -452,6 +470,9 @@ class ImageImportInfo
     VIGRA_EXPORT int numExtraBands() const;
 
         /** Get the number of images contained in the image file.
+
+            The number is determined on the first call, because multi-page
+            formats (TIFF) have to scan the entire file to find it.
          **/
     VIGRA_EXPORT int numImages() const;
 
@@ -549,8 +570,13 @@ class ImageImportInfo
     VIGRA_EXPORT const ICCProfile & getICCProfile() const;
 
   private:
+    friend class ImageMetadataCache;
+
+    ImageImportInfo();
+
     std::string m_filename, m_filetype, m_pixeltype;
-    int m_width, m_height, m_num_bands, m_num_extra_bands, m_num_images, m_image_index;
+    int m_width, m_height, m_num_bands, m_num_extra_bands, m_image_index;
+    mutable int m_num_images; // -1 until numImages() is called
     float m_x_res, m_y_res;
     Diff2D m_pos;
     Size2D m_canvas_size;
@@ -559,6 +585,91 @@ class ImageImportInfo
     void readHeader_();
 };
 
+/** \brief Cache of image file metadata.
+
+    Indexing large sets of image files (e.g. the slices of an image stack) with
+    \ref ImageImportInfo opens every file to read its header. This class remembers
+    the header information of each file, keyed by the file's path, modification time
+    (in seconds) and size, and only opens files that are new or have changed since
+    they were seen.
+    When the cache is associated with a file, its contents are loaded on construction
+    and written back by save() or the destructor, so that subsequent runs of a
+    program can skip reading the headers altogether:
+
+    \code
+    ImageMetadataCache cache("images.vigra-cache");
+    for(std::size_t k = 0; k < filenames.size(); ++k)
+    {
+        ImageImportInfo info = cache.info(filenames[k].c_str());
+        ...
+    }
+    \endcode
+
+    The class is not thread-safe.
+
+    <b>\#include</b> \<vigra/imageinfo.hxx\><br/>
+    Namespace: vigra
+**/
+class ImageMetadataCache
+{
+  public:
+        /** Create an empty cache that is only kept in memory.
+         **/
+    VIGRA_EXPORT ImageMetadataCache();
+
+        /** Create a cache that is stored in the file \a cacheFile.
+
+            Existing entries are loaded if the file exists (entries of an unreadable or
+            incompatible file are ignored). The file is created or updated by save().
+         **/
+    VIGRA_EXPORT explicit ImageMetadataCache( const char * cacheFile );
+
+        /** Write the cache back to its file (when it has been modified),
+            errors are ignored.
+         **/
+    VIGRA_EXPORT ~ImageMetadataCache();
+
+        /** Get the header information of page \a page of image \a filename.
+
+            If the file is unchanged since its entry was created, the cached information
+            is returned without opening the file. Otherwise, the header is read via
+            \ref ImageImportInfo and stored in the cache.
+         **/
+    VIGRA_EXPORT ImageImportInfo info( const char * filename, unsigned int page = 0 );
+
+        /** Number of cached entries.
+         **/
+    VIGRA_EXPORT std::size_t size() const;
+
+        /** Remove all entries.
+         **/
+    VIGRA_EXPORT void clear();
+
+        /** Write the cache to its file. Does nothing for a memory-only cache.
+
+            Throws a PostconditionViolation if the file cannot be written.
+         **/
+    VIGRA_EXPORT void save();
+
+  private:
+    struct Entry
+    {
+        long long mtime, size;
+        ImageImportInfo info;
+    };
+
+    typedef std::map<std::pair<std::string, unsigned int>, Entry> EntryMap;
+
+    ImageMetadataCache( ImageMetadataCache const & );
+    ImageMetadataCache & operator=( ImageMetadataCache const & );
+
+    void load_();
+
+    std::string m_cache_file;
+    EntryMap m_entries;
+    bool m_modified;
+};
+
 // return a decoder for a given ImageImportInfo object
 VIGRA_EXPORT VIGRA_UNIQUE_PTR<Decoder> decoder( const ImageImportInfo & info );
 
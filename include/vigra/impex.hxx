@@ -60,23 +60,145 @@ namespace vigra
 */
     namespace detail
     {
+        // Prepare 'decoder' for reading the rectangle 'roi' of the image. Codecs that can
+        // decode a region natively (see Decoder::setRegionOfInterest()) only deliver the
+        // region's scanlines, otherwise the returned offset is the number of leading
+        // scanlines and pixels the reader has to skip.
+        inline Diff2D
+        select_region_of_interest(Decoder* decoder, Rect2D const & roi)
+        {
+            vigra_precondition(roi.left() >= 0 && roi.top() >= 0 &&
+                               roi.right() <= (int)decoder->getWidth() &&
+                               roi.bottom() <= (int)decoder->getHeight() &&
+                               !roi.isEmpty(),
+                "importImage(): region of interest must be a non-empty part of the image.");
+
+            if (roi.upperLeft() == Point2D(0, 0) &&
+                roi.size() == Size2D(decoder->getWidth(), decoder->getHeight()))
+                return Diff2D(0, 0);
+            if (decoder->setRegionOfInterest(roi.upperLeft(), roi.size()))
+                return Diff2D(0, 0);
+
+            for (int y = 0; y != roi.top(); ++y)
+                decoder->nextScanline();
+            return Diff2D(roi.left(), 0);
+        }
+
+        // Finish reading 'roi': codecs may complain when closed before
+        // all scanlines were read, so abort instead.
+        inline void
+        finish_region_of_interest(Decoder* decoder, Rect2D const & roi)
+        {
+            if (roi.bottom() == (int)decoder->getHeight())
+                decoder->close();
+            else
+                decoder->abort();
+        }
+
+        // Element types that can be decoded into memory directly: 'pixel_type' is the
+        // pixel_t of the samples (or -1 if unsupported), 'bands' the number of samples.
+        template <class T>
+        struct direct_import_traits
+        {
+            enum { pixel_type = -1, bands = 1 };
+        };
+
+#define VIGRA_DIRECT_IMPORT_TRAITS(T, PIXEL_TYPE) \
+        template <> \
+        struct direct_import_traits<T> \
+        { \
+            enum { pixel_type = PIXEL_TYPE, bands = 1 }; \
+        };
+
+        VIGRA_DIRECT_IMPORT_TRAITS(UInt8, UNSIGNED_INT_8)
+        VIGRA_DIRECT_IMPORT_TRAITS(UInt16, UNSIGNED_INT_16)
+        VIGRA_DIRECT_IMPORT_TRAITS(UInt32, UNSIGNED_INT_32)
+        VIGRA_DIRECT_IMPORT_TRAITS(Int16, SIGNED_INT_16)
+        VIGRA_DIRECT_IMPORT_TRAITS(Int32, SIGNED_INT_32)
+        VIGRA_DIRECT_IMPORT_TRAITS(float, IEEE_FLOAT_32)
+        VIGRA_DIRECT_IMPORT_TRAITS(double, IEEE_FLOAT_64)
+
+#undef VIGRA_DIRECT_IMPORT_TRAITS
+
+        template <class T, int SIZE>
+        struct direct_import_traits<TinyVector<T, SIZE> >
+        {
+            enum { pixel_type = direct_import_traits<T>::bands == 1
+                                    ? (int)direct_import_traits<T>::pixel_type
+                                    : -1,
+                   bands = SIZE };
+        };
+
+        // only the default band order matches the file
+        template <class T>
+        struct direct_import_traits<RGBValue<T, 0, 1, 2> >
+        {
+            enum { pixel_type = direct_import_traits<T>::bands == 1
+                                    ? (int)direct_import_traits<T>::pixel_type
+                                    : -1,
+                   bands = 3 };
+        };
+
+        // Decode 'roi' through Decoder::readScanlines() straight into the memory of 'image'
+        // when its element type matches the file's pixel type and number of bands.
+        // Returns false (without touching the file) when a conversion is required.
+        template <class T, class S>
+        bool
+        read_image_direct(const ImageImportInfo& import_info, Rect2D const & roi,
+                          MultiArrayView<2, T, S> image)
+        {
+            typedef direct_import_traits<T> traits;
+
+            if ((int)traits::pixel_type < 0 ||
+                (int)traits::bands != import_info.numBands() ||
+                (int)traits::pixel_type != (int)pixel_t_of_string(import_info.getPixelType()))
+                return false;
+
+            VIGRA_UNIQUE_PTR<Decoder> decoder(vigra::decoder(import_info));
+            const std::ptrdiff_t sample_size = sizeof(T) / traits::bands;
+            const Diff2D skip(select_region_of_interest(decoder.get(), roi));
+
+            if (skip.x == 0)
+            {
+                decoder->readScanlines(image.data(), roi.width(), roi.height(),
+                                       image.stride(0) * sizeof(T), sample_size,
+                                       image.stride(1) * sizeof(T));
+            }
+            else
+            {
+                // the codec delivers entire rows, decode them one at a time
+                ArrayVector<T> row(decoder->getWidth());
+                for (int y = 0; y < roi.height(); ++y)
+                {
+                    decoder->readScanlines(row.data(), row.size(), 1,
+                                           sizeof(T), sample_size, 0);
+                    std::copy(row.begin() + skip.x, row.begin() + skip.x + roi.width(),
+                              image.bindOuter(y).begin());
+                }
+            }
+
+            finish_region_of_interest(decoder.get(), roi);
+            return true;
+        }
+
         template <class ValueType,
                   class ImageIterator, class ImageAccessor>
         void
-        read_image_band(Decoder* decoder,
+        read_image_band(Decoder* decoder, Rect2D const & roi,
                         ImageIterator image_iterator, ImageAccessor image_accessor)
         {
             typedef typename ImageIterator::row_iterator ImageRowIterator;
 
-            const unsigned width(decoder->getWidth());
-            const unsigned height(decoder->getHeight());
+            const Diff2D skip(select_region_of_interest(decoder, roi));
+            const unsigned width(roi.width());
+            const unsigned height(roi.height());
             const unsigned offset(decoder->getOffset());
 
             for (unsigned y = 0U; y != height; ++y)
             {
                 decoder->nextScanline();
 
-                const ValueType* scanline = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                const ValueType* scanline = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip.x * offset;
 
                 ImageRowIterator is(image_iterator.rowIterator());
                 const ImageRowIterator is_end(is + width);
@@ -96,13 +218,14 @@ namespace vigra
         template <class ValueType,
                   class ImageIterator, class ImageAccessor>
         void
-        read_image_bands(Decoder* decoder,
+        read_image_bands(Decoder* decoder, Rect2D const & roi,
                          ImageIterator image_iterator, ImageAccessor image_accessor)
         {
             typedef typename ImageIterator::row_iterator ImageRowIterator;
 
-            const unsigned width(decoder->getWidth());
-            const unsigned height(decoder->getHeight());
+            const Diff2D skip(select_region_of_interest(decoder, roi));
+            const unsigned width(roi.width());
+            const unsigned height(roi.height());
             const unsigned bands(decoder->getNumBands());
             const unsigned offset(decoder->getOffset());
             const unsigned accessor_size(image_accessor.size(image_iterator));
@@ -119,7 +242,7 @@ namespace vigra
                 {
                     decoder->nextScanline();
 
-                    scanline_0 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                    scanline_0 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip.x * offset;
                     
                     if(bands == 1)
                     {
@@ -128,8 +251,8 @@ namespace vigra
                     }
                     else
                     {
-                        scanline_1 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(1));
-                        scanline_2 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(2));
+                        scanline_1 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(1)) + skip.x * offset;
+                        scanline_2 = static_cast<const ValueType*>(decoder->currentScanlineOfBand(2)) + skip.x * offset;
                     }
                     
                     ImageRowIterator is(image_iterator.rowIterator());
@@ -159,7 +282,7 @@ namespace vigra
                 {
                     decoder->nextScanline();
                     
-                    scanlines[0] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0));
+                    scanlines[0] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(0)) + skip.x * offset;
 
                     if(bands == 1)
                     {
@@ -172,7 +295,7 @@ namespace vigra
                     {
                         for (unsigned i = 1U; i != accessor_size; ++i)
                         {
-                            scanlines[i] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(i));
+                            scanlines[i] = static_cast<const ValueType*>(decoder->currentScanlineOfBand(i)) + skip.x * offset;
                         }
                     }
                     
@@ -197,7 +320,7 @@ namespace vigra
 
         template <class ImageIterator, class ImageAccessor>
         void
-        importImage(const ImageImportInfo& import_info,
+        importImage(const ImageImportInfo& import_info, Rect2D const & roi,
                     ImageIterator image_iterator, ImageAccessor image_accessor,
                     /* isScalar? */ VigraTrueType)
         {
@@ -206,37 +329,37 @@ namespace vigra
             switch (pixel_t_of_string(decoder->getPixelType()))
             {
             case UNSIGNED_INT_8:
-                read_image_band<UInt8>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt8>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case UNSIGNED_INT_16:
-                read_image_band<UInt16>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt16>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case UNSIGNED_INT_32:
-                read_image_band<UInt32>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<UInt32>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case SIGNED_INT_16:
-                read_image_band<Int16>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<Int16>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case SIGNED_INT_32:
-                read_image_band<Int32>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<Int32>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case IEEE_FLOAT_32:
-                read_image_band<float>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<float>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case IEEE_FLOAT_64:
-                read_image_band<double>(decoder.get(), image_iterator, image_accessor);
+                read_image_band<double>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             default:
                 vigra_fail("detail::importImage<scalar>: not reached");
             }
 
-            decoder->close();
+            finish_region_of_interest(decoder.get(), roi);
         }
 
 
         template <class ImageIterator, class ImageAccessor>
         void
-        importImage(const ImageImportInfo& import_info,
+        importImage(const ImageImportInfo& import_info, Rect2D const & roi,
                     ImageIterator image_iterator, ImageAccessor image_accessor,
                     /* isScalar? */ VigraFalseType)
         {
@@ -250,31 +373,31 @@ namespace vigra
             switch (pixel_t_of_string(decoder->getPixelType()))
             {
             case UNSIGNED_INT_8:
-                read_image_bands<UInt8>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt8>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case UNSIGNED_INT_16:
-                read_image_bands<UInt16>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt16>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case UNSIGNED_INT_32:
-                read_image_bands<UInt32>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<UInt32>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case SIGNED_INT_16:
-                read_image_bands<Int16>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<Int16>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case SIGNED_INT_32:
-                read_image_bands<Int32>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<Int32>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case IEEE_FLOAT_32:
-                read_image_bands<float>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<float>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             case IEEE_FLOAT_64:
-                read_image_bands<double>(decoder.get(), image_iterator, image_accessor);
+                read_image_bands<double>(decoder.get(), roi, image_iterator, image_accessor);
                 break;
             default:
                 vigra_fail("vigra::detail::importImage<non-scalar>: not reached");
             }
 
-            decoder->close();
+            finish_region_of_interest(decoder.get(), roi);
         }
 
         template<class ValueType,
@@ -654,6 +777,12 @@ namespace vigra
         importImage(ImageImportInfo const & import_info,
                     MultiArrayView<2, T, S> image);
 
+        // read only the rectangle 'roi' of the image into an array view of the roi's size
+        template <class T, class S>
+        void
+        importImage(ImageImportInfo const & import_info, Rect2D const & roi,
+                    MultiArrayView<2, T, S> image);
+
         // resize the given array and then read the data
         template <class T, class A>
         void
@@ -713,6 +842,15 @@ namespace vigra
         ...
     }
     \endcode
+    To read only part of a large image, pass the desired rectangle. Codecs that support it
+    (currently TIFF, including tiled TIFF) only decode the strips or tiles intersecting
+    the rectangle, all others decode the image up to the rectangle's last row:
+    \code
+    ImageImportInfo info("huge.tif");
+    MultiArray<2, UInt8> crop(1000, 1000);
+    importImage(info, Rect2D(Point2D(50000, 50000), Size2D(1000, 1000)), crop);
+    \endcode
+    
     When the type of input image is already known, this can be shortened:
     \code
     // create empty float image
@@ -794,7 +932,20 @@ namespace vigra
         typedef typename ImageAccessor::value_type ImageValueType;
         typedef typename NumericTraits<ImageValueType>::isScalar is_scalar;
 
-        detail::importImage(import_info,
+        detail::importImage(import_info, Rect2D(Size2D(import_info.width(), import_info.height())),
+                    image_iterator, image_accessor,
+                    is_scalar());
+    }
+
+    template <class ImageIterator, class ImageAccessor>
+    inline void
+    importImage(const ImageImportInfo& import_info, Rect2D const & roi,
+                ImageIterator image_iterator, ImageAccessor image_accessor)
+    {
+        typedef typename ImageAccessor::value_type ImageValueType;
+        typedef typename NumericTraits<ImageValueType>::isScalar is_scalar;
+
+        detail::importImage(import_info, roi,
                     image_iterator, image_accessor,
                     is_scalar());
     }
@@ -809,6 +960,15 @@ namespace vigra
                     image.first, image.second);
     }
 
+    template <class ImageIterator, class ImageAccessor>
+    inline void
+    importImage(ImageImportInfo const & import_info, Rect2D const & roi,
+                pair<ImageIterator, ImageAccessor> image)
+    {
+        importImage(import_info, roi,
+                    image.first, image.second);
+    }
+
     template <class T, class S>
     inline void
     importImage(ImageImportInfo const & import_info,
@@ -816,7 +976,28 @@ namespace vigra
     {
         vigra_precondition(import_info.shape() == image.shape(),
             "importImage(): shape mismatch between input and output.");
-        importImage(import_info, destImage(image));
+        if (!detail::read_image_direct(import_info, Rect2D(Size2D(import_info.width(), import_info.height())), image))
+            importImage(import_info, destImage(image));
+    }
+
+    template <class T, class S>
+    inline void
+    importImage(ImageImportInfo const & import_info, Rect2D const & roi,
+                MultiArrayView<2, T, S> image)
+    {
+        vigra_precondition(image.shape() == Shape2(roi.width(), roi.height()),
+            "importImage(): shape mismatch between region of interest and output.");
+        if (!detail::read_image_direct(import_info, roi, image))
+            importImage(import_info, roi,
+                        destImage(image).first, destImage(image).second);
+    }
+
+    template <class T, class A>
+    inline void
+    importImage(ImageImportInfo const & import_info, Rect2D const & roi,
+                MultiArray<2, T, A> & image)
+    {
+        importImage(import_info, roi, static_cast<MultiArrayView<2, T> &>(image));
     }
 
     template <class T, class A>
@@ -826,7 +1007,7 @@ namespace vigra
     {
         ImageImportInfo info(name);
         image.reshape(info.shape());
-        importImage(info, destImage(image));
+        importImage(info, static_cast<MultiArrayView<2, T> &>(image));
     }
 
     template <class T, class A>
@@ -1020,6 +1201,167 @@ namespace vigra
         exportImage(srcImageRange(image), export_info);
     }
 
+    namespace detail
+    {
+        // Pass bands of rows obtained from 'band_source' to the encoder without
+        // conversion, so that only one band has to be in memory at any time.
+        template <class T, class BandSource>
+        void
+        exportImageBands(Shape2 const & shape, BandSource & band_source,
+                         ImageExportInfo const & export_info, MultiArrayIndex band_height)
+        {
+            typedef direct_import_traits<T> traits;
+
+            vigra_precondition((int)traits::pixel_type >= 0,
+                "exportImageBands(): element type must be a scalar, TinyVector, or RGBValue "
+                "of a pixel type supported by the codecs.");
+            vigra_precondition(shape[0] > 0 && shape[1] > 0,
+                "exportImageBands(): image shape must be positive.");
+            vigra_precondition(!export_info.hasForcedRangeMapping(),
+                "exportImageBands(): range mapping is not possible when the image is streamed.");
+
+            VIGRA_UNIQUE_PTR<Encoder> encoder(vigra::encoder(export_info));
+
+            const std::string source_type(string_of_pixel_t((pixel_t)traits::pixel_type));
+            std::string pixel_type(export_info.getPixelType());
+            const bool downcast(negotiatePixelType(encoder->getFileType(), source_type, pixel_type));
+            vigra_precondition(!downcast && pixel_type == source_type,
+                "exportImageBands(): file type must support the element type of the bands without conversion.");
+
+            encoder->setPixelType(pixel_type);
+            encoder->setWidth(shape[0]);
+            encoder->setHeight(shape[1]);
+            encoder->setNumBands(traits::bands);
+            encoder->finalizeSettings();
+
+            if (band_height <= 0)
+                band_height = std::max<MultiArrayIndex>(1, (1 << 20) / (shape[0] * sizeof(T)));
+            band_height = std::min(band_height, shape[1]);
+
+            const unsigned int sample_size = sizeof(T) / traits::bands;
+            MultiArray<2, T> buffer(Shape2(shape[0], band_height));
+            for (MultiArrayIndex y = 0; y < shape[1]; y += band_height)
+            {
+                const MultiArrayIndex rows = std::min(band_height, shape[1] - y);
+                MultiArrayView<2, T> band(buffer.subarray(Shape2(0, 0), Shape2(shape[0], rows)));
+                band_source(band, y);
+                encoder->writeScanlines(band.data(), shape[0], rows, traits::bands, sample_size,
+                                        sizeof(T), sample_size, band.stride(1) * sizeof(T));
+            }
+
+            encoder->close();
+        }
+
+        // Band source reading the rows of a chunked array.
+        template <class T>
+        struct ChunkedArrayBandSource
+        {
+            ChunkedArray<2, T> const & array;
+
+            ChunkedArrayBandSource(ChunkedArray<2, T> const & a)
+            : array(a)
+            {}
+
+            void operator()(MultiArrayView<2, T> band, MultiArrayIndex y) const
+            {
+                array.checkoutSubarray(Shape2(0, y), band);
+            }
+        };
+    } // namespace detail
+
+/** \brief Write an image to a file one band of rows at a time.
+
+    The image is not passed as a whole: <tt>band_source(band, y)</tt> is called for
+    successive bands of rows and must fill the <tt>MultiArrayView<2, T></tt> <tt>band</tt>
+    with rows <tt>y</tt> to <tt>y + band.shape(1) - 1</tt> of the image. Only one band is
+    held in memory, and the codec consumes it before the next one is requested, so images
+    larger than the available memory (e.g. computed on the fly or stored in a
+    \ref vigra::ChunkedArray) can be written. The second overload streams a
+    <tt>ChunkedArray<2, T></tt>, using its chunk height as the band height.
+
+    If <tt>band_height</tt> is not positive, bands of about 1 MB are used. Since the image
+    is never seen as a whole, no range mapping is possible: the element type <tt>T</tt>
+    must be a scalar, <tt>TinyVector</tt>, or <tt>RGBValue</tt> of a pixel type the file
+    format stores natively (e.g. <tt>UInt8</tt> or <tt>UInt16</tt> for PNG), and
+    <tt>export_info</tt> may not request a different pixel type or a forced range mapping.
+
+    Combine this with <tt>ImageExportInfo::setNumThreads()</tt> to compress PNG and
+    DEFLATE-compressed TIFF files in parallel while the bands are produced.
+
+    <B>Declarations</B>
+
+    \code
+    namespace vigra {
+        template <class T, class BandSource>
+        void
+        exportImageBands(Shape2 const & shape, BandSource band_source,
+                         ImageExportInfo const & export_info,
+                         MultiArrayIndex band_height = 0);
+
+        template <class T>
+        void
+        exportImageBands(ChunkedArray<2, T> const & array,
+                         ImageExportInfo const & export_info);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <B>\#include</B> \<vigra/impex.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    // a 100000 x 100000 gradient image that never exists in memory as a whole
+    exportImageBands<UInt8>(Shape2(100000, 100000),
+        [](MultiArrayView<2, UInt8> band, MultiArrayIndex y)
+        {
+            for (MultiArrayIndex j = 0; j < band.shape(1); ++j)
+                for (MultiArrayIndex i = 0; i < band.shape(0); ++i)
+                    band(i, j) = (i + y + j) % 256;
+        },
+        ImageExportInfo("gradient.png").setNumThreads(-1));
+
+    ChunkedArrayCompressed<2, UInt16> big(Shape2(50000, 50000));
+    ...
+    exportImageBands(big, ImageExportInfo("big.tif").setCompression("DEFLATE"));
+    \endcode
+
+    <B>Preconditions</B>
+
+    - The image file must be writable,
+    - the file type must be one of the supported file types and
+    - support the element type <tt>T</tt> without conversion.
+*/
+    doxygen_overloaded_function(template <...> void exportImageBands)
+
+    template <class T, class BandSource>
+    void
+    exportImageBands(Shape2 const & shape, BandSource band_source,
+                     ImageExportInfo const & export_info,
+                     MultiArrayIndex band_height = 0)
+    {
+        try
+        {
+            detail::exportImageBands<T>(shape, band_source, export_info, band_height);
+        }
+        catch (Encoder::TIFFCompressionException&)
+        {
+            ImageExportInfo info(export_info);
+
+            info.setCompression("");
+            detail::exportImageBands<T>(shape, band_source, info, band_height);
+        }
+    }
+
+    template <class T>
+    inline void
+    exportImageBands(ChunkedArray<2, T> const & array,
+                     ImageExportInfo const & export_info)
+    {
+        exportImageBands<T>(array.shape(), detail::ChunkedArrayBandSource<T>(array),
+                            export_info, array.chunkShape(1));
+    }
+
 /** @} */
 
 } // end namespace vigra
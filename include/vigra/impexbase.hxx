@@ -102,6 +102,32 @@ namespace vigra
         }
 
 
+        inline static std::string
+        string_of_pixel_t(pixel_t pixel_type)
+        {
+            switch (pixel_type)
+            {
+            case UNSIGNED_INT_8:
+                return "UINT8";
+            case UNSIGNED_INT_16:
+                return "UINT16";
+            case UNSIGNED_INT_32:
+                return "UINT32";
+            case SIGNED_INT_16:
+                return "INT16";
+            case SIGNED_INT_32:
+                return "INT32";
+            case IEEE_FLOAT_32:
+                return "FLOAT";
+            case IEEE_FLOAT_64:
+                return "DOUBLE";
+            default:
+                vigra_fail("vigra_ext::detail::string_of_pixel_t: unknown pixel type");
+                return ""; // NOT REACHED
+            }
+        }
+
+
         struct identity
         {
             template <typename T>
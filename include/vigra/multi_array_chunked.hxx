@@ -131,6 +131,7 @@
 
 #include <queue>
 #include <string>
+#include <exception>
 
 #include "multi_fwd.hxx"
 #include "multi_handle.hxx"
@@ -138,6 +139,7 @@
 #include "memory.hxx"
 #include "metaprogramming.hxx"
 #include "threading.hxx"
+#include "threadpool.hxx"
 #include "compression.hxx"
 
 #ifdef _WIN32
@@ -1273,6 +1275,8 @@ class ChunkedArrayOptions
     : fill_value(0.0)
     , cache_max(-1)
     , compression_method(DEFAULT_COMPRESSION)
+    , write_behind_threads(0)
+    , write_behind_bytes(0)
     {}
 
     /** \brief Element value for read-only access of uninitialized chunks.
@@ -1320,11 +1324,110 @@ class ChunkedArrayOptions
         return ChunkedArrayOptions(*this).compression(v);
     }
 
+    /** \brief Unload chunks evicted from the cache in background threads.
+
+        When 'threads' is positive, chunks evicted from the cache are handed to
+        a queue served by 'threads' worker threads, which compress them
+        (ChunkedArrayCompressed) or write them to disk (ChunkedArrayHDF5)
+        while the thread that caused the eviction continues. At most
+        'max_bytes' of evicted chunk data are held by the queue (0 means four
+        chunks per thread), further evictions block until a write finishes.
+        ChunkedArray::flush() waits until the queue is empty.
+
+        Default: 0 (the evicting thread unloads chunks itself)
+    */
+    ChunkedArrayOptions & writeBehind(int threads, std::size_t max_bytes = 0)
+    {
+        write_behind_threads = threads;
+        write_behind_bytes = max_bytes;
+        return *this;
+    }
+
+    ChunkedArrayOptions writeBehind(int threads, std::size_t max_bytes = 0) const
+    {
+        return ChunkedArrayOptions(*this).writeBehind(threads, max_bytes);
+    }
+
     double fill_value;
     int cache_max;
     CompressionMethod compression_method;
+    int write_behind_threads;
+    std::size_t write_behind_bytes;
 };
 
+namespace detail {
+
+    // queue of evicted chunks waiting to be unloaded by background
+    // threads (see ChunkedArrayOptions::writeBehind())
+struct ChunkWriteBehind
+{
+    ChunkWriteBehind(int threads, std::size_t max_bytes)
+    : max_bytes_(max_bytes)
+    , bytes_(0)
+    , pending_(0)
+    , pool_(threads)
+    {}
+
+    ~ChunkWriteBehind()
+    {
+        wait(false);
+    }
+
+        // reserve space for a chunk of the given size, block while the queue is full
+    void acquire(std::size_t bytes)
+    {
+        threading::unique_lock<threading::mutex> lock(mutex_);
+        while(pending_ > 0 && bytes_ + bytes > max_bytes_)
+            done_.wait(lock);
+        bytes_ += bytes;
+        ++pending_;
+    }
+
+    void release(std::size_t bytes)
+    {
+        threading::lock_guard<threading::mutex> guard(mutex_);
+        bytes_ -= bytes;
+        --pending_;
+        done_.notify_all();
+    }
+
+    void fail(std::exception_ptr error)
+    {
+        threading::lock_guard<threading::mutex> guard(mutex_);
+        if(!error_)
+            error_ = error;
+    }
+
+        // wait until the queue is empty, and rethrow the first
+        // exception of a background write if requested
+    void wait(bool rethrow)
+    {
+        threading::unique_lock<threading::mutex> lock(mutex_);
+        while(pending_ > 0)
+            done_.wait(lock);
+        if(rethrow && error_)
+        {
+            std::exception_ptr error = error_;
+            error_ = std::exception_ptr();
+            std::rethrow_exception(error);
+        }
+    }
+
+    template <class F>
+    void enqueue(F && f)
+    {
+        pool_.enqueue(std::forward<F>(f));
+    }
+
+    threading::mutex mutex_;
+    threading::condition_variable done_;
+    std::size_t max_bytes_, bytes_, pending_;
+    std::exception_ptr error_;
+    ThreadPool pool_;  // declared last to join the workers first
+};
+
+} // namespace detail
+
 /** \weakgroup ParallelProcessing
     \sa ChunkedArray
  */
@@ -1528,7 +1631,6 @@ class ChunkedArray
     * backends:
        * allocators are not used
        * HDF5 only works for scalar types so far
-       * HDF5 must support read-only and read/write mode
        * temp file arrays in swap (just an API addition to the constructor)
        * support TIFF chunked reading
     * the array implementations should go into cxx files in src/impex
@@ -1632,12 +1734,19 @@ class ChunkedArray
     , fill_value_(T(options.fill_value))
     , fill_scalar_(options.fill_value)
     , handle_array_(detail::computeChunkArrayShape(shape, bits_, mask_))
-    , data_bytes_()
+    , data_bytes_(0)
     , overhead_bytes_(handle_array_.size()*sizeof(Handle))
     {
         fill_value_chunk_.pointer_ = &fill_value_;
         fill_value_handle_.pointer_ = &fill_value_chunk_;
         fill_value_handle_.chunk_state_.store(1);
+        if(options.write_behind_threads > 0)
+        {
+            std::size_t max_bytes = options.write_behind_bytes > 0
+                                        ? options.write_behind_bytes
+                                        : 4*options.write_behind_threads*prod(this->chunk_shape_)*sizeof(T);
+            write_behind_.reset(new detail::ChunkWriteBehind(options.write_behind_threads, max_bytes));
+        }
     }
 
     // compute masks needed for fast index access
@@ -2007,6 +2116,12 @@ class ChunkedArray
             {
                 vigra_invariant(handle != &fill_value_handle_,
                    "ChunkedArray::releaseChunk(): attempt to release fill_value_handle_.");
+                if(write_behind_ && !destroy)
+                {
+                    // the chunk stays locked until a background thread has unloaded it
+                    unloadChunkAsync(handle);
+                    return rc;
+                }
                 Chunk * chunk = handle->pointer_;
                 this->data_bytes_ -= dataBytes(chunk);
                 int didDestroy = unloadChunk(chunk, destroy);
@@ -2025,6 +2140,61 @@ class ChunkedArray
         return rc;
     }
 
+    // NOTE: This function must only be called while we hold the chunk_lock_
+    //       and the chunk is locked.
+    void unloadChunkAsync(Handle * handle)
+    {
+        std::size_t bytes = dataBytes(handle->pointer_);
+        write_behind_->acquire(bytes);
+        this->data_bytes_ -= bytes;
+        try
+        {
+            write_behind_->enqueue(
+                [this, handle, bytes](int)
+                {
+                    long state = chunk_failed;
+                    try
+                    {
+                        if(this->unloadChunk(handle->pointer_, false))
+                            state = chunk_uninitialized;
+                        else
+                            state = chunk_asleep;
+                        this->data_bytes_ += this->dataBytes(handle->pointer_);
+                    }
+                    catch(...)
+                    {
+                        write_behind_->fail(std::current_exception());
+                    }
+                    handle->chunk_state_.store(state);
+                    write_behind_->release(bytes);
+                });
+        }
+        catch(...)
+        {
+            write_behind_->release(bytes);
+            throw;
+        }
+    }
+
+    /** \brief Wait until all chunks evicted so far have been unloaded.
+
+        Only relevant when the array was constructed with
+        ChunkedArrayOptions::writeBehind(). Rethrows the first exception
+        raised by a background write since the last call.
+    */
+    void flush()
+    {
+        if(write_behind_)
+            write_behind_->wait(true);
+    }
+
+    // like flush(), but doesn't report errors (for use in destructors)
+    void joinWriteBehind()
+    {
+        if(write_behind_)
+            write_behind_->wait(false);
+    }
+
     // NOTE: this function must only be called while we hold the chunk_lock_
     void cleanCache(int how_many = -1)
     {
@@ -2482,7 +2652,9 @@ class ChunkedArray
     value_type fill_value_;
     double fill_scalar_;
     MultiArray<N, Handle> handle_array_;
-    std::size_t data_bytes_, overhead_bytes_;
+    threading::atomic<std::size_t> data_bytes_;
+    std::size_t overhead_bytes_;
+    VIGRA_SHARED_PTR<detail::ChunkWriteBehind> write_behind_;
 };
 
 /** Returns a CoupledScanOrderIterator to simultaneously iterate over image m1 and its coordinates.
@@ -2754,6 +2926,7 @@ class ChunkedArrayLazy
 
     ~ChunkedArrayLazy()
     {
+        this->joinWriteBehind();
         typename ChunkStorage::iterator i   = this->handle_array_.begin(),
                                         end = this->handle_array_.end();
         for(; i != end; ++i)
@@ -2933,6 +3106,7 @@ class ChunkedArrayCompressed
 
     ~ChunkedArrayCompressed()
     {
+        this->joinWriteBehind();
         typename ChunkStorage::iterator i   = this->handle_array_.begin(),
                                         end = this->handle_array_.end();
         for(; i != end; ++i)
@@ -3187,6 +3361,7 @@ class ChunkedArrayTmpFile
 
     ~ChunkedArrayTmpFile()
     {
+        this->joinWriteBehind();
         typename ChunkStorage::iterator  i = this->handle_array_.begin(),
                                          end = this->handle_array_.end();
         for(; i != end; ++i)
@@ -37,6 +37,7 @@
 #define VIGRA_MULTI_ARRAY_CHUNKED_HDF5_HXX
 
 #include <queue>
+#include <cstring>
 
 #include "multi_array_chunked.hxx"
 #include "hdf5impex.hxx"
@@ -51,6 +52,29 @@
 
 namespace vigra {
 
+namespace detail {
+
+    // Fast non-cryptographic checksum, used to detect whether a chunk
+    // was modified while it was in memory.
+inline UInt64 chunkChecksum(void const * data, std::size_t size)
+{
+    char const * p = static_cast<char const *>(data);
+    UInt64 h = 0xcbf29ce484222325ull;
+    std::size_t k = 0;
+    for(; k + sizeof(UInt64) <= size; k += sizeof(UInt64))
+    {
+        UInt64 w;
+        std::memcpy(&w, p + k, sizeof(UInt64));
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 32;
+    }
+    for(; k < size; ++k)
+        h = (h ^ static_cast<unsigned char>(p[k])) * 0x100000001b3ull;
+    return h;
+}
+
+} // namespace detail
+
 /** \addtogroup ChunkedArrayClasses
 */
 //@{
@@ -99,11 +123,15 @@ class ChunkedArrayHDF5
         , start_(start)
         , array_(array)
         , alloc_(alloc)
+        , checksum_(0)
         {}
 
         ~Chunk()
         {
-            write();
+            if(array_->copy_on_write_)
+                deallocate();
+            else
+                write();
         }
 
         std::size_t size() const
@@ -115,18 +143,32 @@ class ChunkedArrayHDF5
         {
             if(this->pointer_ != 0)
             {
-                if(!array_->file_.isReadOnly())
+                if(array_->copy_on_write_)
                 {
-                    herr_t status = array_->file_.writeBlock(array_->dataset_, start_,
-                                          MultiArrayView<N, T>(shape_, this->strides_, this->pointer_));
-                    vigra_postcondition(status >= 0,
-                        "ChunkedArrayHDF5: write to dataset failed.");
+                    // only modified chunks go to the scratch store
+                    UInt64 checksum = detail::chunkChecksum(this->pointer_, this->size()*sizeof(T));
+                    if(checksum != checksum_)
+                    {
+                        ::vigra::compress((char const *)this->pointer_, this->size()*sizeof(T),
+                                          scratch_, array_->compression_);
+                        checksum_ = checksum;
+                    }
                 }
-                if(deallocate)
+                else if(!array_->file_.isReadOnly())
                 {
-                    alloc_.deallocate(this->pointer_, this->size());
-                    this->pointer_ = 0;
+                    array_->writeChunk(start_, shape_, this->pointer_);
                 }
+                if(deallocate)
+                    this->deallocate();
+            }
+        }
+
+        void deallocate()
+        {
+            if(this->pointer_ != 0)
+            {
+                alloc_.deallocate(this->pointer_, this->size());
+                this->pointer_ = 0;
             }
         }
 
@@ -135,10 +177,14 @@ class ChunkedArrayHDF5
             if(this->pointer_ == 0)
             {
                 this->pointer_ = alloc_.allocate(this->size());
-                herr_t status = array_->file_.readBlock(array_->dataset_, start_, shape_,
-                                     MultiArrayView<N, T>(shape_, this->strides_, this->pointer_));
-                vigra_postcondition(status >= 0,
-                    "ChunkedArrayHDF5: read from dataset failed.");
+                if(scratch_.size() > 0)
+                    ::vigra::uncompress(scratch_.data(), scratch_.size(),
+                                        (char*)this->pointer_, this->size()*sizeof(T),
+                                        array_->compression_);
+                else
+                    array_->readChunk(start_, shape_, this->pointer_);
+                if(array_->copy_on_write_)
+                    checksum_ = detail::chunkChecksum(this->pointer_, this->size()*sizeof(T));
             }
             return this->pointer_;
         }
@@ -146,6 +192,8 @@ class ChunkedArrayHDF5
         shape_type shape_, start_;
         ChunkedArrayHDF5 * array_;
         Alloc alloc_;
+        ArrayVector<char> scratch_;  // copy-on-write mode: modified data (compressed)
+        UInt64 checksum_;            // copy-on-write mode: checksum of the data last read or saved
 
       private:
         Chunk & operator=(Chunk const &);
@@ -175,6 +223,11 @@ class ChunkedArrayHDF5
                                 request this mode when the dataset doesn't exist.
         <li>HDF5File::Default: Resolves to ReadOnly when the dataset exists, and
                                to New otherwise.
+        <li>HDF5File::ReadOnlyShared: Same as ReadOnly. Open 'file' in this mode as well
+                                      when many processes read the same dataset.
+        <li>HDF5File::CopyOnWrite: Open an existing dataset for reading and writing,
+                                   but never modify the file. Modified chunks are
+                                   kept in memory instead (see below).
         </ul>
         The supported compression algorithms are:
         <ul>
@@ -183,6 +236,11 @@ class ChunkedArrayHDF5
         <li>ZLIB_NONE: Use 'zlib' format without compression.
         <li>DEFAULT_COMPRESSION: Same as ZLIB_FAST.
         </ul>
+        In CopyOnWrite mode, the file is treated as read-only. When a chunk is
+        evicted from the cache, a checksum tells whether it was modified. If so,
+        it is compressed into an in-memory scratch store (using 'compression_method',
+        where DEFAULT_COMPRESSION means LZ4) and read from there on the next access.
+        Unmodified chunks are simply dropped.
     */
     ChunkedArrayHDF5(HDF5File const & file, std::string const & dataset,
                      HDF5File::OpenMode mode,
@@ -195,7 +253,9 @@ class ChunkedArrayHDF5
       dataset_name_(dataset),
       dataset_(),
       compression_(options.compression_method),
-      alloc_(alloc)
+      alloc_(alloc),
+      direct_io_(false),
+      copy_on_write_(false)
     {
         init(mode);
     }
@@ -213,6 +273,10 @@ class ChunkedArrayHDF5
                                  to request this mode when 'file' is read-only.
         <li>HDF5File::ReadOnly: Open the dataset for reading (default).
         <li>HDF5File::Default: Same as ReadOnly.
+        <li>HDF5File::ReadOnlyShared: Same as ReadOnly.
+        <li>HDF5File::CopyOnWrite: Open the dataset for reading and writing, but
+                                   keep modified chunks in memory instead of writing
+                                   them back.
         </ul>
         The supported compression algorithms are:
         <ul>
@@ -221,6 +285,11 @@ class ChunkedArrayHDF5
         <li>ZLIB_NONE: Use 'zlib' format without compression.
         <li>DEFAULT_COMPRESSION: Same as ZLIB_FAST.
         </ul>
+        In CopyOnWrite mode, the file is treated as read-only. When a chunk is
+        evicted from the cache, a checksum tells whether it was modified. If so,
+        it is compressed into an in-memory scratch store (using 'compression_method',
+        where DEFAULT_COMPRESSION means LZ4) and read from there on the next access.
+        Unmodified chunks are simply dropped.
     */
     ChunkedArrayHDF5(HDF5File const & file, std::string const & dataset,
                      HDF5File::OpenMode mode = HDF5File::ReadOnly,
@@ -231,7 +300,9 @@ class ChunkedArrayHDF5
       dataset_name_(dataset),
       dataset_(),
       compression_(options.compression_method),
-      alloc_(alloc)
+      alloc_(alloc),
+      direct_io_(false),
+      copy_on_write_(false)
     {
         init(mode);
     }
@@ -252,7 +323,19 @@ class ChunkedArrayHDF5
                 mode = HDF5File::New;
         }
 
-        if(mode == HDF5File::ReadOnly)
+        if(mode == HDF5File::ReadOnlyShared)
+            mode = HDF5File::ReadOnly;
+
+        if(mode == HDF5File::CopyOnWrite)
+        {
+            vigra_precondition(exists,
+                "ChunkedArrayHDF5(): copy-on-write mode requires an existing dataset.");
+            copy_on_write_ = true;
+            if(compression_ == DEFAULT_COMPRESSION)
+                compression_ = LZ4;
+            file_.setReadOnly();
+        }
+        else if(mode == HDF5File::ReadOnly)
             file_.setReadOnly();
         else
             vigra_precondition(!file_.isReadOnly(),
@@ -263,23 +346,10 @@ class ChunkedArrayHDF5
 
         if(!exists || mode == HDF5File::New)
         {
-            // FIXME: set rdcc_nbytes to 0 (disable cache, because we don't
-            //        need two caches
-            // H5Pset_chunk_cache (dapl, rdcc_nslots, rdcc_nbytes, rdcc_w0);
-            // Chunk cache size (rdcc_nbytes) should be large
-            // enough to hold all the chunks in a selection
-            // * If this is not possible, it may be best to disable chunk
-            // caching altogether (set rdcc_nbytes to 0)
-            // * rdcc_slots should be a prime number that is at
-            // least 10 to 100 times the number of chunks that can fit
-            // into rdcc_nbytes
-            // * rdcc_w0 should be set to 1 if chunks that have been
-            // fully read/written will never be read/written again
-            //
-            // the above may be WRONG in general - it may only apply if the
-            // chunk size in the file matches the chunk size in the CachedArray.
-            // Otherwise, make sure that the file cache can hold at least as many
-            // chunks as are needed for a single array chunk.
+            // When the file's chunk shape equals ours, chunks bypass the HDF5
+            // chunk cache (see readChunk()). Otherwise, the cache (configured by
+            // HDF5File::setChunkCache()) should hold all file chunks overlapping
+            // one array chunk.
             if(compression_ == DEFAULT_COMPRESSION)
                 compression_ = ZLIB_FAST;
             vigra_precondition(compression_ != LZ4,
@@ -341,6 +411,85 @@ class ChunkedArrayHDF5
                 i->chunk_state_.store(base_type::chunk_asleep);
             }
         }
+
+        typedef detail::HDF5TypeTraits<T> TypeTraits;
+        codec_ = detail::HDF5ChunkCodec(dataset_, TypeTraits::getH5DataType(),
+                                        TypeTraits::numberOfBands(), N, sizeof(T));
+        direct_io_ = codec_.supported();
+        for(unsigned int k=0; k<N && direct_io_; ++k)
+            direct_io_ = codec_.chunkShape()[N-1-k] == (hsize_t)this->chunk_shape_[k];
+    }
+
+        // Transfer a chunk between memory and file. When the file's chunk shape
+        // equals ours, raw chunks are exchanged via H5Dread_chunk()/H5Dwrite_chunk()
+        // and (de-)compressed by the calling thread, so that only the raw I/O is
+        // serialized. Otherwise, the HDF5 filter pipeline is used.
+    void readChunk(shape_type const & start, shape_type const & shape, pointer p)
+    {
+        if(!direct_io_)
+        {
+            threading::lock_guard<threading::mutex> guard(hdf5_lock_);
+            herr_t status = file_.readBlock(dataset_, start, shape, MultiArrayView<N, T>(shape, p));
+            vigra_postcondition(status >= 0,
+                "ChunkedArrayHDF5: read from dataset failed.");
+            return;
+        }
+
+        ArrayVector<hsize_t> fileOffset(codec_.chunkShape().size(), 0);
+        for(unsigned int k=0; k<N; ++k)
+            fileOffset[N-1-k] = start[k];
+        ArrayVector<char> raw, scratch;
+        unsigned int filterMask = 0;
+        bool allocated;
+        {
+            threading::lock_guard<threading::mutex> guard(hdf5_lock_);
+            allocated = codec_.readRaw(dataset_, fileOffset.data(), raw, filterMask);
+        }
+
+        // chunks at the array border are padded to full size in the file
+        MultiArray<N, T> buffer;
+        if(shape != this->chunk_shape_)
+            buffer.reshape(this->chunk_shape_);
+        char * dest = shape == this->chunk_shape_
+                         ? reinterpret_cast<char *>(p)
+                         : reinterpret_cast<char *>(buffer.data());
+        if(allocated)
+            codec_.decode(raw.data(), raw.size(), filterMask, dest, scratch);
+        else
+            codec_.fill(dest);
+        if(shape != this->chunk_shape_)
+            MultiArrayView<N, T>(shape, p) = buffer.subarray(shape_type(), shape);
+    }
+
+    void writeChunk(shape_type const & start, shape_type const & shape, pointer p)
+    {
+        if(!direct_io_)
+        {
+            threading::lock_guard<threading::mutex> guard(hdf5_lock_);
+            herr_t status = file_.writeBlock(dataset_, start, MultiArrayView<N, T>(shape, p));
+            vigra_postcondition(status >= 0,
+                "ChunkedArrayHDF5: write to dataset failed.");
+            return;
+        }
+
+        ArrayVector<char> raw, scratch;
+        if(shape == this->chunk_shape_)
+        {
+            codec_.encode(reinterpret_cast<char const *>(p), raw, scratch);
+        }
+        else
+        {
+            MultiArray<N, T> buffer(this->chunk_shape_);
+            codec_.fill(reinterpret_cast<char *>(buffer.data()));
+            buffer.subarray(shape_type(), shape) = MultiArrayView<N, T>(shape, p);
+            codec_.encode(reinterpret_cast<char const *>(buffer.data()), raw, scratch);
+        }
+
+        ArrayVector<hsize_t> fileOffset(codec_.chunkShape().size(), 0);
+        for(unsigned int k=0; k<N; ++k)
+            fileOffset[N-1-k] = start[k];
+        threading::lock_guard<threading::mutex> guard(hdf5_lock_);
+        codec_.writeRaw(dataset_, fileOffset.data(), raw);
     }
 
     ~ChunkedArrayHDF5()
@@ -366,8 +515,11 @@ class ChunkedArrayHDF5
 
     void flushToDiskImpl(bool destroy, bool force_destroy)
     {
-        if(file_.isReadOnly())
-            return;
+        // chunks in the write-behind queue must reach the file first
+        if(force_destroy)
+            this->joinWriteBehind();
+        else
+            this->flush();
 
         threading::lock_guard<threading::mutex> guard(*this->chunk_lock_);
         typename ChunkStorage::iterator i   = this->handle_array_.begin(),
@@ -396,12 +548,20 @@ class ChunkedArrayHDF5
                 chunk->write(false);
             }
         }
-        file_.flushToDisk();
+        if(!file_.isReadOnly())
+            file_.flushToDisk();
     }
 
     virtual bool isReadOnly() const
     {
-        return file_.isReadOnly();
+        return file_.isReadOnly() && !copy_on_write_;
+    }
+
+        /** \brief Check if the array was opened in HDF5File::CopyOnWrite mode.
+        */
+    bool isCopyOnWrite() const
+    {
+        return copy_on_write_;
     }
 
     virtual pointer loadChunk(ChunkBase<N, T> ** p, shape_type const & index)
@@ -431,9 +591,11 @@ class ChunkedArrayHDF5
 
     virtual std::size_t dataBytes(ChunkBase<N,T> * c) const
     {
-        return c->pointer_ == 0
+        Chunk * chunk = static_cast<Chunk*>(c);
+        return chunk->scratch_.size() +
+               (c->pointer_ == 0
                  ? 0
-                 : static_cast<Chunk*>(c)->size()*sizeof(T);
+                 : chunk->size()*sizeof(T));
     }
 
     virtual std::size_t overheadBytesPerChunk() const
@@ -456,6 +618,10 @@ class ChunkedArrayHDF5
     HDF5HandleShared dataset_;
     CompressionMethod compression_;
     Alloc alloc_;
+    detail::HDF5ChunkCodec codec_;
+    bool direct_io_;
+    bool copy_on_write_;
+    threading::mutex hdf5_lock_;
 };
 
 //@}
@@ -0,0 +1,465 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_ARRAY_CHUNKED_PYRAMID_HXX
+#define VIGRA_MULTI_ARRAY_CHUNKED_PYRAMID_HXX
+
+#include <algorithm>
+#include "multi_array_chunked.hxx"
+#include "multi_iterator_coupled.hxx"
+#include "numerictraits.hxx"
+
+namespace vigra {
+
+/** \brief How a pyramid level is computed from the next finer level.
+
+    See \ref ChunkedArrayPyramid.
+*/
+enum PyramidReduction
+{
+    PyramidMean,     ///< average of each 2x...x2 block (good for intensity data)
+    PyramidMode,     ///< most frequent value of each 2x...x2 block (for label images)
+    PyramidGaussian  ///< Burt filter [0.05, 0.25, 0.4, 0.25, 0.05] followed by subsampling
+};
+
+namespace detail {
+
+    // Separable reduction by factor 2 along 'axis'. 'src' is a block of the finer
+    // level starting at global coordinate 'src_start[axis]' along 'axis', 'dest'
+    // receives the coarser level starting at 'dest_start[axis]'. Source coordinates
+    // outside [0, src_size) are reflected (Gaussian) or clamped (mean).
+template <unsigned int N, class T1, class S1, class T2, class S2, class Shape>
+void
+pyramidReduceAxis(MultiArrayView<N, T1, S1> const & src, Shape const & src_start, Shape const & src_size,
+                  MultiArrayView<N, T2, S2> dest, Shape const & dest_start,
+                  unsigned int axis, PyramidReduction method)
+{
+    static const double burt[5] = { 0.05, 0.25, 0.4, 0.25, 0.05 };
+    MultiArrayIndex size = src_size[axis];
+
+    typedef typename MultiArrayShape<N>::type shape_type;
+    MultiCoordinateIterator<N> i(dest.shape()), end(i.getEndIterator());
+    for(; i != end; ++i)
+    {
+        shape_type p(*i);
+        MultiArrayIndex center = 2*(p[axis] + dest_start[axis]);
+        T2 sum = T2();
+        if(method == PyramidGaussian)
+        {
+            for(int k=-2; k<=2; ++k)
+            {
+                MultiArrayIndex x = center + k;
+                if(size == 1)
+                    x = 0;
+                else
+                {
+                    // repeat the reflection, on very short axes a reflected
+                    // index may leave the opposite border
+                    while(x < 0 || x >= size)
+                        x = x < 0 ? -x : 2*size - 2 - x;
+                }
+                p[axis] = x - src_start[axis];
+                sum += burt[k+2]*src[p];
+            }
+        }
+        else
+        {
+            p[axis] = center - src_start[axis];
+            sum += 0.5*src[p];
+            if(center + 1 < size)
+                p[axis] += 1;
+            sum += 0.5*src[p];
+        }
+        dest[*i] = sum;
+    }
+}
+
+    // Most frequent value of each 2x...x2 block (ties resolve to the smallest value).
+template <unsigned int N, class T, class S1, class S2, class Shape>
+void
+pyramidReduceMode(MultiArrayView<N, T, S1> const & src, Shape const & src_start, Shape const & src_size,
+                  MultiArrayView<N, T, S2> dest, Shape const & dest_start)
+{
+    typedef typename MultiArrayShape<N>::type shape_type;
+    ArrayVector<T> values(1 << N);
+    MultiCoordinateIterator<N> i(dest.shape()), end(i.getEndIterator());
+    for(; i != end; ++i)
+    {
+        for(unsigned int k=0; k<values.size(); ++k)
+        {
+            shape_type p;
+            for(unsigned int d=0; d<N; ++d)
+            {
+                MultiArrayIndex x = 2*((*i)[d] + dest_start[d]) + ((k >> d) & 1);
+                p[d] = std::min(x, src_size[d]-1) - src_start[d];
+            }
+            values[k] = src[p];
+        }
+        std::sort(values.begin(), values.end());
+        T best = values[0];
+        unsigned int best_count = 0;
+        for(unsigned int k=0; k<values.size();)
+        {
+            unsigned int j = k+1;
+            while(j < values.size() && values[j] == values[k])
+                ++j;
+            if(j - k > best_count)
+            {
+                best = values[k];
+                best_count = j - k;
+            }
+            k = j;
+        }
+        dest[*i] = best;
+    }
+}
+
+} // namespace detail
+
+/** \addtogroup ChunkedArrayClasses
+*/
+//@{
+
+/** Implement ChunkedArray as a lazily computed, reduced version of another ChunkedArray.
+
+    <b>\#include</b> \<vigra/multi_array_chunked_pyramid.hxx\> <br/>
+    Namespace: vigra
+
+    The array's shape is <tt>(source.shape() + 1) / 2</tt>. A chunk is computed from
+    the corresponding region of the source array when it is first accessed (see
+    \ref PyramidReduction for the available methods). Afterwards, it behaves like a
+    chunk of \ref ChunkedArrayCompressed: it is compressed when evicted from the cache
+    and never recomputed unless it is explicitly released with <tt>destroy=true</tt>.
+    The array is read-only. It is usually created by \ref ChunkedArrayPyramid.
+*/
+template <unsigned int N, class T>
+class ChunkedArrayPyramidLevel
+: public ChunkedArrayCompressed<N, T>
+{
+  public:
+    typedef ChunkedArrayCompressed<N, T> base_type;
+    typedef typename base_type::Chunk Chunk;
+    typedef typename base_type::shape_type shape_type;
+    typedef T value_type;
+    typedef value_type * pointer;
+
+    /** \brief Reduce 'source' with the given 'method'.
+
+        Argument 'chunk_shape' and 'options' are interpreted as in
+        \ref ChunkedArrayCompressed. 'source' must outlive this array
+        (or be replaced via setSource()).
+    */
+    ChunkedArrayPyramidLevel(ChunkedArray<N, T> const & source,
+                             PyramidReduction method = PyramidMean,
+                             shape_type const & chunk_shape = shape_type(),
+                             ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : base_type((source.shape() + shape_type(1)) / shape_type(2), chunk_shape, options),
+      source_(&source),
+      method_(method)
+    {
+        // all chunks exist implicitly (uninitialized chunks would read as fill value)
+        typename base_type::ChunkStorage::iterator i   = this->handle_array_.begin(),
+                                                   end = this->handle_array_.end();
+        for(; i != end; ++i)
+            i->chunk_state_.store(ChunkedArray<N, T>::chunk_asleep);
+    }
+
+        /** \brief The array this level is computed from.
+        */
+    ChunkedArray<N, T> const & source() const
+    {
+        return *source_;
+    }
+
+        /** \brief Compute future chunks from 'source', which must have the
+            same shape as the current source (already computed chunks are kept).
+        */
+    void setSource(ChunkedArray<N, T> const & source)
+    {
+        vigra_precondition(source.shape() == source_->shape(),
+            "ChunkedArrayPyramidLevel::setSource(): shape mismatch.");
+        source_ = &source;
+    }
+
+    PyramidReduction reduction() const
+    {
+        return method_;
+    }
+
+    virtual bool isReadOnly() const
+    {
+        return true;
+    }
+
+    virtual pointer loadChunk(ChunkBase<N, T> ** p, shape_type const & index)
+    {
+        if(*p == 0)
+        {
+            *p = new Chunk(this->chunkShape(index));
+            this->overhead_bytes_ += sizeof(Chunk);
+        }
+        Chunk * chunk = static_cast<Chunk *>(*p);
+        bool compute = chunk->pointer_ == 0 && chunk->compressed_.size() == 0;
+        pointer res = chunk->uncompress(this->compression_method_);
+        if(compute)
+            computeChunk(index, MultiArrayView<N, T>(this->chunkShape(index), res));
+        return res;
+    }
+
+    virtual bool unloadChunk(ChunkBase<N, T> * chunk, bool destroy)
+    {
+        // destroyed chunks are recomputed on the next access
+        base_type::unloadChunk(chunk, destroy);
+        return false;
+    }
+
+    virtual std::string backend() const
+    {
+        return "ChunkedArrayPyramidLevel<" + source_->backend() + ">";
+    }
+
+  protected:
+
+    void computeChunk(shape_type const & index, MultiArrayView<N, T> dest) const
+    {
+        typedef typename NumericTraits<T>::RealPromote TmpType;
+
+        shape_type dest_start = index*this->chunk_shape_,
+                   src_size   = source_->shape(),
+                   border     = method_ == PyramidGaussian ? shape_type(2) : shape_type(),
+                   src_start  = max(dest_start + dest_start - border, shape_type()),
+                   src_stop   = min(shape_type(2)*(dest_start + dest.shape()) + border, src_size);
+
+        MultiArray<N, T> src(src_stop - src_start);
+        source_->checkoutSubarray(src_start, src);
+
+        if(method_ == PyramidMode)
+        {
+            detail::pyramidReduceMode(src, src_start, src_size, dest, dest_start);
+            return;
+        }
+
+        // reduce one axis at a time, the shrinking intermediate result
+        // uses the coarse coordinates along axes that are already done
+        MultiArray<N, TmpType> tmp(src);
+        shape_type tmp_start(src_start);
+        for(unsigned int d=0; d<N; ++d)
+        {
+            shape_type shape(tmp.shape());
+            shape[d] = dest.shape(d);
+            MultiArray<N, TmpType> reduced(shape);
+            detail::pyramidReduceAxis(tmp, tmp_start, src_size, reduced, dest_start, d, method_);
+            tmp.swap(reduced);
+            tmp_start[d] = 0;
+        }
+        typename MultiArray<N, TmpType>::iterator t = tmp.begin();
+        typename MultiArrayView<N, T>::iterator i = dest.begin(), end = dest.end();
+        for(; i != end; ++i, ++t)
+            *i = NumericTraits<T>::fromRealPromote(*t);
+    }
+
+    ChunkedArray<N, T> const * source_;
+    PyramidReduction method_;
+};
+
+/** \brief Multi-resolution pyramid on top of a ChunkedArray.
+
+    <b>\#include</b> \<vigra/multi_array_chunked_pyramid.hxx\> <br/>
+    Namespace: vigra
+
+    Level 0 is the given base array, level k+1 halves the shape of level k
+    (rounding up). Coarser levels are \ref ChunkedArrayPyramidLevel arrays,
+    so their chunks are computed on demand from the next finer level and cached
+    in memory. Requesting a chunk at level k therefore only touches the
+    regions of levels 0...k-1 that contribute to it.
+
+    A level can be made persistent by copying it into another ChunkedArray
+    (e.g. a \ref ChunkedArrayHDF5 dataset in a "pyramid" group of the base file)
+    with storeLevel(). When the file is opened again, attachLevel() reuses the
+    stored data instead of recomputing it.
+
+    \code
+    ChunkedArrayHDF5<3, float> volume(file, "volume");
+    ChunkedArrayPyramid<3, float> pyramid(volume, 4, PyramidGaussian);
+
+    MultiArray<3, float> overview(pyramid.level(3).shape());
+    pyramid.level(3).checkoutSubarray(Shape3(), overview);
+    \endcode
+*/
+template <unsigned int N, class T>
+class ChunkedArrayPyramid
+{
+  public:
+    typedef ChunkedArray<N, T> array_type;
+    typedef ChunkedArrayPyramidLevel<N, T> level_type;
+    typedef typename MultiArrayShape<N>::type shape_type;
+
+    /** \brief Create a pyramid with 'levels' levels (including 'base')
+        using the given reduction 'method'.
+
+        When 'levels' is negative, levels are added until the coarsest level
+        has shape 1 along all axes. The chunk shape of the coarser levels equals
+        the chunk shape of 'base', 'options' control their cache and in-memory
+        compression (default: LZ4). 'base' must outlive the pyramid.
+    */
+    explicit ChunkedArrayPyramid(array_type & base,
+                                 int levels = -1,
+                                 PyramidReduction method = PyramidMean,
+                                 ChunkedArrayOptions const & options = ChunkedArrayOptions())
+    : method_(method)
+    {
+        if(levels < 0)
+        {
+            levels = 1;
+            for(shape_type s = base.shape(); max(s) > 1; s = (s + shape_type(1)) / shape_type(2))
+                ++levels;
+        }
+        vigra_precondition(levels > 0,
+            "ChunkedArrayPyramid(): need at least one level.");
+
+        levels_.push_back(&base);
+        for(int k=1; k<levels; ++k)
+        {
+            VIGRA_SHARED_PTR<level_type> level(
+                new level_type(*levels_.back(), method, base.chunkShape(), options));
+            computed_.push_back(level);
+            levels_.push_back(level.get());
+        }
+    }
+
+        /** \brief Number of levels, including the base array.
+        */
+    int levels() const
+    {
+        return (int)levels_.size();
+    }
+
+    PyramidReduction reduction() const
+    {
+        return method_;
+    }
+
+        /** \brief Access level 'k' (level 0 is the base array).
+
+            Coarser levels are read-only.
+        */
+    array_type & level(int k)
+    {
+        checkLevel(k, "ChunkedArrayPyramid::level()");
+        return *levels_[k];
+    }
+
+    array_type const & level(int k) const
+    {
+        checkLevel(k, "ChunkedArrayPyramid::level()");
+        return *levels_[k];
+    }
+
+        /** \brief Shape of level 'k'.
+        */
+    shape_type shape(int k) const
+    {
+        return level(k).shape();
+    }
+
+        /** \brief Use the existing array 'stored' as level 'k' > 0.
+
+            'stored' must have the shape of level 'k' and must outlive the pyramid.
+            The next coarser level is henceforth computed from 'stored'. References
+            to the previous level 'k' become invalid.
+        */
+    void attachLevel(int k, array_type & stored)
+    {
+        checkLevel(k, "ChunkedArrayPyramid::attachLevel()");
+        vigra_precondition(k > 0,
+            "ChunkedArrayPyramid::attachLevel(): cannot replace the base array.");
+        vigra_precondition(stored.shape() == levels_[k]->shape(),
+            "ChunkedArrayPyramid::attachLevel(): shape mismatch.");
+        levels_[k] = &stored;
+        if(k+1 < levels() && computed_[k])
+            computed_[k]->setSource(stored);
+        computed_[k-1].reset();
+    }
+
+        /** \brief Copy level 'k' > 0 into 'dest' chunk by chunk and attach 'dest'
+            in its place (see attachLevel()).
+
+            'dest' must be writable and have the shape of level 'k'. Computed
+            chunks of level 'k' are discarded as soon as they are copied.
+        */
+    void storeLevel(int k, array_type & dest)
+    {
+        checkLevel(k, "ChunkedArrayPyramid::storeLevel()");
+        vigra_precondition(k > 0,
+            "ChunkedArrayPyramid::storeLevel(): cannot store the base array.");
+        vigra_precondition(dest.shape() == levels_[k]->shape(),
+            "ChunkedArrayPyramid::storeLevel(): shape mismatch.");
+
+        array_type & src = *levels_[k];
+        bool discard = &src == computed_[k-1].get();
+        shape_type chunk_shape = src.chunkShape();
+        MultiCoordinateIterator<N> i(src.chunkArrayShape()), end(i.getEndIterator());
+        for(; i != end; ++i)
+        {
+            shape_type start = *i * chunk_shape,
+                       stop  = min(start + chunk_shape, src.shape());
+            MultiArray<N, T> buffer(stop - start);
+            src.checkoutSubarray(start, buffer);
+            dest.commitSubarray(start, buffer);
+            if(discard)
+                src.releaseChunks(start, stop, true);
+        }
+        attachLevel(k, dest);
+    }
+
+  private:
+
+    void checkLevel(int k, char const * where) const
+    {
+        vigra_precondition(k >= 0 && k < levels(),
+            std::string(where) + ": level index out of range.");
+    }
+
+    PyramidReduction method_;
+    ArrayVector<array_type *> levels_;
+    ArrayVector<VIGRA_SHARED_PTR<level_type> > computed_;  // computed_[k-1] belongs to level k
+};
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_CHUNKED_PYRAMID_HXX
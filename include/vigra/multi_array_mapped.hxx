@@ -0,0 +1,335 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_ARRAY_MAPPED_HXX
+#define VIGRA_MULTI_ARRAY_MAPPED_HXX
+
+#include <string>
+#include <algorithm>
+#include "multi_array.hxx"
+#include "numerictraits.hxx"
+#include "sized_int.hxx"
+
+#ifdef _WIN32
+# include "windows.h"
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+#endif
+
+namespace vigra {
+
+/** \brief Byte order of the data in a memory-mapped file.
+
+    See \ref MultiArrayMapped.
+*/
+enum MappedByteOrder { NativeByteOrder, LittleEndianByteOrder, BigEndianByteOrder };
+
+/** \brief View onto the contents of a memory-mapped file.
+
+    The file is mapped into the address space of the process, and the
+    inherited \ref MultiArrayView refers directly to the mapping. Opening the
+    array is therefore independent of the file size, pages are only read
+    from disk when they are accessed, and they are backed by the page cache
+    rather than by private memory of the process. This is the method of
+    choice to access large raw volumes or other uncompressed data that are
+    stored contiguously in a file.
+
+    If the byte order of the file differs from the byte order of the machine,
+    the data are mapped copy-on-write and swapped in place. All pages then
+    become private to the process, so this case is no faster than reading
+    the file.
+
+    The file is always mapped copy-on-write: elements can be modified through
+    the view, but changes are never written back to the file. A modified page
+    becomes a private copy of the process, the other pages remain shared.
+
+    <b>Usage:</b>
+
+    \code
+    // a 2000 x 2000 x 1000 volume of 16-bit big-endian data after a 512 byte header
+    MultiArrayMapped<3, UInt16> volume("volume.raw", Shape3(2000, 2000, 1000),
+                                       512, BigEndianByteOrder);
+    std::cout << volume(10, 20, 30) << "\n";
+    \endcode
+
+    <b>\#include</b> \<vigra/multi_array_mapped.hxx\> <br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T>
+class MultiArrayMapped
+: public MultiArrayView<N, T, StridedArrayTag>
+{
+  public:
+    typedef MultiArrayView<N, T, StridedArrayTag>     view_type;
+    typedef typename view_type::difference_type       difference_type;
+    typedef typename view_type::difference_type_1     difference_type_1;
+    typedef typename view_type::pointer               pointer;
+    typedef typename NumericTraits<T>::ValueType      scalar_type;
+
+#ifdef _WIN32
+    typedef HANDLE FileHandle;
+#else
+    typedef int FileHandle;
+#endif
+
+        /** Construct an empty array that does not refer to a file.
+         */
+    MultiArrayMapped()
+    : view_type()
+    , mapping_(0)
+    , mapping_size_(0)
+    , is_private_(false)
+    {}
+
+        /** Map the file \a filename, whose data start \a offset bytes into
+            the file and are arranged in scan-order (first dimension changes
+            fastest) with the given \a shape.
+         */
+    MultiArrayMapped(std::string const & filename,
+                     difference_type const & shape,
+                     std::size_t offset = 0,
+                     MappedByteOrder byteorder = NativeByteOrder)
+    : view_type()
+    , mapping_(0)
+    , mapping_size_(0)
+    , is_private_(false)
+    {
+        map(filename, shape, detail::defaultStride(shape), offset, byteorder);
+    }
+
+        /** Map the file \a filename, whose data start \a offset bytes into
+            the file and are arranged according to the given \a shape and
+            element \a stride (all strides must be non-negative).
+         */
+    MultiArrayMapped(std::string const & filename,
+                     difference_type const & shape,
+                     difference_type const & stride,
+                     std::size_t offset = 0,
+                     MappedByteOrder byteorder = NativeByteOrder)
+    : view_type()
+    , mapping_(0)
+    , mapping_size_(0)
+    , is_private_(false)
+    {
+        map(filename, shape, stride, offset, byteorder);
+    }
+
+    ~MultiArrayMapped()
+    {
+        unmap();
+    }
+
+        /** Map a new file. The current mapping (if any) is released first.
+            See the constructors for the meaning of the arguments.
+         */
+    void map(std::string const & filename,
+             difference_type const & shape,
+             difference_type const & stride,
+             std::size_t offset = 0,
+             MappedByteOrder byteorder = NativeByteOrder);
+
+        /** Map a new file with scan-order layout.
+         */
+    void map(std::string const & filename,
+             difference_type const & shape,
+             std::size_t offset = 0,
+             MappedByteOrder byteorder = NativeByteOrder)
+    {
+        map(filename, shape, detail::defaultStride(shape), offset, byteorder);
+    }
+
+        /** Release the mapping. The array becomes empty.
+         */
+    void unmap();
+
+        /** True if the array currently refers to a file.
+         */
+    bool isMapped() const
+    {
+        return mapping_ != 0;
+    }
+
+        /** True if the data had to be byte-swapped, so that the mapped
+            pages are private copies instead of shared page cache.
+         */
+    bool isPrivate() const
+    {
+        return is_private_;
+    }
+
+        /** The view onto the mapped data.
+         */
+    view_type const & view() const
+    {
+        return *this;
+    }
+
+    static bool isNativeByteOrder(MappedByteOrder byteorder)
+    {
+        UInt16 probe = 1;
+        bool little = *reinterpret_cast<char const *>(&probe) == 1;
+        return byteorder == NativeByteOrder ||
+               (byteorder == LittleEndianByteOrder) == little;
+    }
+
+  private:
+    MultiArrayMapped(MultiArrayMapped const &);
+    MultiArrayMapped & operator=(MultiArrayMapped const &);
+
+    static std::size_t pageSize()
+    {
+    #ifdef _WIN32
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+    #else
+        return sysconf(_SC_PAGE_SIZE);
+    #endif
+    }
+
+    void swapBytes(std::size_t count);
+
+    char * mapping_;
+    std::size_t mapping_size_;
+    bool is_private_;
+};
+
+template <unsigned int N, class T>
+void
+MultiArrayMapped<N, T>::map(std::string const & filename,
+                            difference_type const & shape,
+                            difference_type const & stride,
+                            std::size_t offset,
+                            MappedByteOrder byteorder)
+{
+    vigra_precondition(allGreater(shape, difference_type()) && allGreaterEqual(stride, difference_type()),
+        "MultiArrayMapped::map(): shape must be positive and strides non-negative.");
+    vigra_precondition(offset % sizeof(scalar_type) == 0,
+        "MultiArrayMapped::map(): offset must be a multiple of the element size.");
+
+    unmap();
+
+    // the last byte addressed by the view
+    std::size_t data_size = (dot(shape - difference_type(1), stride) + 1)*sizeof(T);
+    std::size_t aligned_offset = offset - offset % pageSize();
+    std::size_t size = offset - aligned_offset + data_size;
+    bool swap = sizeof(scalar_type) > 1 && !isNativeByteOrder(byteorder);
+
+#ifdef _WIN32
+    FileHandle file = ::CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        vigra_fail("MultiArrayMapped::map(): unable to open file '" + filename + "'.");
+    LARGE_INTEGER file_size;
+    if(!::GetFileSizeEx(file, &file_size) || (std::size_t)file_size.QuadPart < offset + data_size)
+    {
+        ::CloseHandle(file);
+        vigra_fail("MultiArrayMapped::map(): file '" + filename + "' is too small for the requested shape.");
+    }
+    HANDLE mapped_file = ::CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    ::CloseHandle(file);
+    if(!mapped_file)
+        vigra_fail("MultiArrayMapped::map(): unable to map file '" + filename + "'.");
+    static const std::size_t bits = sizeof(DWORD)*8,
+                             mask = (std::size_t(1) << bits) - 1;
+    mapping_ = (char*)::MapViewOfFile(mapped_file, FILE_MAP_COPY,
+                                      std::size_t(aligned_offset) >> bits, aligned_offset & mask, size);
+    ::CloseHandle(mapped_file); // the view keeps the mapping alive
+    if(mapping_ == 0)
+        vigra_fail("MultiArrayMapped::map(): unable to map file '" + filename + "'.");
+#else
+    FileHandle file = ::open(filename.c_str(), O_RDONLY);
+    if(file == -1)
+        vigra_fail("MultiArrayMapped::map(): unable to open file '" + filename + "'.");
+    struct stat info;
+    if(::fstat(file, &info) == -1 || (std::size_t)info.st_size < offset + data_size)
+    {
+        ::close(file);
+        vigra_fail("MultiArrayMapped::map(): file '" + filename + "' is too small for the requested shape.");
+    }
+    void * mapping = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, aligned_offset);
+    ::close(file); // the mapping keeps the file alive
+    if(mapping == MAP_FAILED)
+        vigra_fail("MultiArrayMapped::map(): unable to map file '" + filename + "'.");
+    mapping_ = (char*)mapping;
+#endif
+
+    mapping_size_ = size;
+    is_private_ = swap;
+    this->m_shape = shape;
+    this->m_stride = stride;
+    this->m_ptr = (pointer)(mapping_ + (offset - aligned_offset));
+
+    if(swap)
+        swapBytes(data_size / sizeof(scalar_type));
+}
+
+template <unsigned int N, class T>
+void
+MultiArrayMapped<N, T>::unmap()
+{
+    if(mapping_ == 0)
+        return;
+#ifdef _WIN32
+    ::UnmapViewOfFile(mapping_);
+#else
+    ::munmap(mapping_, mapping_size_);
+#endif
+    mapping_ = 0;
+    mapping_size_ = 0;
+    is_private_ = false;
+    this->m_shape = difference_type();
+    this->m_stride = difference_type();
+    this->m_ptr = 0;
+}
+
+template <unsigned int N, class T>
+void
+MultiArrayMapped<N, T>::swapBytes(std::size_t count)
+{
+    // swap the entire addressed range, so that gaps between strided
+    // elements don't need special treatment
+    char * p = (char *)this->m_ptr;
+    for(std::size_t k = 0; k < count; ++k, p += sizeof(scalar_type))
+        std::reverse(p, p + sizeof(scalar_type));
+}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_ARRAY_MAPPED_HXX
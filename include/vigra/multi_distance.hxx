@@ -47,6 +47,7 @@
 #include "metaprogramming.hxx"
 #include "multi_pointoperators.hxx"
 #include "functorexpression.hxx"
+#include "threadpool.hxx"
 
 #include "multi_gridgraph.hxx"     //for boundaryGraph & boundaryMultiDistance
 #include "union_find.hxx"        //for boundaryGraph & boundaryMultiDistance
@@ -79,7 +80,8 @@ struct DistParabolaStackEntry
 template <class SrcIterator, class SrcAccessor,
           class DestIterator, class DestAccessor >
 void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
-                  DestIterator id, DestAccessor da, double sigma )
+                  DestIterator id, DestAccessor da, double sigma,
+                  std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > & _stack)
 {
     // We assume that the data in the input is distance squared and treat it as such
     double w = iend - is;
@@ -91,7 +93,7 @@ void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
 
     typedef typename SrcAccessor::value_type SrcType;
     typedef DistParabolaStackEntry<SrcType> Influence;
-    std::vector<Influence> _stack;
+    _stack.clear();
     _stack.push_back(Influence(sa(is), 0.0, 0.0, w));
 
     ++is;
@@ -135,6 +137,15 @@ void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
     }
 }
 
+template <class SrcIterator, class SrcAccessor,
+          class DestIterator, class DestAccessor >
+inline void distParabola(SrcIterator is, SrcIterator iend, SrcAccessor sa,
+                         DestIterator id, DestAccessor da, double sigma )
+{
+    std::vector<DistParabolaStackEntry<typename SrcAccessor::value_type> > _stack;
+    distParabola(is, iend, sa, id, da, sigma, _stack);
+}
+
 template <class SrcIterator, class SrcAccessor,
           class DestIterator, class DestAccessor>
 inline void distParabola(triple<SrcIterator, SrcIterator, SrcAccessor> src,
@@ -233,6 +244,56 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
     internalSeparableMultiArrayDistTmp( si, shape, src, di, dest, sigmas, false );
 }
 
+/********************************************************/
+/*                                                      */
+/*       internalSeparableMultiArrayDistParallel        */
+/*                                                      */
+/********************************************************/
+
+    // In-place version of internalSeparableMultiArrayDistTmp() that distributes
+    // the lines of each dimension over the threads of a pool. Every thread
+    // reuses its own line buffer and parabola stack.
+template <unsigned int N, class T, class S, class Array>
+void
+internalSeparableMultiArrayDistParallel(MultiArrayView<N, T, S> array, Array const & sigmas,
+                                        ParallelOptions const & options)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef typename NumericTraits<T>::RealPromote TmpType;
+    typedef DistParabolaStackEntry<TmpType> Influence;
+
+    ThreadPool pool(options);
+    int nThreads = std::max<int>(1, pool.nThreads());
+    ArrayVector<ArrayVector<TmpType> > buffers(nThreads);
+    ArrayVector<std::vector<Influence> > stacks(nThreads);
+
+    for(unsigned int d = 0; d < N; ++d)
+    {
+        Shape planeShape(array.shape());
+        planeShape[d] = 1;
+        MultiArrayIndex length = array.shape(d),
+                        stride = array.stride(d);
+        for(int k=0; k<nThreads; ++k)
+            buffers[k].resize(length);
+
+        parallel_foreach(pool, prod(planeShape),
+            [&](int threadId, MultiArrayIndex lineIndex)
+            {
+                Shape start;
+                ScanOrderToCoordinate<N>::exec(lineIndex, planeShape, start);
+                MultiArrayView<1, T, StridedArrayTag> line(Shape1(length), Shape1(stride), &array[start]);
+                ArrayVector<TmpType> & tmp = buffers[threadId];
+
+                // first copy source to temp for maximum cache efficiency
+                std::copy(line.begin(), line.end(), tmp.begin());
+                distParabola(tmp.begin(), tmp.end(),
+                             typename AccessorTraits<TmpType>::default_const_accessor(),
+                             line.begin(), typename AccessorTraits<T>::default_accessor(),
+                             sigmas[d], stacks[threadId]);
+            });
+    }
+}
+
 } // namespace detail
 
 /** \addtogroup DistanceTransform
@@ -272,6 +333,25 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
         separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
                                   MultiArrayView<N, T2, S2> dest,
                                   bool background);
+
+        // parallel versions (BlockwiseOptions are also accepted)
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2,
+                  class Array>
+        void
+        separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest,
+                                  bool background,
+                                  Array const & pixelPitch,
+                                  ParallelOptions const & options);
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
+                                  MultiArrayView<N, T2, S2> dest,
+                                  bool background,
+                                  ParallelOptions const & options);
     }
     \endcode
 
@@ -343,6 +423,10 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
     <tt> NumericTraits<typename DestAccessor::value_type>::max() < N * M*M</tt>, where M is the
     size of the largest dimension of the array.
 
+    When <tt>ParallelOptions</tt> are given, the lines of each dimension are distributed over
+    <tt>options.getNumThreads()</tt> threads (each thread reuses its own scratch buffers).
+    The result is identical to the sequential version.
+
     <b> Usage:</b>
 
     <b>\#include</b> \<vigra/multi_distance.hxx\><br/>
@@ -356,6 +440,9 @@ inline void internalSeparableMultiArrayDistTmp( SrcIterator si, SrcShape const &
 
     // Calculate Euclidean distance squared for all background pixels
     separableMultiDistSquared(source, dest, true);
+
+    // likewise, using 8 threads
+    separableMultiDistSquared(source, dest, true, ParallelOptions().numThreads(8));
     \endcode
 
     \see vigra::distanceTransform(), vigra::separableMultiDistance()
@@ -456,7 +543,7 @@ inline void separableMultiDistSquared( triple<SrcIterator, SrcShape, SrcAccessor
 template <unsigned int N, class T1, class S1,
                           class T2, class S2,
           class Array>
-inline void
+inline typename enable_if<!IsDerivedFrom<Array, ParallelOptions>::value>::type
 separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
                           MultiArrayView<N, T2, S2> dest, bool background,
                           Array const & pixelPitch)
@@ -479,6 +566,75 @@ separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
                                destMultiArray(dest), background );
 }
 
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Array>
+void
+separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest, bool background,
+                          Array const & pixelPitch, ParallelOptions const & options)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "separableMultiDistSquared(): shape mismatch between input and output.");
+
+    typedef typename NumericTraits<T2>::RealPromote Real;
+
+    T1 zero = NumericTraits<T1>::zero();
+
+    double dmax = 0.0;
+    bool pixelPitchIsReal = false;
+    for( unsigned int k=0; k<N; ++k)
+    {
+        if(int(pixelPitch[k]) != pixelPitch[k])
+            pixelPitchIsReal = true;
+        dmax += sq(pixelPitch[k]*source.shape(k));
+    }
+
+    using namespace vigra::functor;
+
+    if(dmax > NumericTraits<T2>::toRealPromote(NumericTraits<T2>::max())
+       || pixelPitchIsReal) // need a temporary array to avoid overflows
+    {
+        // Threshold the values so all objects have infinity value in the beginning
+        Real maxDist = (Real)dmax, rzero = (Real)0.0;
+        MultiArray<N, Real> tmpArray(source.shape());
+        if(background == true)
+            transformMultiArray(source, tmpArray,
+                                ifThenElse( Arg1() == Param(zero), Param(maxDist), Param(rzero) ));
+        else
+            transformMultiArray(source, tmpArray,
+                                ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(rzero) ));
+
+        detail::internalSeparableMultiArrayDistParallel(tmpArray, pixelPitch, options);
+
+        copyMultiArray(tmpArray, dest);
+    }
+    else        // work directly on the destination array
+    {
+        // Threshold the values so all objects have infinity value in the beginning
+        T2 maxDist = T2(std::ceil(dmax)), rzero = (T2)0;
+        if(background == true)
+            transformMultiArray(source, dest,
+                                ifThenElse( Arg1() == Param(zero), Param(maxDist), Param(rzero) ));
+        else
+            transformMultiArray(source, dest,
+                                ifThenElse( Arg1() != Param(zero), Param(maxDist), Param(rzero) ));
+
+        detail::internalSeparableMultiArrayDistParallel(dest, pixelPitch, options);
+    }
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest, bool background,
+                          ParallelOptions const & options)
+{
+    ArrayVector<double> pixelPitch(N, 1.0);
+    separableMultiDistSquared(source, dest, background, pixelPitch, options);
+}
+
 /********************************************************/
 /*                                                      */
 /*             separableMultiDistance                   */
@@ -508,6 +664,24 @@ separableMultiDistSquared(MultiArrayView<N, T1, S1> const & source,
         separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                                MultiArrayView<N, T2, S2> dest,
                                bool background);
+
+        // parallel versions (BlockwiseOptions are also accepted)
+        template <unsigned int N, class T1, class S1,
+                  class T2, class S2, class Array>
+        void
+        separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                               MultiArrayView<N, T2, S2> dest,
+                               bool background,
+                               Array const & pixelPitch,
+                               ParallelOptions const & options);
+
+        template <unsigned int N, class T1, class S1,
+                  class T2, class S2>
+        void
+        separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                               MultiArrayView<N, T2, S2> dest,
+                               bool background,
+                               ParallelOptions const & options);
     }
     \endcode
 
@@ -630,7 +804,7 @@ inline void separableMultiDistance( triple<SrcIterator, SrcShape, SrcAccessor> c
 
 template <unsigned int N, class T1, class S1,
           class T2, class S2, class Array>
-inline void
+inline typename enable_if<!IsDerivedFrom<Array, ParallelOptions>::value>::type
 separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                        MultiArrayView<N, T2, S2> dest,
                        bool background,
@@ -655,6 +829,35 @@ separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
                             destMultiArray(dest), background );
 }
 
+template <unsigned int N, class T1, class S1,
+          class T2, class S2, class Array>
+inline void
+separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                       MultiArrayView<N, T2, S2> dest,
+                       bool background,
+                       Array const & pixelPitch,
+                       ParallelOptions const & options)
+{
+    separableMultiDistSquared(source, dest, background, pixelPitch, options);
+
+    // Finally, calculate the square root of the distances
+    using namespace vigra::functor;
+
+    transformMultiArray(dest, dest, sqrt(Arg1()));
+}
+
+template <unsigned int N, class T1, class S1,
+          class T2, class S2>
+inline void
+separableMultiDistance(MultiArrayView<N, T1, S1> const & source,
+                       MultiArrayView<N, T2, S2> dest,
+                       bool background,
+                       ParallelOptions const & options)
+{
+    ArrayVector<double> pixelPitch(N, 1.0);
+    separableMultiDistance(source, dest, background, pixelPitch, options);
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% BoundaryDistanceTransform %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 //rewrite labeled data and work with separableMultiDist
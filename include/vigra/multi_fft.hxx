@@ -43,6 +43,7 @@
 #include "navigator.hxx"
 #include "copyimage.hxx"
 #include "threading.hxx"
+#include "threadpool.hxx"
 
 namespace vigra {
 
@@ -204,11 +205,12 @@ inline fftw_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<double> * in,  int* instrides,  int instep,
                FFTWComplex<double> * out, int* outstrides, int outstep,
-               int sign, unsigned int planner_flags)
+               int sign, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftw_plan_many_dft(N, shape, 1,
-                              (fftw_complex *)in, instrides, instep, 0,
-                              (fftw_complex *)out, outstrides, outstep, 0,
+    return fftw_plan_many_dft(N, shape, howmany,
+                              (fftw_complex *)in, instrides, instep, idist,
+                              (fftw_complex *)out, outstrides, outstep, odist,
                               sign, planner_flags);
 }
 
@@ -216,11 +218,12 @@ inline fftw_plan
 fftwPlanCreate(unsigned int N, int* shape,
                double * in,  int* instrides,  int instep,
                FFTWComplex<double> * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftw_plan_many_dft_r2c(N, shape, 1,
-                                   in, instrides, instep, 0,
-                                   (fftw_complex *)out, outstrides, outstep, 0,
+    return fftw_plan_many_dft_r2c(N, shape, howmany,
+                                   in, instrides, instep, idist,
+                                   (fftw_complex *)out, outstrides, outstep, odist,
                                    planner_flags);
 }
 
@@ -228,11 +231,12 @@ inline fftw_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<double> * in,  int* instrides,  int instep,
                double * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftw_plan_many_dft_c2r(N, shape, 1,
-                                  (fftw_complex *)in, instrides, instep, 0,
-                                  out, outstrides, outstep, 0,
+    return fftw_plan_many_dft_c2r(N, shape, howmany,
+                                  (fftw_complex *)in, instrides, instep, idist,
+                                  out, outstrides, outstep, odist,
                                   planner_flags);
 }
 
@@ -240,11 +244,12 @@ inline fftwf_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<float> * in,  int* instrides,  int instep,
                FFTWComplex<float> * out, int* outstrides, int outstep,
-               int sign, unsigned int planner_flags)
+               int sign, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwf_plan_many_dft(N, shape, 1,
-                               (fftwf_complex *)in, instrides, instep, 0,
-                               (fftwf_complex *)out, outstrides, outstep, 0,
+    return fftwf_plan_many_dft(N, shape, howmany,
+                               (fftwf_complex *)in, instrides, instep, idist,
+                               (fftwf_complex *)out, outstrides, outstep, odist,
                                sign, planner_flags);
 }
 
@@ -252,11 +257,12 @@ inline fftwf_plan
 fftwPlanCreate(unsigned int N, int* shape,
                float * in,  int* instrides,  int instep,
                FFTWComplex<float> * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwf_plan_many_dft_r2c(N, shape, 1,
-                                    in, instrides, instep, 0,
-                                    (fftwf_complex *)out, outstrides, outstep, 0,
+    return fftwf_plan_many_dft_r2c(N, shape, howmany,
+                                    in, instrides, instep, idist,
+                                    (fftwf_complex *)out, outstrides, outstep, odist,
                                     planner_flags);
 }
 
@@ -264,11 +270,12 @@ inline fftwf_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<float> * in,  int* instrides,  int instep,
                float * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwf_plan_many_dft_c2r(N, shape, 1,
-                                   (fftwf_complex *)in, instrides, instep, 0,
-                                   out, outstrides, outstep, 0,
+    return fftwf_plan_many_dft_c2r(N, shape, howmany,
+                                   (fftwf_complex *)in, instrides, instep, idist,
+                                   out, outstrides, outstep, odist,
                                    planner_flags);
 }
 
@@ -276,11 +283,12 @@ inline fftwl_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<long double> * in,  int* instrides,  int instep,
                FFTWComplex<long double> * out, int* outstrides, int outstep,
-               int sign, unsigned int planner_flags)
+               int sign, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwl_plan_many_dft(N, shape, 1,
-                               (fftwl_complex *)in, instrides, instep, 0,
-                               (fftwl_complex *)out, outstrides, outstep, 0,
+    return fftwl_plan_many_dft(N, shape, howmany,
+                               (fftwl_complex *)in, instrides, instep, idist,
+                               (fftwl_complex *)out, outstrides, outstep, odist,
                                sign, planner_flags);
 }
 
@@ -288,11 +296,12 @@ inline fftwl_plan
 fftwPlanCreate(unsigned int N, int* shape,
                long double * in,  int* instrides,  int instep,
                FFTWComplex<long double> * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwl_plan_many_dft_r2c(N, shape, 1,
-                                    in, instrides, instep, 0,
-                                    (fftwl_complex *)out, outstrides, outstep, 0,
+    return fftwl_plan_many_dft_r2c(N, shape, howmany,
+                                    in, instrides, instep, idist,
+                                    (fftwl_complex *)out, outstrides, outstep, odist,
                                     planner_flags);
 }
 
@@ -300,11 +309,12 @@ inline fftwl_plan
 fftwPlanCreate(unsigned int N, int* shape,
                FFTWComplex<long double> * in,  int* instrides,  int instep,
                long double * out, int* outstrides, int outstep,
-               int /*sign is ignored*/, unsigned int planner_flags)
+               int /*sign is ignored*/, unsigned int planner_flags,
+               int howmany = 1, int idist = 0, int odist = 0)
 {
-    return fftwl_plan_many_dft_c2r(N, shape, 1,
-                                   (fftwl_complex *)in, instrides, instep, 0,
-                                   out, outstrides, outstep, 0,
+    return fftwl_plan_many_dft_c2r(N, shape, howmany,
+                                   (fftwl_complex *)in, instrides, instep, idist,
+                                   out, outstrides, outstep, odist,
                                    planner_flags);
 }
 
@@ -1152,6 +1162,437 @@ void FFTWPlan<N, Real>::executeImpl(MI ins, MO outs) const
         outs *= V(1.0) / Real(outs.size());
 }
 
+/********************************************************/
+/*                                                      */
+/*                    FFTWBatchPlan                     */
+/*                                                      */
+/********************************************************/
+
+/** C++ wrapper for FFTW plans that transform a whole stack of arrays at once.
+
+    The class is the batched counterpart of \ref FFTWPlan. It transforms an
+    (N+1)-dimensional array along its first N dimensions, i.e. each slice
+    <tt>in.bindOuter(k)</tt> is Fourier transformed independently. All slices
+    are handled by a single call to <tt>fftw_plan_many_dft</tt> (and its R2C and C2R
+    counterparts), so that planning is only done once and FFTW can optimize the
+    traversal of the entire stack.
+
+    If the <tt>ParallelOptions</tt> passed to the constructor request more than one thread,
+    the stack is split into (at most) as many contiguous chunks as there are threads,
+    and the chunks are transformed concurrently by means of FFTW's thread-safe new-array
+    execute functions.
+
+    Usually, you use this class only indirectly via \ref fourierTransformMany()
+    and \ref fourierTransformInverseMany(). You only need this class if you want to
+    re-use the plan for several stacks of the same shape.
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\><br>
+    Namespace: vigra
+
+    \code
+    // compute the Fourier transforms of all frames of a time series
+    MultiArray<3, FFTWComplex<double> > frames(Shape3(w, h, t)), fourier(Shape3(w, h, t));
+
+    // the template parameter denotes the dimension of the individual transforms
+    FFTWBatchPlan<2, double> plan(frames, fourier, FFTW_FORWARD, FFTW_ESTIMATE,
+                                  ParallelOptions().numThreads(4));
+
+    plan.execute(frames, fourier);
+    \endcode
+*/
+template <unsigned int N, class Real = double>
+class FFTWBatchPlan
+{
+    typedef ArrayVector<int> Shape;
+    typedef typename FFTWReal2Complex<Real>::plan_type PlanType;
+
+    PlanType plan, lastPlan;
+    Shape shape, instrides, outstrides;
+    int sign, batchSize, chunkSize;
+    MultiArrayIndex idist, odist;
+
+  public:
+        /** \brief Create an empty plan.
+
+            The plan can be initialized later by one of the init() functions.
+        */
+    FFTWBatchPlan()
+    : plan(0),
+      lastPlan(0),
+      batchSize(0),
+      chunkSize(0)
+    {}
+
+        /** \brief Create a plan for a batch of complex-to-complex transforms.
+
+            \arg SIGN must be <tt>FFTW_FORWARD</tt> or <tt>FFTW_BACKWARD</tt> according to the
+            desired transformation direction.
+            \arg planner_flags must be a combination of the <a href="http://www.fftw.org/doc/Planner-Flags.html">planner
+            flags</a> defined by the FFTW library.
+            \arg options determines how many threads will later be used in execute().
+        */
+    template <class C1, class C2>
+    FFTWBatchPlan(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+                  MultiArrayView<N+1, FFTWComplex<Real>, C2> out,
+                  int SIGN, unsigned int planner_flags = FFTW_ESTIMATE,
+                  ParallelOptions const & options = ParallelOptions())
+    : plan(0),
+      lastPlan(0)
+    {
+        init(in, out, SIGN, planner_flags, options);
+    }
+
+        /** \brief Create a plan for a batch of real-to-complex transforms.
+
+            This always refers to forward transforms. The output shape must be
+            <tt>fftwCorrespondingShapeR2C()</tt> of the input shape in the first N dimensions.
+        */
+    template <class C1, class C2>
+    FFTWBatchPlan(MultiArrayView<N+1, Real, C1> in,
+                  MultiArrayView<N+1, FFTWComplex<Real>, C2> out,
+                  unsigned int planner_flags = FFTW_ESTIMATE,
+                  ParallelOptions const & options = ParallelOptions())
+    : plan(0),
+      lastPlan(0)
+    {
+        init(in, out, planner_flags, options);
+    }
+
+        /** \brief Create a plan for a batch of complex-to-real transforms.
+
+            This always refers to inverse transforms. The input shape must be
+            <tt>fftwCorrespondingShapeR2C()</tt> of the output shape in the first N dimensions.
+        */
+    template <class C1, class C2>
+    FFTWBatchPlan(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+                  MultiArrayView<N+1, Real, C2> out,
+                  unsigned int planner_flags = FFTW_ESTIMATE,
+                  ParallelOptions const & options = ParallelOptions())
+    : plan(0),
+      lastPlan(0)
+    {
+        init(in, out, planner_flags, options);
+    }
+
+        /** \brief Copy constructor.
+        */
+    FFTWBatchPlan(FFTWBatchPlan const & other)
+    : plan(other.plan),
+      lastPlan(other.lastPlan),
+      sign(other.sign),
+      batchSize(other.batchSize),
+      chunkSize(other.chunkSize),
+      idist(other.idist),
+      odist(other.odist)
+    {
+        FFTWBatchPlan & o = const_cast<FFTWBatchPlan &>(other);
+        shape.swap(o.shape);
+        instrides.swap(o.instrides);
+        outstrides.swap(o.outstrides);
+        o.plan = 0; // act like std::auto_ptr
+        o.lastPlan = 0;
+    }
+
+        /** \brief Copy assigment.
+        */
+    FFTWBatchPlan & operator=(FFTWBatchPlan const & other)
+    {
+        if(this != &other)
+        {
+            FFTWBatchPlan & o = const_cast<FFTWBatchPlan &>(other);
+            {
+                detail::FFTWLock<> lock;
+                detail::fftwPlanDestroy(plan);
+                detail::fftwPlanDestroy(lastPlan);
+            }
+            plan = o.plan;
+            lastPlan = o.lastPlan;
+            shape.swap(o.shape);
+            instrides.swap(o.instrides);
+            outstrides.swap(o.outstrides);
+            sign = o.sign;
+            batchSize = o.batchSize;
+            chunkSize = o.chunkSize;
+            idist = o.idist;
+            odist = o.odist;
+            o.plan = 0; // act like std::auto_ptr
+            o.lastPlan = 0;
+        }
+        return *this;
+    }
+
+        /** \brief Destructor.
+        */
+    ~FFTWBatchPlan()
+    {
+        detail::FFTWLock<> lock;
+        detail::fftwPlanDestroy(plan);
+        detail::fftwPlanDestroy(lastPlan);
+    }
+
+        /** \brief Init a batch of complex-to-complex transforms.
+
+            See the constructor with the same signature for details.
+        */
+    template <class C1, class C2>
+    void init(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+              MultiArrayView<N+1, FFTWComplex<Real>, C2> out,
+              int SIGN, unsigned int planner_flags = FFTW_ESTIMATE,
+              ParallelOptions const & options = ParallelOptions())
+    {
+        checkStacks(in, out);
+        initImpl(in.bindOuter(0).permuteStridesDescending(),
+                 out.bindOuter(0).permuteStridesDescending(),
+                 in.shape(N), in.stride(N), out.stride(N),
+                 SIGN, planner_flags, options);
+    }
+
+        /** \brief Init a batch of real-to-complex transforms.
+
+            See the constructor with the same signature for details.
+        */
+    template <class C1, class C2>
+    void init(MultiArrayView<N+1, Real, C1> in,
+              MultiArrayView<N+1, FFTWComplex<Real>, C2> out,
+              unsigned int planner_flags = FFTW_ESTIMATE,
+              ParallelOptions const & options = ParallelOptions())
+    {
+        checkStacks(in, out);
+        initImpl(in.bindOuter(0).permuteStridesDescending(),
+                 out.bindOuter(0).permuteStridesDescending(),
+                 in.shape(N), in.stride(N), out.stride(N),
+                 FFTW_FORWARD, planner_flags, options);
+    }
+
+        /** \brief Init a batch of complex-to-real transforms.
+
+            See the constructor with the same signature for details.
+        */
+    template <class C1, class C2>
+    void init(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+              MultiArrayView<N+1, Real, C2> out,
+              unsigned int planner_flags = FFTW_ESTIMATE,
+              ParallelOptions const & options = ParallelOptions())
+    {
+        checkStacks(in, out);
+        initImpl(in.bindOuter(0).permuteStridesDescending(),
+                 out.bindOuter(0).permuteStridesDescending(),
+                 in.shape(N), in.stride(N), out.stride(N),
+                 FFTW_BACKWARD, planner_flags, options);
+    }
+
+        /** \brief Execute a batch of complex-to-complex transforms.
+
+            The array shapes and strides must be the same as in the corresponding init function
+            or constructor. However, execute() can be called several times on
+            the same plan, even with different arrays, as long as they have the appropriate
+            shapes.
+        */
+    template <class C1, class C2>
+    void execute(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+                 MultiArrayView<N+1, FFTWComplex<Real>, C2> out) const
+    {
+        checkStacks(in, out);
+        executeImpl(in, out);
+    }
+
+        /** \brief Execute a batch of real-to-complex transforms.
+
+            See the complex-to-complex version of execute() for details.
+        */
+    template <class C1, class C2>
+    void execute(MultiArrayView<N+1, Real, C1> in,
+                 MultiArrayView<N+1, FFTWComplex<Real>, C2> out) const
+    {
+        checkStacks(in, out);
+        executeImpl(in, out);
+    }
+
+        /** \brief Execute a batch of complex-to-real transforms.
+
+            See the complex-to-complex version of execute() for details.
+        */
+    template <class C1, class C2>
+    void execute(MultiArrayView<N+1, FFTWComplex<Real>, C1> in,
+                 MultiArrayView<N+1, Real, C2> out) const
+    {
+        checkStacks(in, out);
+        executeImpl(in, out);
+    }
+
+        /** \brief Number of arrays in the stack this plan was created for.
+        */
+    int size() const
+    {
+        return batchSize;
+    }
+
+  private:
+
+    template <class MI, class MO>
+    void initImpl(MI ins, MO outs, int count, MultiArrayIndex newIDist, MultiArrayIndex newODist,
+                  int SIGN, unsigned int planner_flags, ParallelOptions const & options);
+
+    template <class SI, class SO>
+    void executeImpl(SI inStack, SO outStack) const;
+
+    template <class SI, class SO>
+    static void checkStacks(SI const & in, SO const & out)
+    {
+        vigra_precondition(in.shape(N) == out.shape(N) && in.shape(N) > 0,
+            "FFTWBatchPlan: input and output must contain the same (non-zero) number of arrays.");
+        vigra_precondition(in.bindOuter(0).strideOrdering() == out.bindOuter(0).strideOrdering(),
+            "FFTWBatchPlan: input and output must have the same stride ordering.");
+    }
+
+    void checkShapes(MultiArrayView<N, FFTWComplex<Real>, StridedArrayTag> in,
+                     MultiArrayView<N, FFTWComplex<Real>, StridedArrayTag> out) const
+    {
+        vigra_precondition(in.shape() == out.shape(),
+            "FFTWBatchPlan.init(): input and output must have the same shape.");
+    }
+
+    void checkShapes(MultiArrayView<N, Real, StridedArrayTag> ins,
+                     MultiArrayView<N, FFTWComplex<Real>, StridedArrayTag> outs) const
+    {
+        for(int k=0; k<(int)N-1; ++k)
+            vigra_precondition(ins.shape(k) == outs.shape(k),
+                "FFTWBatchPlan.init(): input and output must have matching shapes.");
+        vigra_precondition(ins.shape(N-1) / 2 + 1 == outs.shape(N-1),
+            "FFTWBatchPlan.init(): input and output must have matching shapes.");
+    }
+
+    void checkShapes(MultiArrayView<N, FFTWComplex<Real>, StridedArrayTag> ins,
+                     MultiArrayView<N, Real, StridedArrayTag> outs) const
+    {
+        for(int k=0; k<(int)N-1; ++k)
+            vigra_precondition(ins.shape(k) == outs.shape(k),
+                "FFTWBatchPlan.init(): input and output must have matching shapes.");
+        vigra_precondition(outs.shape(N-1) / 2 + 1 == ins.shape(N-1),
+            "FFTWBatchPlan.init(): input and output must have matching shapes.");
+    }
+};
+
+template <unsigned int N, class Real>
+template <class MI, class MO>
+void
+FFTWBatchPlan<N, Real>::initImpl(MI ins, MO outs, int count,
+                                 MultiArrayIndex newIDist, MultiArrayIndex newODist,
+                                 int SIGN, unsigned int planner_flags,
+                                 ParallelOptions const & options)
+{
+    checkShapes(ins, outs);
+
+    typename MultiArrayShape<N>::type logicalShape(SIGN == FFTW_FORWARD
+                                                ? ins.shape()
+                                                : outs.shape());
+
+    Shape newShape(logicalShape.begin(), logicalShape.end()),
+          newIStrides(ins.stride().begin(), ins.stride().end()),
+          newOStrides(outs.stride().begin(), outs.stride().end()),
+          itotal(ins.shape().begin(), ins.shape().end()),
+          ototal(outs.shape().begin(), outs.shape().end());
+
+    for(unsigned int j=1; j<N; ++j)
+    {
+        itotal[j] = ins.stride(j-1) / ins.stride(j);
+        ototal[j] = outs.stride(j-1) / outs.stride(j);
+    }
+
+    // split the stack into one chunk per thread, where only the last chunk may be smaller
+    int nThreads = std::min(options.getActualNumThreads(), count),
+        newChunkSize = (count + nThreads - 1) / nThreads,
+        nChunks = (count + newChunkSize - 1) / newChunkSize,
+        lastChunkSize = count - (nChunks - 1)*newChunkSize;
+
+    // chunks other than the first start at arbitrary addresses
+    if(nChunks > 1)
+        planner_flags |= FFTW_UNALIGNED;
+
+    {
+        detail::FFTWLock<> lock;
+        PlanType newPlan = detail::fftwPlanCreate(N, newShape.begin(),
+                                      ins.data(), itotal.begin(), ins.stride(N-1),
+                                      outs.data(), ototal.begin(), outs.stride(N-1),
+                                      SIGN, planner_flags,
+                                      newChunkSize, (int)newIDist, (int)newODist);
+        PlanType newLastPlan = 0;
+        if(lastChunkSize != newChunkSize)
+            newLastPlan = detail::fftwPlanCreate(N, newShape.begin(),
+                                      ins.data(), itotal.begin(), ins.stride(N-1),
+                                      outs.data(), ototal.begin(), outs.stride(N-1),
+                                      SIGN, planner_flags,
+                                      lastChunkSize, (int)newIDist, (int)newODist);
+        detail::fftwPlanDestroy(plan);
+        detail::fftwPlanDestroy(lastPlan);
+        plan = newPlan;
+        lastPlan = newLastPlan;
+    }
+
+    shape.swap(newShape);
+    instrides.swap(newIStrides);
+    outstrides.swap(newOStrides);
+    sign = SIGN;
+    batchSize = count;
+    chunkSize = newChunkSize;
+    idist = newIDist;
+    odist = newODist;
+}
+
+template <unsigned int N, class Real>
+template <class SI, class SO>
+void FFTWBatchPlan<N, Real>::executeImpl(SI inStack, SO outStack) const
+{
+    vigra_precondition(plan != 0, "FFTWBatchPlan::execute(): plan is NULL.");
+
+    typedef typename SI::value_type TI;
+    typedef typename SO::value_type TO;
+
+    MultiArrayView<N, TI, StridedArrayTag> ins  = inStack.bindOuter(0).permuteStridesDescending();
+    MultiArrayView<N, TO, StridedArrayTag> outs = outStack.bindOuter(0).permuteStridesDescending();
+
+    typename MultiArrayShape<N>::type lshape(sign == FFTW_FORWARD
+                                                ? ins.shape()
+                                                : outs.shape());
+
+    vigra_precondition((lshape == TinyVectorView<int, N>(shape.data())),
+        "FFTWBatchPlan::execute(): shape mismatch between plan and data.");
+    vigra_precondition((ins.stride() == TinyVectorView<int, N>(instrides.data())),
+        "FFTWBatchPlan::execute(): strides mismatch between plan and input data.");
+    vigra_precondition((outs.stride() == TinyVectorView<int, N>(outstrides.data())),
+        "FFTWBatchPlan::execute(): strides mismatch between plan and output data.");
+    vigra_precondition(inStack.shape(N) == batchSize,
+        "FFTWBatchPlan::execute(): number of arrays differs from plan.");
+    vigra_precondition(inStack.stride(N) == idist && outStack.stride(N) == odist,
+        "FFTWBatchPlan::execute(): stack strides mismatch between plan and data.");
+
+    TO norm = TO(1.0) / Real(outs.size());
+    int nChunks = (batchSize + chunkSize - 1) / chunkSize;
+
+    auto transformChunk = [&](size_t /* thread_id */, std::ptrdiff_t k)
+    {
+        MultiArrayIndex begin = k*chunkSize,
+                        end   = std::min<MultiArrayIndex>(begin + chunkSize, batchSize);
+        detail::fftwPlanExecute(end - begin == chunkSize ? plan : lastPlan,
+                                inStack.data() + begin*idist,
+                                outStack.data() + begin*odist);
+        if(sign == FFTW_BACKWARD)
+        {
+            typename MultiArrayShape<N+1>::type start, stop(outStack.shape());
+            start[N] = begin;
+            stop[N]  = end;
+            outStack.subarray(start, stop) *= norm;
+        }
+    };
+
+    if(nChunks == 1)
+        transformChunk(0, 0);
+    else
+        parallel_foreach(nChunks, nChunks, transformChunk);
+}
+
 /********************************************************/
 /*                                                      */
 /*                  FFTWConvolvePlan                    */
@@ -2156,6 +2597,127 @@ fourierTransformInverse(MultiArrayView<N, FFTWComplex<Real>, C1> in,
     FFTWPlan<N, Real>(in, out).execute(in, out);
 }
 
+/********************************************************/
+/*                                                      */
+/*                 fourierTransformMany                 */
+/*                                                      */
+/********************************************************/
+
+/** \brief Fourier transform all slices of an array stack at once.
+
+    The input and output arrays are interpreted as stacks of (N-1)-dimensional arrays,
+    where the last dimension enumerates the stack members. Each member is transformed
+    independently along the first N-1 dimensions, but all transforms are executed by
+    a single batched \ref FFTWBatchPlan. The optional <tt>ParallelOptions</tt> determine
+    how many threads are used to process the stack. Inverse transforms are normalized
+    like \ref fourierTransformInverse().
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class Real, class C1, class C2>
+        void
+        fourierTransformMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                             MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                             ParallelOptions const & options = ParallelOptions());
+
+        // real input: 'out' must either have the same shape as 'in', or
+        // out.shape(0) == in.shape(0) / 2 + 1 (R2C transform)
+        template <unsigned int N, class Real, class C1, class C2>
+        void
+        fourierTransformMany(MultiArrayView<N, Real, C1> in,
+                             MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                             ParallelOptions const & options = ParallelOptions());
+
+        template <unsigned int N, class Real, class C1, class C2>
+        void
+        fourierTransformInverseMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                                    MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                                    ParallelOptions const & options = ParallelOptions());
+
+        template <unsigned int N, class Real, class C1, class C2>
+        void
+        fourierTransformInverseMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                                    MultiArrayView<N, Real, C2> out,
+                                    ParallelOptions const & options = ParallelOptions());
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_fft.hxx\><br>
+    Namespace: vigra
+
+    \code
+    // 2D Fourier transforms of 1000 frames of a time-lapse sequence
+    MultiArray<3, float> frames(Shape3(w, h, 1000));
+    MultiArray<3, FFTWComplex<float> > fourier(Shape3(w / 2 + 1, h, 1000));
+
+    fourierTransformMany(frames, fourier, ParallelOptions().numThreads(8));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void fourierTransformMany)
+
+template <unsigned int N, class Real, class C1, class C2>
+inline void
+fourierTransformMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                     MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                     ParallelOptions const & options = ParallelOptions())
+{
+    FFTWBatchPlan<N-1, Real>(in, out, FFTW_FORWARD, FFTW_ESTIMATE, options).execute(in, out);
+}
+
+template <unsigned int N, class Real, class C1, class C2>
+void
+fourierTransformMany(MultiArrayView<N, Real, C1> in,
+                     MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                     ParallelOptions const & options = ParallelOptions())
+{
+    typedef typename MultiArrayShape<N-1>::type Shape;
+
+    vigra_precondition(in.shape(N-1) == out.shape(N-1),
+        "fourierTransformMany(): input and output must contain the same number of arrays.");
+    if(in.shape() == out.shape())
+    {
+        // copy the input array into the output and then perform in-place FFTs
+        out = in;
+        FFTWBatchPlan<N-1, Real>(out, out, FFTW_FORWARD, FFTW_ESTIMATE, options).execute(out, out);
+    }
+    else if(Shape(out.shape().begin()) == fftwCorrespondingShapeR2C(Shape(in.shape().begin())))
+    {
+        FFTWBatchPlan<N-1, Real>(in, out, FFTW_ESTIMATE, options).execute(in, out);
+    }
+    else
+        vigra_precondition(false,
+            "fourierTransformMany(): shape mismatch between input and output.");
+}
+
+doxygen_overloaded_function(template <...> void fourierTransformInverseMany)
+
+template <unsigned int N, class Real, class C1, class C2>
+inline void
+fourierTransformInverseMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                            MultiArrayView<N, FFTWComplex<Real>, C2> out,
+                            ParallelOptions const & options = ParallelOptions())
+{
+    FFTWBatchPlan<N-1, Real>(in, out, FFTW_BACKWARD, FFTW_ESTIMATE, options).execute(in, out);
+}
+
+template <unsigned int N, class Real, class C1, class C2>
+void
+fourierTransformInverseMany(MultiArrayView<N, FFTWComplex<Real>, C1> in,
+                            MultiArrayView<N, Real, C2> out,
+                            ParallelOptions const & options = ParallelOptions())
+{
+    typedef typename MultiArrayShape<N-1>::type Shape;
+
+    vigra_precondition(in.shape(N-1) == out.shape(N-1) &&
+                       Shape(in.shape().begin()) == fftwCorrespondingShapeR2C(Shape(out.shape().begin())),
+        "fourierTransformInverseMany(): shape mismatch between input and output.");
+    FFTWBatchPlan<N-1, Real>(in, out, FFTW_ESTIMATE, options).execute(in, out);
+}
+
 //@}
 
 /** \addtogroup ConvolutionFilters
@@ -136,6 +136,9 @@ class ChunkedArrayBase;
 template <unsigned int N, class T>
 class ChunkedArray;
 
+template <unsigned int N, class T>
+class MultiArrayMapped;
+
 /********************************************************/
 /*                                                      */
 /*                iterators / traversers                */
@@ -2727,6 +2727,122 @@ isInside(GridGraph<N, DirectedTag> const & g,
     return allLess(v, g.shape()) && allGreaterEqual(v, typename MultiArrayShape<N>::type());
 }
 
+    /** \brief Enumerate the edges of a GridGraph in bulk, one neighborhood offset at a time.
+
+        For every neighbor index <tt>k</tt> in <tt>[0, g.maxUniqueDegree())</tt>, the functor is
+        called once as
+        \code
+        f(k, start, stop, offset);
+        \endcode
+        where the edges with neighbor index <tt>k</tt> are exactly the pairs <tt>(u, u+offset)</tt>
+        with <tt>u</tt> in the box <tt>[start, stop)</tt>. The edge <tt>(u, k)</tt> is stored at
+        coordinate <tt>(u, k)</tt> of an edge map, so that <tt>edgeMap.bindOuter(k).subarray(start, stop)</tt>
+        and <tt>nodeMap.subarray(start+offset, stop+offset)</tt> are the corresponding strided slices.
+        Border handling is thus done once per offset instead of once per edge, and the functor
+        can process each slice with tight, vectorizable loops (see transformGridGraphEdges()).
+        Offsets whose box is empty (e.g. on a graph with extent 1 along some axis) are skipped.
+    */
+template <unsigned int N, class DirectedTag, class FUNCTOR>
+void
+gridGraphEdgeSlices(GridGraph<N, DirectedTag> const & g, FUNCTOR && f)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    for(MultiArrayIndex k = 0; k < (MultiArrayIndex)g.maxUniqueDegree(); ++k)
+    {
+        Shape const & offset = g.neighborOffset(k);
+        Shape start, stop(g.shape());
+        bool empty = false;
+        for(unsigned int d = 0; d < N; ++d)
+        {
+            if(offset[d] < 0)
+                start[d] = -offset[d];
+            else
+                stop[d] -= offset[d];
+            if(start[d] >= stop[d])
+                empty = true;
+        }
+        if(!empty)
+            f(k, start, stop, offset);
+    }
+}
+
+namespace detail {
+
+template <unsigned int K>
+struct GridGraphEdgeSliceLoop
+{
+    template <class U, class V, class E, class Shape, class FUNCTOR>
+    static void exec(U u, V v, E e, Shape const & shape,
+                     Shape const & us, Shape const & vs, Shape const & es, FUNCTOR & f)
+    {
+        for(MultiArrayIndex i = 0; i < shape[K]; ++i, u += us[K], v += vs[K], e += es[K])
+            GridGraphEdgeSliceLoop<K-1>::exec(u, v, e, shape, us, vs, es, f);
+    }
+};
+
+template <>
+struct GridGraphEdgeSliceLoop<0>
+{
+    template <class U, class V, class E, class Shape, class FUNCTOR>
+    static void exec(U u, V v, E e, Shape const & shape,
+                     Shape const & us, Shape const & vs, Shape const & es, FUNCTOR & f)
+    {
+        const MultiArrayIndex n = shape[0];
+        if(us[0] == 1 && vs[0] == 1 && es[0] == 1)
+        {
+            // contiguous innermost dimension: let the compiler vectorize
+            for(MultiArrayIndex i = 0; i < n; ++i)
+                e[i] = f(u[i], v[i]);
+        }
+        else
+        {
+            for(MultiArrayIndex i = 0; i < n; ++i)
+                e[i*es[0]] = f(u[i*us[0]], v[i*vs[0]]);
+        }
+    }
+};
+
+} // namespace detail
+
+    /** \brief Compute an edge map from a node map in bulk.
+
+        Sets <tt>edgeData[edge] = f(nodeData[u], nodeData[v])</tt> for every edge <tt>(u, v)</tt> of
+        the grid graph \a g. \a nodeData must have the graph's shape, and \a edgeData the shape
+        <tt>g.edge_propmap_shape()</tt> (as a <tt>GridGraph::EdgeMap</tt> has). Entries of
+        \a edgeData that do not correspond to an edge are left unchanged.
+
+        In contrast to a loop over <tt>GridGraph::EdgeIt</tt>, the edges are processed slice by
+        slice (see gridGraphEdgeSlices()) with raw pointer loops, so there are no per-edge border
+        checks or coordinate computations, and the innermost loop vectorizes when the arrays are
+        contiguous along the first axis.
+
+        <b>\#include</b> \<vigra/multi_gridgraph.hxx\><br>
+        Namespace: vigra
+    */
+template <unsigned int N, class DirectedTag, class T1, class S1, class T2, class S2, class FUNCTOR>
+void
+transformGridGraphEdges(GridGraph<N, DirectedTag> const & g,
+                        MultiArrayView<N, T1, S1> const & nodeData,
+                        MultiArrayView<N+1, T2, S2> edgeData,
+                        FUNCTOR f)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    vigra_precondition(nodeData.shape() == g.shape(),
+        "transformGridGraphEdges(): shape mismatch between graph and nodeData.");
+    vigra_precondition(edgeData.shape() == g.edge_propmap_shape(),
+        "transformGridGraphEdges(): shape mismatch between graph and edgeData.");
+
+    gridGraphEdgeSlices(g,
+        [&](MultiArrayIndex k, Shape const & start, Shape const & stop, Shape const & offset)
+        {
+            MultiArrayView<N, T1, StridedArrayTag> u(nodeData.subarray(start, stop)),
+                                                   v(nodeData.subarray(start+offset, stop+offset));
+            MultiArrayView<N, T2, StridedArrayTag> e(edgeData.bindOuter(k).subarray(start, stop));
+            detail::GridGraphEdgeSliceLoop<N-1>::exec(u.data(), v.data(), e.data(), e.shape(),
+                                                      u.stride(), v.stride(), e.stride(), f);
+        });
+}
+
 //@}
 
 #ifdef WITH_BOOST_GRAPH
@@ -49,6 +49,7 @@
 #include "impex.hxx"
 #include "multi_array.hxx"
 #include "multi_pointoperators.hxx"
+#include "threadpool.hxx"
 #include "sifImport.hxx"
 
 #ifdef _MSC_VER
@@ -106,10 +107,11 @@ class VolumeImportInfo
                 <li> height = [positive integer] (required)
                 <li> depth = [positive integer] (required)
                 <li> datatype = [ UINT8 | INT16 | UINT16 | INT32 | UINT32 | FLOAT | DOUBLE ] (required)
+                <li> bands = [positive integer] (optional, default: 1, bands are interleaved)
                 </UL>
                 Lines starting with "#" are ignored. To read the data correctly, the
-                value_type of the target MultiArray must match the datatype stored in the file.
-                Only single-band files are currently supported.
+                value_type of the target MultiArray must match the datatype stored in the file
+                (e.g. <tt>TinyVector<UInt8, 3></tt> for "datatype = UINT8" and "bands = 3").
             <li>If the name refers to a 2D image file, the constructor will attempt to decompose
                 the filename into the format <tt>base_name + slice_number + name_extension</tt>.
                 If this decomposition succeeds, all images with the same base_name and name_extension
@@ -225,9 +227,26 @@ class VolumeImportInfo
     template <class T, class Stride>
     void importImpl(MultiArrayView <3, T, Stride> &volume) const;
 
+    template <class T, class Stride>
+    void importImpl(MultiArrayView <3, T, Stride> volume,
+                    ParallelOptions const & options) const;
+
+    template <class T>
+    void importImpl(ChunkedArray<3, T> & volume,
+                    ParallelOptions const & options) const;
+
+    template <class T>
+    void mapImpl(MultiArrayMapped<3, T> & volume) const;
+
   protected:
     void getVolumeInfoFromFirstSlice(const std::string &filename);
 
+        // Decode the slices of a "STACK" or "MULTIPAGE" volume in parallel.
+        // f(thread_id, slice_info, z) is called once per slice, with
+        // at most options.getActualNumThreads() decoders open at any time.
+    template <class FUNCTOR>
+    void importSlicesParallel(ParallelOptions const & options, FUNCTOR f) const;
+
     size_type shape_;
     Resolution resolution_;
     //PixelType pixelType_;
@@ -580,6 +599,99 @@ void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> &volume) const
     }
 }
 
+template <class FUNCTOR>
+void VolumeImportInfo::importSlicesParallel(ParallelOptions const & options, FUNCTOR f) const
+{
+    vigra_precondition(fileType_ == "STACK" || fileType_ == "MULTIPAGE",
+        "VolumeImportInfo::importSlicesParallel(): file type must be 'STACK' or 'MULTIPAGE'.");
+
+    ThreadPool pool(options);
+    parallel_foreach(pool, shape_[2],
+        [&](size_t thread_id, MultiArrayIndex z)
+        {
+            // each task opens its own decoder, so there are never more
+            // files open than there are threads in the pool
+            if(fileType_ == "STACK")
+            {
+                std::string filename = baseName_ + numbers_[z] + extension_;
+                ImageImportInfo info(filename.c_str());
+                f(thread_id, info, z);
+            }
+            else
+            {
+                ImageImportInfo info(baseName_.c_str(), (unsigned int)z);
+                f(thread_id, info, z);
+            }
+        });
+}
+
+template <class T, class Stride>
+void VolumeImportInfo::importImpl(MultiArrayView <3, T, Stride> volume,
+                                  ParallelOptions const & options) const
+{
+    vigra_precondition(this->shape() == volume.shape(), "importVolume(): Output array must be shaped according to VolumeImportInfo.");
+
+    if(fileType_ != "STACK" && fileType_ != "MULTIPAGE")
+    {
+        // RAW and SIF data are not decoded slice by slice
+        importImpl(volume);
+        return;
+    }
+
+    importSlicesParallel(options,
+        [&volume](size_t, ImageImportInfo const & info, MultiArrayIndex z)
+        {
+            MultiArrayView <2, T, StridedArrayTag> view(volume.bindOuter(z));
+            vigra_precondition(view.shape() == info.shape(),
+                "importVolume(): the images have inconsistent sizes.");
+            importImage(info, view);
+        });
+}
+
+template <class T>
+void VolumeImportInfo::importImpl(ChunkedArray<3, T> & volume,
+                                  ParallelOptions const & options) const
+{
+    vigra_precondition(this->shape() == volume.shape(), "importVolume(): Output array must be shaped according to VolumeImportInfo.");
+
+    if(fileType_ != "STACK" && fileType_ != "MULTIPAGE")
+    {
+        MultiArray<3, T> buffer(shape_);
+        importImpl(buffer);
+        volume.commitSubarray(MultiArrayShape<3>::type(), buffer);
+        return;
+    }
+
+    // one slice buffer per thread, committed to the chunks after decoding
+    std::vector<MultiArray<3, T> > buffers(options.getActualNumThreads(),
+                                           MultiArray<3, T>(MultiArrayShape<3>::type(shape_[0], shape_[1], 1)));
+    importSlicesParallel(options,
+        [&volume, &buffers](size_t thread_id, ImageImportInfo const & info, MultiArrayIndex z)
+        {
+            MultiArray<3, T> & buffer = buffers[thread_id];
+            vigra_precondition(buffer.bindOuter(0).shape() == info.shape(),
+                "importVolume(): the images have inconsistent sizes.");
+            importImage(info, buffer.bindOuter(0));
+            volume.commitSubarray(MultiArrayShape<3>::type(0, 0, z), buffer);
+        });
+}
+template <class T>
+void VolumeImportInfo::mapImpl(MultiArrayMapped<3, T> & volume) const
+{
+    vigra_precondition(fileType_ == "RAW",
+        "mapVolume(): only RAW volumes can be memory-mapped.");
+
+    typedef typename ExpandElementResult<T>::type ScalarType;
+    vigra_precondition(TypeAsString<ScalarType>::result() == pixelType_ &&
+                       numBands_ == (int)ExpandElementResult<T>::size &&
+                       sizeof(T) == sizeof(ScalarType)*ExpandElementResult<T>::size,
+        "mapVolume(): value_type of the array doesn't match the datatype in the .info file.");
+
+    bool absolute = rawFilename_.size() > 0 &&
+                    (rawFilename_[0] == '/' || rawFilename_[0] == '\\' ||
+                     (rawFilename_.size() > 1 && rawFilename_[1] == ':'));
+    volume.map(absolute ? rawFilename_ : path_ + "/" + rawFilename_, shape_);
+}
 
 VIGRA_EXPORT void findImageSequence(const std::string &name_base,
                        const std::string &name_ext,
@@ -615,6 +727,28 @@ VIGRA_EXPORT void findImageSequence(const std::string &name_base,
         importVolume(MultiArray <3, T, Allocator> & volume,
                      const std::string &name_base,
                      const std::string &name_ext);
+
+        // variant 4: like variant 1, but decode the slices in parallel
+        template <class T, class Stride>
+        void
+        importVolume(VolumeImportInfo const & info,
+                     MultiArrayView <3, T, Stride> volume,
+                     ParallelOptions const & options);
+
+        // variant 5: decode the slices in parallel and write them into a chunked array
+        // (requires \#include \<vigra/multi_array_chunked.hxx\>)
+        template <class T>
+        void
+        importVolume(VolumeImportInfo const & info,
+                     ChunkedArray <3, T> & volume,
+                     ParallelOptions const & options = ParallelOptions());
+
+        // map a RAW volume into memory without reading it
+        // (requires \#include \<vigra/multi_array_mapped.hxx\>)
+        template <class T>
+        void
+        mapVolume(VolumeImportInfo const & info,
+                  MultiArrayMapped <3, T> & volume);
     }
     \endcode
 
@@ -661,6 +795,31 @@ VIGRA_EXPORT void findImageSequence(const std::string &name_base,
     will be interpreted according to their numerical order (i.e. "009", "010", "011"
     are read in the same order as "9", "10", "11"). The number of images
     found determines the depth of the volume.
+
+    Variants 4 and 5 decode the slices of an image stack or the pages of a multi-page
+    TIFF concurrently, using as many threads as requested by \ref ParallelOptions.
+    Each thread opens only one file at a time, so the number of threads also bounds
+    the number of open files. Variant 5 writes each decoded slice directly into the
+    chunks of the destination \ref ChunkedArray, so that the volume never has to fit
+    into memory as a whole. RAW and SIF data are read sequentially.
+    \code
+    VolumeImportInfo info("my_data", ".png");
+    MultiArray<3, UInt8> volume(info.shape());
+    importVolume(info, volume, ParallelOptions().numThreads(8));
+
+    ChunkedArrayCompressed<3, UInt8> chunked(info.shape());
+    importVolume(info, chunked);
+    \endcode
+
+    RAW volumes (described by a ".info" file) can alternatively be memory-mapped by
+    mapVolume(). The volume is then not read at all: the \ref MultiArrayMapped
+    refers directly to the file contents, which are loaded on demand by the operating
+    system and don't consume private memory.
+    \code
+    VolumeImportInfo info("my_volume.info");
+    MultiArrayMapped<3, UInt16> volume;
+    mapVolume(info, volume);
+    \endcode
 */
 doxygen_overloaded_function(template <...> void importVolume)
 
@@ -694,6 +853,32 @@ void importVolume (MultiArray <3, T, Allocator> & volume,
     info.importImpl(volume);
 }
 
+template <class T, class Stride>
+void
+importVolume(VolumeImportInfo const & info,
+             MultiArrayView <3, T, Stride> volume,
+             ParallelOptions const & options)
+{
+    info.importImpl(volume, options);
+}
+
+template <class T>
+void
+importVolume(VolumeImportInfo const & info,
+             ChunkedArray <3, T> & volume,
+             ParallelOptions const & options = ParallelOptions())
+{
+    info.importImpl(volume, options);
+}
+
+template <class T>
+void
+mapVolume(VolumeImportInfo const & info,
+          MultiArrayMapped <3, T> & volume)
+{
+    info.mapImpl(volume);
+}
+
 namespace detail {
 
 template <class T>
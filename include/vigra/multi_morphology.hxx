@@ -39,6 +39,8 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <functional>
 #include "multi_distance.hxx"
 #include "array_vector.hxx"
 #include "multi_array.hxx"
@@ -139,6 +141,9 @@ struct MultiBinaryMorphologyImpl<bool, bool>
     dimensional array that is specified by iterators (compatible to \ref MultiIteratorPage)
     and shape objects. It can therefore be applied to a wide range of data structures
     (\ref vigra::MultiArrayView, \ref vigra::MultiArray etc.).
+    
+    Besides the parabolic operators, flat morphology with box-shaped and line-shaped
+    structuring elements is provided (see \ref multiBoxErosion() and \ref multiLineErosion()).
 */
 //@{
 
@@ -672,6 +677,763 @@ multiGrayscaleDilation(MultiArrayView<N, T1, S1> const & source,
                             destMultiArray(dest), sigma);
 }
 
+/********************************************************/
+/*                                                      */
+/*      flat morphology with box and line elements      */
+/*                                                      */
+/********************************************************/
+
+namespace detail {
+
+    // Running minima (or maxima, depending on 'cmp') by the algorithm of
+    // van Herk and Gil/Werman: 'ext' is divided into blocks of length 'size',
+    // and the prefix and suffix extrema within each block are stored in 'g' and 'h'.
+    // A window of length 'size' starting at j covers the end of one block and
+    // the beginning of the next, so that its extremum is cmp(h[j], g[j+size-1]).
+template <class T, class Compare>
+void
+vanHerkGilWermanLine(T const * ext, MultiArrayIndex m, MultiArrayIndex size,
+                     T * g, T * h, Compare cmp)
+{
+    for(MultiArrayIndex k = 0; k < m; k += size)
+    {
+        MultiArrayIndex e = std::min(k + size, m);
+        g[k] = ext[k];
+        for(MultiArrayIndex j = k+1; j < e; ++j)
+            g[j] = cmp(ext[j], g[j-1]) ? ext[j] : g[j-1];
+        h[e-1] = ext[e-1];
+        for(MultiArrayIndex j = e-2; j >= k; --j)
+            h[j] = cmp(ext[j], h[j+1]) ? ext[j] : h[j+1];
+    }
+}
+
+    // Apply the flat line element { k*step | -before <= k < size-before } to all
+    // lines of the array that run in direction 'step'. Since the element is
+    // contiguous along each line, clipping it at the array border is equivalent
+    // to repeating the first and last element of the line.
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2,
+          class Compare>
+void
+flatLineMorphology(MultiArrayView<N, T1, S1> const & src,
+                   MultiArrayView<N, T2, S2> dest,
+                   typename MultiArrayShape<N>::type const & step,
+                   MultiArrayIndex size, MultiArrayIndex before, Compare cmp)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    Shape shape(src.shape());
+    MultiArrayIndex srcStep  = dot(step, src.stride()),
+                    destStep = dot(step, dest.stride());
+    ArrayVector<T2> ext, g, h;
+
+    MultiCoordinateIterator<N> p(shape), end = p.getEndIterator();
+    for(; p != end; ++p)
+    {
+        if(src.isInside(*p - step))
+            continue; // *p is not the first point of a line
+
+        MultiArrayIndex n = NumericTraits<MultiArrayIndex>::max();
+        for(unsigned int k=0; k<N; ++k)
+        {
+            if(step[k] > 0)
+                n = std::min(n, (shape[k] - 1 - (*p)[k]) / step[k]);
+            else if(step[k] < 0)
+                n = std::min(n, (*p)[k] / -step[k]);
+        }
+        n += 1;
+
+        MultiArrayIndex m = n + size - 1;
+        if((MultiArrayIndex)ext.size() < m)
+        {
+            ext.resize(m);
+            g.resize(m);
+            h.resize(m);
+        }
+
+        T1 const * s = &src[*p];
+        for(MultiArrayIndex k=0; k<n; ++k, s += srcStep)
+            ext[before+k] = detail::RequiresExplicitCast<T2>::cast(*s);
+        std::fill(ext.begin(), ext.begin()+before, ext[before]);
+        std::fill(ext.begin()+before+n, ext.begin()+m, ext[before+n-1]);
+
+        vanHerkGilWermanLine(ext.begin(), m, size, g.begin(), h.begin(), cmp);
+
+        T2 * d = &dest[*p];
+        for(MultiArrayIndex k=0; k<n; ++k, d += destStep)
+            *d = cmp(h[k], g[k+size-1]) ? h[k] : g[k+size-1];
+    }
+}
+
+    // Erosion or dilation with the union of line segments 'segments' (given as
+    // pairs of step vector and length), applied one after the other.
+    // When 'reflect' is true, the segments are mirrored at the origin.
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+flatSegmentMorphology(MultiArrayView<N, T1, S1> const & src,
+                      MultiArrayView<N, T2, S2> dest,
+                      ArrayVector<std::pair<typename MultiArrayShape<N>::type, MultiArrayIndex> > const & segments,
+                      bool dilation, bool reflect)
+{
+    bool first = true;
+    for(unsigned int k=0; k<segments.size(); ++k)
+    {
+        MultiArrayIndex size = segments[k].second;
+        if(size == 1)
+            continue;
+        MultiArrayIndex before = reflect
+                                     ? size - 1 - size / 2
+                                     : size / 2;
+        if(first)
+        {
+            if(dilation)
+                flatLineMorphology(src, dest, segments[k].first, size, before, std::greater<T2>());
+            else
+                flatLineMorphology(src, dest, segments[k].first, size, before, std::less<T2>());
+            first = false;
+        }
+        else
+        {
+            if(dilation)
+                flatLineMorphology(dest, dest, segments[k].first, size, before, std::greater<T2>());
+            else
+                flatLineMorphology(dest, dest, segments[k].first, size, before, std::less<T2>());
+        }
+    }
+    if(first)
+        copyMultiArray(srcMultiArrayRange(src), destMultiArray(dest));
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+flatSegmentOpening(MultiArrayView<N, T1, S1> const & src,
+                   MultiArrayView<N, T2, S2> dest,
+                   ArrayVector<std::pair<typename MultiArrayShape<N>::type, MultiArrayIndex> > const & segments,
+                   bool closing)
+{
+    flatSegmentMorphology(src, dest, segments, closing, false);
+    flatSegmentMorphology(dest, dest, segments, !closing, true);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+bool
+flatMorphologyArraysOverlap(MultiArrayView<N, T1, S1> const & src,
+                            MultiArrayView<N, T2, S2> const & dest)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    char const * s0 = reinterpret_cast<char const *>(src.data()),
+               * s1 = reinterpret_cast<char const *>(&src[src.shape() - Shape(1)]),
+               * d0 = reinterpret_cast<char const *>(dest.data()),
+               * d1 = reinterpret_cast<char const *>(&dest[dest.shape() - Shape(1)]);
+    if(s1 < s0)
+        std::swap(s0, s1);
+    if(d1 < d0)
+        std::swap(d0, d1);
+    return !(s1 + sizeof(T1) <= d0 || d1 + sizeof(T2) <= s0);
+}
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+flatSegmentTopHat(MultiArrayView<N, T1, S1> const & src,
+                  MultiArrayView<N, T2, S2> dest,
+                  ArrayVector<std::pair<typename MultiArrayShape<N>::type, MultiArrayIndex> > const & segments,
+                  bool black)
+{
+    if(flatMorphologyArraysOverlap(src, dest))
+    {
+        // the opening would overwrite the input
+        MultiArray<N, T1> tmp(src);
+        flatSegmentTopHat(tmp, dest, segments, black);
+        return;
+    }
+
+    using namespace vigra::functor;
+
+    flatSegmentOpening(src, dest, segments, black);
+    if(black)
+        combineTwoMultiArrays(srcMultiArrayRange(dest), srcMultiArray(src), destMultiArray(dest),
+                              Arg1() - Arg2());
+    else
+        combineTwoMultiArrays(srcMultiArrayRange(src), srcMultiArray(dest), destMultiArray(dest),
+                              Arg1() - Arg2());
+}
+
+template <unsigned int N>
+ArrayVector<std::pair<typename MultiArrayShape<N>::type, MultiArrayIndex> >
+boxSegments(typename MultiArrayShape<N>::type const & windowShape)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    ArrayVector<std::pair<Shape, MultiArrayIndex> > segments;
+    for(unsigned int k=0; k<N; ++k)
+        segments.push_back(std::make_pair(Shape::unitVector(k), windowShape[k]));
+    return segments;
+}
+
+template <unsigned int N>
+ArrayVector<std::pair<typename MultiArrayShape<N>::type, MultiArrayIndex> >
+lineSegments(typename MultiArrayShape<N>::type const & step, MultiArrayIndex length)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    return ArrayVector<std::pair<Shape, MultiArrayIndex> >(1, std::make_pair(step, length));
+}
+
+} // namespace detail
+
+/********************************************************/
+/*                                                      */
+/*                  multiBoxErosion                     */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat erosion with a box-shaped structuring element on multi-dimensional arrays.
+
+    For every element, the function computes the minimum of <tt>source</tt> in the window
+    <tt>[x - windowShape / 2, x - windowShape / 2 + windowShape)</tt>, which is
+    symmetric around <tt>x</tt> when all window sizes are odd. Parts of the window
+    outside of the array are ignored.
+
+    The box is decomposed into line segments along the coordinate axes, and each line is
+    processed with the algorithm of van Herk and Gil/Werman. It needs three comparisons
+    per element and dimension, regardless of the window size, so that large boxes
+    (e.g. for background subtraction) are as cheap as small ones.
+    This function may work in-place, and the input and output types may differ
+    (intermediate results are stored in the destination type).
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxErosion(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> source(Shape3(width, height, depth)),
+                         dest(source.shape());
+    ...
+    // minimum of each 31x31x5 neighborhood
+    multiBoxErosion(source, dest, Shape3(31, 31, 5));
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    source.shape() == dest.shape()
+    windowShape.all() > 0
+    \endcode
+
+    \see multiBoxDilation(), multiBoxOpening(), multiBoxWhiteTopHat(), multiLineErosion()
+*/
+doxygen_overloaded_function(template <...> void multiBoxErosion)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxErosion(MultiArrayView<N, T1, S1> const & source,
+                MultiArrayView<N, T2, S2> dest,
+                typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxErosion(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxErosion(): window shape must be positive.");
+    detail::flatSegmentMorphology(source, dest, detail::boxSegments<N>(windowShape), false, false);
+}
+
+/********************************************************/
+/*                                                      */
+/*                  multiBoxDilation                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat dilation with a box-shaped structuring element on multi-dimensional arrays.
+
+    Computes the maximum of <tt>source</tt> in the same window as \ref multiBoxErosion(),
+    with the same complexity and options.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxDilation(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiBoxDilation)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxDilation(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxDilation(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxDilation(): window shape must be positive.");
+    detail::flatSegmentMorphology(source, dest, detail::boxSegments<N>(windowShape), true, false);
+}
+
+/********************************************************/
+/*                                                      */
+/*             multiBoxOpening, multiBoxClosing         */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat opening with a box-shaped structuring element on multi-dimensional arrays.
+
+    Performs \ref multiBoxErosion() followed by \ref multiBoxDilation() with the
+    mirrored window (which is the same window when all sizes are odd).
+    The function may work in-place.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxOpening(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiBoxOpening)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxOpening(MultiArrayView<N, T1, S1> const & source,
+                MultiArrayView<N, T2, S2> dest,
+                typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxOpening(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxOpening(): window shape must be positive.");
+    detail::flatSegmentOpening(source, dest, detail::boxSegments<N>(windowShape), false);
+}
+
+/** \brief Flat closing with a box-shaped structuring element on multi-dimensional arrays.
+
+    Performs \ref multiBoxDilation() followed by \ref multiBoxErosion() with the
+    mirrored window (which is the same window when all sizes are odd).
+    The function may work in-place.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxClosing(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiBoxClosing)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxClosing(MultiArrayView<N, T1, S1> const & source,
+                MultiArrayView<N, T2, S2> dest,
+                typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxClosing(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxClosing(): window shape must be positive.");
+    detail::flatSegmentOpening(source, dest, detail::boxSegments<N>(windowShape), true);
+}
+
+/********************************************************/
+/*                                                      */
+/*      multiBoxWhiteTopHat, multiBoxBlackTopHat        */
+/*                                                      */
+/********************************************************/
+
+/** \brief White top-hat transform with a box-shaped structuring element.
+
+    Computes <tt>source - multiBoxOpening(source)</tt>, i.e. the bright structures
+    that do not contain the box. With a box larger than the objects of interest,
+    this is a standard method to subtract an uneven background.
+    The function may work in-place (a temporary copy of the input is created in this case).
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxWhiteTopHat(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest,
+                            typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, UInt16> image(Shape2(w, h)), foreground(image.shape());
+    ...
+    // remove the background from an image with cells of diameter up to 40 pixels
+    multiBoxWhiteTopHat(image, foreground, Shape2(41));
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiBoxWhiteTopHat)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxWhiteTopHat(MultiArrayView<N, T1, S1> const & source,
+                    MultiArrayView<N, T2, S2> dest,
+                    typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxWhiteTopHat(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxWhiteTopHat(): window shape must be positive.");
+    detail::flatSegmentTopHat(source, dest, detail::boxSegments<N>(windowShape), false);
+}
+
+/** \brief Black top-hat transform with a box-shaped structuring element.
+
+    Computes <tt>multiBoxClosing(source) - source</tt>, i.e. the dark structures
+    that do not contain the box.
+    The function may work in-place (a temporary copy of the input is created in this case).
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiBoxBlackTopHat(MultiArrayView<N, T1, S1> const & source,
+                            MultiArrayView<N, T2, S2> dest,
+                            typename MultiArrayShape<N>::type const & windowShape);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiBoxBlackTopHat)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiBoxBlackTopHat(MultiArrayView<N, T1, S1> const & source,
+                    MultiArrayView<N, T2, S2> dest,
+                    typename MultiArrayShape<N>::type const & windowShape)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiBoxBlackTopHat(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, typename MultiArrayShape<N>::type()),
+        "multiBoxBlackTopHat(): window shape must be positive.");
+    detail::flatSegmentTopHat(source, dest, detail::boxSegments<N>(windowShape), true);
+}
+
+/********************************************************/
+/*                                                      */
+/*                  multiLineErosion                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat erosion with a line-shaped structuring element on multi-dimensional arrays.
+
+    The structuring element consists of the <tt>length</tt> points
+    <tt>x + k*step</tt> with <tt>-length/2 <= k < length - length/2</tt>. The direction
+    <tt>step</tt> is an arbitrary non-zero offset vector, e.g. <tt>Shape2(1, 1)</tt> for a
+    diagonal line or <tt>Shape3(0, 0, 1)</tt> for a line along the z-axis. When the
+    components of <tt>step</tt> are not in <tt>{-1, 0, 1}</tt>, the element is a periodic
+    line (i.e. the points are not neighbors in the grid), and unions of such lines can
+    approximate lines of arbitrary orientation. Parts of the line outside of the
+    array are ignored.
+
+    Each grid line in direction <tt>step</tt> is processed with the algorithm of van Herk and
+    Gil/Werman, which needs three comparisons per element regardless of <tt>length</tt>.
+    This function may work in-place.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineErosion(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & step,
+                         MultiArrayIndex length);
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_morphology.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<2, float> source(Shape2(width, height)),
+                         dest(source.shape());
+    ...
+    // minimum along diagonal lines of 15 pixels
+    multiLineErosion(source, dest, Shape2(1, 1), 15);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    source.shape() == dest.shape()
+    step != 0
+    length > 0
+    \endcode
+
+    \see multiLineDilation(), multiLineOpening(), multiLineWhiteTopHat(), multiBoxErosion()
+*/
+doxygen_overloaded_function(template <...> void multiLineErosion)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineErosion(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 typename MultiArrayShape<N>::type const & step,
+                 MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineErosion(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineErosion(): step must be non-zero and length positive.");
+    detail::flatSegmentMorphology(source, dest, detail::lineSegments<N>(step, length), false, false);
+}
+
+/********************************************************/
+/*                                                      */
+/*                  multiLineDilation                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat dilation with a line-shaped structuring element on multi-dimensional arrays.
+
+    Computes the maximum of <tt>source</tt> along the same line as \ref multiLineErosion(),
+    with the same complexity and options.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineDilation(MultiArrayView<N, T1, S1> const & source,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & step,
+                          MultiArrayIndex length);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiLineDilation)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineDilation(MultiArrayView<N, T1, S1> const & source,
+                  MultiArrayView<N, T2, S2> dest,
+                  typename MultiArrayShape<N>::type const & step,
+                  MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineDilation(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineDilation(): step must be non-zero and length positive.");
+    detail::flatSegmentMorphology(source, dest, detail::lineSegments<N>(step, length), true, false);
+}
+
+/********************************************************/
+/*                                                      */
+/*            multiLineOpening, multiLineClosing        */
+/*                                                      */
+/********************************************************/
+
+/** \brief Flat opening with a line-shaped structuring element on multi-dimensional arrays.
+
+    Performs \ref multiLineErosion() followed by \ref multiLineDilation() with the
+    mirrored line. The function may work in-place.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineOpening(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & step,
+                         MultiArrayIndex length);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiLineOpening)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineOpening(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 typename MultiArrayShape<N>::type const & step,
+                 MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineOpening(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineOpening(): step must be non-zero and length positive.");
+    detail::flatSegmentOpening(source, dest, detail::lineSegments<N>(step, length), false);
+}
+
+/** \brief Flat closing with a line-shaped structuring element on multi-dimensional arrays.
+
+    Performs \ref multiLineDilation() followed by \ref multiLineErosion() with the
+    mirrored line. The function may work in-place.
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineClosing(MultiArrayView<N, T1, S1> const & source,
+                         MultiArrayView<N, T2, S2> dest,
+                         typename MultiArrayShape<N>::type const & step,
+                         MultiArrayIndex length);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiLineClosing)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineClosing(MultiArrayView<N, T1, S1> const & source,
+                 MultiArrayView<N, T2, S2> dest,
+                 typename MultiArrayShape<N>::type const & step,
+                 MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineClosing(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineClosing(): step must be non-zero and length positive.");
+    detail::flatSegmentOpening(source, dest, detail::lineSegments<N>(step, length), true);
+}
+
+/********************************************************/
+/*                                                      */
+/*     multiLineWhiteTopHat, multiLineBlackTopHat       */
+/*                                                      */
+/********************************************************/
+
+/** \brief White top-hat transform with a line-shaped structuring element.
+
+    Computes <tt>source - multiLineOpening(source)</tt>. This enhances bright
+    structures that are narrower than the line in its direction, e.g. thin
+    vessels or fibers perpendicular to the line.
+    The function may work in-place (a temporary copy of the input is created in this case).
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineWhiteTopHat(MultiArrayView<N, T1, S1> const & source,
+                             MultiArrayView<N, T2, S2> dest,
+                             typename MultiArrayShape<N>::type const & step,
+                             MultiArrayIndex length);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiLineWhiteTopHat)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineWhiteTopHat(MultiArrayView<N, T1, S1> const & source,
+                     MultiArrayView<N, T2, S2> dest,
+                     typename MultiArrayShape<N>::type const & step,
+                     MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineWhiteTopHat(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineWhiteTopHat(): step must be non-zero and length positive.");
+    detail::flatSegmentTopHat(source, dest, detail::lineSegments<N>(step, length), false);
+}
+
+/** \brief Black top-hat transform with a line-shaped structuring element.
+
+    Computes <tt>multiLineClosing(source) - source</tt>.
+    The function may work in-place (a temporary copy of the input is created in this case).
+
+    <b> Declaration:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiLineBlackTopHat(MultiArrayView<N, T1, S1> const & source,
+                             MultiArrayView<N, T2, S2> dest,
+                             typename MultiArrayShape<N>::type const & step,
+                             MultiArrayIndex length);
+    }
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiLineBlackTopHat)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiLineBlackTopHat(MultiArrayView<N, T1, S1> const & source,
+                     MultiArrayView<N, T2, S2> dest,
+                     typename MultiArrayShape<N>::type const & step,
+                     MultiArrayIndex length)
+{
+    vigra_precondition(source.shape() == dest.shape(),
+        "multiLineBlackTopHat(): shape mismatch between input and output.");
+    vigra_precondition(step != typename MultiArrayShape<N>::type() && length > 0,
+        "multiLineBlackTopHat(): step must be non-zero and length positive.");
+    detail::flatSegmentTopHat(source, dest, detail::lineSegments<N>(step, length), true);
+}
+
 //@}
 
 } //-- namespace vigra
@@ -0,0 +1,598 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#ifndef VIGRA_MULTI_RANK_FILTER_HXX
+#define VIGRA_MULTI_RANK_FILTER_HXX
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "multi_array.hxx"
+#include "multi_blocking.hxx"
+#include "multi_blockwise.hxx"
+#include "bordertreatment.hxx"
+#include "threadpool.hxx"
+
+namespace vigra {
+
+namespace detail {
+
+    // Map a (possibly out-of-range) coordinate into [0, size) according
+    // to the border treatment. Returns -1 when the value is zero-padded.
+inline MultiArrayIndex
+rankFilterBorderIndex(MultiArrayIndex i, MultiArrayIndex size, BorderTreatmentMode border)
+{
+    if(i >= 0 && i < size)
+        return i;
+    switch(border)
+    {
+      case BORDER_TREATMENT_REPEAT:
+        return i < 0 ? 0 : size - 1;
+      case BORDER_TREATMENT_REFLECT:
+      {
+        if(size == 1)
+            return 0;
+        MultiArrayIndex period = 2*(size - 1);
+        i = (i < 0 ? -i : i) % period;
+        return i < size ? i : period - i;
+      }
+      case BORDER_TREATMENT_WRAP:
+        i %= size;
+        return i < 0 ? i + size : i;
+      default: // BORDER_TREATMENT_ZEROPAD
+        return -1;
+    }
+}
+
+    // Copy the region [begin, begin + buffer.shape()) of 'src' into 'buffer',
+    // where coordinates outside of 'src' are resolved by the border treatment.
+template <unsigned int N, class T1, class S1, class T2>
+void
+rankFilterCopyBlock(MultiArrayView<N, T1, S1> const & src,
+                    MultiArray<N, T2> & buffer,
+                    typename MultiArrayShape<N>::type const & begin,
+                    BorderTreatmentMode border)
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+
+    ArrayVector<ArrayVector<MultiArrayIndex> > indexMap(N);
+    for(unsigned int d=0; d<N; ++d)
+    {
+        indexMap[d].resize(buffer.shape(d));
+        for(MultiArrayIndex k=0; k<buffer.shape(d); ++k)
+            indexMap[d][k] = rankFilterBorderIndex(begin[d] + k, src.shape(d), border);
+    }
+
+    typename MultiArray<N, T2>::iterator b = buffer.begin(), bend = buffer.end();
+    for(; b != bend; ++b)
+    {
+        Shape p;
+        bool inside = true;
+        for(unsigned int d=0; d<N; ++d)
+        {
+            p[d] = indexMap[d][b.point()[d]];
+            if(p[d] < 0)
+                inside = false;
+        }
+        *b = inside ? T2(src[p]) : T2();
+    }
+}
+
+template <class T>
+inline int
+rankFilterBin(T v)
+{
+    return (int)v - (int)std::numeric_limits<T>::min();
+}
+
+template <class T>
+inline T
+rankFilterValue(int bin)
+{
+    return T(bin + (int)std::numeric_limits<T>::min());
+}
+
+    // Helper class to compute the rank filter on a block whose border has already
+    // been resolved, i.e. 'buffer.shape() == dest.shape() + windowShape - 1'.
+    // Output is computed line by line along dimension 0. The primary template
+    // keeps the values of the current window in a sorted array and updates it
+    // by merging when the window slides. It is used for floating point and
+    // large integer types.
+template <class T,
+          int BITS = std::is_integral<T>::value ? 8*(int)sizeof(T) : 0>
+struct RankFilterBlock
+{
+    template <unsigned int N, class T2, class S2>
+    static void
+    exec(MultiArrayView<N, T> const & buffer,
+         MultiArrayView<N, T2, S2> dest,
+         typename MultiArrayShape<N>::type const & windowShape,
+         MultiArrayIndex rankIndex)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+
+        std::vector<T> window, merged, entering, leaving;
+
+        Shape lineShape(dest.shape());
+        lineShape[0] = 1;
+        MultiCoordinateIterator<N> line(lineShape), lineEnd = line.getEndIterator();
+        for(; line != lineEnd; ++line)
+        {
+            Shape p(*line), wbegin(p), wend(p + windowShape);
+
+            window.clear();
+            collect(buffer.subarray(wbegin, wend), window);
+            std::sort(window.begin(), window.end());
+
+            for(MultiArrayIndex x=0; x<dest.shape(0); ++x)
+            {
+                if(x > 0)
+                {
+                    wbegin[0] = x - 1;
+                    wend[0]   = x;
+                    leaving.clear();
+                    collect(buffer.subarray(wbegin, wend), leaving);
+                    std::sort(leaving.begin(), leaving.end());
+
+                    wbegin[0] = x + windowShape[0] - 1;
+                    wend[0]   = x + windowShape[0];
+                    entering.clear();
+                    collect(buffer.subarray(wbegin, wend), entering);
+                    std::sort(entering.begin(), entering.end());
+
+                    // merged = (window \ leaving) + entering, in sorted order
+                    merged.clear();
+                    typename std::vector<T>::const_iterator l = leaving.begin(),
+                                                            e = entering.begin();
+                    for(typename std::vector<T>::const_iterator w = window.begin();
+                        w != window.end(); ++w)
+                    {
+                        if(l != leaving.end() && !(*w < *l) && !(*l < *w))
+                        {
+                            ++l;
+                            continue;
+                        }
+                        for(; e != entering.end() && *e < *w; ++e)
+                            merged.push_back(*e);
+                        merged.push_back(*w);
+                    }
+                    merged.insert(merged.end(), e, entering.cend());
+                    window.swap(merged);
+                }
+                p[0] = x;
+                dest[p] = window[rankIndex];
+            }
+        }
+    }
+
+    template <unsigned int N>
+    static void
+    collect(MultiArrayView<N, T> const & a, std::vector<T> & res)
+    {
+        res.insert(res.end(), a.begin(), a.end());
+    }
+};
+
+    // Histogram-based rank filter for 8-bit types according to
+    //
+    //     S. Perreault and P. Hebert: "Median Filtering in Constant Time",
+    //     IEEE Trans. Image Processing 16(9), 2007
+    //
+    // generalized to N dimensions: For every x-position of the buffer, a
+    // column histogram collects the values in the window's extent along the
+    // dimensions 1...N-1. When the window moves by one step along dimension 1,
+    // each column histogram is updated by removing and adding one (N-2)-dimensional
+    // slab. The window histogram for the current line is then maintained by adding
+    // the entering and subtracting the leaving column histogram, so that the cost per
+    // pixel is independent of the window size in dimensions 0 and 1.
+template <class T>
+struct RankFilterBlock<T, 8>
+{
+    enum { Bins = 256, CoarseShift = 4, CoarseBins = Bins >> CoarseShift };
+
+    template <unsigned int N, class T2, class S2>
+    static void
+    exec(MultiArrayView<N, T> const & buffer,
+         MultiArrayView<N, T2, S2> dest,
+         typename MultiArrayShape<N>::type const & windowShape,
+         MultiArrayIndex rankIndex)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+
+        MultiArrayIndex width = buffer.shape(0);
+        MultiArray<2, int> fine(Shape2(Bins, width)),
+                           coarse(Shape2(CoarseBins, width));
+        int hist[Bins], coarseHist[CoarseBins];
+
+        Shape lineShape(dest.shape()), previous;
+        lineShape[0] = 1;
+        bool first = true;
+        MultiCoordinateIterator<N> line(lineShape), lineEnd = line.getEndIterator();
+        for(; line != lineEnd; ++line)
+        {
+            Shape p(*line), wbegin(p), wend(p + windowShape);
+            wbegin[0] = 0;
+            wend[0]   = width;
+
+            bool incremental = !first && N > 1 && p[1] == previous[1] + 1;
+            for(unsigned int d=2; d<N && incremental; ++d)
+                incremental = p[d] == previous[d];
+
+            if(incremental)
+            {
+                // slide the column histograms by one step along dimension 1
+                Shape sbegin(wbegin), send(wend);
+                sbegin[1] = previous[1];
+                send[1]   = previous[1] + 1;
+                updateColumns(buffer.subarray(sbegin, send), fine, coarse, -1);
+                sbegin[1] = p[1] + windowShape[1] - 1;
+                send[1]   = p[1] + windowShape[1];
+                updateColumns(buffer.subarray(sbegin, send), fine, coarse, 1);
+            }
+            else
+            {
+                fine.init(0);
+                coarse.init(0);
+                updateColumns(buffer.subarray(wbegin, wend), fine, coarse, 1);
+            }
+            previous = p;
+            first = false;
+
+            std::fill(hist, hist+Bins, 0);
+            std::fill(coarseHist, coarseHist+CoarseBins, 0);
+            for(MultiArrayIndex x=0; x<windowShape[0]; ++x)
+                addColumn(hist, coarseHist, fine, coarse, x, x);
+
+            for(MultiArrayIndex x=0; x<dest.shape(0); ++x)
+            {
+                if(x > 0)
+                    addColumn(hist, coarseHist, fine, coarse, x + windowShape[0] - 1, x - 1);
+
+                // find the coarse bin containing the requested rank, then the fine bin
+                int c = 0, count = 0;
+                for(; count + coarseHist[c] <= rankIndex; ++c)
+                    count += coarseHist[c];
+                int b = c << CoarseShift;
+                for(; count + hist[b] <= rankIndex; ++b)
+                    count += hist[b];
+
+                p[0] = x;
+                dest[p] = rankFilterValue<T>(b);
+            }
+        }
+    }
+
+    template <unsigned int N>
+    static void
+    updateColumns(MultiArrayView<N, T> const & a,
+                  MultiArray<2, int> & fine, MultiArray<2, int> & coarse, int delta)
+    {
+        typename MultiArrayView<N, T>::const_iterator i = a.begin(), end = a.end();
+        for(; i != end; ++i)
+        {
+            int b = rankFilterBin(*i);
+            MultiArrayIndex x = i.point()[0];
+            fine(b, x) += delta;
+            coarse(b >> CoarseShift, x) += delta;
+        }
+    }
+
+        // add column 'in' and subtract column 'out' (unless in == out)
+    static void
+    addColumn(int * hist, int * coarseHist,
+              MultiArray<2, int> const & fine, MultiArray<2, int> const & coarse,
+              MultiArrayIndex in, MultiArrayIndex out)
+    {
+        int const * fi = &fine(0, in);
+        int const * ci = &coarse(0, in);
+        if(in == out)
+        {
+            for(int k=0; k<Bins; ++k)
+                hist[k] += fi[k];
+            for(int k=0; k<CoarseBins; ++k)
+                coarseHist[k] += ci[k];
+        }
+        else
+        {
+            int const * fo = &fine(0, out);
+            int const * co = &coarse(0, out);
+            for(int k=0; k<Bins; ++k)
+                hist[k] += fi[k] - fo[k];
+            for(int k=0; k<CoarseBins; ++k)
+                coarseHist[k] += ci[k] - co[k];
+        }
+    }
+};
+
+    // Histogram-based rank filter for 16-bit types according to
+    //
+    //     T. Huang, G. Yang, and G. Tang: "A fast two-dimensional median
+    //     filtering algorithm", IEEE Trans. Acoust., Speech, Signal Processing 27(1), 1979
+    //
+    // The window histogram is updated by the values of the entering and leaving
+    // (N-1)-dimensional columns, and the requested rank is tracked incrementally,
+    // so that the 65536 bins never have to be scanned.
+template <class T>
+struct RankFilterBlock<T, 16>
+{
+    enum { Bins = 1 << 16 };
+
+    template <unsigned int N, class T2, class S2>
+    static void
+    exec(MultiArrayView<N, T> const & buffer,
+         MultiArrayView<N, T2, S2> dest,
+         typename MultiArrayShape<N>::type const & windowShape,
+         MultiArrayIndex rankIndex)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+
+        std::vector<int> hist(Bins, 0);
+        // invariant: 'below' is the number of values whose bin is smaller than 'current'
+        int current = 0, below = 0;
+
+        Shape lineShape(dest.shape());
+        lineShape[0] = 1;
+        MultiCoordinateIterator<N> line(lineShape), lineEnd = line.getEndIterator();
+        for(; line != lineEnd; ++line)
+        {
+            Shape p(*line), wbegin(p), wend(p + windowShape);
+            update(buffer.subarray(wbegin, wend), hist, current, below, 1);
+
+            for(MultiArrayIndex x=0; x<dest.shape(0); ++x)
+            {
+                if(x > 0)
+                {
+                    wbegin[0] = x - 1;
+                    wend[0]   = x;
+                    update(buffer.subarray(wbegin, wend), hist, current, below, -1);
+                    wbegin[0] = x + windowShape[0] - 1;
+                    wend[0]   = x + windowShape[0];
+                    update(buffer.subarray(wbegin, wend), hist, current, below, 1);
+                }
+
+                while(below > rankIndex)
+                    below -= hist[--current];
+                while(below + hist[current] <= rankIndex)
+                    below += hist[current++];
+
+                p[0] = x;
+                dest[p] = rankFilterValue<T>(current);
+            }
+
+            // clear the histogram for the next line
+            wbegin[0] = dest.shape(0) - 1;
+            wend[0]   = dest.shape(0) - 1 + windowShape[0];
+            update(buffer.subarray(wbegin, wend), hist, current, below, -1);
+        }
+    }
+
+    template <unsigned int N>
+    static void
+    update(MultiArrayView<N, T> const & a, std::vector<int> & hist,
+           int current, int & below, int delta)
+    {
+        typename MultiArrayView<N, T>::const_iterator i = a.begin(), end = a.end();
+        for(; i != end; ++i)
+        {
+            int b = rankFilterBin(*i);
+            hist[b] += delta;
+            if(b < current)
+                below += delta;
+        }
+    }
+};
+
+} // namespace detail
+
+/** \addtogroup MultiArrayNonlinearFilters Nonlinear filters for multi-dimensional arrays
+
+    Rank order and median filters for arrays of arbitrary dimension.
+*/
+//@{
+
+/********************************************************/
+/*                                                      */
+/*                    multiRankFilter                   */
+/*                                                      */
+/********************************************************/
+
+/** \brief Rank order filter with a box-shaped window for arrays of arbitrary dimension.
+
+    For every element, the function sorts the values in the window of shape
+    <tt>windowShape</tt> around the element and writes the value at relative
+    position <tt>rank</tt> into the destination, i.e. <tt>rank = 0.0</tt> computes the
+    minimum, <tt>rank = 1.0</tt> the maximum, and <tt>rank = 0.5</tt> the median.
+    More precisely, the result is the value with (zero-based) index
+    <tt>min(windowSize - 1, floor(rank * windowSize))</tt> in the sorted window, where
+    <tt>windowSize = prod(windowShape)</tt>. The window covers the range
+    <tt>[x - windowShape / 2, x - windowShape / 2 + windowShape)</tt>, which is symmetric
+    when the window sizes are odd.
+
+    The algorithm is selected by the value type: 8-bit types use a histogram method
+    in the spirit of Perreault and H&eacute;bert whose cost per pixel is independent of the window
+    size along the first two dimensions, 16-bit types use Huang's sliding histogram
+    with incremental rank tracking, and all other types (especially floating point)
+    maintain a sorted copy of the window that is updated by merging when the window moves.
+    In contrast to \ref medianFilter(), the work is therefore not proportional to the
+    window size (in 2D) or its cross-section (in higher dimensions).
+
+    The array is divided into blocks (according to <tt>options.getBlockShape()</tt>)
+    which are processed in parallel using <tt>options.getNumThreads()</tt> threads.
+    The border treatment can be <tt>BORDER_TREATMENT_AVOID</tt> (border elements,
+    where the window does not fit into the array, remain unchanged),
+    <tt>BORDER_TREATMENT_REPEAT</tt>, <tt>BORDER_TREATMENT_REFLECT</tt>,
+    <tt>BORDER_TREATMENT_WRAP</tt>, or <tt>BORDER_TREATMENT_ZEROPAD</tt>.
+    Like the convolution functions (and unlike \ref medianFilter()), <tt>BORDER_TREATMENT_REFLECT</tt>
+    mirrors at the border element without repeating it.
+    The value type must be scalar and totally ordered (i.e. must not contain NaNs).
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiRankFilter(MultiArrayView<N, T1, S1> const & src,
+                        MultiArrayView<N, T2, S2> dest,
+                        typename MultiArrayShape<N>::type const & windowShape,
+                        double rank,
+                        BorderTreatmentMode border = BORDER_TREATMENT_REPEAT,
+                        BlockwiseOptions const & options = BlockwiseOptions());
+
+        template <unsigned int N, class T1, class S1,
+                                  class T2, class S2>
+        void
+        multiMedianFilter(MultiArrayView<N, T1, S1> const & src,
+                          MultiArrayView<N, T2, S2> dest,
+                          typename MultiArrayShape<N>::type const & windowShape,
+                          BorderTreatmentMode border = BORDER_TREATMENT_REPEAT,
+                          BlockwiseOptions const & options = BlockwiseOptions());
+    }
+    \endcode
+
+    <b> Usage:</b>
+
+    <b>\#include</b> \<vigra/multi_rank_filter.hxx\><br/>
+    Namespace: vigra
+
+    \code
+    MultiArray<3, UInt8> volume(Shape3(512, 512, 256)), denoised(volume.shape());
+    ...
+    // median of a 7x7x7 neighborhood, using 8 threads
+    multiMedianFilter(volume, denoised, Shape3(7), BORDER_TREATMENT_REFLECT,
+                      BlockwiseOptions().numThreads(8));
+
+    // 90% percentile in a 15x15 window
+    MultiArray<2, float> image(Shape2(w, h)), percentile(image.shape());
+    multiRankFilter(image, percentile, Shape2(15), 0.9);
+    \endcode
+
+    <b> Preconditions:</b>
+
+    \code
+    src.shape() == dest.shape()
+    windowShape.all() > 0
+    0.0 <= rank <= 1.0
+    \endcode
+*/
+doxygen_overloaded_function(template <...> void multiRankFilter)
+
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+void
+multiRankFilter(MultiArrayView<N, T1, S1> const & src,
+                MultiArrayView<N, T2, S2> dest,
+                typename MultiArrayShape<N>::type const & windowShape,
+                double rank,
+                BorderTreatmentMode border = BORDER_TREATMENT_REPEAT,
+                BlockwiseOptions const & options = BlockwiseOptions())
+{
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef MultiBlocking<N> Blocking;
+
+    vigra_precondition(src.shape() == dest.shape(),
+        "multiRankFilter(): shape mismatch between input and output.");
+    vigra_precondition(allGreater(windowShape, Shape()),
+        "multiRankFilter(): window shape must be positive.");
+    vigra_precondition(0.0 <= rank && rank <= 1.0,
+        "multiRankFilter(): rank must be in the range [0.0, 1.0].");
+    vigra_precondition(border != BORDER_TREATMENT_CLIP,
+        "multiRankFilter(): BORDER_TREATMENT_CLIP is not supported.");
+
+    Shape before = div(windowShape, MultiArrayIndex(2)),
+          after  = windowShape - before - Shape(1);
+    MultiArrayIndex windowSize = prod(windowShape),
+                    rankIndex  = std::min<MultiArrayIndex>(windowSize - 1,
+                                                           (MultiArrayIndex)(rank * windowSize));
+
+    Shape roiBegin, roiEnd(src.shape());
+    if(border == BORDER_TREATMENT_AVOID)
+    {
+        roiBegin = before;
+        roiEnd  -= after;
+        if(!allLess(roiBegin, roiEnd))
+            return; // the window doesn't fit anywhere
+    }
+
+    Blocking blocking(src.shape(), options.template getBlockShapeN<N>(), roiBegin, roiEnd);
+
+    parallel_foreach(options.getNumThreads(),
+        blocking.blockBegin(), blocking.blockEnd(),
+        [&](int /*threadId*/, typename Blocking::Block block)
+        {
+            MultiArray<N, T1> buffer(block.size() + windowShape - Shape(1));
+            detail::rankFilterCopyBlock(src, buffer, block.begin() - before, border);
+            detail::RankFilterBlock<T1>::exec(buffer, dest.subarray(block.begin(), block.end()),
+                                              windowShape, rankIndex);
+        },
+        blocking.numBlocks()
+    );
+}
+
+/********************************************************/
+/*                                                      */
+/*                   multiMedianFilter                  */
+/*                                                      */
+/********************************************************/
+
+/** \brief Median filter with a box-shaped window for arrays of arbitrary dimension.
+
+    This is a shorthand for \ref multiRankFilter() with <tt>rank = 0.5</tt>.
+    See there for details.
+
+    <b>\#include</b> \<vigra/multi_rank_filter.hxx\><br/>
+    Namespace: vigra
+*/
+template <unsigned int N, class T1, class S1,
+                          class T2, class S2>
+inline void
+multiMedianFilter(MultiArrayView<N, T1, S1> const & src,
+                  MultiArrayView<N, T2, S2> dest,
+                  typename MultiArrayShape<N>::type const & windowShape,
+                  BorderTreatmentMode border = BORDER_TREATMENT_REPEAT,
+                  BlockwiseOptions const & options = BlockwiseOptions())
+{
+    multiRankFilter(src, dest, windowShape, 0.5, border, options);
+}
+
+//@}
+
+} // namespace vigra
+
+#endif // VIGRA_MULTI_RANK_FILTER_HXX
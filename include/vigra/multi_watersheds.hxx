@@ -224,21 +224,85 @@ generateWatershedSeeds(Graph const & g,
 #pragma GCC diagnostic ignored "-Wsign-compare"
 #endif
 
-template <class Graph, class T1Map, class T2Map>
+    // Select the priority queue for seeded watersheds: 8- and 16-bit data use a
+    // BucketQueue (via the PriorityQueue specializations), other integer types
+    // a RadixHeap (the flooding order is monotone), and floating-point types a
+    // binary heap unless the user requested quantization.
+template <class Node, class CostType,
+          bool UseRadixHeap = NumericTraits<CostType>::isIntegral::value &&
+                              (sizeof(CostType) > 2)>
+struct SeededWatershedsQueue
+{
+    typedef PriorityQueue<Node, CostType, true> type;
+};
+
+template <class Node, class CostType>
+struct SeededWatershedsQueue<Node, CostType, true>
+{
+    typedef RadixHeap<Node, CostType> type;
+};
+
+    // Use the data values as priorities.
+template <class CostType>
+struct WatershedsIdentityPriority
+{
+    template <class T>
+    CostType operator()(T v) const
+    {
+        return (CostType)v;
+    }
+
+    bool exceeds(CostType cost, double max_cost) const
+    {
+        return cost > max_cost;
+    }
+};
+
+    // Quantize the data values into the buckets [0, ..., bucket_count-1]
+    // between the minimum and maximum of the data.
+struct WatershedsQuantizedPriority
+{
+    double offset, scale;
+    std::ptrdiff_t maxIndex;
+
+    WatershedsQuantizedPriority(double minimum, double maximum, unsigned int bucket_count)
+    : offset(minimum),
+      scale(maximum > minimum ? (bucket_count - 1) / (maximum - minimum) : 0.0),
+      maxIndex((std::ptrdiff_t)bucket_count - 1)
+    {}
+
+    template <class T>
+    std::ptrdiff_t operator()(T v) const
+    {
+        double index = std::floor(((double)v - offset) * scale + 0.5);
+        return index <= 0.0
+                   ? 0
+                   : index >= (double)maxIndex
+                        ? maxIndex
+                        : (std::ptrdiff_t)index;
+    }
+
+    bool exceeds(std::ptrdiff_t cost, double max_cost) const
+    {
+        return cost > (*this)(max_cost);
+    }
+};
+
+template <class Graph, class T1Map, class T2Map, class Queue, class Priority>
 typename T2Map::value_type
 seededWatersheds(Graph const & g,
                  T1Map const & data,
                  T2Map & labels,
-                 WatershedOptions const & options)
+                 WatershedOptions const & options,
+                 Queue & pqueue,
+                 Priority const & toPriority)
 {
     typedef typename Graph::Node        Node;
     typedef typename Graph::NodeIt      graph_scanner;
     typedef typename Graph::OutArcIt    neighbor_iterator;
-    typedef typename T1Map::value_type  CostType;
+    typedef typename Queue::priority_type  CostType;
     typedef typename T2Map::value_type  LabelType;
 
-    PriorityQueue<Node, CostType, true> pqueue;
-
     bool keepContours = ((options.terminate & KeepContours) != 0);
     LabelType maxRegionLabel = 0;
 
@@ -256,9 +320,9 @@ seededWatersheds(Graph const & g,
                 {
                     // register all seeds that have an unlabeled neighbor
                     if(label == options.biased_label)
-                        pqueue.push(*node, data[*node] * options.bias);
+                        pqueue.push(*node, toPriority(data[*node] * options.bias));
                     else
-                        pqueue.push(*node, data[*node]);
+                        pqueue.push(*node, toPriority(data[*node]));
                     break;
                 }
             }
@@ -274,7 +338,7 @@ seededWatersheds(Graph const & g,
         CostType cost = pqueue.topPriority();
         pqueue.pop();
 
-        if((options.terminate & StopAtThreshold) && (cost > options.max_cost))
+        if((options.terminate & StopAtThreshold) && toPriority.exceeds(cost, options.max_cost))
             break;
 
         LabelType label = labels[node];
@@ -290,8 +354,8 @@ seededWatersheds(Graph const & g,
             {
                 labels[g.target(*arc)] = label;
                 CostType priority = (label == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
+                                       ? toPriority(data[g.target(*arc)] * options.bias)
+                                       : toPriority(data[g.target(*arc)]);
                 if(priority < cost)
                     priority = cost;
                 pqueue.push(g.target(*arc), priority);
@@ -301,8 +365,8 @@ seededWatersheds(Graph const & g,
                 // The present neighbor is adjacent to more than one region
                 // => mark it as contour.
                 CostType priority = (neighborLabel == options.biased_label)
-                                       ? data[g.target(*arc)] * options.bias
-                                       : data[g.target(*arc)];
+                                       ? toPriority(data[g.target(*arc)] * options.bias)
+                                       : toPriority(data[g.target(*arc)]);
                 if(cost < priority) // neighbor not yet processed
                     labels[g.target(*arc)] = contourLabel;
             }
@@ -331,6 +395,43 @@ seededWatersheds(Graph const & g,
 #pragma GCC diagnostic pop
 #endif
 
+template <class Graph, class T1Map, class T2Map>
+typename T2Map::value_type
+seededWatersheds(Graph const & g,
+                 T1Map const & data,
+                 T2Map & labels,
+                 WatershedOptions const & options)
+{
+    typedef typename Graph::Node        Node;
+    typedef typename T1Map::value_type  CostType;
+
+    if(options.bucket_count > 0 && !NumericTraits<CostType>::isIntegral::value)
+    {
+        // explicitly requested quantization into 'bucket_count' levels
+        // (integer data are never quantized, SeededWatershedsQueue is exact for them)
+        typename Graph::NodeIt node(g);
+        if(node == lemon::INVALID)
+            return 0;
+        double minimum = (double)data[*node],
+               maximum = minimum;
+        for(; node != lemon::INVALID; ++node)
+        {
+            double v = (double)data[*node];
+            if(v < minimum)
+                minimum = v;
+            if(maximum < v)
+                maximum = v;
+        }
+        BucketQueue<Node, true> pqueue(options.bucket_count);
+        return seededWatersheds(g, data, labels, options, pqueue,
+                                WatershedsQuantizedPriority(minimum, maximum, options.bucket_count));
+    }
+
+    typename SeededWatershedsQueue<Node, CostType>::type pqueue;
+    return seededWatersheds(g, data, labels, options, pqueue,
+                            WatershedsIdentityPriority<CostType>());
+}
+
 } // namespace graph_detail
 
 template <class Graph, class T1Map, class T2Map>
@@ -40,7 +40,11 @@
 #include "config.hxx"
 #include "error.hxx"
 #include "array_vector.hxx"
+#include "sized_int.hxx"
+#include "numerictraits.hxx"
 #include <queue>
+#include <vector>
+#include <cstring>
 
 namespace vigra {
 
@@ -400,6 +404,209 @@ class PriorityQueue<ValueType, unsigned short, Ascending>
 };
 
 
+namespace detail {
+
+    // Map a priority to an unsigned 64-bit key with the same ordering.
+template <class T,
+          bool IsIntegral = NumericTraits<T>::isIntegral::value,
+          bool IsSigned = NumericTraits<T>::isSigned::value>
+struct RadixHeapKey
+{
+    // unsigned integer
+    static UInt64 exec(T t)
+    {
+        return (UInt64)t;
+    }
+};
+
+template <class T>
+struct RadixHeapKey<T, true, true>
+{
+    // signed integer: shift the range to non-negative numbers
+    static UInt64 exec(T t)
+    {
+        return (UInt64)(Int64)t ^ ((UInt64)1 << 63);
+    }
+};
+
+template <class T, bool IsSigned>
+struct RadixHeapKey<T, false, IsSigned>
+{
+    // floating point: positive numbers order like their bit patterns,
+    // negative numbers in reverse
+    static UInt64 exec(T t)
+    {
+        double d = (double)t;
+        if(d == 0.0)
+            d = 0.0; // -0.0 and +0.0 must get the same key
+        UInt64 bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return (bits & ((UInt64)1 << 63)) != 0
+                   ? ~bits
+                   : bits | ((UInt64)1 << 63);
+    }
+};
+
+    // index of the highest set bit plus one (0 for x == 0)
+inline unsigned int radixHeapBucket(UInt64 x)
+{
+    unsigned int res = 0;
+    for(unsigned int shift = 32; shift > 0; shift /= 2)
+    {
+        if(x >> shift)
+        {
+            x >>= shift;
+            res += shift;
+        }
+    }
+    return res + (unsigned int)x;
+}
+
+} // namespace detail
+
+/** \brief Monotone priority queue implemented as a radix heap.
+
+    This template is compatible to \ref vigra::PriorityQueue with ascending order,
+    but exploits the fact that many algorithms (e.g. watershed flooding and
+    Dijkstra's algorithm) never insert an element whose priority is smaller than the
+    priority of the element most recently retrieved via <tt>top()</tt>. Under this
+    condition, each element moves through at most 65 buckets, so that
+    <tt>push()</tt> takes constant time and <tt>pop()</tt> takes amortized constant time
+    for a fixed priority width, rather than the logarithmic time of a binary heap.
+
+    Priorities can be of any integer or floating-point type. They are internally mapped to
+    64-bit unsigned keys preserving the order, so that the full range (including
+    negative numbers) is supported. Elements of equal priority are returned in
+    insertion order.
+
+    <b>\#include</b> \<vigra/priority_queue.hxx\><br>
+    Namespace: vigra
+*/
+template <class ValueType,
+          class PriorityType>
+class RadixHeap
+{
+    struct Entry
+    {
+        UInt64 key;
+        ValueType value;
+        PriorityType priority;
+
+        Entry(UInt64 k, ValueType const & v, PriorityType const & p)
+        : key(k), value(v), priority(p)
+        {}
+    };
+
+    typedef std::vector<Entry> Bucket;
+
+    mutable ArrayVector<Bucket> buckets_;
+    mutable UInt64 last_;
+    std::size_t size_, front_;
+
+        // move the elements with minimal key into bucket 0
+    void refill() const
+    {
+        if(!buckets_[0].empty())
+            return;
+        unsigned int i = 1;
+        while(buckets_[i].empty())
+            ++i;
+        Bucket & bucket = buckets_[i];
+        UInt64 newLast = bucket[0].key;
+        for(std::size_t k=1; k<bucket.size(); ++k)
+            if(bucket[k].key < newLast)
+                newLast = bucket[k].key;
+        last_ = newLast;
+        for(std::size_t k=0; k<bucket.size(); ++k)
+            buckets_[detail::radixHeapBucket(bucket[k].key ^ last_)].push_back(bucket[k]);
+        bucket.clear();
+    }
+
+  public:
+
+    typedef ValueType value_type;
+    typedef ValueType & reference;
+    typedef ValueType const & const_reference;
+    typedef std::size_t size_type;
+    typedef PriorityType priority_type;
+
+        /** \brief Create empty queue.
+        */
+    RadixHeap()
+    : buckets_(65),
+      last_(0),
+      size_(0),
+      front_(0)
+    {}
+
+        /** \brief Number of elements in this queue.
+        */
+    size_type size() const
+    {
+        return size_;
+    }
+
+        /** \brief Queue contains no elements.
+             Equivalent to <tt>size() == 0</tt>.
+        */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+        /** \brief Priority of the current top element.
+        */
+    priority_type topPriority() const
+    {
+        refill();
+        return buckets_[0][front_].priority;
+    }
+
+        /** \brief The current top element.
+        */
+    const_reference top() const
+    {
+        refill();
+        return buckets_[0][front_].value;
+    }
+
+        /** \brief Remove the current top element.
+        */
+    void pop()
+    {
+        refill();
+        // bucket 0 is consumed in FIFO order, so that elements of equal
+        // priority are returned in insertion order (like in BucketQueue)
+        Bucket & bucket = buckets_[0];
+        if(++front_ == bucket.size())
+        {
+            bucket.clear();
+            front_ = 0;
+        }
+        else if(front_ >= 1024 && 2*front_ >= bucket.size())
+        {
+            // on a plateau, bucket 0 may never run empty: drop the consumed
+            // prefix (amortized constant, since it is at least as long as the rest)
+            bucket.erase(bucket.begin(), bucket.begin() + front_);
+            front_ = 0;
+        }
+        --size_;
+    }
+
+        /** \brief Insert new element \arg v with given \arg priority.
+
+            The priority must not be smaller than the priority of the most recent
+            top element.
+        */
+    void push(value_type const & v, priority_type priority)
+    {
+        UInt64 key = detail::RadixHeapKey<PriorityType>::exec(priority);
+        vigra_precondition(key >= last_,
+            "RadixHeap::push(): priority is smaller than the priority of the last top element.");
+        buckets_[detail::radixHeapBucket(key ^ last_)].push_back(Entry(key, v, priority));
+        ++size_;
+    }
+};
 
 /** \brief Heap-based changable priority queue with a maximum number of elemements.
 
@@ -38,6 +38,8 @@
 
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <functional>
 #include <stdexcept>
 #include <cmath>
 #include "mathutil.hxx"
@@ -677,6 +679,110 @@ inline void parallel_foreach(
     parallel_foreach(threadpool, iter, iter.end(), f, nItems);
 }
 
+/********************************************************/
+/*                                                      */
+/*                     parallel_sort                    */
+/*                                                      */
+/********************************************************/
+
+/** \brief Sort a random-access range in parallel.
+
+    <b> Declarations:</b>
+
+    \code
+    namespace vigra {
+        template<class ITER, class COMPARE>
+        void parallel_sort(ThreadPool & pool, ITER begin, ITER end, COMPARE cmp);
+
+        template<class ITER>
+        void parallel_sort(ThreadPool & pool, ITER begin, ITER end);
+
+        template<class ITER, class COMPARE>
+        void parallel_sort(int64_t nThreads, ITER begin, ITER end, COMPARE cmp);
+
+        template<class ITER>
+        void parallel_sort(int64_t nThreads, ITER begin, ITER end);
+    }
+    \endcode
+
+    The range is cut into one slice per thread, the slices are sorted
+    concurrently with <tt>std::sort</tt>, and neighbouring slices are then
+    combined by rounds of <tt>std::inplace_merge</tt> (the merges of each round
+    run in parallel as well). Like <tt>std::sort</tt>, the result is not stable.
+    Small ranges and single-threaded pools fall back to a plain <tt>std::sort</tt>.
+*/
+doxygen_overloaded_function(template <...> void parallel_sort)
+
+template<class ITER, class COMPARE>
+inline void parallel_sort(
+    ThreadPool & pool,
+    ITER begin,
+    ITER end,
+    COMPARE cmp)
+{
+    std::ptrdiff_t const n = end - begin;
+    std::ptrdiff_t const nSlices = (std::ptrdiff_t)pool.nThreads();
+    if(nSlices < 2 || n < 4096*nSlices)
+    {
+        std::sort(begin, end, cmp);
+        return;
+    }
+
+    std::vector<std::ptrdiff_t> bounds(nSlices+1);
+    for(std::ptrdiff_t k=0; k<=nSlices; ++k)
+        bounds[k] = (n / nSlices) * k + std::min(k, n % nSlices);
+
+    parallel_foreach(pool, nSlices,
+        [&](size_t, std::ptrdiff_t k)
+        {
+            std::sort(begin+bounds[k], begin+bounds[k+1], cmp);
+        });
+
+    for(std::ptrdiff_t width=1; width<nSlices; width*=2)
+    {
+        parallel_foreach(pool, (nSlices + 2*width - 1) / (2*width),
+            [&](size_t, std::ptrdiff_t m)
+            {
+                std::ptrdiff_t lo  = 2*width*m,
+                               mid = std::min(lo + width, nSlices),
+                               hi  = std::min(lo + 2*width, nSlices);
+                if(mid < hi)
+                    std::inplace_merge(begin+bounds[lo], begin+bounds[mid], begin+bounds[hi], cmp);
+            });
+    }
+}
+
+template<class ITER>
+inline void parallel_sort(
+    ThreadPool & pool,
+    ITER begin,
+    ITER end)
+{
+    parallel_sort(pool, begin, end,
+                  std::less<typename std::iterator_traits<ITER>::value_type>());
+}
+
+template<class ITER, class COMPARE>
+inline void parallel_sort(
+    int64_t nThreads,
+    ITER begin,
+    ITER end,
+    COMPARE cmp)
+{
+    ThreadPool pool(nThreads);
+    parallel_sort(pool, begin, end, cmp);
+}
+
+template<class ITER>
+inline void parallel_sort(
+    int64_t nThreads,
+    ITER begin,
+    ITER end)
+{
+    ThreadPool pool(nThreads);
+    parallel_sort(pool, begin, end);
+}
+
 //@}
 
 } // namespace vigra
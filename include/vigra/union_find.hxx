@@ -39,6 +39,9 @@
 
 /*std*/
 #include <map>
+#include <vector>
+#include <atomic>
+#include <utility>
 
 /*vigra*/
 #include "config.hxx"
@@ -321,6 +324,92 @@ class UnionFindArray
     }
 };
 
+/** \brief Union-find array that supports concurrent merging.
+
+    In contrast to \ref UnionFindArray, the parent pointers are stored as
+    <tt>std::atomic<T></tt>, and makeUnion() links roots by a compare-and-swap,
+    so that many threads can merge sets at the same time without locking.
+    A root is always linked below the smaller root, so the representative of
+    every set is its smallest index, independent of the order of the merges.
+    findIndex() performs path halving by means of compare-and-swap as well.
+
+    The number of indices is fixed at construction, and all indices are
+    initially singleton sets.
+
+    <b>\#include</b> \<vigra/union_find.hxx\><br>
+    Namespace: vigra
+*/
+template <class T>
+class ConcurrentUnionFindArray
+{
+    std::vector<std::atomic<T> > parents_;
+
+  public:
+    ConcurrentUnionFindArray(std::size_t size = 0)
+    : parents_(size)
+    {
+        for(std::size_t k=0; k<size; ++k)
+            parents_[k].store((T)k, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const
+    {
+        return parents_.size();
+    }
+
+        // find the representative of 'index' (thread-safe)
+    T findIndex(T index)
+    {
+        T parent = parents_[index].load();
+        while(parent != index)
+        {
+            T grandparent = parents_[parent].load();
+            if(grandparent != parent)
+                parents_[index].compare_exchange_weak(parent, grandparent);
+            index = grandparent;
+            parent = parents_[index].load();
+        }
+        return index;
+    }
+
+        // merge the sets containing 'l1' and 'l2' (thread-safe),
+        // return the new representative
+    T makeUnion(T l1, T l2)
+    {
+        for(;;)
+        {
+            l1 = findIndex(l1);
+            l2 = findIndex(l2);
+            if(l1 == l2)
+                return l1;
+            if(l1 < l2)
+                std::swap(l1, l2);
+            // 'l1' may have been linked by another thread in the meantime,
+            // in which case we must start over
+            T expected = l1;
+            if(parents_[l1].compare_exchange_strong(expected, l2))
+                return l2;
+        }
+    }
+
+        // Map each index to the number of its set in a contiguous enumeration,
+        // where sets are ordered by their smallest index. Returns the number of sets.
+        // This function must not be called concurrently with makeUnion().
+    template <class Mapping>
+    T makeContiguous(Mapping & mapping)
+    {
+        T count = 0;
+        for(std::size_t k=0; k<parents_.size(); ++k)
+        {
+            T root = findIndex((T)k);
+            mapping[k] = (root == (T)k)
+                             ? count++
+                             : mapping[root];
+        }
+        return count;
+    }
+};
+
 } // namespace vigra
 
 #endif // VIGRA_UNION_FIND_HXX
@@ -102,7 +102,8 @@ template <class SrcIterator,
 void
 vectorialDistParabola(MultiArrayIndex dimension,
                       SrcIterator is, SrcIterator iend,
-                      Array const & pixel_pitch )
+                      Array const & pixel_pitch,
+                      std::vector<VectorialDistParabolaStackEntry<typename SrcIterator::value_type, double> > & _stack)
 {
     typedef typename SrcIterator::value_type SrcType;
     typedef VectorialDistParabolaStackEntry<SrcType, double> Influence;
@@ -113,7 +114,7 @@ vectorialDistParabola(MultiArrayIndex dimension,
 
     SrcIterator id = is;
 
-    std::vector<Influence> _stack; //stack of influence parabolas
+    _stack.clear(); //stack of influence parabolas
     double apex_height = partialSquaredMagnitude(*is, dimension, pixel_pitch);
     _stack.push_back(Influence(*is, apex_height, 0.0, 0.0, w));
     ++is;
@@ -156,6 +157,17 @@ vectorialDistParabola(MultiArrayIndex dimension,
     }
 }
 
+template <class SrcIterator,
+          class Array>
+inline void
+vectorialDistParabola(MultiArrayIndex dimension,
+                      SrcIterator is, SrcIterator iend,
+                      Array const & pixel_pitch )
+{
+    std::vector<VectorialDistParabolaStackEntry<typename SrcIterator::value_type, double> > _stack;
+    vectorialDistParabola(dimension, is, iend, pixel_pitch, _stack);
+}
+
 template <class DestIterator,
           class LabelIterator,
           class Array1, class Array2>
@@ -335,12 +347,32 @@ struct Error_output_pixel_type_must_be_TinyVector_of_appropriate_length
                                     MultiArrayView<N, T2, S2> dest,
                                     bool background,
                                     Array const & pixelPitch=TinyVector<double, N>(1));
+
+            // parallel versions (BlockwiseOptions are also accepted)
+            template <unsigned int N, class T1, class S1,
+                      class T2, class S2, class Array>
+            void
+            separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                                    MultiArrayView<N, T2, S2> dest,
+                                    bool background,
+                                    Array const & pixelPitch,
+                                    ParallelOptions const & options);
+
+            template <unsigned int N, class T1, class S1,
+                      class T2, class S2>
+            void
+            separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                                    MultiArrayView<N, T2, S2> dest,
+                                    bool background,
+                                    ParallelOptions const & options);
         }
         \endcode
 
         This function works like \ref separableMultiDistance() (see there for details),
         but returns in each pixel the <i>vector</i> to the nearest background pixel
         rather than the scalar distance. This enables much more powerful applications.
+        When <tt>ParallelOptions</tt> are given, the lines of each dimension are
+        processed in parallel.
 
         <b> Usage:</b>
 
@@ -363,7 +395,7 @@ doxygen_overloaded_function(template <...> void separableVectorDistance)
 
 template <unsigned int N, class T1, class S1,
           class T2, class S2, class Array>
-void
+typename enable_if<!IsDerivedFrom<Array, ParallelOptions>::value>::type
 separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
                         MultiArrayView<N, T2, S2> dest,
                         bool background,
@@ -408,6 +440,66 @@ separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
     separableVectorDistance(source, dest, background, pixelPitch);
 }
 
+template <unsigned int N, class T1, class S1,
+          class T2, class S2, class Array>
+void
+separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        bool background,
+                        Array const & pixelPitch,
+                        ParallelOptions const & options)
+{
+    using namespace vigra::functor;
+    typedef typename MultiArrayShape<N>::type Shape;
+    typedef detail::VectorialDistParabolaStackEntry<T2, double> Influence;
+
+    VIGRA_STATIC_ASSERT((Error_output_pixel_type_must_be_TinyVector_of_appropriate_length<N == T2::static_size>));
+    vigra_precondition(source.shape() == dest.shape(),
+        "separableVectorDistance(): shape mismatch between input and output.");
+    vigra_precondition(pixelPitch.size() == N,
+        "separableVectorDistance(): pixelPitch has wrong length.");
+
+    T2 maxDist(2*sum(source.shape()*pixelPitch)), rzero;
+    if(background == true)
+        transformMultiArray( source, dest,
+                                ifThenElse( Arg1() == Param(0), Param(maxDist), Param(rzero) ));
+    else
+        transformMultiArray( source, dest,
+                                ifThenElse( Arg1() != Param(0), Param(maxDist), Param(rzero) ));
+
+    ThreadPool pool(options);
+    ArrayVector<std::vector<Influence> > stacks(std::max<int>(1, pool.nThreads()));
+
+    for(unsigned d = 0; d < N; ++d )
+    {
+        Shape planeShape(dest.shape());
+        planeShape[d] = 1;
+        MultiArrayIndex length = dest.shape(d),
+                        stride = dest.stride(d);
+
+        parallel_foreach(pool, prod(planeShape),
+            [&](int threadId, MultiArrayIndex lineIndex)
+            {
+                Shape start;
+                detail::ScanOrderToCoordinate<N>::exec(lineIndex, planeShape, start);
+                MultiArrayView<1, T2, StridedArrayTag> line(Shape1(length), Shape1(stride), &dest[start]);
+                detail::vectorialDistParabola(d, line.begin(), line.end(), pixelPitch, stacks[threadId]);
+            });
+    }
+}
+
+template <unsigned int N, class T1, class S1,
+          class T2, class S2>
+inline void
+separableVectorDistance(MultiArrayView<N, T1, S1> const & source,
+                        MultiArrayView<N, T2, S2> dest,
+                        bool background,
+                        ParallelOptions const & options)
+{
+    TinyVector<double, N> pixelPitch(1.0);
+    separableVectorDistance(source, dest, background, pixelPitch, options);
+}
+
 
     /** \brief Compute the vector distance transform to the implicit boundaries of a
                multi-dimensional label array.
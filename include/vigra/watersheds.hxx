@@ -857,6 +857,14 @@ class WatershedOptions
             these boundary indicators are typically represented as
             UInt8 images, the default <tt>bucket_count</tt> is 256.
 
+            In \ref watershedsMultiArray() and \ref lemon_graph::watershedsGraph(), 8- and 16-bit
+            integer data always use a bucket queue, and other integer types use a \ref RadixHeap,
+            so this option is ignored for integer data there. For all other types (in particular
+            <tt>float</tt> boundary indicators), this option requests that the data be
+            quantized into <tt>bucket_count</tt> equally spaced levels between their
+            minimum and maximum, so that a \ref BucketQueue can be used instead of a binary heap.
+            Quantization may change the flooding order of data values falling into the same level.
+
             Default: don't use the turbo algorithm
         */
     WatershedOptions & turboAlgorithm(unsigned int bucket_count = 256)
@@ -193,6 +193,28 @@ void uncompress(char const * source, std::size_t srcSize,
     }
 }
 
+bool compressionAvailable(CompressionMethod method)
+{
+    switch(method)
+    {
+      case NO_COMPRESSION:
+      case DEFAULT_COMPRESSION:
+      case LZ4:
+        return true;
+      case ZLIB:
+      case ZLIB_NONE:
+      case ZLIB_FAST:
+      case ZLIB_BEST:
+    #ifdef HasZLIB
+        return true;
+    #else
+        return false;
+    #endif
+      default:
+        return false;
+    }
+}
+
 /** Uncompress a data buffer when the uncompressed size is unknown.
 
     The destination array will be resized as required.
@@ -145,6 +145,8 @@ namespace vigra {
         // methods
         void init();
         void nextScanline();
+        void readScanlines( char * buffer, unsigned int count, std::ptrdiff_t pixelStride,
+                            std::ptrdiff_t bandStride, std::ptrdiff_t rowStride );
     };
 
     ExrDecoderImpl::ExrDecoderImpl( const std::string & filename )
@@ -199,6 +201,29 @@ namespace vigra {
         }
     }
 
+    void ExrDecoderImpl::readScanlines( char * buffer, unsigned int count, std::ptrdiff_t pixelStride,
+                                        std::ptrdiff_t bandStride, std::ptrdiff_t rowStride )
+    {
+        // decode all rows with a single library call and convert them directly into the buffer
+        ArrayVector<Rgba> rows(width * count);
+        file.setFrameBuffer (rows.data() - position.x - scanline * width, 1, width);
+        file.readPixels (scanline, scanline + count - 1);
+        scanline += count;
+
+        const Rgba * src = rows.data();
+        for (unsigned int y = 0; y < count; ++y)
+        {
+            char * dest = buffer + y * rowStride;
+            for (int x = 0; x < width; ++x, ++src, dest += pixelStride)
+            {
+                *reinterpret_cast<float *>(dest) = src->r;
+                *reinterpret_cast<float *>(dest + bandStride) = src->g;
+                *reinterpret_cast<float *>(dest + 2*bandStride) = src->b;
+                *reinterpret_cast<float *>(dest + 3*bandStride) = src->a;
+            }
+        }
+    }
+
     void ExrDecoder::init( const std::string & filename )
     {
         pimpl = new ExrDecoderImpl(filename);
@@ -275,6 +300,18 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void ExrDecoder::readScanlines( void * buffer, unsigned int width, unsigned int count,
+                                    std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                    std::ptrdiff_t rowStride )
+    {
+        if ( (int)width != pimpl->width || pimpl->components != 4 || count == 0 )
+        {
+            Decoder::readScanlines(buffer, width, count, pixelStride, bandStride, rowStride);
+            return;
+        }
+        pimpl->readScanlines(static_cast<char *>(buffer), count, pixelStride, bandStride, rowStride);
+    }
+
     void ExrDecoder::close() {}
 
     void ExrDecoder::abort() {}
@@ -53,6 +53,7 @@
 #include <vector>
 #include <iterator>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -63,6 +64,7 @@
 #include "codecmanager.hxx"
 #include "vigra/multi_impex.hxx"
 #include "vigra/sifImport.hxx"
+#include "vigra/threadpool.hxx"
 
 #if defined(_MSC_VER)
 #  include "vigra/windows.h"
@@ -334,6 +336,7 @@ bool isImage(char const * filename)
 
 ImageExportInfo::ImageExportInfo( const char * filename, const char * mode )
     : m_filename(filename), m_mode(mode),
+      m_num_threads(0),
       m_x_res(0), m_y_res(0),
       fromMin_(0.0), fromMax_(0.0), toMin_(0.0), toMax_(0.0)
 {}
@@ -426,6 +429,17 @@ const char * ImageExportInfo::getCompression() const
     return m_comp.c_str();
 }
 
+ImageExportInfo & ImageExportInfo::setNumThreads( int n )
+{
+    m_num_threads = n;
+    return *this;
+}
+
+int ImageExportInfo::getNumThreads() const
+{
+    return m_num_threads;
+}
+
 float ImageExportInfo::getXResolution() const
 {
     return m_x_res;
@@ -546,6 +560,8 @@ VIGRA_UNIQUE_PTR<Encoder> encoder( const ImageExportInfo & info )
     enc->setYResolution(info.getYResolution());
     enc->setPosition(info.getPosition());
     enc->setCanvasSize(info.getCanvasSize());
+    if ( info.getNumThreads() != 0 )
+        enc->setNumThreads(ParallelOptions().numThreads(info.getNumThreads()).getActualNumThreads());
 
     if ( info.getICCProfile().size() > 0 ) {
         enc->setICCProfile(info.getICCProfile());
@@ -557,11 +573,17 @@ VIGRA_UNIQUE_PTR<Encoder> encoder( const ImageExportInfo & info )
 // class ImageImportInfo
 
 ImageImportInfo::ImageImportInfo( const char * filename, unsigned int imageIndex )
-    : m_filename(filename), m_image_index(imageIndex)
+    : m_filename(filename), m_image_index(imageIndex), m_num_images(-1)
 {
     readHeader_();
 }
 
+ImageImportInfo::ImageImportInfo()
+    : m_width(0), m_height(0), m_num_bands(0), m_num_extra_bands(0),
+      m_image_index(0), m_num_images(-1), m_x_res(0), m_y_res(0)
+{
+}
+
 ImageImportInfo::~ImageImportInfo() {
 }
 
@@ -623,6 +645,14 @@ int ImageImportInfo::numExtraBands() const
 
 int ImageImportInfo::numImages() const
 {
+    if (m_num_images < 0)
+    {
+        // counting the pages may require a pass over the entire file,
+        // so it is postponed until the number is actually needed
+        VIGRA_UNIQUE_PTR<Decoder> decoder = getDecoder(m_filename, m_filetype, m_image_index);
+        m_num_images = decoder->getNumImages();
+        decoder->abort();
+    }
     return m_num_images;
 }
 
@@ -690,7 +720,6 @@ const ImageImportInfo::ICCProfile & ImageImportInfo::getICCProfile() const
 void ImageImportInfo::readHeader_()
 {
     VIGRA_UNIQUE_PTR<Decoder> decoder = getDecoder(m_filename, "undefined", m_image_index);
-    m_num_images = decoder->getNumImages();
 
     m_filetype = decoder->getFileType();
     m_pixeltype = decoder->getPixelType();
@@ -716,6 +745,190 @@ VIGRA_UNIQUE_PTR<Decoder> decoder( const ImageImportInfo & info )
     return getDecoder( std::string( info.getFileName() ), filetype, info.getImageIndex() );
 }
 
+// class ImageMetadataCache
+
+static const char * const imageMetadataCacheMagic = "VIGRA image metadata cache 1";
+
+// modification time and size of a file, false if it does not exist
+static bool
+imageFileStatus( const std::string & filename, long long & mtime, long long & size )
+{
+#if defined(_MSC_VER)
+    struct _stat64 st;
+    if (_stat64(filename.c_str(), &st) != 0)
+        return false;
+#else
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return false;
+#endif
+    mtime = (long long)st.st_mtime;
+    size = (long long)st.st_size;
+    return true;
+}
+
+ImageMetadataCache::ImageMetadataCache()
+    : m_modified(false)
+{
+}
+
+ImageMetadataCache::ImageMetadataCache( const char * cacheFile )
+    : m_cache_file(cacheFile), m_modified(false)
+{
+    load_();
+}
+
+ImageMetadataCache::~ImageMetadataCache()
+{
+    try
+    {
+        if (m_modified)
+            save();
+    }
+    catch (std::exception &)
+    {
+    }
+}
+
+ImageImportInfo ImageMetadataCache::info( const char * filename, unsigned int page )
+{
+    const std::pair<std::string, unsigned int> key(filename, page);
+    long long mtime = 0, size = 0;
+    const bool exists = imageFileStatus(key.first, mtime, size);
+
+    EntryMap::iterator i = m_entries.find(key);
+    if (exists && i != m_entries.end() &&
+        i->second.mtime == mtime && i->second.size == size)
+        return i->second.info;
+
+    // new or modified file: read the header (this throws for missing files)
+    ImageImportInfo info(filename, page);
+    info.numImages();
+
+    const Entry entry = { mtime, size, info };
+    if (i != m_entries.end())
+        i->second = entry;
+    else
+        m_entries.insert(std::make_pair(key, entry));
+    m_modified = true;
+    return info;
+}
+
+std::size_t ImageMetadataCache::size() const
+{
+    return m_entries.size();
+}
+
+void ImageMetadataCache::clear()
+{
+    m_entries.clear();
+    m_modified = true;
+}
+
+void ImageMetadataCache::save()
+{
+    if (m_cache_file == "")
+        return;
+
+    // write to a temporary file first, so that concurrent readers never see
+    // a partially written cache
+    const std::string tmp_file = m_cache_file + ".tmp";
+    {
+        std::ofstream stream(tmp_file.c_str());
+        std::string message("ImageMetadataCache::save(): Unable to write file '");
+        message += tmp_file + "'.";
+        vigra_postcondition(stream.good(), message.c_str());
+
+        stream << imageMetadataCacheMagic << "\n";
+        stream.precision(9);
+        for (EntryMap::const_iterator i = m_entries.begin(); i != m_entries.end(); ++i)
+        {
+            const ImageImportInfo & info = i->second.info;
+            stream << i->second.mtime << '\t' << i->second.size << '\t'
+                   << i->first.second << '\t'
+                   << info.m_filetype << '\t' << info.m_pixeltype << '\t'
+                   << info.m_width << '\t' << info.m_height << '\t'
+                   << info.m_num_bands << '\t' << info.m_num_extra_bands << '\t'
+                   << info.m_num_images << '\t'
+                   << info.m_x_res << '\t' << info.m_y_res << '\t'
+                   << info.m_pos.x << '\t' << info.m_pos.y << '\t'
+                   << info.m_canvas_size.x << '\t' << info.m_canvas_size.y << '\t';
+            if (info.m_icc_profile.size() == 0)
+                stream << '-';
+            static const char hex[] = "0123456789abcdef";
+            for (std::size_t k = 0; k < info.m_icc_profile.size(); ++k)
+                stream << hex[info.m_icc_profile[k] >> 4] << hex[info.m_icc_profile[k] & 15];
+            stream << '\t' << i->first.first << "\n";
+        }
+        vigra_postcondition(stream.good(), message.c_str());
+    }
+    if (std::rename(tmp_file.c_str(), m_cache_file.c_str()) != 0)
+    {
+        std::remove(m_cache_file.c_str());
+        std::string message("ImageMetadataCache::save(): Unable to write file '");
+        message += m_cache_file + "'.";
+        vigra_postcondition(std::rename(tmp_file.c_str(), m_cache_file.c_str()) == 0,
+                            message.c_str());
+    }
+    m_modified = false;
+}
+
+void ImageMetadataCache::load_()
+{
+    std::ifstream stream(m_cache_file.c_str());
+    std::string line;
+    if (!std::getline(stream, line) || line != imageMetadataCacheMagic)
+        return;
+
+    const std::size_t fields = 18;
+    while (std::getline(stream, line))
+    {
+        std::vector<std::string> field;
+        std::string::size_type begin = 0, end;
+        while (field.size() < fields - 1 &&
+               (end = line.find('\t', begin)) != std::string::npos)
+        {
+            field.push_back(line.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        field.push_back(line.substr(begin)); // the file name may contain tabs
+        if (field.size() != fields)
+            continue;
+
+        Entry entry = { 0, 0, ImageImportInfo() };
+        ImageImportInfo & info = entry.info;
+        unsigned int page = 0;
+        std::istringstream numbers(field[0] + ' ' + field[1] + ' ' + field[2] + ' ' +
+                                   field[5] + ' ' + field[6] + ' ' + field[7] + ' ' +
+                                   field[8] + ' ' + field[9] + ' ' + field[10] + ' ' +
+                                   field[11] + ' ' + field[12] + ' ' + field[13] + ' ' +
+                                   field[14] + ' ' + field[15]);
+        numbers >> entry.mtime >> entry.size >> page
+                >> info.m_width >> info.m_height >> info.m_num_bands >> info.m_num_extra_bands
+                >> info.m_num_images >> info.m_x_res >> info.m_y_res
+                >> info.m_pos.x >> info.m_pos.y >> info.m_canvas_size.x >> info.m_canvas_size.y;
+        if (numbers.fail() || field[3] == "" || field[4] == "")
+            continue;
+
+        const std::string & icc = field[16];
+        if (icc != "-")
+        {
+            if (icc.size() % 2 != 0)
+                continue;
+            info.m_icc_profile.resize(icc.size() / 2);
+            for (std::size_t k = 0; k < info.m_icc_profile.size(); ++k)
+                info.m_icc_profile[k] =
+                    (unsigned char)strtol(icc.substr(2*k, 2).c_str(), 0, 16);
+        }
+
+        info.m_filename = field[17];
+        info.m_filetype = field[3];
+        info.m_pixeltype = field[4];
+        info.m_image_index = page;
+        m_entries.insert(std::make_pair(std::make_pair(info.m_filename, page), entry));
+    }
+}
+
 // class VolumeExportInfo
 
 VolumeExportInfo::VolumeExportInfo( const char * filename ) :
@@ -1063,6 +1276,7 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
         
         // try .info file loading
         std::ifstream stream(filename.c_str());
+        int bands = 1;
 
         while(stream.good())
         {
@@ -1103,6 +1317,12 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
                     if(pixelType_ == "UNSIGNED_CHAR" || pixelType_ == "UNSIGNED_BYTE")
                         pixelType_ = "UINT8";
                 }
+                else if(key == "bands")
+                {
+                    bands = atoi(value.c_str());
+                    vigra_precondition(bands > 0,
+                        "VolumeImportInfo(): Invalid number of bands '" + value +"' in .info file.");
+                }
                 else if(key == "description")
                     description_ = value;
                 else if(key == "name")
@@ -1124,7 +1344,7 @@ VolumeImportInfo::VolumeImportInfo(const std::string &filename)
 
         if((shape_[0]*shape_[1]*shape_[2] > 0) && (rawFilename_.size() > 0))
         {
-            numBands_ = 1;
+            numBands_ = bands;
 
             baseName_ = filename;
             if(name_.size() > 0)
@@ -41,6 +41,7 @@
 #ifdef HasJPEG
 
 #include <stdexcept>
+#include <vector>
 #include <csetjmp>
 #include "vigra/config.hxx"
 #include "void_vector.hxx"
@@ -319,6 +320,29 @@ namespace vigra
         }
     }
 
+    void JPEGDecoder::readScanlines( void * buffer, unsigned int width, unsigned int count,
+                                     std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                     std::ptrdiff_t rowStride )
+    {
+        if ( width != pimpl->width || bandStride != 1 ||
+             pixelStride != (std::ptrdiff_t)pimpl->components )
+        {
+            Decoder::readScanlines(buffer, width, count, pixelStride, bandStride, rowStride);
+            return;
+        }
+
+        // let libjpeg decode all rows directly into the buffer
+        std::vector<JSAMPROW> rows(count);
+        for ( unsigned int y = 0; y < count; ++y )
+            rows[y] = static_cast<JSAMPROW>(buffer) + y * rowStride;
+
+        unsigned int done = 0;
+        if (setjmp(pimpl->err.buf))
+            vigra_fail( "error in jpeg_read_scanlines()" );
+        while ( done < count && pimpl->info.output_scanline < pimpl->info.output_height )
+            done += jpeg_read_scanlines( &pimpl->info, &rows[done], count - done );
+    }
+
     void JPEGDecoder::close()
     {
         // finish any pending decompression
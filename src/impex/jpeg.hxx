@@ -68,6 +68,9 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void readScanlines( void * buffer, unsigned int width, unsigned int count,
+                            std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                            std::ptrdiff_t rowStride );
 
         std::string getPixelType() const;
         unsigned int getOffset() const;
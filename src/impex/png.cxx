@@ -51,20 +51,24 @@
 #include "png.hxx"
 #include "byteorder.hxx"
 #include "error.hxx"
+#include "vigra/array_vector.hxx"
+#include "vigra/threadpool.hxx"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 extern "C"
 {
 #include <png.h>
+#include <zlib.h>
 }
 
 #if PNG_LIBPNG_VER < 10201
 #error "please update your libpng to at least 1.2.1"
 #endif
 
-// TODO: per-scanline reading/writing
-
 namespace {
     std::string png_error_message;
 }
@@ -180,6 +184,7 @@ namespace vigra {
         // methods
         void init();
         void nextScanline();
+        void readRows( unsigned char * buffer, unsigned int count, std::ptrdiff_t rowStride );
     };
 
     PngDecoderImpl::PngDecoderImpl( const std::string & filename )
@@ -385,6 +390,16 @@ namespace vigra {
         }
     }
 
+    void PngDecoderImpl::readRows( unsigned char * buffer, unsigned int count, std::ptrdiff_t rowStride )
+    {
+        if (setjmp(png_jmpbuf(png)))
+            vigra_postcondition( false,png_error_message.insert(0, "error in png_read_row(): ").c_str());
+        for (unsigned int y = 0; y < count; ++y)
+        {
+            png_read_row(png, buffer + y * rowStride, NULL);
+        }
+    }
+
     void PngDecoder::init( const std::string & filename )
     {
         pimpl = new PngDecoderImpl(filename);
@@ -483,16 +498,82 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void PngDecoder::readScanlines( void * buffer, unsigned int width, unsigned int count,
+                                    std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                    std::ptrdiff_t rowStride )
+    {
+        // let libpng write interleaved rows directly into the buffer
+        const std::ptrdiff_t samplesize = pimpl->bit_depth / 8;
+        if ( pimpl->n_interlace_passes != 1 || width != pimpl->width ||
+             bandStride != samplesize || pixelStride != samplesize * (std::ptrdiff_t)pimpl->components ||
+             pimpl->rowsize != (int)width * pixelStride )
+        {
+            Decoder::readScanlines(buffer, width, count, pixelStride, bandStride, rowStride);
+            return;
+        }
+        pimpl->readRows(static_cast<unsigned char *>(buffer), count, rowStride);
+    }
+
     void PngDecoder::close() {}
 
     void PngDecoder::abort() {}
 
+    // PNG row filter (types 0...4) with the smallest sum of absolute
+    // differences, the same heuristic libpng uses by default.
+    // 'prev' is 0 for the first row of the image.
+    static void
+    filterPngRow( const png_byte * row, const png_byte * prev, png_uint_32 n,
+                  unsigned int bpp, png_byte * dest, png_byte * candidate )
+    {
+        unsigned long best_sum = ~0ul;
+        for (int type = 0; type < 5; ++type)
+        {
+            if (prev == 0 && (type == 2 || type == 4))
+                continue; // same as types 0 and 1
+            unsigned long sum = 0;
+            for (png_uint_32 i = 0; i < n; ++i)
+            {
+                const int a = i >= bpp ? row[i - bpp] : 0;
+                const int b = prev ? prev[i] : 0;
+                const int c = prev && i >= bpp ? prev[i - bpp] : 0;
+                int predicted = 0;
+                switch (type)
+                {
+                case 1:
+                    predicted = a;
+                    break;
+                case 2:
+                    predicted = b;
+                    break;
+                case 3:
+                    predicted = (a + b) >> 1;
+                    break;
+                case 4:
+                    {
+                        const int p = a + b - c;
+                        const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                        predicted = (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+                    }
+                    break;
+                }
+                candidate[i] = static_cast<png_byte>(row[i] - predicted);
+                sum += std::abs(static_cast<int>(static_cast<signed char>(candidate[i])));
+            }
+            if (sum < best_sum)
+            {
+                best_sum = sum;
+                dest[0] = static_cast<png_byte>(type);
+                std::memcpy(dest + 1, candidate, n);
+            }
+        }
+    }
+
     struct PngEncoderImpl
     {
         // data sink
         auto_file file;
 
-        // data container
+        // data container for the rows not yet written
         void_vector_base bands;
 
         // this is where libpng stores its state
@@ -507,8 +588,8 @@ namespace vigra {
         // icc profile, if available
         Encoder::ICCProfile iccProfile;
 
-        // scanline counter
-        int scanline;
+        // scanline counter, first row held in 'bands' and capacity of 'bands' in rows
+        int scanline, buffer_start, buffer_rows;
 
         // state
         bool finalized;
@@ -519,13 +600,27 @@ namespace vigra {
         // resolution
         float x_resolution, y_resolution;
 
+        // parallel compression: number of threads, the last row of the previous
+        // batch (for the filters), the end of the filtered data written so far
+        // (the deflate dictionary of the next batch), and its Adler-32 checksum
+        int threads;
+        VIGRA_UNIQUE_PTR<ThreadPool> pool;
+        ArrayVector<png_byte> previous_row, dictionary;
+        uLong adler;
+
         // ctor, dtor
         PngEncoderImpl( const std::string & filename );
         ~PngEncoderImpl();
 
         // methods
+        png_uint_32 rowBytes() const;
         void finalize();
-        void write();
+        void * currentScanlineOfBand( unsigned int band );
+        void nextScanline();
+        void writeRows( const png_byte * rows, int count, std::ptrdiff_t rowStride );
+        void writeRowsParallel( png_byte * rows, int count );
+        void writeChunk( const char * name, const png_byte * data, std::size_t size );
+        void close();
     };
 
     PngEncoderImpl::PngEncoderImpl( const std::string & filename )
@@ -535,8 +630,9 @@ namespace vigra {
         : file( filename.c_str(), "w" ),
 #endif
           bands(0),
-          scanline(0), finalized(false),
-          x_resolution(0), y_resolution(0)
+          scanline(0), buffer_start(0), buffer_rows(1), finalized(false),
+          x_resolution(0), y_resolution(0),
+          threads(0), adler(adler32(0, Z_NULL, 0))
     {
         png_error_message = "";
         // create png struct with user defined handlers
@@ -568,6 +664,11 @@ namespace vigra {
         png_destroy_write_struct( &png, &info );
     }
 
+    png_uint_32 PngEncoderImpl::rowBytes() const
+    {
+        return ( bit_depth >> 3 ) * width * components;
+    }
+
     void PngEncoderImpl::finalize()
     {
         // write the IHDR
@@ -610,37 +711,209 @@ namespace vigra {
             vigra_postcondition( false, png_error_message.insert(0, "error in png_write_info(): ").c_str() );
         png_write_info( png, info );
 
+        if (threads > 1)
+        {
+            // collect enough rows for four blocks of about 256 kB per thread,
+            // the blocks are filtered and deflated concurrently
+            pool.reset(new ThreadPool(threads));
+            const int block_rows = std::max<int>(1, (1 << 18) / rowBytes());
+            buffer_rows = std::min<int>(height, 4 * threads * block_rows);
+        }
+        else
+        {
+            // libpng writes the rows one by one
+            byteorder bo;
+            if(bit_depth == 16 && bo.get_host_byteorder() == "little endian")
+                png_set_swap(png);
+            buffer_rows = 1;
+        }
+
         // prepare the bands
-        bands.resize( ( bit_depth >> 3 ) * width * components * height );
+        bands.resize( rowBytes() * buffer_rows );
 
         // enter finalized state
         finalized = true;
     }
 
-    void PngEncoderImpl::write()
+    void * PngEncoderImpl::currentScanlineOfBand( unsigned int band )
     {
-        // prepare row pointers
-        png_uint_32 row_stride = ( bit_depth >> 3 ) * width * components;
-        void_vector<png_byte *>  row_pointers(height);
-        typedef void_vector<png_byte> vector_type;
-        vector_type & cbands = static_cast< vector_type & >(bands);
-        png_byte * mover = cbands.data();
-        for( png_uint_32 i = 0; i < height; ++i ) {
-            row_pointers[i] = mover;
-            mover += row_stride;
+        const unsigned int index = width * components * ( scanline - buffer_start ) + band;
+        switch (bit_depth) {
+        case 8:
+            {
+                typedef void_vector< UInt8 > bands_type;
+                bands_type & cbands = static_cast< bands_type & >(bands);
+                return cbands.data() + index;
+            }
+        case 16:
+            {
+                typedef void_vector<Int16> bands_type;
+                bands_type & cbands = static_cast< bands_type & >(bands);
+                return cbands.data() + index;
+            }
+        default:
+            vigra_fail( "internal error: illegal bit depth." );
         }
+        return 0;
+    }
 
-        // check whether byteorder must be swapped (png files must be big-endian)
-        byteorder bo;
-        if(bit_depth == 16 && bo.get_host_byteorder() == "little endian")
+    void PngEncoderImpl::nextScanline()
+    {
+        ++scanline;
+        if ( scanline - buffer_start == buffer_rows || scanline == (int)height )
         {
-            png_set_swap(png);
+            typedef void_vector<png_byte> vector_type;
+            vector_type & cbands = static_cast< vector_type & >(bands);
+            if (threads > 1)
+                writeRowsParallel( cbands.data(), scanline - buffer_start );
+            else
+                writeRows( cbands.data(), scanline - buffer_start, rowBytes() );
+            buffer_start = scanline;
         }
+    }
+
+    void PngEncoderImpl::writeRows( const png_byte * rows, int count, std::ptrdiff_t rowStride )
+    {
+        if (setjmp(png_jmpbuf(png)))
+            vigra_postcondition( false, png_error_message.insert(0, "error in png_write_row(): ").c_str() );
+        for ( int y = 0; y < count; ++y )
+            png_write_row( png, const_cast<png_byte *>(rows + y * rowStride) );
+    }
 
-        // write the whole image
+    void PngEncoderImpl::writeChunk( const char * name, const png_byte * data, std::size_t size )
+    {
         if (setjmp(png_jmpbuf(png)))
-            vigra_postcondition( false, png_error_message.insert(0, "error in png_write_image(): ").c_str() );
-        png_write_image( png, row_pointers.begin() );
+            vigra_postcondition( false, png_error_message.insert(0, "error in png_write_chunk(): ").c_str() );
+        png_write_chunk( png, (png_const_bytep)name, data, size );
+    }
+
+    // Filter and deflate blocks of rows concurrently and write the resulting
+    // IDAT chunks in order. All blocks form a single zlib stream: each block
+    // is primed with the last 32 kB of the preceding data and terminated by a
+    // sync flush, only the last block of the image finishes the stream.
+    void PngEncoderImpl::writeRowsParallel( png_byte * rows, int count )
+    {
+        const png_uint_32 row_bytes = rowBytes();
+        const unsigned int bpp = components * ( bit_depth >> 3 );
+        const int block_rows = std::max<int>(1, (1 << 18) / row_bytes);
+        const int blocks = ( count + block_rows - 1 ) / block_rows;
+        const bool last_batch = buffer_start + count == (int)height;
+        const std::size_t window = 1 << 15;
+
+        // png files are big-endian
+        byteorder bo;
+        if (bit_depth == 16 && bo.get_host_byteorder() == "little endian")
+        {
+            parallel_foreach(*pool, blocks,
+                [&](int, int b)
+                {
+                    png_byte * p   = rows + (std::size_t)b * block_rows * row_bytes;
+                    png_byte * end = rows + (std::size_t)std::min(count, (b + 1) * block_rows) * row_bytes;
+                    for (; p < end; p += 2)
+                        std::swap(p[0], p[1]);
+                });
+        }
+
+        ArrayVector<ArrayVector<png_byte> > filtered(blocks), compressed(blocks);
+        ArrayVector<uLong> checksums(blocks);
+
+        parallel_foreach(*pool, blocks,
+            [&](int, int b)
+            {
+                const int first = b * block_rows, stop = std::min(count, first + block_rows);
+                ArrayVector<png_byte> candidate(row_bytes);
+                filtered[b].resize((std::size_t)(stop - first) * (row_bytes + 1));
+                for (int y = first; y < stop; ++y)
+                {
+                    const png_byte * prev = y > 0
+                                               ? rows + (std::size_t)(y - 1) * row_bytes
+                                               : previous_row.size() > 0 ? previous_row.data() : 0;
+                    filterPngRow(rows + (std::size_t)y * row_bytes, prev, row_bytes, bpp,
+                                 filtered[b].data() + (std::size_t)(y - first) * (row_bytes + 1),
+                                 candidate.data());
+                }
+                checksums[b] = adler32(adler32(0, Z_NULL, 0), filtered[b].data(), filtered[b].size());
+            });
+
+        parallel_foreach(*pool, blocks,
+            [&](int, int b)
+            {
+                z_stream stream;
+                std::memset(&stream, 0, sizeof(stream));
+                vigra_postcondition(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                                 -15, 8, Z_FILTERED) == Z_OK,
+                    "PngEncoder: deflateInit2() failed.");
+
+                const ArrayVector<png_byte> & preceding = b > 0 ? filtered[b-1] : dictionary;
+                const std::size_t dict_size = std::min(window, preceding.size());
+                if (dict_size > 0)
+                    deflateSetDictionary(&stream, preceding.data() + preceding.size() - dict_size,
+                                         (uInt)dict_size);
+
+                ArrayVector<png_byte> & out = compressed[b];
+                out.resize(deflateBound(&stream, filtered[b].size()) + 16);
+                stream.next_in = filtered[b].data();
+                stream.avail_in = (uInt)filtered[b].size();
+                const int flush = last_batch && b == blocks - 1 ? Z_FINISH : Z_SYNC_FLUSH;
+                std::size_t used = 0;
+                for (;;)
+                {
+                    stream.next_out = out.data() + used;
+                    stream.avail_out = (uInt)(out.size() - used);
+                    const int res = deflate(&stream, flush);
+                    used = out.size() - stream.avail_out;
+                    if (res == Z_STREAM_END || (flush == Z_SYNC_FLUSH && stream.avail_out > 0))
+                        break;
+                    vigra_postcondition(res == Z_OK || res == Z_BUF_ERROR,
+                        "PngEncoder: deflate() failed.");
+                    out.resize(2 * out.size());
+                }
+                deflateEnd(&stream);
+                out.resize(used);
+            });
+
+        if (buffer_start == 0)
+        {
+            // zlib header: deflate with 32 kB window and default compression
+            const png_byte header[2] = { 0x78, 0x9c };
+            writeChunk("IDAT", header, 2);
+        }
+        for (int b = 0; b < blocks; ++b)
+        {
+            writeChunk("IDAT", compressed[b].data(), compressed[b].size());
+            adler = adler32_combine(adler, checksums[b], (z_off_t)filtered[b].size());
+        }
+        if (last_batch)
+        {
+            const png_byte trailer[4] = { (png_byte)(adler >> 24), (png_byte)(adler >> 16),
+                                          (png_byte)(adler >> 8), (png_byte)adler };
+            writeChunk("IDAT", trailer, 4);
+        }
+
+        // remember what the next batch depends on
+        previous_row.resize(row_bytes);
+        std::memcpy(previous_row.data(), rows + (std::size_t)(count - 1) * row_bytes, row_bytes);
+        const ArrayVector<png_byte> & tail = filtered[blocks - 1];
+        if (tail.size() >= window)
+        {
+            dictionary = ArrayVector<png_byte>(tail.end() - window, tail.end());
+        }
+        else
+        {
+            dictionary.insert(dictionary.end(), tail.begin(), tail.end());
+            if (dictionary.size() > window)
+                dictionary.erase(dictionary.begin(), dictionary.end() - window);
+        }
+    }
+
+    void PngEncoderImpl::close()
+    {
+        if (threads > 1)
+        {
+            // the image data were written as raw chunks
+            writeChunk("IEND", 0, 0);
+            return;
+        }
         if (setjmp(png_jmpbuf(png)))
             vigra_postcondition( false, png_error_message.insert(0, "error in png_write_end(): ").c_str() );
         png_write_end(png, info);
@@ -741,37 +1014,44 @@ namespace vigra {
 
     void * PngEncoder::currentScanlineOfBand( unsigned int band )
     {
-        const unsigned int index = pimpl->width * pimpl->components
-            * pimpl->scanline + band;
-        switch (pimpl->bit_depth) {
-        case 8:
-            {
-                typedef void_vector< UInt8 > bands_type;
-                bands_type & bands
-                    = static_cast< bands_type & >(pimpl->bands);
-                return bands.data() + index;
-            }
-        case 16:
-            {
-                typedef void_vector<Int16> bands_type;
-                bands_type & bands
-                    = static_cast< bands_type & >(pimpl->bands);
-                return bands.data() + index;
-            }
-        default:
-            vigra_fail( "internal error: illegal bit depth." );
-        }
-        return 0;
+        return pimpl->currentScanlineOfBand(band);
     }
 
     void PngEncoder::nextScanline()
     {
-        ++(pimpl->scanline);
+        pimpl->nextScanline();
+    }
+
+    void PngEncoder::setNumThreads( int n )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+        pimpl->threads = n;
+    }
+
+    void PngEncoder::writeScanlines( const void * buffer, unsigned int width, unsigned int count,
+                                     unsigned int bands, unsigned int sampleSize,
+                                     std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                     std::ptrdiff_t rowStride )
+    {
+        // libpng copies interleaved rows from the caller's memory
+        if ( pimpl->threads <= 1 && width == pimpl->width &&
+             pixelStride == (std::ptrdiff_t)(bands * sampleSize) &&
+             bandStride == (std::ptrdiff_t)sampleSize )
+        {
+            pimpl->writeRows( static_cast<const png_byte *>(buffer), count, rowStride );
+            pimpl->scanline += count;
+            pimpl->buffer_start = pimpl->scanline;
+        }
+        else
+        {
+            Encoder::writeScanlines( buffer, width, count, bands, sampleSize,
+                                     pixelStride, bandStride, rowStride );
+        }
     }
 
     void PngEncoder::close()
     {
-        pimpl->write();
+        pimpl->close();
     }
 
     void PngEncoder::abort() {}
@@ -91,6 +91,9 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void readScanlines( void * buffer, unsigned int width, unsigned int count,
+                            std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                            std::ptrdiff_t rowStride );
     };
 
     class PngEncoder : public Encoder
@@ -125,6 +128,12 @@ namespace vigra {
         void * currentScanlineOfBand( unsigned int );
         void nextScanline();
         void setICCProfile(const ICCProfile & data);
+
+        void setNumThreads( int n );
+        void writeScanlines( const void * buffer, unsigned int width, unsigned int count,
+                             unsigned int bands, unsigned int sampleSize,
+                             std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                             std::ptrdiff_t rowStride );
     };
 }
 
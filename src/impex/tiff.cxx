@@ -61,10 +61,18 @@
 #include "vigra/sized_int.hxx"
 #include "error.hxx"
 #include "tiff.hxx"
+#include "vigra/array_vector.hxx"
+#include "vigra/threadpool.hxx"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 
+#ifdef HasZLIB
+#include <zlib.h>
+#endif
+
 extern "C"
 {
 
@@ -197,6 +205,8 @@ namespace vigra {
 
         Decoder::ICCProfile iccProfile;
 
+        void freeStripBuffer();
+
     public:
 
         TIFFCodecImpl();
@@ -217,6 +227,14 @@ namespace vigra {
    }
 
     TIFFCodecImpl::~TIFFCodecImpl()
+    {
+        freeStripBuffer();
+
+        if ( tiff != 0 )
+            TIFFClose(tiff);
+    }
+
+    void TIFFCodecImpl::freeStripBuffer()
     {
         if ( planarconfig == PLANARCONFIG_SEPARATE ) {
             if ( stripbuffer != 0 ) {
@@ -232,9 +250,7 @@ namespace vigra {
                 delete[] stripbuffer;
             }
         }
-
-        if ( tiff != 0 )
-            TIFFClose(tiff);
+        stripbuffer = 0;
     }
 
     class TIFFDecoderImpl : public TIFFCodecImpl
@@ -242,15 +258,32 @@ namespace vigra {
         friend class TIFFDecoder;
 
         unsigned int scanline;
+        bool reading;
+
+        // tiled images are decoded tile by tile into a buffer holding
+        // the region of interest's part of one row of tiles
+        bool tiled;
+        uint32 tile_width, tile_height;
+        tdata_t tilebuffer;
+
+        // region of interest, and layout of the rows in stripbuffer:
+        // 'buffer_width' pixels per row, the region starting at 'buffer_offset'
+        uint32 roi_x, roi_y, roi_width, roi_height;
+        uint32 buffer_width, buffer_offset;
 
         std::string get_pixeltype_by_sampleformat() const;
         std::string get_pixeltype_by_datatype() const;
 
+        void allocateBuffers();
+        void readTileRow();
+
     public:
 
         TIFFDecoderImpl( const std::string & filename );
+        ~TIFFDecoderImpl();
 
         void init( unsigned int imageIndex );
+        void setRegionOfInterest( const Diff2D & upperLeft, const Size2D & size );
 
         unsigned int getNumImages();
         void setImageIndex( unsigned int index );
@@ -258,6 +291,9 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int band ) const;
         void nextScanline();
+        bool readScanlines( char * buffer, unsigned int width, unsigned int count,
+                            std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                            std::ptrdiff_t rowStride );
     };
 
     TIFFDecoderImpl::TIFFDecoderImpl( const std::string & filename )
@@ -272,6 +308,18 @@ namespace vigra {
         }
 
         scanline = 0;
+        reading = false;
+        tiled = false;
+        tile_width = tile_height = 0;
+        tilebuffer = 0;
+        roi_x = roi_y = roi_width = roi_height = 0;
+        buffer_width = buffer_offset = 0;
+    }
+
+    TIFFDecoderImpl::~TIFFDecoderImpl()
+    {
+        if ( tilebuffer != 0 )
+            _TIFFfree(tilebuffer);
     }
 
     std::string TIFFDecoderImpl::get_pixeltype_by_sampleformat() const
@@ -349,6 +397,13 @@ namespace vigra {
 
     void TIFFDecoderImpl::init(unsigned int imageIndex)
     {
+        // release the buffers of a previously read image
+        freeStripBuffer();
+        if ( tilebuffer != 0 ) {
+            _TIFFfree(tilebuffer);
+            tilebuffer = 0;
+        }
+
         // set image directory, if necessary:
         if (imageIndex != TIFFCurrentDirectory(tiff))
         {
@@ -361,12 +416,12 @@ namespace vigra {
         TIFFGetField( tiff, TIFFTAG_IMAGELENGTH, &height );
 
         // check for tiled TIFFs
-        uint32 tileWidth, tileHeight;
-        if( TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tileWidth ) &&
-            TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tileHeight ) )
-            vigra_precondition( (tileWidth == width) && (tileHeight == height),
-                                "TIFFDecoder: "
-                                "Cannot read tiled TIFFs (not implemented)." );
+        tiled = TIFFIsTiled(tiff) != 0;
+        if ( tiled ) {
+            if ( !TIFFGetField( tiff, TIFFTAG_TILEWIDTH, &tile_width ) ||
+                 !TIFFGetField( tiff, TIFFTAG_TILELENGTH, &tile_height ) )
+                vigra_fail( "TIFFDecoder: tiled TIFF without tile size." );
+        }
 
         // find out strip heights
         stripheight = 1; // now using scanline interface instead of strip interface
@@ -596,8 +651,46 @@ namespace vigra {
             iccProfile.swap(iccData);
         }
 
+        if ( tiled && bits_per_sample % 8 != 0 )
+            vigra_fail( "TIFFDecoder: Cannot read tiled TIFFs with less than "
+                        "8 bits per sample (not implemented)." );
+
+        // by default, the region of interest is the entire image
+        roi_x = roi_y = 0;
+        roi_width = width;
+        roi_height = height;
+        scanline = 0;
+        reading = false;
+        allocateBuffers();
+    }
+
+    void TIFFDecoderImpl::allocateBuffers()
+    {
+        freeStripBuffer();
+        if ( tilebuffer != 0 ) {
+            _TIFFfree(tilebuffer);
+            tilebuffer = 0;
+        }
+
+        // scanline images read entire rows and skip to the region's first column,
+        // tiled images only store the region's columns
+        tsize_t stripsize;
+        if ( tiled ) {
+            const unsigned int pixelsize = ( bits_per_sample / 8 ) *
+                ( planarconfig == PLANARCONFIG_SEPARATE ? 1 : samples_per_pixel );
+            buffer_width = roi_width;
+            buffer_offset = 0;
+            stripsize = (tsize_t)buffer_width * tile_height * pixelsize;
+            tilebuffer = _TIFFmalloc(TIFFTileSize(tiff));
+            if(tilebuffer == 0)
+                throw std::bad_alloc();
+        } else {
+            buffer_width = width;
+            buffer_offset = roi_x;
+            stripsize = TIFFScanlineSize(tiff);
+        }
+
         // allocate data buffers
-        const unsigned int stripsize = TIFFScanlineSize(tiff);
         if ( planarconfig == PLANARCONFIG_SEPARATE ) {
             stripbuffer = new tdata_t[samples_per_pixel];
             for( unsigned int i = 0; i < samples_per_pixel; ++i ) {
@@ -611,15 +704,80 @@ namespace vigra {
         } else {
             stripbuffer = new tdata_t[1];
             stripbuffer[0] = 0;
-            stripbuffer[0] = _TIFFmalloc(stripsize < width ? width : stripsize);
+            stripbuffer[0] = _TIFFmalloc(stripsize < (tsize_t)width ? (tsize_t)width : stripsize);
             if(stripbuffer[0] == 0)
                 throw std::bad_alloc();
         }
 
-        // let the codec read a new strip
+        // let the codec read a new strip (tiled images determine
+        // the number of rows when they read a row of tiles)
+        if ( tiled )
+            stripheight = 0;
         stripindex = stripheight;
     }
 
+    void TIFFDecoderImpl::setRegionOfInterest( const Diff2D & upperLeft, const Size2D & size )
+    {
+        vigra_precondition( !reading,
+            "TIFFDecoder::setRegionOfInterest(): must be called before the first scanline is read." );
+        vigra_precondition( upperLeft.x >= 0 && upperLeft.y >= 0 && size.x > 0 && size.y > 0 &&
+                            (uint32)(upperLeft.x + size.x) <= width &&
+                            (uint32)(upperLeft.y + size.y) <= height,
+            "TIFFDecoder::setRegionOfInterest(): region is outside of the image." );
+
+        roi_x = upperLeft.x;
+        roi_y = upperLeft.y;
+        roi_width = size.x;
+        roi_height = size.y;
+        if ( tiled ) {
+            scanline = roi_y;
+            allocateBuffers();   // the buffer only holds the region's columns
+        } else {
+            // compressed strips can only be decoded from their beginning, so start
+            // at the first row of the strip containing the region (see nextScanline())
+            uint32 rowsperstrip = 0;
+            if ( !TIFFGetFieldDefaulted( tiff, TIFFTAG_ROWSPERSTRIP, &rowsperstrip ) || rowsperstrip == 0 )
+                rowsperstrip = 1;
+            scanline = roi_y - roi_y % rowsperstrip;
+            buffer_offset = roi_x;
+        }
+    }
+
+    void TIFFDecoderImpl::readTileRow()
+    {
+        vigra_precondition( scanline < roi_y + roi_height,
+            "TIFFDecoder: attempt to read beyond the last scanline." );
+
+        const uint32 rowStart = scanline;
+        const uint32 tileTop  = rowStart - rowStart % tile_height;
+        const uint32 rowEnd   = std::min(tileTop + tile_height, roi_y + roi_height);
+        const uint32 roiEnd   = roi_x + roi_width;
+
+        const bool separate = planarconfig == PLANARCONFIG_SEPARATE;
+        const unsigned int planes = separate ? samples_per_pixel : 1;
+        const unsigned int pixelsize = ( bits_per_sample / 8 ) * ( separate ? 1 : samples_per_pixel );
+
+        // only the tiles intersecting the region of interest are decoded
+        for ( unsigned int plane = 0; plane < planes; ++plane ) {
+            UInt8 * const dest = static_cast< UInt8 * >(stripbuffer[plane]);
+            for ( uint32 tileLeft = roi_x - roi_x % tile_width; tileLeft < roiEnd; tileLeft += tile_width ) {
+                if ( TIFFReadTile( tiff, tilebuffer, tileLeft, tileTop, 0, (tsample_t)plane ) < 0 )
+                    vigra_fail( "TIFFDecoder: error while reading tile." );
+
+                const uint32 colStart = std::max(tileLeft, roi_x);
+                const uint32 colEnd   = std::min(tileLeft + tile_width, roiEnd);
+                const UInt8 * const src = static_cast< UInt8 * >(tilebuffer);
+                for ( uint32 row = rowStart; row < rowEnd; ++row )
+                    std::memcpy( dest + ( (row - rowStart) * buffer_width + (colStart - roi_x) ) * pixelsize,
+                                 src + ( (row - tileTop) * tile_width + (colStart - tileLeft) ) * pixelsize,
+                                 (colEnd - colStart) * pixelsize );
+            }
+        }
+
+        stripheight = rowEnd - rowStart;
+        scanline = rowEnd;
+    }
+
     const void *
     TIFFDecoderImpl::currentScanlineOfBand( unsigned int band ) const
     {
@@ -649,16 +807,17 @@ namespace vigra {
                 }
             }
             // XXX probably right
-            return startpointer + ( stripindex * width ) / 8;
+            return startpointer + ( stripindex * width ) / 8 + buffer_offset;
         } else {
+            const uint32 pixel = stripindex * buffer_width + buffer_offset;
             if ( planarconfig == PLANARCONFIG_SEPARATE ) {
                 UInt8 * const buf
                     = static_cast< UInt8 * >(stripbuffer[band]);
-                return buf + ( stripindex * width ) * ( bits_per_sample / 8 );
+                return buf + pixel * ( bits_per_sample / 8 );
             } else {
                 UInt8 * const buf
                     = static_cast< UInt8 * >(stripbuffer[0]);
-                return buf + ( band + stripindex * width * samples_per_pixel )
+                return buf + ( band + pixel * samples_per_pixel )
                     * ( bits_per_sample / 8 );
             }
         }
@@ -666,16 +825,24 @@ namespace vigra {
 
     void TIFFDecoderImpl::nextScanline()
     {
+        reading = true;
+
         // eventually read a new strip
         if ( ++stripindex >= stripheight ) {
             stripindex = 0;
 
-            if ( planarconfig == PLANARCONFIG_SEPARATE ) {
-                const tsize_t size = TIFFScanlineSize(tiff);
-                for( unsigned int i = 0; i < samples_per_pixel; ++i )
-                    TIFFReadScanline(tiff, stripbuffer[i], scanline++, size);
+            if ( tiled ) {
+                readTileRow();
+            } else if ( planarconfig == PLANARCONFIG_SEPARATE ) {
+                // (rows above the region of interest are decoded and dropped)
+                do {
+                    for( unsigned int i = 0; i < samples_per_pixel; ++i )
+                        TIFFReadScanline(tiff, stripbuffer[i], scanline, (tsample_t)i);
+                } while ( ++scanline <= roi_y );
             } else {
-                TIFFReadScanline( tiff, stripbuffer[0], scanline++, 0);
+                do {
+                    TIFFReadScanline( tiff, stripbuffer[0], scanline, 0);
+                } while ( ++scanline <= roi_y );
             }
 
             // XXX handle bilevel images
@@ -685,7 +852,9 @@ namespace vigra {
                  samples_per_pixel == 1 && pixeltype == "UINT8" ) {
 
                 UInt8 * buf = static_cast< UInt8 * >(stripbuffer[0]);
-                const unsigned int n = TIFFScanlineSize(tiff);
+                const unsigned int n = tiled
+                    ? stripheight * buffer_width
+                    : TIFFScanlineSize(tiff);
 
                 // invert every pixel
                 for ( unsigned int i = 0; i < n; ++i, ++buf )
@@ -694,6 +863,46 @@ namespace vigra {
         }
     }
 
+    bool TIFFDecoderImpl::readScanlines( char * buffer, unsigned int width, unsigned int count,
+                                         std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                         std::ptrdiff_t rowStride )
+    {
+        // only full-width rows of whole-byte samples that need no post-processing
+        // can be decoded directly into the buffer
+        const std::ptrdiff_t samplesize = bits_per_sample / 8;
+        const bool separate = planarconfig == PLANARCONFIG_SEPARATE;
+        if ( tiled || bits_per_sample % 8 != 0 || buffer_offset != 0 || width != this->width ||
+             ( photometric == PHOTOMETRIC_MINISWHITE && samples_per_pixel == 1 && pixeltype == "UINT8" ) )
+            return false;
+        if ( separate
+                ? pixelStride != samplesize
+                : ( bandStride != samplesize || pixelStride != samplesize * (std::ptrdiff_t)samples_per_pixel ) )
+            return false;
+        if ( TIFFScanlineSize(tiff) != (tsize_t)width * ( separate ? samplesize : pixelStride ) )
+            return false;
+
+        reading = true;
+
+        // rows above the region of interest are decoded and dropped
+        for ( ; scanline < roi_y; ++scanline )
+            for( unsigned int i = 0; i < ( separate ? samples_per_pixel : 1 ); ++i )
+                TIFFReadScanline(tiff, stripbuffer[i], scanline, (tsample_t)i);
+
+        for ( unsigned int y = 0; y < count; ++y, ++scanline ) {
+            char * row = buffer + y * rowStride;
+            if ( separate ) {
+                for( unsigned int i = 0; i < samples_per_pixel; ++i )
+                    TIFFReadScanline(tiff, row + i * bandStride, scanline, (tsample_t)i);
+            } else {
+                TIFFReadScanline(tiff, row, scanline, 0);
+            }
+        }
+
+        // the next call to nextScanline() must read a new row
+        stripindex = stripheight;
+        return true;
+    }
+
     void TIFFDecoder::init( const std::string & filename, unsigned int imageIndex=0 )
     {
         pimpl = new TIFFDecoderImpl(filename);
@@ -777,6 +986,12 @@ namespace vigra {
             1 : pimpl->samples_per_pixel;
     }
 
+    bool TIFFDecoder::setRegionOfInterest( const Diff2D & upperLeft, const Size2D & size )
+    {
+        pimpl->setRegionOfInterest(upperLeft, size);
+        return true;
+    }
+
     unsigned int
     TIFFDecoderImpl::getNumImages()
     {
@@ -810,6 +1025,15 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void TIFFDecoder::readScanlines( void * buffer, unsigned int width, unsigned int count,
+                                     std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                                     std::ptrdiff_t rowStride )
+    {
+        if ( !pimpl->readScanlines(static_cast<char *>(buffer), width, count,
+                                   pixelStride, bandStride, rowStride) )
+            Decoder::readScanlines(buffer, width, count, pixelStride, bandStride, rowStride);
+    }
+
     void TIFFDecoder::close() {}
     void TIFFDecoder::abort() {}
 
@@ -823,12 +1047,19 @@ namespace vigra {
         unsigned short tiffcomp;
         bool finalized;
 
+        // parallel deflate: number of threads and of strips buffered
+        // in 'stripbuffer[0]' (one strip in sequential mode)
+        int threads;
+        unsigned int batchstrips;
+        VIGRA_UNIQUE_PTR<ThreadPool> pool;
+
     public:
 
         // ctor, dtor
 
         TIFFEncoderImpl( const std::string & filename, const std::string & mode )
-            : tiffcomp(COMPRESSION_LZW), finalized(false)
+            : tiffcomp(COMPRESSION_LZW), finalized(false),
+              threads(0), batchstrips(1)
         {
             tiff = TIFFOpen( filename.c_str(), mode.c_str() );
             if (!tiff)
@@ -846,6 +1077,7 @@ namespace vigra {
 
         void setCompressionType( const std::string &, int );
         void finalizeSettings();
+        void writeStripsParallel( unsigned int count );
 
         void * currentScanlineOfBand( unsigned int band ) const
         {
@@ -857,6 +1089,18 @@ namespace vigra {
 
         void nextScanline()
         {
+            if ( batchstrips > 1 )
+            {
+                // 'stripindex' counts the rows of the current batch
+                const unsigned int first = strip * stripheight;
+                if ( ++stripindex == batchstrips * stripheight || first + stripindex == height )
+                {
+                    writeStripsParallel( ( stripindex + stripheight - 1 ) / stripheight );
+                    stripindex = 0;
+                }
+                return;
+            }
+
             // compute the number of rows in the current strip
             unsigned int rows = ( strip + 1 ) * stripheight > height ?
                 height - strip * stripheight : stripheight;
@@ -1003,16 +1247,65 @@ namespace vigra {
                          iccProfile.size(), iccProfile.begin());
         }
 
+#ifdef HasZLIB
+        // DEFLATE strips are independent zlib streams, so several of them
+        // can be compressed concurrently and written with TIFFWriteRawStrip()
+        if ( threads > 1 && tiffcomp == COMPRESSION_DEFLATE && bits_per_sample >= 8 )
+        {
+            const unsigned int strips = ( height + stripheight - 1 ) / stripheight;
+            batchstrips = std::min<unsigned int>( strips, 2 * threads );
+            if ( batchstrips > 1 )
+                pool.reset( new ThreadPool( threads ) );
+            else
+                batchstrips = 1;
+        }
+#endif
+
         // alloc memory
         stripbuffer = new tdata_t[1];
         stripbuffer[0] = 0;
-        stripbuffer[0] = _TIFFmalloc( TIFFStripSize(tiff) );
+        stripbuffer[0] = _TIFFmalloc( batchstrips * TIFFStripSize(tiff) );
         if(stripbuffer[0] == 0)
             throw std::bad_alloc();
 
         finalized = true;
     }
 
+    void TIFFEncoderImpl::writeStripsParallel( unsigned int count )
+    {
+#ifdef HasZLIB
+        const tmsize_t stripsize = TIFFStripSize( tiff );
+        ArrayVector<ArrayVector<Bytef> > compressed( count );
+        ArrayVector<int> status( count, Z_OK );
+
+        parallel_foreach( *pool, count,
+            [&](int, int k)
+            {
+                const unsigned int s = strip + k;
+                const unsigned int rows = ( s + 1 ) * stripheight > height ?
+                    height - s * stripheight : stripheight;
+                const uLong size = TIFFVStripSize( tiff, rows );
+                uLongf dest_size = compressBound( size );
+                compressed[k].resize( dest_size );
+                status[k] = compress2( compressed[k].data(), &dest_size,
+                                       ( const Bytef * ) stripbuffer[0] + k * stripsize,
+                                       size, Z_DEFAULT_COMPRESSION );
+                compressed[k].resize( dest_size );
+            });
+
+        for ( unsigned int k = 0; k < count; ++k, ++strip )
+        {
+            if ( status[k] != Z_OK )
+                throw Encoder::TIFFCompressionException(); // retry without compression
+            vigra_postcondition( TIFFWriteRawStrip( tiff, strip, compressed[k].data(),
+                                                    compressed[k].size() ) != -1,
+                    "exportImage(): Unable to write TIFF data." );
+        }
+#else
+        vigra_fail( "TIFFEncoderImpl::writeStripsParallel(): compiled without zlib." );
+#endif
+    }
+
     void TIFFEncoder::init( const std::string & filename, const std::string & mode )
     {
         pimpl = new TIFFEncoderImpl(filename, mode);
@@ -1104,6 +1397,12 @@ namespace vigra {
         pimpl->nextScanline();
     }
 
+    void TIFFEncoder::setNumThreads( int n )
+    {
+        VIGRA_IMPEX_FINALIZED(pimpl->finalized);
+        pimpl->threads = n;
+    }
+
     void TIFFEncoder::setICCProfile(const ICCProfile & data)
     {
         pimpl->iccProfile = data;
@@ -91,10 +91,15 @@ namespace vigra {
 
         const void * currentScanlineOfBand( unsigned int ) const;
         void nextScanline();
+        void readScanlines( void * buffer, unsigned int width, unsigned int count,
+                            std::ptrdiff_t pixelStride, std::ptrdiff_t bandStride,
+                            std::ptrdiff_t rowStride );
 
         std::string getPixelType() const;
         unsigned int getOffset() const;
 
+        bool setRegionOfInterest( const Diff2D & upperLeft, const Size2D & size );
+
         void init( const std::string &, unsigned int );
         void init( const std::string & fileName)
         {
@@ -135,6 +140,7 @@ namespace vigra {
         void * currentScanlineOfBand( unsigned int );
         void nextScanline();
 
+        void setNumThreads( int n );
         void setICCProfile(const ICCProfile & data);
 
         void init( const std::string &, const std::string & );
@@ -522,15 +522,21 @@ namespace vigra {
         ViffHeader header;
         void_vector_base maps, bands;
 
+        // the pixel data are only read when the first scanline is requested
+        std::string filename;
+        bool data_read;
+
         ViffDecoderImpl( const std::string & filename );
 
+        void read_data();
         void read_maps( std::ifstream & stream, byteorder & bo );
         void read_bands( std::ifstream & stream, byteorder & bo );
         void color_map();
     };
 
     ViffDecoderImpl::ViffDecoderImpl( const std::string & filename )
-        : pixelType("undefined"), current_scanline(-1)
+        : pixelType("undefined"), current_scanline(-1),
+          filename(filename), data_read(false)
     {
 #ifdef VIGRA_NEED_BIN_STREAMS
         std::ifstream stream( filename.c_str(), std::ios::binary );
@@ -553,12 +559,70 @@ namespace vigra {
         height = header.col_size;
         components = header.num_data_bands;
 
+        // derive the number of bands and the pixel type of the (mapped) data
+        // from the header, so that the image data need not be read yet
+        if ( header.map_scheme != VFF_MS_NONE )
+        {
+            vigra_precondition(components == 1u,
+                   "map_multiband(): Source image must have one band.");
+            num_maps = header.map_scheme == VFF_MS_SHARED ? 1 : header.num_data_bands;
+            map_width = header.map_row_size;
+            map_height = header.map_col_size;
+            components = num_maps * map_width;
+
+            if ( header.map_storage_type == VFF_MAPTYP_1_BYTE )
+                pixelType = "UINT8";
+            else if ( header.map_storage_type == VFF_MAPTYP_2_BYTE )
+                pixelType = "INT16";
+            else if ( header.map_storage_type == VFF_MAPTYP_4_BYTE )
+                pixelType = "INT32";
+            else if ( header.map_storage_type == VFF_MAPTYP_FLOAT )
+                pixelType = "FLOAT";
+            else
+                vigra_precondition( false, "map storage type unsupported" );
+            vigra_precondition( header.data_storage_type == VFF_TYP_1_BYTE ||
+                                header.data_storage_type == VFF_TYP_2_BYTE ||
+                                header.data_storage_type == VFF_TYP_4_BYTE,
+                                "storage type unsupported" );
+        }
+        else
+        {
+            if ( header.data_storage_type == VFF_TYP_1_BYTE )
+                pixelType = "UINT8";
+            else if ( header.data_storage_type == VFF_TYP_2_BYTE )
+                pixelType = "INT16";
+            else if ( header.data_storage_type == VFF_TYP_4_BYTE )
+                pixelType = "INT32";
+            else if ( header.data_storage_type == VFF_TYP_FLOAT )
+                pixelType = "FLOAT";
+            else if ( header.data_storage_type == VFF_TYP_DOUBLE )
+                pixelType = "DOUBLE";
+            else
+                vigra_precondition( false, "storage type unsupported" );
+        }
+    }
+
+    void ViffDecoderImpl::read_data()
+    {
+#ifdef VIGRA_NEED_BIN_STREAMS
+        std::ifstream stream( filename.c_str(), std::ios::binary );
+#else
+        std::ifstream stream( filename.c_str() );
+#endif
+        byteorder bo( "big endian" );
+
+        // skip the header
+        ViffHeader dummy;
+        dummy.from_stream( stream, bo );
+
         // read data and eventually map it
+        components = header.num_data_bands;
         if ( header.map_scheme != VFF_MS_NONE )
             read_maps( stream, bo );
         read_bands( stream, bo );
         if ( header.map_scheme != VFF_MS_NONE )
             color_map();
+        data_read = true;
     }
 
     void ViffDecoderImpl::read_maps( std::ifstream & stream, byteorder & bo )
@@ -849,6 +913,8 @@ namespace vigra {
 
     const void * ViffDecoder::currentScanlineOfBand( unsigned int band ) const
     {
+        if ( !pimpl->data_read )
+            pimpl->read_data();
         const unsigned int index = pimpl->width
             * ( pimpl->height * band + pimpl->current_scanline );
         if ( pimpl->pixelType == "UINT8" ) {
@@ -0,0 +1,117 @@
+#include <vigra/blockwise_distance.hxx>
+
+#include <vigra/multi_distance.hxx>
+#include <vigra/unittest.hxx>
+#include <vigra/multi_array_chunked.hxx>
+
+#include <iostream>
+#include "utils.hxx"
+
+using namespace std;
+using namespace vigra;
+
+struct BlockwiseDistanceTest
+{
+    typedef MultiArray<3, UInt8> Mask;
+    typedef MultiArray<3, float> Result;
+    typedef Mask::difference_type Shape;
+
+    Shape shape;
+    Mask mask;
+
+    BlockwiseDistanceTest()
+    : shape(37, 23, 29),
+      mask(shape)
+    {
+        // sparse random seeds
+        fillRandom(mask.begin(), mask.end(), 50);
+        for(int i = 0; i != mask.size(); ++i)
+            mask[i] = mask[i] == 0 ? 1 : 0;
+    }
+
+    void testDistSquared()
+    {
+        ChunkedArrayLazy<3, UInt8> source(shape, Shape(8));
+        source.commitSubarray(Shape(0), mask);
+
+        Result reference(shape);
+        separableMultiDistSquared(mask, reference, true);
+
+        int threads[] = { 0, 1, 4 };
+        for(int k=0; k<3; ++k)
+        {
+            ChunkedArrayLazy<3, float> dest(shape, Shape(8));
+            separableMultiDistSquaredBlockwise(source, dest, true,
+                                               BlockwiseOptions().numThreads(threads[k]));
+
+            Result res(shape);
+            dest.checkoutSubarray(Shape(0), res);
+            shouldEqualSequence(reference.begin(), reference.end(), res.begin());
+        }
+
+        // foreground distances and explicit block shape
+        separableMultiDistSquared(mask, reference, false);
+        ChunkedArrayLazy<3, float> dest(shape, Shape(8));
+        separableMultiDistSquaredBlockwise(source, dest, false,
+                                           BlockwiseOptions().blockShape(Shape(5, 7, 3)).numThreads(2));
+        Result res(shape);
+        dest.checkoutSubarray(Shape(0), res);
+        shouldEqualSequence(reference.begin(), reference.end(), res.begin());
+    }
+
+    void testDistance()
+    {
+        ChunkedArrayLazy<3, UInt8> source(shape, Shape(16));
+        source.commitSubarray(Shape(0), mask);
+
+        TinyVector<double, 3> pitch(1.0, 2.5, 0.5);
+
+        Result reference(shape);
+        separableMultiDistance(mask, reference, true, pitch);
+
+        ChunkedArrayLazy<3, float> dest(shape, Shape(8));
+        separableMultiDistanceBlockwise(source, dest, true, pitch,
+                                        BlockwiseOptions().numThreads(3));
+
+        Result res(shape);
+        dest.checkoutSubarray(Shape(0), res);
+        shouldEqualSequenceTolerance(reference.begin(), reference.end(), res.begin(), 1e-5);
+    }
+
+    void testInPlace()
+    {
+        MultiArray<3, int> reference(shape);
+        separableMultiDistSquared(mask, reference, true);
+
+        // integer destination is allowed for integer pixel pitch
+        ChunkedArrayLazy<3, int> data(shape, Shape(8));
+        data.commitSubarray(Shape(0), mask);
+        separableMultiDistSquaredBlockwise(data, data, true);
+
+        MultiArray<3, int> res(shape);
+        data.checkoutSubarray(Shape(0), res);
+        shouldEqualSequence(reference.begin(), reference.end(), res.begin());
+    }
+};
+
+struct BlockwiseDistanceTestSuite
+: public test_suite
+{
+    BlockwiseDistanceTestSuite()
+    : test_suite("blockwise distance test")
+    {
+        add(testCase(&BlockwiseDistanceTest::testDistSquared));
+        add(testCase(&BlockwiseDistanceTest::testDistance));
+        add(testCase(&BlockwiseDistanceTest::testInPlace));
+    }
+};
+
+int main(int argc, char** argv)
+{
+    BlockwiseDistanceTestSuite test;
+    int failed = test.run(testsToBeExecuted(argc, argv));
+
+    cout << test.report() << endl;
+
+    return failed != 0;
+}
@@ -282,6 +282,89 @@ struct BlockwiseLabelingTest
         testOnData(array_ones.begin(), array_ones.end(),
                      shape_ones.begin(), shape_ones.end());
     }
+
+    void parallelTest()
+    {
+        typedef MultiArray<3, int> DataArray;
+        typedef MultiArray<3, UInt32> LabelArray;
+        typedef DataArray::difference_type Shape;
+
+        Shape shape(47, 33, 21);
+        DataArray data(shape);
+        fillRandom(data.begin(), data.end(), 3);
+
+        LabelArray correct_labels(shape);
+        UInt32 correct_label_number = labelMultiArray(data, correct_labels, IndirectNeighborhood);
+
+        LabelArray correct_bg_labels(shape);
+        UInt32 correct_bg_label_number = labelMultiArrayWithBackground(data, correct_bg_labels, DirectNeighborhood, 0);
+
+        int threads[] = { 1, 2, 4, 8 };
+        for(int k = 0; k < 4; ++k)
+        {
+            LabelArray tested_labels(shape);
+            UInt32 tested_label_number =
+                labelMultiArrayBlockwise(data, tested_labels,
+                                         BlockwiseLabelOptions().neighborhood(IndirectNeighborhood)
+                                                                .blockShape(Shape(5, 7, 4))
+                                                                .numThreads(threads[k]));
+            shouldEqual(tested_label_number, correct_label_number);
+            shouldEqual(*argMax(tested_labels.begin(), tested_labels.end()), correct_label_number);
+            should(equivalentLabels(tested_labels.begin(), tested_labels.end(),
+                                    correct_labels.begin(), correct_labels.end()));
+
+            tested_labels = 0;
+            tested_label_number =
+                labelMultiArrayBlockwise(data, tested_labels,
+                                         BlockwiseLabelOptions().neighborhood(DirectNeighborhood)
+                                                                .ignoreBackgroundValue(0)
+                                                                .blockShape(Shape(8))
+                                                                .numThreads(threads[k]));
+            shouldEqual(tested_label_number, correct_bg_label_number);
+            should(equivalentLabels(tested_labels.begin(), tested_labels.end(),
+                                    correct_bg_labels.begin(), correct_bg_labels.end()));
+        }
+
+        // chunked arrays with several threads
+        ChunkedArrayLazy<3, int> chunked_data(shape, Shape(16));
+        chunked_data.commitSubarray(Shape(0), data);
+        ChunkedArrayLazy<3, UInt32> chunked_labels(shape, Shape(16));
+        UInt32 tested_label_number =
+            labelMultiArrayBlockwise(chunked_data, chunked_labels,
+                                     BlockwiseLabelOptions().neighborhood(IndirectNeighborhood).numThreads(4));
+        LabelArray checked_out_labels(shape);
+        chunked_labels.checkoutSubarray(Shape(0), checked_out_labels);
+        shouldEqual(tested_label_number, correct_label_number);
+        should(equivalentLabels(checked_out_labels.begin(), checked_out_labels.end(),
+                                correct_labels.begin(), correct_labels.end()));
+    }
+
+    void concurrentUnionFindTest()
+    {
+        ConcurrentUnionFindArray<UInt32> unions(10);
+        shouldEqual(unions.size(), 10u);
+        shouldEqual(unions.makeUnion(7, 3), 3u);
+        shouldEqual(unions.makeUnion(9, 7), 3u);
+        shouldEqual(unions.makeUnion(5, 6), 5u);
+        shouldEqual(unions.makeUnion(6, 2), 2u);
+        shouldEqual(unions.findIndex(9), 3u);
+        shouldEqual(unions.findIndex(5), 2u);
+
+        std::vector<UInt32> mapping(10);
+        shouldEqual(unions.makeContiguous(mapping), 6u);
+        UInt32 desired[] = { 0, 1, 2, 3, 4, 2, 2, 3, 5, 3 };
+        shouldEqualSequence(mapping.begin(), mapping.end(), desired);
+
+        // concurrent merges of a chain: the result must be a single set
+        ConcurrentUnionFindArray<UInt32> chain(10000);
+        parallel_foreach(4, 9999,
+            [&](int /*threadId*/, uint64_t k)
+            {
+                chain.makeUnion((UInt32)(9999 - k), (UInt32)(9998 - k));
+            });
+        for(UInt32 k = 0; k < 10000; ++k)
+            shouldEqual(chain.findIndex(k), 0u);
+    }
 };
 
 struct BlockwiseLabelingTestSuite
@@ -295,6 +378,8 @@ struct BlockwiseLabelingTestSuite
         add(testCase(&BlockwiseLabelingTest::fiveDimensionalRandomTest));
         add(testCase(&BlockwiseLabelingTest::debugTest));
         add(testCase(&BlockwiseLabelingTest::chunkedArrayTest));
+        add(testCase(&BlockwiseLabelingTest::parallelTest));
+        add(testCase(&BlockwiseLabelingTest::concurrentUnionFindTest));
     }
 };
 
@@ -202,6 +202,156 @@ struct BlockwiseWatershedTest
                                      correct_labels.begin(), correct_labels.end()),
                     true);
     }
+
+    void seededTest()
+    {
+        typedef MultiArray<3, float> Array;
+        typedef MultiArray<3, UInt32> LabelArray;
+        typedef Array::difference_type Shape;
+
+        Shape shape(17, 12, 9);
+
+        // distinct data values, so that there are no ties in the flooding order
+        Array data(shape);
+        linearSequence(data.begin(), data.end());
+        for(int i = data.size()-1; i > 0; --i)
+            std::swap(data[i], data[rand() % (i+1)]);
+
+        LabelArray seeds(shape);
+        for(int i = 1; i <= 20; ++i)
+            seeds[rand() % seeds.size()] = i;
+
+        vector<Shape> block_shapes;
+        block_shapes.push_back(Shape(1));
+        block_shapes.push_back(Shape(4));
+        block_shapes.push_back(Shape(5, 3, 9));
+        block_shapes.push_back(Shape(100));
+
+        NeighborhoodType neighborhoods[] = { DirectNeighborhood, IndirectNeighborhood };
+
+        for(int k = 0; k < 2; ++k)
+        {
+            LabelArray correct_labels(seeds);
+            UInt32 correct_max = watershedsMultiArray(data, correct_labels, neighborhoods[k],
+                                                      WatershedOptions().regionGrowing());
+            for(decltype(block_shapes.size()) j = 0; j != block_shapes.size(); ++j)
+            {
+                LabelArray tested_labels(seeds);
+                UInt32 tested_max = seededWatershedsBlockwise(data, tested_labels, WatershedOptions(),
+                                                              BlockwiseLabelOptions().neighborhood(neighborhoods[k])
+                                                                                     .blockShape(block_shapes[j])
+                                                                                     .numThreads(j % 3));
+                shouldEqual(correct_max, tested_max);
+                shouldEqualSequence(correct_labels.begin(), correct_labels.end(), tested_labels.begin());
+            }
+
+            // stop at threshold
+            double threshold = 0.7 * data.size();
+            correct_labels = seeds;
+            watershedsMultiArray(data, correct_labels, neighborhoods[k],
+                                 WatershedOptions().regionGrowing().stopAtThreshold(threshold));
+            LabelArray tested_labels(seeds);
+            seededWatershedsBlockwise(data, tested_labels, WatershedOptions().stopAtThreshold(threshold),
+                                      BlockwiseLabelOptions().neighborhood(neighborhoods[k])
+                                                             .blockShape(Shape(4)));
+            shouldEqualSequence(correct_labels.begin(), correct_labels.end(), tested_labels.begin());
+        }
+    }
+
+    void seededTiesTest()
+    {
+        typedef MultiArray<2, UInt8> Array;
+        typedef MultiArray<2, UInt32> LabelArray;
+        typedef Array::difference_type Shape;
+
+        Shape shape(60, 47);
+        Array data(shape);
+        fillRandom(data.begin(), data.end(), 4);
+
+        LabelArray seeds(shape);
+        for(int i = 1; i <= 30; ++i)
+            seeds[rand() % seeds.size()] = i;
+
+        LabelArray correct_labels(seeds);
+        watershedsMultiArray(data, correct_labels, IndirectNeighborhood,
+                             WatershedOptions().regionGrowing().stopAtThreshold(2));
+
+        // ties are broken deterministically, independent of the block shape
+        LabelArray reference(seeds);
+        seededWatershedsBlockwise(data, reference, WatershedOptions().stopAtThreshold(2),
+                                  BlockwiseLabelOptions().neighborhood(IndirectNeighborhood).blockShape(shape));
+        for(int j = 1; j < 8; ++j)
+        {
+            LabelArray tested_labels(seeds);
+            seededWatershedsBlockwise(data, tested_labels, WatershedOptions().stopAtThreshold(2),
+                                      BlockwiseLabelOptions().neighborhood(IndirectNeighborhood)
+                                                             .blockShape(Shape(j, 2*j+1)).numThreads(j % 3));
+            shouldEqualSequence(reference.begin(), reference.end(), tested_labels.begin());
+        }
+
+        // the same voxels are labeled as in the serial algorithm, and every voxel
+        // has a neighbor with the same label (i.e. no voxel was assigned an unreachable label)
+        GridGraph<2, undirected_tag> graph(shape, IndirectNeighborhood);
+        for(MultiCoordinateIterator<2> i(shape); i != i.getEndIterator(); ++i)
+        {
+            shouldEqual(reference[*i] == 0, correct_labels[*i] == 0);
+            if(reference[*i] == 0 || seeds[*i] != 0)
+                continue;
+            bool has_neighbor = false;
+            for(GridGraph<2, undirected_tag>::OutArcIt arc(graph, *i); arc != lemon::INVALID; ++arc)
+                if(reference[graph.target(*arc)] == reference[*i])
+                    has_neighbor = true;
+            should(has_neighbor);
+        }
+    }
+
+    template <class T>
+    void seededPlateauTestImpl()
+    {
+        typedef MultiArray<2, T> Array;
+        typedef MultiArray<2, UInt32> LabelArray;
+        typedef typename Array::difference_type Shape;
+
+        Shape shape(20, 9);
+        LabelArray seeds(shape);
+        seeds.bind<0>(0).init(2);
+        seeds.bind<0>(shape[0]-1).init(1);
+
+        // a constant image, and terraces of width 4
+        Array plateau(shape, T(3)), terraces(shape);
+        for(MultiCoordinateIterator<2> i(shape); i != i.getEndIterator(); ++i)
+            terraces[*i] = T((*i)[0] / 4);
+
+        NeighborhoodType neighborhoods[] = { DirectNeighborhood, IndirectNeighborhood };
+        for(int k = 0; k < 2; ++k)
+        {
+            for(int m = 0; m < 2; ++m)
+            {
+                Array const & data = m == 0 ? plateau : terraces;
+                LabelArray correct_labels(seeds);
+                watershedsMultiArray(data, correct_labels, neighborhoods[k],
+                                     WatershedOptions().regionGrowing());
+                // the plateaus are divided, not flooded by the smallest label
+                shouldEqual(correct_labels(m == 0 ? 9 : 17, 4), 2u);
+                shouldEqual(correct_labels(m == 0 ? 10 : 18, 4), 1u);
+
+                for(int j = 1; j < 6; ++j)
+                {
+                    LabelArray tested_labels(seeds);
+                    seededWatershedsBlockwise(data, tested_labels, WatershedOptions(),
+                                              BlockwiseLabelOptions().neighborhood(neighborhoods[k])
+                                                                     .blockShape(Shape(j, j+2)).numThreads(j % 3));
+                    shouldEqualSequence(correct_labels.begin(), correct_labels.end(), tested_labels.begin());
+                }
+            }
+        }
+    }
+
+    void seededPlateauTest()
+    {
+        seededPlateauTestImpl<UInt8>();
+        seededPlateauTestImpl<Int32>();
+    }
 };
 
 struct BlockwiseWatershedTestSuite
@@ -213,6 +363,9 @@ struct BlockwiseWatershedTestSuite
         add(testCase(&BlockwiseWatershedTest::fourDimensionalRandomTest));
         add(testCase(&BlockwiseWatershedTest::oneDimensionalTest));
         add(testCase(&BlockwiseWatershedTest::chunkedTest));
+        add(testCase(&BlockwiseWatershedTest::seededTest));
+        add(testCase(&BlockwiseWatershedTest::seededTiesTest));
+        add(testCase(&BlockwiseWatershedTest::seededPlateauTest));
     }
 };
 
@@ -0,0 +1,264 @@
+/************************************************************************/
+/*                                                                      */
+/*               Copyright 2026 by the VIGRA developers                 */
+/*                                                                      */
+/*    This file is part of the VIGRA computer vision library.           */
+/*    The VIGRA Website is                                              */
+/*        http://hci.iwr.uni-heidelberg.de/vigra/                       */
+/*    Please direct questions, bug reports, and contributions to        */
+/*        ullrich.koethe@iwr.uni-heidelberg.de    or                    */
+/*        vigra@informatik.uni-hamburg.de                               */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+
+#include <iostream>
+#include <set>
+#include "vigra/unittest.hxx"
+#include "vigra/adjacency_list_graph.hxx"
+#include "vigra/multi_gridgraph.hxx"
+#include "vigra/csr_graph.hxx"
+#include "vigra/graph_algorithms.hxx"
+#include "vigra/hierarchical_clustering.hxx"
+
+using namespace vigra;
+
+struct CsrGraphTest{
+
+    typedef vigra::AdjacencyListGraph            ListGraph;
+    typedef vigra::CsrGraph                      GraphType;
+    typedef GraphType::Node                      Node;
+    typedef GraphType::Edge                      Edge;
+    typedef GraphType::Arc                       Arc;
+    typedef GraphType::EdgeIt                    EdgeIt;
+    typedef GraphType::NodeIt                    NodeIt;
+    typedef GraphType::ArcIt                     ArcIt;
+    typedef GraphType::IncEdgeIt                 IncEdgeIt;
+    typedef GraphType::OutArcIt                  OutArcIt;
+    typedef GraphType::InArcIt                   InArcIt;
+    typedef GraphType::NeighborNodeIt            NeighborNodeIt;
+
+    ListGraph listGraph;
+
+    CsrGraphTest()
+    {
+        // node ids with holes, edges in arbitrary order
+        for(int i=1; i<40; ++i)
+            if(i % 7 != 0)
+                listGraph.addNode(i);
+        for(int i=1; i<40; ++i)
+        {
+            for(int k=1; k<4; ++k)
+            {
+                const int j = (i*k*13 + 5) % 40;
+                if(listGraph.nodeFromId(i) != lemon::INVALID &&
+                   listGraph.nodeFromId(j) != lemon::INVALID && i != j)
+                    listGraph.addEdge(listGraph.nodeFromId(i), listGraph.nodeFromId(j));
+            }
+        }
+    }
+
+    float weight(Int64 edgeId) const
+    {
+        return float((edgeId * 37) % 23) + 0.01f * edgeId;
+    }
+
+    void testStructure()
+    {
+        GraphType g(listGraph);
+
+        shouldEqual(g.nodeNum(), listGraph.nodeNum());
+        shouldEqual(g.edgeNum(), listGraph.edgeNum());
+        shouldEqual(g.arcNum(), listGraph.arcNum());
+        shouldEqual(g.maxNodeId(), listGraph.maxNodeId());
+        shouldEqual(g.maxEdgeId(), listGraph.maxEdgeId());
+        shouldEqual(g.maxArcId(), listGraph.maxArcId());
+
+        for(Int64 id=-1; id<=g.maxNodeId()+1; ++id)
+            shouldEqual(g.nodeFromId(id) == lemon::INVALID, listGraph.nodeFromId(id) == lemon::INVALID);
+
+        int count = 0;
+        for(NodeIt n(g); n != lemon::INVALID; ++n, ++count)
+            should(listGraph.nodeFromId(g.id(*n)) != lemon::INVALID);
+        shouldEqual(count, g.nodeNum());
+
+        count = 0;
+        for(EdgeIt e(g); e != lemon::INVALID; ++e, ++count)
+        {
+            const ListGraph::Edge le = listGraph.edgeFromId(g.id(*e));
+            shouldEqual(g.id(g.u(*e)), listGraph.id(listGraph.u(le)));
+            shouldEqual(g.id(g.v(*e)), listGraph.id(listGraph.v(le)));
+            should(g.findEdge(g.u(*e), g.v(*e)) == *e);
+            should(g.findEdge(g.v(*e), g.u(*e)) == *e);
+            should(g.source(g.findArc(g.v(*e), g.u(*e))) == g.v(*e));
+        }
+        shouldEqual(count, g.edgeNum());
+        should(g.findEdge(g.nodeFromId(1), g.nodeFromId(1)) == lemon::INVALID);
+
+        count = 0;
+        for(ArcIt a(g); a != lemon::INVALID; ++a, ++count)
+        {
+            should(g.arcFromId(g.id(*a)) == *a);
+            const Edge e = g.edgeFromId((*a).edgeId());
+            should(g.source(*a) == (g.direction(*a) ? g.u(e) : g.v(e)));
+        }
+        shouldEqual(count, g.arcNum());
+
+        // adjacency is identical to AdjacencyListGraph, including the order
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            const ListGraph::Node ln = listGraph.nodeFromId(g.id(*n));
+            shouldEqual(g.degree(*n), listGraph.degree(ln));
+
+            std::vector<Int64> edges, listEdges, neighbors, listNeighbors;
+            for(IncEdgeIt e(g, *n); e != lemon::INVALID; ++e)
+                edges.push_back(g.id(*e));
+            for(ListGraph::IncEdgeIt e(listGraph, ln); e != lemon::INVALID; ++e)
+                listEdges.push_back(listGraph.id(*e));
+            for(NeighborNodeIt m(g, *n); m != lemon::INVALID; ++m)
+                neighbors.push_back(g.id(*m));
+            for(ListGraph::NeighborNodeIt m(listGraph, ln); m != lemon::INVALID; ++m)
+                listNeighbors.push_back(listGraph.id(*m));
+            shouldEqual(edges.size(), listEdges.size());
+            shouldEqualSequence(edges.begin(), edges.end(), listEdges.begin());
+            shouldEqualSequence(neighbors.begin(), neighbors.end(), listNeighbors.begin());
+
+            for(OutArcIt a(g, *n); a != lemon::INVALID; ++a)
+                should(g.source(*a) == *n);
+            for(InArcIt a(g, *n); a != lemon::INVALID; ++a)
+                should(g.target(*a) == *n);
+        }
+    }
+
+    void testFromGridGraph()
+    {
+        typedef GridGraph<3, boost_graph::undirected_tag> Grid;
+        Grid grid(Shape3(5, 4, 3), IndirectNeighborhood);
+        GraphType g(grid);
+
+        shouldEqual(g.nodeNum(), grid.nodeNum());
+        shouldEqual(g.edgeNum(), grid.edgeNum());
+        shouldEqual(g.maxNodeId(), grid.maxNodeId());
+        shouldEqual(g.maxEdgeId(), grid.maxEdgeId());
+
+        for(Grid::NodeIt n(grid); n != lemon::INVALID; ++n)
+            shouldEqual(g.degree(g.nodeFromId(grid.id(*n))), (size_t)grid.degree(*n));
+
+        for(Grid::EdgeIt e(grid); e != lemon::INVALID; ++e)
+        {
+            const Edge ce = g.findEdge(g.nodeFromId(grid.id(grid.u(*e))),
+                                       g.nodeFromId(grid.id(grid.v(*e))));
+            shouldEqual(g.id(ce), grid.id(*e));
+        }
+        for(Int64 id=0; id<=grid.maxEdgeId(); ++id)
+            shouldEqual(g.edgeFromId(id) == lemon::INVALID, grid.edgeFromId(id) == lemon::INVALID);
+
+        GraphType empty;
+        shouldEqual(empty.nodeNum(), 0);
+        shouldEqual(empty.maxNodeId(), -1);
+        should(NodeIt(empty) == lemon::INVALID);
+        should(EdgeIt(empty) == lemon::INVALID);
+    }
+
+    void testAlgorithms()
+    {
+        GraphType g(listGraph);
+
+        ListGraph::EdgeMap<float> listWeights(listGraph), listLengths(listGraph, 1.0f);
+        GraphType::EdgeMap<float> weights(g), lengths(g, 1.0f);
+        for(EdgeIt e(g); e != lemon::INVALID; ++e)
+        {
+            weights[*e] = weight(g.id(*e));
+            listWeights[listGraph.edgeFromId(g.id(*e))] = weight(g.id(*e));
+        }
+
+        // shortest paths
+        ShortestPathDijkstra<ListGraph, float> listSp(listGraph);
+        ShortestPathDijkstra<GraphType, float> sp(g);
+        listSp.run(listWeights, listGraph.nodeFromId(1));
+        sp.run(weights, g.nodeFromId(1));
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+            shouldEqual(sp.distance(*n), listSp.distance(listGraph.nodeFromId(g.id(*n))));
+
+        // edge weighted watersheds
+        ListGraph::NodeMap<UInt32> listSeeds(listGraph, 0), listLabels(listGraph, 0);
+        GraphType::NodeMap<UInt32> seeds(g, 0), labels(g, 0);
+        listSeeds[listGraph.nodeFromId(1)] = seeds[g.nodeFromId(1)] = 1;
+        listSeeds[listGraph.nodeFromId(20)] = seeds[g.nodeFromId(20)] = 2;
+        listSeeds[listGraph.nodeFromId(33)] = seeds[g.nodeFromId(33)] = 3;
+        edgeWeightedWatershedsSegmentation(listGraph, listWeights, listSeeds, listLabels);
+        edgeWeightedWatershedsSegmentation(g, weights, seeds, labels);
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+            shouldEqual(labels[*n], listLabels[listGraph.nodeFromId(g.id(*n))]);
+
+        // felzenszwalb
+        ListGraph::NodeMap<float> listSizes(listGraph, 1.0f);
+        GraphType::NodeMap<float> sizes(g, 1.0f);
+        felzenszwalbSegmentation(listGraph, listWeights, listSizes, 5.0f, listLabels, 6);
+        felzenszwalbSegmentation(g, weights, sizes, 5.0f, labels, 6);
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+            shouldEqual(labels[*n], listLabels[listGraph.nodeFromId(g.id(*n))]);
+
+        // hierarchical clustering
+        ListGraph::NodeMap<float> listFeatures(listGraph);
+        GraphType::NodeMap<float> features(g);
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+            listFeatures[listGraph.nodeFromId(g.id(*n))] = features[*n] = float(g.id(*n) % 5);
+        hierarchicalClustering(listGraph, listWeights, listLengths, listFeatures, listSizes, listLabels,
+                               ClusteringOptions().minRegionCount(4).nodeFeatureImportance(0.5));
+        hierarchicalClustering(g, weights, lengths, features, sizes, labels,
+                               ClusteringOptions().minRegionCount(4).nodeFeatureImportance(0.5));
+        std::set<UInt32> clusters;
+        for(NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            shouldEqual(labels[*n], listLabels[listGraph.nodeFromId(g.id(*n))]);
+            clusters.insert(labels[*n]);
+        }
+        shouldEqual(clusters.size(), 4u);
+    }
+};
+
+struct CsrGraphTestSuite
+: public vigra::test_suite
+{
+    CsrGraphTestSuite()
+    : vigra::test_suite("CsrGraphTestSuite")
+    {
+        add( testCase( &CsrGraphTest::testStructure));
+        add( testCase( &CsrGraphTest::testFromGridGraph));
+        add( testCase( &CsrGraphTest::testAlgorithms));
+    }
+};
+
+int main(int argc, char ** argv)
+{
+    CsrGraphTestSuite test;
+
+    int failed = test.run(vigra::testsToBeExecuted(argc, argv));
+
+    std::cout << test.report() << std::endl;
+
+    return (failed != 0);
+}
@@ -13,6 +13,8 @@
 #include "vigra/impex.hxx"
 
 #include "vigra/medianfilter.hxx"
+#include "vigra/multi_rank_filter.hxx"
+#include "vigra/random.hxx"
 #include "vigra/shockfilter.hxx"
 #include "vigra/specklefilters.hxx"
 
@@ -225,6 +227,112 @@ struct MedianFilterExactTest
     
 };
 
+struct MultiRankFilterTest
+{
+    // brute-force reference: sort the window of every pixel
+    template <unsigned int N, class T>
+    static void referenceRankFilter(MultiArrayView<N, T> const & src, MultiArrayView<N, T> dest,
+                                    typename MultiArrayShape<N>::type const & windowShape,
+                                    double rank, BorderTreatmentMode border)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+        MultiArrayIndex size = prod(windowShape),
+                        index = std::min<MultiArrayIndex>(size-1, (MultiArrayIndex)(rank*size));
+        std::vector<T> window;
+        MultiCoordinateIterator<N> p(src.shape()), end = p.getEndIterator();
+        for(; p != end; ++p)
+        {
+            window.clear();
+            MultiCoordinateIterator<N> w(windowShape), wend = w.getEndIterator();
+            for(; w != wend; ++w)
+            {
+                Shape q = *p + *w - div(windowShape, MultiArrayIndex(2));
+                bool inside = true;
+                for(unsigned int d=0; d<N; ++d)
+                {
+                    if(q[d] < 0 || q[d] >= src.shape(d))
+                    {
+                        inside = false;
+                        q[d] = q[d] < 0 ? 0 : src.shape(d) - 1;
+                    }
+                }
+                window.push_back(inside || border == BORDER_TREATMENT_REPEAT ? src[q] : T());
+            }
+            std::sort(window.begin(), window.end());
+            dest[*p] = window[index];
+        }
+    }
+
+    template <unsigned int N, class T>
+    void testRandom(typename MultiArrayShape<N>::type const & shape, int maxValue)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+        MersenneTwister random;
+        MultiArray<N, T> src(shape), dest(shape), ref(shape);
+        for(int k=0; k<src.size(); ++k)
+            src[k] = T(random.uniformInt(maxValue));
+
+        Shape windows[] = { Shape(1), Shape(3), Shape(5), Shape(4) };
+        windows[3][0] = 7;
+        double ranks[] = { 0.0, 0.2, 0.5, 1.0 };
+        BorderTreatmentMode borders[] = { BORDER_TREATMENT_REPEAT, BORDER_TREATMENT_ZEROPAD };
+
+        for(int w=0; w<4; ++w)
+        {
+            for(int r=0; r<4; ++r)
+            {
+                for(int b=0; b<2; ++b)
+                {
+                    referenceRankFilter(src, ref, windows[w], ranks[r], borders[b]);
+                    multiRankFilter(src, dest, windows[w], ranks[r], borders[b],
+                                    BlockwiseOptions().blockShape(7).numThreads(w));
+                    shouldEqualSequence(dest.begin(), dest.end(), ref.begin());
+                }
+            }
+        }
+
+        dest = src;
+        multiMedianFilter(src, dest, Shape(5), BORDER_TREATMENT_AVOID);
+        referenceRankFilter(src, ref, Shape(5), 0.5, BORDER_TREATMENT_REPEAT);
+        shouldEqual(dest[Shape()], src[Shape()]);
+        shouldEqual(dest[shape - Shape(1)], src[shape - Shape(1)]);
+        shouldEqualSequence(dest.subarray(Shape(2), shape-Shape(2)).begin(), dest.subarray(Shape(2), shape-Shape(2)).end(),
+                            ref.subarray(Shape(2), shape-Shape(2)).begin());
+    }
+
+    void testRandom2D()
+    {
+        testRandom<2, UInt8>(Shape2(31, 23), 256);
+        testRandom<2, Int16>(Shape2(31, 23), 1000);
+        testRandom<2, float>(Shape2(31, 23), 50);
+    }
+
+    void testRandom3D()
+    {
+        testRandom<3, UInt8>(Shape3(17, 13, 11), 256);
+        testRandom<3, UInt16>(Shape3(17, 13, 11), 65536);
+        testRandom<3, double>(Shape3(17, 13, 11), 1000);
+    }
+
+    void testMedianFilterCompatibility()
+    {
+        MedianFilterExactTest t;
+        MultiArrayView<2, float> img(Shape2(5,5), t.img.data());
+        // BORDER_TREATMENT_REFLECT is not compared: medianFilter() repeats the edge pixel,
+        // whereas multiRankFilter() reflects like the convolution functions
+        BorderTreatmentMode borders[] = { BORDER_TREATMENT_REPEAT, BORDER_TREATMENT_WRAP,
+                                          BORDER_TREATMENT_ZEROPAD };
+        for(int b=0; b<3; ++b)
+        {
+            FImage ref(img.shape(0), img.shape(1));
+            MultiArray<2, float> res(img.shape());
+            medianFilter(srcImageRange(t.img), destImage(ref), Diff2D(3,3), borders[b]);
+            multiMedianFilter(img, res, Shape2(3), borders[b]);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+        }
+    }
+};
+
 struct MedianFilterTestSuite
 : public vigra::test_suite
 {
@@ -238,6 +346,9 @@ struct MedianFilterTestSuite
         add( testCase( &MedianFilterExactTest::testREFLECT));
         add( testCase( &MedianFilterExactTest::testWRAP));
         add( testCase( &MedianFilterExactTest::testZEROPAD));
+        add( testCase( &MultiRankFilterTest::testRandom2D));
+        add( testCase( &MultiRankFilterTest::testRandom3D));
+        add( testCase( &MultiRankFilterTest::testMedianFilterCompatibility));
    }
 };
 
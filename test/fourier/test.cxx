@@ -469,6 +469,60 @@ struct MultiFFTTest
         shouldEqualTolerance(minmax.max, 0.0, 1e-10);
     }
 
+    void testFFTMany()
+    {
+        Shape3 s(12, 10, 7);
+        CArray3 in(s), out(s), ref(s), inv(s);
+        DArray3 rin(s), rinv(s);
+        for(int k=0; k<rin.size(); ++k)
+        {
+            rin[k] = rand()/(double)RAND_MAX;
+            in[k] = C(rin[k], rand()/(double)RAND_MAX);
+        }
+
+        for(int k=0; k<s[2]; ++k)
+            fourierTransform(in.bindOuter(k), ref.bindOuter(k));
+
+        for(int threads=0; threads<4; ++threads)
+        {
+            out.init(C());
+            fourierTransformMany(in, out, ParallelOptions().numThreads(threads));
+            shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), C(1e-12, 1e-12));
+
+            fourierTransformInverseMany(out, inv, ParallelOptions().numThreads(threads));
+            shouldEqualSequenceTolerance(inv.data(), inv.data()+inv.size(), in.data(), C(1e-12, 1e-12));
+        }
+
+        // real-valued input, full and half-space output
+        for(int k=0; k<s[2]; ++k)
+            fourierTransform(rin.bindOuter(k), ref.bindOuter(k));
+        fourierTransformMany(rin, out, ParallelOptions().numThreads(3));
+        shouldEqualSequenceTolerance(out.data(), out.data()+out.size(), ref.data(), C(1e-12, 1e-12));
+
+        Shape3 hs(fftwCorrespondingShapeR2C(Shape2(s[0], s[1]))[0], s[1], s[2]);
+        CArray3 half(hs), halfRef(hs);
+        for(int k=0; k<s[2]; ++k)
+            fourierTransform(rin.bindOuter(k), halfRef.bindOuter(k));
+        fourierTransformMany(rin, half, ParallelOptions().numThreads(2));
+        shouldEqualSequenceTolerance(half.data(), half.data()+half.size(), halfRef.data(), C(1e-12, 1e-12));
+
+        fourierTransformInverseMany(half, rinv, ParallelOptions().numThreads(2));
+        shouldEqualSequenceTolerance(rinv.data(), rinv.data()+rinv.size(), rin.data(), 1e-10);
+
+        // re-use an explicit plan on a stack whose slices are interleaved in memory
+        for(int k=0; k<s[2]; ++k)
+            fourierTransform(in.bindOuter(k), ref.bindOuter(k));
+        CArray3 tin(Shape3(s[0], s[2], s[1])), tout(tin.shape());
+        MultiArrayView<3, C, StridedArrayTag> sin  = tin.transpose(Shape3(0, 2, 1)),
+                                              sout = tout.transpose(Shape3(0, 2, 1));
+        FFTWBatchPlan<2, double> plan(sin, sout, FFTW_FORWARD, FFTW_ESTIMATE, ParallelOptions().numThreads(2));
+        shouldEqual(plan.size(), s[2]);
+        sin = in; // planning may overwrite the input
+        plan.execute(sin, sout);
+        CArray3 res(sout);
+        shouldEqualSequenceTolerance(res.data(), res.data()+res.size(), ref.data(), C(1e-12, 1e-12));
+    }
+
     void testPadding()
     {
         shouldEqual(0, detail::FFTWPaddingSize<0>::find(0));
@@ -711,6 +765,7 @@ struct FFTWTestSuite
         add( testCase(&MultiFFTTest::testFFTShift));
         add( testCase(&MultiFFTTest::testFFT2D));
         add( testCase(&MultiFFTTest::testFFT3D));
+        add( testCase(&MultiFFTTest::testFFTMany));
         add( testCase(&MultiFFTTest::testPadding));
         add( testCase(&MultiFFTTest::testConvolveFFT));
         add( testCase(&MultiFFTTest::testConvolveFFTComplex));
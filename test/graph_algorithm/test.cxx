@@ -34,11 +34,15 @@
 /************************************************************************/
 
 #include <iostream>
+#include <map>
+#include <set>
 #include "vigra/unittest.hxx"
 #include "vigra/stdimage.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/adjacency_list_graph.hxx"
 #include "vigra/graph_algorithms.hxx"
+#include "vigra/hierarchical_clustering.hxx"
+#include "vigra/merge_graph_adaptor.hxx"
 #include "vigra/multi_resize.hxx"
 
 using namespace vigra;
@@ -453,6 +457,406 @@ struct GraphAlgorithmTest{
     }
 
 
+    template<class GRAPH_IN, class LABELS>
+    void checkParallelRag(GRAPH_IN const & g, LABELS const & labels, Int64 ignoreLabel)
+    {
+        typedef typename GRAPH_IN::Edge InEdge;
+        typedef GraphType::EdgeMap< std::vector<InEdge> > AffEdges;
+
+        GraphType serialRag, parallelRag;
+        AffEdges serialAff, parallelAff;
+        makeRegionAdjacencyGraph(g, labels, serialRag, serialAff, ignoreLabel);
+        makeRegionAdjacencyGraph(g, labels, parallelRag, parallelAff,
+                                 ParallelOptions().numThreads(4), ignoreLabel);
+
+        shouldEqual(parallelRag.nodeNum(), serialRag.nodeNum());
+        shouldEqual(parallelRag.edgeNum(), serialRag.edgeNum());
+        shouldEqual(parallelRag.maxNodeId(), serialRag.maxNodeId());
+        for(NodeIt n(serialRag); n != lemon::INVALID; ++n)
+            should(parallelRag.nodeFromId(serialRag.id(*n)) != lemon::INVALID);
+
+        for(EdgeIt e(serialRag); e != lemon::INVALID; ++e)
+        {
+            const Edge pe = parallelRag.findEdge(parallelRag.nodeFromId(serialRag.id(serialRag.u(*e))),
+                                                 parallelRag.nodeFromId(serialRag.id(serialRag.v(*e))));
+            should(pe != lemon::INVALID);
+
+            std::vector<Int64> serialIds, parallelIds;
+            for(std::size_t k=0; k<serialAff[*e].size(); ++k)
+                serialIds.push_back(g.id(serialAff[*e][k]));
+            for(std::size_t k=0; k<parallelAff[pe].size(); ++k)
+                parallelIds.push_back(g.id(parallelAff[pe][k]));
+            std::sort(serialIds.begin(), serialIds.end());
+            shouldEqual(parallelIds.size(), serialIds.size());
+            shouldEqualSequence(parallelIds.begin(), parallelIds.end(), serialIds.begin());
+        }
+    }
+
+    void testParallelRegionAdjacencyGraph()
+    {
+        typedef GridGraph<3, boost_graph::undirected_tag> GridGraph3d;
+        typedef GridGraph3d::NodeMap<UInt32> LabelMap;
+
+        // large enough to exercise several id slices per thread
+        GridGraph3d g(Shape3(60, 50, 40), IndirectNeighborhood);
+        LabelMap labels(g);
+        for(GridGraph3d::NodeIt n(g); n != lemon::INVALID; ++n)
+        {
+            const Shape3 p(*n);
+            labels[*n] = 1 + (p[0] + p[2] % 4) / 7 + 10 * (p[1] / 6) + 100 * (p[2] / 5);
+        }
+
+        checkParallelRag(g, labels, -1);
+        checkParallelRag(g, labels, labels[Shape3(30, 25, 20)]);
+
+        // input graphs other than GridGraph are supported as well
+        GraphType g2;
+        GraphType::NodeMap<UInt32> labels2;
+        for(int i=0; i<20; ++i)
+            g2.addNode(i);
+        for(int i=0; i<19; ++i)
+        {
+            g2.addEdge(i, i+1);
+            g2.addEdge(i, (i*7) % 20);
+        }
+        labels2.assign(g2);
+        for(NodeIt n(g2); n != lemon::INVALID; ++n)
+            labels2[*n] = g2.id(*n) / 3;
+        checkParallelRag(g2, labels2, -1);
+    }
+
+    void testLazyHierarchicalClustering()
+    {
+        // a 12x10 grid of regions with pseudo-random edge weights and features
+        GraphType rag;
+        const int w = 12, h = 10;
+        for(int y=0; y<h; ++y)
+            for(int x=0; x<w; ++x)
+            {
+                if(x+1 < w)
+                    rag.addEdge(x+w*y, x+1+w*y);
+                if(y+1 < h)
+                    rag.addEdge(x+w*y, x+w*(y+1));
+            }
+
+        GraphType::EdgeMap<float> edgeWeights(rag), edgeLengths(rag);
+        GraphType::NodeMap<TinyVector<float, 2> > nodeFeatures(rag);
+        GraphType::NodeMap<float> nodeSizes(rag);
+        for(EdgeIt e(rag); e != lemon::INVALID; ++e)
+        {
+            const int id = rag.id(*e);
+            edgeWeights[*e] = float((id * 7919) % 101) / 10.0f + 0.0001f * id;
+            edgeLengths[*e] = float(1 + id % 3);
+        }
+        for(NodeIt n(rag); n != lemon::INVALID; ++n)
+        {
+            const int id = rag.id(*n);
+            nodeFeatures[*n] = TinyVector<float, 2>(float((id * 31) % 17), float((id * 13) % 7));
+            nodeSizes[*n] = float(1 + id % 4);
+        }
+
+        for(int metric = metrics::ManhattanMetric; metric >= metrics::SquaredNormMetric; --metric)
+        {
+            ClusteringOptions options = ClusteringOptions().minRegionCount(9)
+                                                           .nodeFeatureImportance(0.3)
+                                                           .sizeImportance(0.7)
+                                                           .nodeFeatureMetric(metrics::MetricType(metric));
+
+            // the default engine modifies its input maps, so hand it copies
+            GraphType::EdgeMap<float> w1(edgeWeights), l1(edgeLengths);
+            GraphType::NodeMap<TinyVector<float, 2> > f1(nodeFeatures);
+            GraphType::NodeMap<float> s1(nodeSizes);
+            GraphType::NodeMap<UInt32> labels(rag), lazyLabels(rag);
+            hierarchicalClustering(rag, w1, l1, f1, s1, labels, options);
+            hierarchicalClustering(rag, edgeWeights, edgeLengths, nodeFeatures, nodeSizes, lazyLabels,
+                                   ClusteringOptions(options).lazyUpdates());
+
+            std::map<UInt32, UInt32> forward, backward;
+            for(NodeIt n(rag); n != lemon::INVALID; ++n)
+            {
+                forward.insert(std::make_pair(labels[*n], lazyLabels[*n]));
+                backward.insert(std::make_pair(lazyLabels[*n], labels[*n]));
+                shouldEqual(forward[labels[*n]], lazyLabels[*n]);
+                shouldEqual(backward[lazyLabels[*n]], labels[*n]);
+            }
+            shouldEqual(forward.size(), 9u);
+        }
+
+        // the merge tree has one entry per merge, and the engine leaves its inputs alone
+        GraphType::EdgeMap<float> weightsBefore(edgeWeights);
+        AgglomerativeClustering<GraphType> clustering(rag,
+            ClusteringOptions().minRegionCount(5).buildMergeTreeEncoding());
+        clustering.cluster(edgeWeights, edgeLengths, nodeFeatures, nodeSizes);
+        shouldEqual(clustering.nodeNum(), 5);
+        shouldEqual(clustering.mergeTreeEncoding().size(), (std::size_t)(rag.nodeNum() - 5));
+        for(std::size_t k=1; k<clustering.mergeTreeEncoding().size(); ++k)
+        {
+            const AgglomerativeClustering<GraphType>::MergeItem & m = clustering.mergeTreeEncoding()[k];
+            should(m.r_ == m.a_ || m.r_ == m.b_);
+        }
+        for(EdgeIt e(rag); e != lemon::INVALID; ++e)
+            shouldEqual(edgeWeights[*e], weightsBefore[*e]);
+
+        // clustering again starts from scratch
+        GraphType::NodeMap<UInt32> firstLabels(rag), secondLabels(rag);
+        clustering.reprNodeIds(firstLabels);
+        const AgglomerativeClustering<GraphType>::MergeTreeEncoding firstTree(clustering.mergeTreeEncoding());
+        clustering.cluster(edgeWeights, edgeLengths, nodeFeatures, nodeSizes);
+        clustering.reprNodeIds(secondLabels);
+        shouldEqual(clustering.nodeNum(), 5);
+        shouldEqual(clustering.mergeTreeEncoding().size(), firstTree.size());
+        for(std::size_t k=0; k<firstTree.size(); ++k)
+        {
+            shouldEqual(clustering.mergeTreeEncoding()[k].a_, firstTree[k].a_);
+            shouldEqual(clustering.mergeTreeEncoding()[k].b_, firstTree[k].b_);
+        }
+        for(NodeIt n(rag); n != lemon::INVALID; ++n)
+            shouldEqual(secondLabels[*n], firstLabels[*n]);
+
+        // stop at a merge distance threshold
+        AgglomerativeClustering<GraphType> thresholded(rag, ClusteringOptions().maxMergeDistance(0.0));
+        thresholded.cluster(edgeWeights, edgeLengths, nodeFeatures, nodeSizes);
+        shouldEqual(thresholded.nodeNum(), rag.nodeNum());
+    }
+
+    void testParallelFelzenszwalb()
+    {
+        typedef GridGraph<2, boost_graph::undirected_tag> GridGraph2d;
+        GridGraph2d g(Shape2(64, 48), DirectNeighborhood);
+        GridGraph2d::EdgeMap<float> weights(g);
+        GridGraph2d::NodeMap<float> sizes(g, 1.0f);
+        for(GridGraph2d::EdgeIt e(g); e != lemon::INVALID; ++e)
+        {
+            const Shape2 p(g.u(*e)), q(g.v(*e));
+            // strong edges between 16x12 tiles plus a little texture
+            const bool boundary = p[0] / 16 != q[0] / 16 || p[1] / 12 != q[1] / 12;
+            weights[*e] = (boundary ? 10.0f : 0.0f) + float((g.id(*e) * 7919) % 1009) / 1009.0f;
+        }
+
+        GridGraph2d::NodeMap<UInt32> serial(g), parallel(g);
+        felzenszwalbSegmentation(g, weights, sizes, 200.0f, serial);
+
+        // a single block reproduces the serial result exactly
+        felzenszwalbSegmentation(g, weights, sizes, 200.0f, parallel, ParallelOptions().numThreads(1));
+        shouldEqualSequence(parallel.begin(), parallel.end(), serial.begin());
+
+        // with several blocks, the seams are merged afterwards, so the strong
+        // boundaries are preserved and the regions in between are found
+        felzenszwalbSegmentation(g, weights, sizes, 200.0f, parallel, ParallelOptions().numThreads(4));
+        std::set<UInt32> serialRegions(serial.begin(), serial.end()),
+                         parallelRegions(parallel.begin(), parallel.end());
+        shouldEqual(serialRegions.size(), 16u);
+        shouldEqual(parallelRegions.size(), serialRegions.size());
+        for(GridGraph2d::EdgeIt e(g); e != lemon::INVALID; ++e)
+            shouldEqual(parallel[g.u(*e)] == parallel[g.v(*e)], serial[g.u(*e)] == serial[g.v(*e)]);
+
+        // with many tied weights, both versions visit the edges in the same order
+        GridGraph2d::EdgeMap<float> tiedWeights(g);
+        for(GridGraph2d::EdgeIt e(g); e != lemon::INVALID; ++e)
+            tiedWeights[*e] = float((g.id(*e) * 7919) % 4);
+        felzenszwalbSegmentation(g, tiedWeights, sizes, 2.0f, serial);
+        felzenszwalbSegmentation(g, tiedWeights, sizes, 2.0f, parallel, ParallelOptions().numThreads(1));
+        shouldEqualSequence(parallel.begin(), parallel.end(), serial.begin());
+
+        // stopping condition
+        felzenszwalbSegmentation(g, weights, sizes, 20.0f, serial, 5);
+        felzenszwalbSegmentation(g, weights, sizes, 20.0f, parallel, ParallelOptions().numThreads(1), 5);
+        shouldEqualSequence(parallel.begin(), parallel.end(), serial.begin());
+        felzenszwalbSegmentation(g, weights, sizes, 20.0f, parallel, ParallelOptions().numThreads(4), 5);
+        shouldEqual(std::set<UInt32>(parallel.begin(), parallel.end()).size(), 5u);
+
+        // other graph types
+        GraphType ag;
+        for(int i=0; i<200; ++i)
+            ag.addEdge(i, i+1);
+        GraphType::EdgeMap<float> agWeights(ag);
+        GraphType::NodeMap<float> agSizes(ag, 1.0f);
+        GraphType::NodeMap<UInt32> agSerial(ag), agParallel(ag);
+        for(EdgeIt e(ag); e != lemon::INVALID; ++e)
+            agWeights[*e] = (ag.id(*e) % 50 == 49) ? 5.0f : 0.01f * (ag.id(*e) % 7);
+        felzenszwalbSegmentation(ag, agWeights, agSizes, 1.0f, agSerial);
+        felzenszwalbSegmentation(ag, agWeights, agSizes, 1.0f, agParallel, ParallelOptions().numThreads(3));
+        for(EdgeIt e(ag); e != lemon::INVALID; ++e)
+            shouldEqual(agParallel[ag.u(*e)] == agParallel[ag.v(*e)], agSerial[ag.u(*e)] == agSerial[ag.v(*e)]);
+    }
+
+    template <class Graph>
+    void testShortestPathQueryEngineImpl(Graph const & g, typename Graph::template EdgeMap<float> const & weights)
+    {
+        typedef typename Graph::Node Node;
+        typedef typename Graph::NodeIt GraphNodeIt;
+
+        std::vector<Node> nodes;
+        for(GraphNodeIt n(g); n != lemon::INVALID; ++n)
+            nodes.push_back(*n);
+
+        ShortestPathDijkstra<Graph, float> reference(g);
+        ShortestPathQueryEngine<Graph, float> engine(g);
+
+        for(std::size_t q = 0; q < 20; ++q)
+        {
+            const Node source = nodes[(q * 37) % nodes.size()],
+                       target = nodes[(q * 101 + 13) % nodes.size()];
+            reference.run(weights, source);
+
+            // single source, full run
+            shouldEqual(engine.run(weights, source), NumericTraits<float>::max());
+            for(std::size_t k = 0; k < nodes.size(); ++k)
+            {
+                shouldEqualTolerance(engine.distance(nodes[k]), reference.distances()[nodes[k]], 1e-4f);
+                should(engine.nearestSource(nodes[k]) == source);
+            }
+
+            // single source with target, and bidirectional
+            const float expected = reference.distances()[target];
+            shouldEqualTolerance(engine.run(weights, source, target), expected, 1e-4f);
+            shouldEqualTolerance(engine.runBidirectional(weights, source, target), expected, 1e-4f);
+
+            std::vector<Node> path;
+            engine.path(path);
+            should(path.size() > 0);
+            should(path.front() == source);
+            should(path.back() == target);
+            float length = 0.0f;
+            for(std::size_t k = 1; k < path.size(); ++k)
+                length += weights[g.findEdge(path[k-1], path[k])];
+            shouldEqualTolerance(length, expected, 1e-4f);
+        }
+
+        // maxDistance
+        shouldEqual(engine.runBidirectional(weights, nodes[0], nodes.back(), 0.5f), NumericTraits<float>::max());
+        std::vector<Node> path;
+        engine.path(path);
+        shouldEqual(path.size(), 0u);
+
+        // both searches stay within maxDistance and meet, but the path is too long
+        reference.run(weights, nodes[0]);
+        const float fullDistance = reference.distances()[nodes.back()];
+        shouldEqual(engine.runBidirectional(weights, nodes[0], nodes.back(), 0.75f*fullDistance),
+                    NumericTraits<float>::max());
+        engine.path(path);
+        shouldEqual(path.size(), 0u);
+
+        // multi-source agrees with ShortestPathDijkstra::runMultiSource()
+        std::vector<Node> sources;
+        sources.push_back(nodes[3]);
+        sources.push_back(nodes[nodes.size() / 2]);
+        sources.push_back(nodes[nodes.size() - 5]);
+        reference.runMultiSource(weights, sources.begin(), sources.end());
+        engine.runMultiSource(weights, sources.begin(), sources.end());
+        for(std::size_t k = 0; k < nodes.size(); ++k)
+        {
+            const float d = engine.distance(nodes[k]);
+            shouldEqualTolerance(d, reference.distances()[nodes[k]], 1e-4f);
+            // the recorded source is at exactly this distance
+            ShortestPathQueryEngine<Graph, float> check(g);
+            shouldEqualTolerance(check.runBidirectional(weights, engine.nearestSource(nodes[k]), nodes[k]), d, 1e-4f);
+        }
+
+        // batch of queries
+        std::vector<std::pair<Node, Node> > pairs;
+        for(std::size_t q = 0; q < 5; ++q)
+            pairs.push_back(std::make_pair(nodes[q], nodes[nodes.size() - 1 - q]));
+        std::vector<float> batch(pairs.size());
+        engine.runBatch(weights, pairs.begin(), pairs.end(), batch.begin());
+        for(std::size_t q = 0; q < pairs.size(); ++q)
+        {
+            reference.run(weights, pairs[q].first);
+            shouldEqualTolerance(batch[q], reference.distances()[pairs[q].second], 1e-4f);
+        }
+    }
+
+    void testShortestPathQueryEngine()
+    {
+        typedef GridGraph<2, boost_graph::undirected_tag> GridGraph2d;
+        GridGraph2d gg(Shape2(17, 13), IndirectNeighborhood);
+        GridGraph2d::EdgeMap<float> gridWeights(gg);
+        for(GridGraph2d::EdgeIt e(gg); e != lemon::INVALID; ++e)
+            gridWeights[*e] = 1.0f + float((gg.id(*e) * 7919) % 101) / 10.0f;
+        testShortestPathQueryEngineImpl(gg, gridWeights);
+
+        GraphType ag;
+        for(int i = 0; i < 60; ++i)
+        {
+            ag.addEdge(i, (i + 1) % 60);
+            if((i * 7 + 3) % 60 != i)
+                ag.addEdge(i, (i * 7 + 3) % 60);
+        }
+        GraphType::EdgeMap<float> agWeights(ag);
+        for(EdgeIt e(ag); e != lemon::INVALID; ++e)
+            agWeights[*e] = 0.5f + float((ag.id(*e) * 31) % 17);
+        testShortestPathQueryEngineImpl(ag, agWeights);
+    }
+
+    template <class Graph>
+    void checkMinimumSpanningTree(Graph const & g, typename Graph::template EdgeMap<float> const & weights,
+                                  std::size_t expectedTreeEdges)
+    {
+        typedef typename Graph::Edge Edge;
+        typedef typename Graph::EdgeIt GraphEdgeIt;
+
+        typename Graph::template EdgeMap<UInt8> kruskal(g), boruvka(g);
+        shouldEqual(minimumSpanningTree(g, weights, kruskal), expectedTreeEdges);
+
+        std::vector<Edge> kruskalEdges, boruvkaEdges;
+        minimumSpanningTreeEdges(g, weights, kruskalEdges);
+        shouldEqual(kruskalEdges.size(), expectedTreeEdges);
+        for(std::size_t k = 1; k < kruskalEdges.size(); ++k)
+            should(weights[kruskalEdges[k-1]] <= weights[kruskalEdges[k]]);
+
+        for(int threads = 1; threads <= 4; threads += 3)
+        {
+            // weights are distinct, so the tree is unique
+            shouldEqual(minimumSpanningTree(g, weights, boruvka, ParallelOptions().numThreads(threads)),
+                        expectedTreeEdges);
+            for(GraphEdgeIt e(g); e != lemon::INVALID; ++e)
+                shouldEqual(boruvka[*e], kruskal[*e]);
+
+            minimumSpanningTreeEdges(g, weights, boruvkaEdges, ParallelOptions().numThreads(threads));
+            shouldEqual(boruvkaEdges.size(), kruskalEdges.size());
+            for(std::size_t k = 0; k < kruskalEdges.size(); ++k)
+                should(boruvkaEdges[k] == kruskalEdges[k]);
+        }
+    }
+
+    void testMinimumSpanningTree()
+    {
+        // grid graph with distinct weights
+        typedef GridGraph<2, boost_graph::undirected_tag> GridGraph2d;
+        GridGraph2d gg(Shape2(40, 30), IndirectNeighborhood);
+        GridGraph2d::EdgeMap<float> gridWeights(gg);
+        for(GridGraph2d::EdgeIt e(gg); e != lemon::INVALID; ++e)
+            gridWeights[*e] = float((gg.id(*e) * 7919) % 100003);
+        checkMinimumSpanningTree(gg, gridWeights, gg.nodeNum() - 1);
+
+        // adjacency list graph with two connected components
+        GraphType ag;
+        for(int i = 0; i < 100; ++i)
+        {
+            const int offset = i < 50 ? 0 : 50;
+            ag.addEdge(i, offset + (i + 1) % 50);
+            ag.addEdge(i, offset + (i * 7 + 3) % 50);
+        }
+        GraphType::EdgeMap<float> agWeights(ag);
+        for(EdgeIt e(ag); e != lemon::INVALID; ++e)
+            agWeights[*e] = float((ag.id(*e) * 31) % 1009);
+        checkMinimumSpanningTree(ag, agWeights, ag.nodeNum() - 2);
+
+        // merge graph after some contractions
+        typedef MergeGraphAdaptor<GraphType> MergeGraph;
+        MergeGraph mg(ag);
+        for(int i = 0; i < 10; ++i)
+        {
+            const MergeGraph::Edge e(mg.findEdge(mg.nodeFromId(mg.reprNodeId(i)), mg.nodeFromId(mg.reprNodeId(i + 1))));
+            if(e != lemon::INVALID)
+                mg.contractEdge(e);
+        }
+        MergeGraph::EdgeMap<float> mgWeights(mg);
+        for(MergeGraph::EdgeIt e(mg); e != lemon::INVALID; ++e)
+            mgWeights[*e] = float((mg.id(*e) * 61) % 1009);
+        checkMinimumSpanningTree(mg, mgWeights, mg.nodeNum() - 2);
+    }
+
     void testEdgeSort(){
         {
             GraphType g(0,0);
@@ -556,6 +960,11 @@ struct GraphAlgorithmTestSuite
         add( testCase( &GraphAlgorithmTest::testShortestPathAdjacencyListGraph));
         add( testCase( &GraphAlgorithmTest::testShortestPathGridGraph));
         add( testCase( &GraphAlgorithmTest::testRegionAdjacencyGraph));
+        add( testCase( &GraphAlgorithmTest::testParallelRegionAdjacencyGraph));
+        add( testCase( &GraphAlgorithmTest::testLazyHierarchicalClustering));
+        add( testCase( &GraphAlgorithmTest::testParallelFelzenszwalb));
+        add( testCase( &GraphAlgorithmTest::testShortestPathQueryEngine));
+        add( testCase( &GraphAlgorithmTest::testMinimumSpanningTree));
         add( testCase( &GraphAlgorithmTest::testEdgeSort));
         add( testCase( &GraphAlgorithmTest::testEdgeWeightComputation));
         add( testCase( &GraphAlgorithmTest::testShortestPathGridGraph2));
@@ -34,12 +34,14 @@
 /************************************************************************/
 
 #define VIGRA_CHECK_BOUNDS
+#include <numeric>
 #include "vigra/unittest.hxx"
 #include <vigra/multi_shape.hxx>
 #include <vigra/multi_iterator.hxx>
 #include <vigra/multi_array.hxx>
 #include <vigra/multi_gridgraph.hxx>
 #include <vigra/multi_localminmax.hxx>
+#include <vigra/graph_algorithms.hxx>
 #include <vigra/algorithm.hxx>
 
 #ifdef WITH_BOOST_GRAPH
@@ -1215,6 +1217,107 @@ struct GridGraphAlgorithmTests
         
         shouldEqualSequence(src.begin(), src.end(), dest.begin());
     }
+
+    template <class DirectedTag, NeighborhoodType NType>
+    void testTransformEdges()
+    {
+        typedef GridGraph<N, DirectedTag> Graph;
+
+        MultiCoordinateIterator<N> i(Shape(4)), iend = i.getEndIterator();
+        for(; i != iend; ++i)
+        {
+            // all shapes from 1**N to 4**N, including degenerate ones
+            Shape s = *i + Shape(1);
+            Graph g(s, NType);
+
+            MultiArray<N, int> nodes(s);
+            linearSequence(nodes.begin(), nodes.end(), 1);
+
+            // the slices cover exactly the edges of the graph
+            MultiArray<N+1, int> covered(g.edge_propmap_shape());
+            gridGraphEdgeSlices(g,
+                [&](MultiArrayIndex k, Shape const & start, Shape const & stop, Shape const & offset)
+                {
+                    should(offset == g.neighborOffset(k));
+                    covered.bindOuter(k).subarray(start, stop) += 1;
+                });
+            int count = 0;
+            for(typename Graph::EdgeIt e(g); e != lemon::INVALID; ++e, ++count)
+                shouldEqual(covered[*e], 1);
+            shouldEqual(count, (int)g.edgeNum());
+            shouldEqual(std::accumulate(covered.begin(), covered.end(), 0), count);
+
+            // bulk transform matches a loop over the edges
+            MultiArray<N+1, int> bulk(g.edge_propmap_shape(), -1), reference(g.edge_propmap_shape(), -1);
+            transformGridGraphEdges(g, nodes, bulk,
+                [](int u, int v) { return 1000*u + v; });
+            for(typename Graph::EdgeIt e(g); e != lemon::INVALID; ++e)
+                reference[*e] = 1000*nodes[g.u(*e)] + nodes[g.v(*e)];
+            shouldEqualSequence(bulk.begin(), bulk.end(), reference.begin());
+
+            // strided node data
+            MultiArray<N, int> transposed(nodes.transpose());
+            bulk.init(-1);
+            transformGridGraphEdges(g, transposed.transpose(), bulk,
+                [](int u, int v) { return 1000*u + v; });
+            shouldEqualSequence(bulk.begin(), bulk.end(), reference.begin());
+        }
+    }
+
+    template <class EdgeValue, class Graph>
+    static void checkEdgeWeights(Graph const & g, MultiArray<N, float> const & nodes,
+                                 MultiArray<N, float> const & interpolated, bool euclidean)
+    {
+        typedef typename Graph::template EdgeMap<EdgeValue> EdgeMap;
+
+        // per-edge reference computation
+        EdgeMap bulk(g, EdgeValue(-1)), reference(g, EdgeValue(-1));
+        for(typename Graph::EdgeIt e(g); e != lemon::INVALID; ++e)
+        {
+            Shape u(g.u(*e)), v(g.v(*e));
+            double length = euclidean ? norm(u-v) : 1.0;
+            reference[*e] = euclidean
+                               ? length * (0.5*(nodes[u] + nodes[v]))
+                               : 0.5*(nodes[u] + nodes[v]);
+        }
+        edgeWeightsFromNodeWeights(g, nodes, bulk, euclidean);
+        shouldEqualSequence(bulk.begin(), bulk.end(), reference.begin());
+
+        for(typename Graph::EdgeIt e(g); e != lemon::INVALID; ++e)
+        {
+            Shape u(g.u(*e)), v(g.v(*e));
+            reference[*e] = euclidean
+                               ? norm(u-v) * interpolated[u+v]
+                               : interpolated[u+v];
+        }
+        bulk.init(EdgeValue(-1));
+        edgeWeightsFromInterpolatedImage(g, interpolated, bulk, euclidean);
+        shouldEqualSequence(bulk.begin(), bulk.end(), reference.begin());
+    }
+
+    template <class DirectedTag, NeighborhoodType NType>
+    void testEdgeWeights()
+    {
+        typedef GridGraph<N, DirectedTag> Graph;
+
+        Shape s(5);
+        s[0] = 7;
+        Graph g(s, NType);
+
+        MultiArray<N, float> nodes(s), interpolated(Shape(2)*s - Shape(1));
+        for(int k=0; k<nodes.size(); ++k)
+            nodes[k] = 0.1f + 1.7f*((k*37) % 11);
+        for(int k=0; k<interpolated.size(); ++k)
+            interpolated[k] = 0.3f + 1.3f*((k*29) % 13);
+
+        // the diagonal lengths must not be truncated for integer edge maps
+        for(int euclidean=0; euclidean<2; ++euclidean)
+        {
+            checkEdgeWeights<float>(g, nodes, interpolated, euclidean != 0);
+            checkEdgeWeights<double>(g, nodes, interpolated, euclidean != 0);
+            checkEdgeWeights<int>(g, nodes, interpolated, euclidean != 0);
+        }
+    }
 };
 
 template <unsigned int N>
@@ -1275,6 +1378,14 @@ struct GridgraphTestSuiteN
         add(testCase((&GridGraphTests<N>::template testArcIterator<undirected_tag, DirectNeighborhood>)));
         
         add(testCase((&GridGraphAlgorithmTests<N>::template testLocalMinMax<undirected_tag, DirectNeighborhood>)));
+
+        add(testCase((&GridGraphAlgorithmTests<N>::template testTransformEdges<directed_tag, IndirectNeighborhood>)));
+        add(testCase((&GridGraphAlgorithmTests<N>::template testTransformEdges<undirected_tag, IndirectNeighborhood>)));
+        add(testCase((&GridGraphAlgorithmTests<N>::template testTransformEdges<directed_tag, DirectNeighborhood>)));
+        add(testCase((&GridGraphAlgorithmTests<N>::template testTransformEdges<undirected_tag, DirectNeighborhood>)));
+
+        add(testCase((&GridGraphAlgorithmTests<N>::template testEdgeWeights<undirected_tag, IndirectNeighborhood>)));
+        add(testCase((&GridGraphAlgorithmTests<N>::template testEdgeWeights<undirected_tag, DirectNeighborhood>)));
     }
 };
 
@@ -931,6 +931,93 @@ public:
 
     }
 
+    void testHDF5FileDirectChunkAccess()
+    {
+        typedef MultiArrayShape<3>::type Shape3;
+
+        std::string file_name( "testfile_HDF5File_direct_chunk_access.hdf5");
+
+        MultiArray<3, float> out_data(Shape3(40, 30, 25));
+        for (int i = 0; i < out_data.size(); ++i)
+            out_data[i] = i + 0.5f;
+        MultiArray<3, TinyVector<int, 3> > out_vector(Shape3(21, 17, 9));
+        for (int i = 0; i < out_vector.size(); ++i)
+            out_vector[i] = TinyVector<int, 3>(i, -i, 2*i);
+
+        HDF5File file (file_name, HDF5File::New);
+        file.setChunkCache(0);
+        shouldEqual(file.chunkCacheBytes(), 0u);
+
+        // compressed chunks, block not aligned with the chunk grid
+        Shape3 shape(50, 40, 30), offset(3, 5, 2);
+        file.createDataset<3, float>("/float", shape, 42.0f, Shape3(16, 16, 8), 5);
+        file.writeBlock("/float", offset, out_data, ParallelOptions().numThreads(3));
+        file.flushToDisk();
+
+        MultiArray<3, float> in_data(out_data.shape()), in_all(shape);
+        file.readBlock("/float", offset, out_data.shape(), in_data);
+        should(in_data == out_data);
+        in_data = 0.0f;
+        file.readBlock("/float", offset, out_data.shape(), in_data, ParallelOptions().numThreads(2));
+        should(in_data == out_data);
+        file.readBlock("/float", Shape3(), shape, in_all, ParallelOptions().numThreads(2));
+        should(in_all.subarray(offset, offset + out_data.shape()) == out_data);
+        shouldEqual(in_all(0,0,0), 42.0f);
+        shouldEqual(in_all(49,39,29), 42.0f);
+        shouldEqual(in_all(2,20,20), 42.0f);
+
+        // overwrite part of the data again (read-modify-write of partial chunks)
+        MultiArray<3, float> patch(Shape3(5, 6, 7), -1.0f);
+        file.writeBlock("/float", Shape3(10, 10, 10), patch, ParallelOptions().numThreads(2));
+        in_all.subarray(Shape3(10, 10, 10), Shape3(15, 16, 17)) = -1.0f;
+        MultiArray<3, float> in_all2(shape);
+        file.readBlock("/float", Shape3(), shape, in_all2);
+        should(in_all2 == in_all);
+
+        // multi-band data with a strided source and target
+        file.createDataset<3, TinyVector<int, 3> >("/vector", Shape3(21, 17, 9),
+                                                   0, Shape3(8, 8, 4), 1);
+        file.writeBlock("/vector", Shape3(), out_vector.transpose().transpose(), ParallelOptions().numThreads(2));
+        MultiArray<3, TinyVector<int, 3> > in_vector(Shape3(9, 17, 21));
+        file.readBlock("/vector", Shape3(), Shape3(21, 17, 9), in_vector.transpose(), ParallelOptions().numThreads(2));
+        should(in_vector.transpose() == out_vector);
+
+        // unsupported layout (contiguous dataset) falls back to H5Dread()/H5Dwrite()
+        file.write("/contiguous", out_data);
+        in_data = 0.0f;
+        file.readBlock("/contiguous", Shape3(), out_data.shape(), in_data, ParallelOptions().numThreads(2));
+        should(in_data == out_data);
+        file.close();
+
+        // shuffle filter, created through the HDF5 API
+        {
+            hid_t fid = H5Fcreate("testfile_HDF5File_direct_chunk_shuffle.hdf5",
+                                  H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+            hsize_t dims[3] = { 25, 30, 40 }, chunks[3] = { 8, 16, 16 };
+            hid_t space = H5Screate_simple(3, dims, NULL);
+            hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+            H5Pset_chunk(plist, 3, chunks);
+            H5Pset_shuffle(plist);
+            H5Pset_deflate(plist, 4);
+            hid_t dset = H5Dcreate(fid, "shuffled", H5T_NATIVE_FLOAT, space, H5P_DEFAULT, plist, H5P_DEFAULT);
+            H5Dwrite(dset, H5T_NATIVE_FLOAT, H5S_ALL, H5S_ALL, H5P_DEFAULT, out_data.data());
+            H5Dclose(dset);
+            H5Pclose(plist);
+            H5Sclose(space);
+            H5Fclose(fid);
+        }
+        HDF5File shuffled("testfile_HDF5File_direct_chunk_shuffle.hdf5", HDF5File::Open);
+        in_data = 0.0f;
+        shuffled.readBlock("/shuffled", Shape3(), out_data.shape(), in_data, ParallelOptions().numThreads(2));
+        should(in_data == out_data);
+        patch.init(7.0f);
+        shuffled.writeBlock("/shuffled", Shape3(30, 20, 15), patch, ParallelOptions().numThreads(2));
+        in_data.subarray(Shape3(30, 20, 15), Shape3(35, 26, 22)) = 7.0f;
+        MultiArray<3, float> in_shuffled(out_data.shape());
+        shuffled.readBlock("/shuffled", Shape3(), out_data.shape(), in_shuffled);
+        should(in_shuffled == in_data);
+    }
+
 
 
 
@@ -1404,6 +1491,7 @@ struct HDF5ImportExportTestSuite : public vigra::test_suite
         // HDF5File tests
         add(testCase(&HDF5ExportImportTest::testHDF5FileDataAccess));
         add(testCase(&HDF5ExportImportTest::testHDF5FileBlockAccess));
+        add(testCase(&HDF5ExportImportTest::testHDF5FileDirectChunkAccess));
         add(testCase(&HDF5ExportImportTest::testHDF5FileChunks));
         add(testCase(&HDF5ExportImportTest::testHDF5FileCompression));
         add(testCase(&HDF5ExportImportTest::testHDF5FileBrowsing));
@@ -35,12 +35,14 @@
 #include <iostream>
 #include <cmath>
 #include <cstdlib>
+#include <cstdio>
 #include <cstring>
 #include "vigra/stdimage.hxx"
 #include "vigra/impex.hxx"
 #include "vigra/impexalpha.hxx"
 #include "vigra/unittest.hxx"
 #include "vigra/multi_array.hxx"
+#include "vigra/multi_array_chunked.hxx"
 
 #if HasTIFF
 # include "vigra/tiff.hxx"
@@ -299,6 +301,72 @@ public:
 #endif
     }
 
+    void checkRegionOfInterest (const char * fileName)
+    {
+        vigra::ImageImportInfo info (fileName);
+        const Rect2D rois[] = { Rect2D(0, 0, img.width(), img.height()),
+                                Rect2D(17, 5, 93, 60),
+                                Rect2D(img.width() - 40, img.height() - 33, img.width(), img.height()),
+                                Rect2D(0, img.height() / 2, img.width(), img.height() / 2 + 1) };
+        for (int k = 0; k < 4; ++k)
+        {
+            const Rect2D & roi = rois[k];
+            MultiArray<2, unsigned char> res (roi.width(), roi.height());
+            importImage (info, roi, res);
+            for (int y = 0; y < roi.height(); ++y)
+                for (int x = 0; x < roi.width(); ++x)
+                    shouldEqual (res(x, y), img(x + roi.left(), y + roi.top()));
+        }
+
+        try
+        {
+            MultiArray<2, unsigned char> res (10, 10);
+            importImage (info, Rect2D(img.width() - 5, 0, img.width() + 5, 10), res);
+            failTest ("importImage() failed to throw exception.");
+        }
+        catch (vigra::PreconditionViolation &)
+        {}
+    }
+
+    void testRegionOfInterest ()
+    {
+        // codecs without native support skip the surrounding pixels
+        checkRegionOfInterest ("lenna.xv");
+#if defined(HasTIFF)
+        // strips
+        vigra::ImageExportInfo exportinfo ("resroi.tif");
+        exportinfo.setCompression ("LZW");
+        exportImage (srcImageRange (img), exportinfo);
+        checkRegionOfInterest ("resroi.tif");
+
+        // tiles
+        TiffImage * tiff = TIFFOpen("resroitiled.tif", "w");
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, (uint32)img.width());
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, (uint32)img.height());
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, (uint16)1);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, (uint16)8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, (uint16)PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, (uint16)COMPRESSION_LZW);
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, (uint32)32);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, (uint32)16);
+        std::vector<unsigned char> tile(32*16);
+        for (int ty = 0; ty < img.height(); ty += 16)
+        {
+            for (int tx = 0; tx < img.width(); tx += 32)
+            {
+                for (int y = 0; y < 16; ++y)
+                    for (int x = 0; x < 32; ++x)
+                        tile[y*32 + x] = (tx + x < img.width() && ty + y < img.height())
+                                             ? img(tx + x, ty + y)
+                                             : 0;
+                TIFFWriteTile(tiff, &tile[0], tx, ty, 0, 0);
+            }
+        }
+        TIFFClose(tiff);
+        checkRegionOfInterest ("resroitiled.tif");
+#endif
+    }
+
     void testBMP ()
     {
         testFile ("res.bmp");
@@ -431,6 +499,63 @@ public:
 
     void testFile (const char *fileName);
 
+    void checkDirectImport (const char * fileName)
+    {
+        exportImage (srcImageRange (img), vigra::ImageExportInfo (fileName));
+        vigra::ImageImportInfo info (fileName);
+
+        // reference: conversion through the accessor interface
+        Image ref (info.width (), info.height ());
+        importImage (info, destImage (ref));
+
+        // interleaved, contiguous destination
+        MultiArray<2, RGBValue<UInt8> > direct (info.shape ());
+        importImage (info, direct);
+        typedef MultiArrayView<2, RGBValue<UInt8> > RGBView;
+        should (direct == RGBView (Shape2 (ref.width (), ref.height ()), ref.data ()));
+
+        // strided destination
+        MultiArray<2, TinyVector<UInt8, 3> > transposed (Shape2 (info.height (), info.width ()));
+        importImage (info, transposed.transpose ());
+        for (int y = 0; y < info.height (); ++y)
+            for (int x = 0; x < info.width (); ++x)
+                shouldEqual (transposed (y, x), (TinyVector<UInt8, 3> (ref (x, y))));
+
+        // region of interest not starting in the first column
+        Rect2D roi (13, 7, 101, 64);
+        MultiArray<2, RGBValue<UInt8> > cropped (Shape2 (roi.width (), roi.height ()));
+        importImage (info, roi, cropped);
+        for (int y = 0; y < roi.height (); ++y)
+            for (int x = 0; x < roi.width (); ++x)
+                shouldEqual (cropped (x, y), ref (x + roi.left (), y + roi.top ()));
+
+        // planar buffer filled directly by the decoder
+        VIGRA_UNIQUE_PTR<Decoder> dec (vigra::decoder (info));
+        MultiArray<3, UInt8> planar (Shape3 (info.width (), info.height (), 3));
+        dec->readScanlines (planar.data (), info.width (), info.height (),
+                            planar.stride (0), planar.stride (2), planar.stride (1));
+        dec->close ();
+        for (int y = 0; y < info.height (); ++y)
+            for (int x = 0; x < info.width (); ++x)
+                for (int b = 0; b < 3; ++b)
+                    shouldEqual (planar (x, y, b), ref (x, y)[b]);
+    }
+
+    void testDirectImport ()
+    {
+        checkDirectImport ("resdirect.ppm");
+        checkDirectImport ("resdirect.xv");
+#if defined(HasPNG)
+        checkDirectImport ("resdirect.png");
+#endif
+#if defined(HasJPEG)
+        checkDirectImport ("resdirect.jpg");
+#endif
+#if defined(HasTIFF)
+        checkDirectImport ("resdirect.tif");
+#endif
+    }
+
     void testGIF ()
     {
         exportImage (srcImageRange (img), vigra::ImageExportInfo ("resrgb.gif"));
@@ -766,6 +891,96 @@ class PNGInt16Test
     }
 };
 
+class StreamingExportTest
+{
+  public:
+    template <class T>
+    static void fill(MultiArrayView<2, T> band, MultiArrayIndex y0)
+    {
+        // smooth and noisy regions, so that the PNG encoder uses all row filters
+        for (MultiArrayIndex y = 0; y < band.shape(1); ++y)
+            for (MultiArrayIndex x = 0; x < band.shape(0); ++x)
+                band(x, y) = (x < band.shape(0) / 2)
+                                 ? T(x + 3*(y + y0))
+                                 : T((x * 7919 + (y + y0) * 104729) % 65521);
+    }
+
+    static void fillRGB(MultiArrayView<2, RGBValue<UInt8> > band, MultiArrayIndex y0)
+    {
+        for (MultiArrayIndex y = 0; y < band.shape(1); ++y)
+            for (MultiArrayIndex x = 0; x < band.shape(0); ++x)
+                band(x, y) = RGBValue<UInt8>(x + y + y0, (x * 31 + (y + y0) * 17) % 251, x / 3);
+    }
+
+    void testParallelPNG()
+    {
+        MultiArray<2, RGBValue<UInt8> > rgb(Shape2(700, 2100)), rgb_res;
+        fillRGB(rgb, 0);
+        exportImage(rgb, ImageExportInfo("res.png").setNumThreads(2));
+        importImage("res.png", rgb_res);
+        should(rgb_res == rgb);
+
+        MultiArray<2, UInt16> gray(Shape2(1001, 1300)), gray_res;
+        fill(gray, 0);
+        exportImage(gray, ImageExportInfo("res.png").setNumThreads(3));
+        ImageImportInfo info("res.png");
+        shouldEqual(std::string(info.getPixelType()), std::string("UINT16"));
+        importImage("res.png", gray_res);
+        should(gray_res == gray);
+
+        // a single row
+        MultiArray<2, UInt8> row(Shape2(5, 1)), row_res;
+        fill(row, 0);
+        exportImage(row, ImageExportInfo("res.png").setNumThreads(4));
+        importImage("res.png", row_res);
+        should(row_res == row);
+    }
+
+    void testCallbackExport()
+    {
+        const Shape2 shape(123, 77);
+        MultiArray<2, RGBValue<UInt8> > ref(shape), res;
+        fillRGB(ref, 0);
+
+        exportImageBands<RGBValue<UInt8> >(shape, &fillRGB, ImageExportInfo("res.png"), 7);
+        importImage("res.png", res);
+        should(res == ref);
+
+        exportImageBands<RGBValue<UInt8> >(shape, &fillRGB, ImageExportInfo("res.png").setNumThreads(2), 10);
+        importImage("res.png", res);
+        should(res == ref);
+
+        // the file format must store the element type without conversion
+        try
+        {
+            exportImageBands<float>(shape, &fill<float>, ImageExportInfo("res.png"));
+            failTest("exportImageBands() failed to throw exception.");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
+
+    void testChunkedExport()
+    {
+        const Shape2 shape(200, 150);
+        MultiArray<2, UInt16> ref(shape), res;
+        fill(ref, 0);
+
+        ChunkedArrayLazy<2, UInt16> chunked(shape, Shape2(64, 32));
+        chunked.commitSubarray(Shape2(0, 0), ref);
+
+        exportImageBands(chunked, ImageExportInfo("res.png").setNumThreads(2));
+        importImage("res.png", res);
+        should(res == ref);
+
+#if defined(HasTIFF)
+        exportImageBands(chunked, ImageExportInfo("res.tif").setCompression("DEFLATE").setNumThreads(2));
+        importImage("res.tif", res);
+        should(res == ref);
+#endif
+    }
+};
+
 class FloatImageExportImportTest
 {
     typedef vigra::DImage Image;
@@ -1411,6 +1626,78 @@ public:
 };
 
 
+class ImageMetadataCacheTest
+{
+  public:
+    void testCache()
+    {
+        std::remove("res_cache.txt");
+
+        MultiArray<2, RGBValue<float> > rgb(Shape2(13, 7));
+        MultiArray<2, Int16> gray(Shape2(5, 11));
+        exportImage(rgb, "res_cache1.xv");
+        exportImage(gray, "res_cache 2.xv"); // blanks are allowed in file names
+
+        {
+            ImageMetadataCache cache("res_cache.txt");
+            shouldEqual(cache.size(), 0u);
+
+            ImageImportInfo info = cache.info("res_cache1.xv");
+            shouldEqual(info.shape(), Shape2(13, 7));
+            shouldEqual(info.numBands(), 3);
+            shouldEqual(std::string(info.getPixelType()), std::string("FLOAT"));
+            shouldEqual(cache.size(), 1u);
+
+            info = cache.info("res_cache 2.xv");
+            shouldEqual(info.shape(), Shape2(5, 11));
+            shouldEqual(cache.size(), 2u);
+
+            // repeated queries are answered from the cache
+            info = cache.info("res_cache1.xv");
+            shouldEqual(info.shape(), Shape2(13, 7));
+            shouldEqual(cache.size(), 2u);
+        } // the destructor saves the cache
+
+        {
+            ImageMetadataCache cache("res_cache.txt");
+            shouldEqual(cache.size(), 2u);
+
+            ImageImportInfo info = cache.info("res_cache 2.xv");
+            shouldEqual(info.shape(), Shape2(5, 11));
+            shouldEqual(info.numBands(), 1);
+            shouldEqual(info.numImages(), 1);
+            shouldEqual(std::string(info.getFileName()), std::string("res_cache 2.xv"));
+            shouldEqual(std::string(info.getFileType()), std::string("VIFF"));
+            shouldEqual(std::string(info.getPixelType()), std::string("INT16"));
+
+            // a cached info can be used for import
+            MultiArray<2, Int16> res(info.shape());
+            importImage(info, res);
+            should(res == gray);
+
+            // a modified file is read again
+            MultiArray<2, Int16> larger(Shape2(6, 11));
+            exportImage(larger, "res_cache 2.xv");
+            info = cache.info("res_cache 2.xv");
+            shouldEqual(info.shape(), Shape2(6, 11));
+            cache.save();
+        }
+
+        {
+            ImageMetadataCache cache("res_cache.txt");
+            shouldEqual(cache.info("res_cache 2.xv").shape(), Shape2(6, 11));
+
+            try
+            {
+                cache.info("res_cache_does_not_exist.xv");
+                failTest("ImageMetadataCache::info() failed to throw exception.");
+            }
+            catch(PreconditionViolation &)
+            {}
+        }
+    }
+};
+
 class ImageExportImportFailureTest
 {
     vigra::BImage img;
@@ -1833,6 +2120,7 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&ByteImageExportImportTest::testVIFF1));
         add(testCase(&ByteImageExportImportTest::testVIFF2));
         add(testCase(&ByteImageExportImportTest::testGrayToRGB));
+        add(testCase(&ByteImageExportImportTest::testRegionOfInterest));
         
         // rgb byte images
         add(testCase(&ByteRGBImageExportImportTest::testGIF));
@@ -1846,10 +2134,16 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&ByteRGBImageExportImportTest::testSUN));
         add(testCase(&ByteRGBImageExportImportTest::testVIFF1));
         add(testCase(&ByteRGBImageExportImportTest::testVIFF2));
+        add(testCase(&ByteRGBImageExportImportTest::testDirectImport));
 
 #if defined(HasPNG)
         // 16-bit PNG
         add(testCase(&PNGInt16Test::testByteOrder));
+
+        // streamed and parallel export
+        add(testCase(&StreamingExportTest::testParallelPNG));
+        add(testCase(&StreamingExportTest::testCallbackExport));
+        add(testCase(&StreamingExportTest::testChunkedExport));
 #endif
 
         add(testCase(&CanvasSizeTest::testTIFFCanvasSize));
@@ -1888,6 +2182,8 @@ struct ImageImportExportTestSuite : public vigra::test_suite
         add(testCase(&FloatRGBImageExportImportTest::testVIFF));
         add(testCase(&FloatRGBImageExportImportTest::testHDR));
 
+        add(testCase(&ImageMetadataCacheTest::testCache));
+
         // failure tests
         add(testCase(&ImageExportImportFailureTest::testGIFExport));
         add(testCase(&ImageExportImportFailureTest::testGIFImport));
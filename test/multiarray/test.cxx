@@ -38,6 +38,8 @@
 #include "vigra/multi_iterator_coupled.hxx"
 #include "vigra/multi_hierarchical_iterator.hxx"
 #include "vigra/multi_impex.hxx"
+#include "vigra/multi_array_chunked.hxx"
+#include "vigra/multi_array_mapped.hxx"
 #include "vigra/basicimageview.hxx"
 #include "vigra/navigator.hxx"
 #include "vigra/multi_pointoperators.hxx"
@@ -1708,6 +1710,154 @@ struct MultiImpexTest
 #endif // _MSC_VER
     }
 
+    void testParallelImpex()
+    {
+#if defined(HasPNG)
+        const char * ext = ".png";
+#else
+        const char * ext = ".pnm";
+#endif
+        Array big(Shape(37, 29, 23));
+        for(int k=0; k<big.size(); ++k)
+            big[k] = (unsigned char)((k*7) % 251);
+        exportVolume(big, VolumeExportInfo("impex/parallel", ext));
+
+        VolumeImportInfo info("impex/parallel", ext);
+        shouldEqual(big.shape(), info.shape());
+
+        for(int threads = 0; threads <= 4; threads += 2)
+        {
+            Array result(info.shape());
+            importVolume(info, result, ParallelOptions().numThreads(threads));
+            should(result == big);
+
+            ChunkedArrayLazy<3, unsigned char> chunked(info.shape(), Shape(16, 8, 4));
+            importVolume(info, chunked, ParallelOptions().numThreads(threads));
+            Array checked(info.shape());
+            chunked.checkoutSubarray(Shape(), checked);
+            should(checked == big);
+        }
+    }
+
+    void testMappedVolume()
+    {
+        typedef MultiArray<3, UInt16> Array16;
+        Array16 volume(Shape(13, 7, 5));
+        for(int k=0; k<volume.size(); ++k)
+            volume[k] = (UInt16)(k*263 + 17);
+
+        {
+            std::ofstream raw("impex/mapped.raw", std::ios::binary);
+            raw.write((char const *)volume.data(), volume.size()*sizeof(UInt16));
+            std::ofstream info("impex/mapped.info");
+            info << "filename = mapped.raw\n"
+                 << "width = 13\nheight = 7\ndepth = 5\n"
+                 << "datatype = UINT16\n";
+        }
+
+        VolumeImportInfo info("impex/mapped.info");
+        shouldEqualSequence(info.getFileType(), info.getFileType() + 3, "RAW");
+
+        MultiArrayMapped<3, UInt16> mapped;
+        mapVolume(info, mapped);
+        should(mapped.isMapped());
+        should(!mapped.isPrivate());
+        shouldEqual(mapped.shape(), volume.shape());
+        should(mapped == volume);
+
+        Array16 imported(info.shape());
+        importVolume(info, imported);
+        should(mapped == imported);
+
+        // elements can be modified, but the file remains unchanged
+        mapped(3, 2, 1) = 5;
+        shouldEqual(mapped(3, 2, 1), 5);
+        {
+            MultiArrayMapped<3, UInt16> remapped;
+            mapVolume(info, remapped);
+            should(remapped == volume);
+        }
+
+        MultiArrayMapped<3, UInt8> wrongType;
+        try
+        {
+            mapVolume(info, wrongType);
+            failTest("mapVolume() failed to throw exception.");
+        }
+        catch(PreconditionViolation &)
+        {}
+
+        // types of equal size are not silently reinterpreted
+        {
+            std::ofstream info32("impex/mapped32.info");
+            info32 << "filename = mapped.raw\n"
+                   << "width = 13\nheight = 7\ndepth = 1\n"
+                   << "datatype = INT32\n";
+        }
+        VolumeImportInfo info32("impex/mapped32.info");
+        MultiArrayMapped<3, Int32> mapped32;
+        mapVolume(info32, mapped32);
+        shouldEqual(mapped32.shape(), Shape(13, 7, 1));
+        MultiArrayMapped<3, float> wrongFloat;
+        try
+        {
+            mapVolume(info32, wrongFloat);
+            failTest("mapVolume() failed to throw exception.");
+        }
+        catch(PreconditionViolation &)
+        {}
+
+        // interleaved multi-band data
+        {
+            std::ofstream infoBands("impex/mappedbands.info");
+            infoBands << "filename = mapped.raw\n"
+                    << "width = 13\nheight = 5\ndepth = 3\n"
+                    << "datatype = UINT8\nbands = 2\n";
+        }
+        VolumeImportInfo infoBands("impex/mappedbands.info");
+        shouldEqual(infoBands.numBands(), 2);
+        MultiArrayMapped<3, TinyVector<UInt8, 2> > mappedBands;
+        mapVolume(infoBands, mappedBands);
+        UInt8 const * bytes = (UInt8 const *)volume.data();
+        for(int k=0; k<mappedBands.size(); ++k)
+            should(mappedBands[k] == (TinyVector<UInt8, 2>(bytes[2*k], bytes[2*k+1])));
+        MultiArrayMapped<3, UInt16> wrongBands;
+        try
+        {
+            mapVolume(infoBands, wrongBands);
+            failTest("mapVolume() failed to throw exception.");
+        }
+        catch(PreconditionViolation &)
+        {}
+
+        // big-endian data after a header, every second row
+        {
+            std::ofstream raw("impex/mapped_be.raw", std::ios::binary);
+            raw.write("header", 6);
+            for(int k=0; k<volume.size(); ++k)
+            {
+                char bytes[2] = { (char)(volume[k] >> 8), (char)(volume[k] & 0xff) };
+                raw.write(bytes, 2);
+            }
+        }
+        MultiArrayMapped<3, UInt16> swapped("impex/mapped_be.raw", Shape(13, 4, 5),
+                                            Shape(1, 26, 91), 6, BigEndianByteOrder);
+        should(swapped.isPrivate());
+        should(swapped == volume.subarray(Shape(), volume.shape()).stridearray(Shape(1, 2, 1)));
+
+        swapped.unmap();
+        should(!swapped.isMapped());
+        shouldEqual(swapped.size(), 0);
+
+        try
+        {
+            MultiArrayMapped<3, UInt16> tooLarge("impex/mapped.raw", Shape(13, 7, 6));
+            failTest("MultiArrayMapped failed to throw exception.");
+        }
+        catch(std::runtime_error &)
+        {}
+    }
+
 #if defined(HasTIFF)
     void testMultipageTIFF()
     {
@@ -1722,6 +1872,10 @@ struct MultiImpexTest
         shouldEqual(result(0,1,1), 2);
         shouldEqual(result(0,1,2), 3);
         shouldEqual(result(0,1,3), 4);
+
+        Array parallel(info.shape());
+        importVolume(info, parallel, ParallelOptions().numThreads(3));
+        should(parallel == result);
     }
 #endif
 
@@ -3077,6 +3231,8 @@ struct MultiArrayTestSuite
         add( testCase( &MultiArrayTest::test_expandElements ) );
 
         add( testCase( &MultiImpexTest::testImpex ) );
+        add( testCase( &MultiImpexTest::testParallelImpex ) );
+        add( testCase( &MultiImpexTest::testMappedVolume ) );
 #if defined(HasTIFF)
         add( testCase( &MultiImpexTest::testMultipageTIFF ) );
 #endif
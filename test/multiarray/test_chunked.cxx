@@ -39,6 +39,8 @@
 #include "vigra/unittest.hxx"
 #include "vigra/multi_array.hxx"
 #include "vigra/multi_array_chunked.hxx"
+#include "vigra/multi_array_chunked_pyramid.hxx"
+#include "vigra/multi_convolution.hxx"
 #ifdef HasHDF5
 #include "vigra/multi_array_chunked_hdf5.hxx"
 #endif
@@ -97,50 +99,55 @@ public:
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & /*chunk_shape*/,
                                 ChunkedArrayFull<3, T> *,
-                                std::string const & = "chunked_test.h5")
+                                std::string const & = "chunked_test.h5",
+                                ChunkedArrayOptions const & options = ChunkedArrayOptions())
     {
-        return ArrayPtr(new ChunkedArrayFull<3, T>(shape, ChunkedArrayOptions().fillValue(fill_value)));
+        return ArrayPtr(new ChunkedArrayFull<3, T>(shape, options.fillValue(fill_value)));
     }
 
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & chunk_shape,
                                 ChunkedArrayLazy<3, T> *,
-                                std::string const & = "chunked_test.h5")
+                                std::string const & = "chunked_test.h5",
+                                ChunkedArrayOptions const & options = ChunkedArrayOptions())
     {
         return ArrayPtr(new ChunkedArrayLazy<3, T>(shape, chunk_shape,
-                                                   ChunkedArrayOptions().fillValue(fill_value)));
+                                                   options.fillValue(fill_value)));
     }
 
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & chunk_shape,
                                 ChunkedArrayCompressed<3, T> *,
-                                std::string const & = "chunked_test.h5")
+                                std::string const & = "chunked_test.h5",
+                                ChunkedArrayOptions const & options = ChunkedArrayOptions())
     {
         return ArrayPtr(new ChunkedArrayCompressed<3, T>(shape, chunk_shape,
-                                                         ChunkedArrayOptions().fillValue(fill_value)
-                                                                              .compression(LZ4)));
+                                                         options.fillValue(fill_value)
+                                                                .compression(LZ4)));
     }
 
 #ifdef HasHDF5
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & chunk_shape,
                                 ChunkedArrayHDF5<3, T> *,
-                                std::string const & name = "chunked_test.h5")
+                                std::string const & name = "chunked_test.h5",
+                                ChunkedArrayOptions const & options = ChunkedArrayOptions())
     {
         HDF5File hdf5_file(name, HDF5File::New);
         return ArrayPtr(new ChunkedArrayHDF5<3, T>(hdf5_file, "test", HDF5File::New,
                                                    shape, chunk_shape,
-                                                   ChunkedArrayOptions().fillValue(fill_value)));
+                                                   options.fillValue(fill_value)));
     }
 #endif
 
     static ArrayPtr createArray(Shape3 const & shape,
                                 Shape3 const & chunk_shape,
                                 ChunkedArrayTmpFile<3, T> *,
-                                std::string const & = "chunked_test.h5")
+                                std::string const & = "chunked_test.h5",
+                                ChunkedArrayOptions const & options = ChunkedArrayOptions())
     {
         return ArrayPtr(new ChunkedArrayTmpFile<3, T>(shape, chunk_shape,
-                                                      ChunkedArrayOptions().fillValue(fill_value), ""));
+                                                      options.fillValue(fill_value), ""));
     }
 
     void test_construction ()
@@ -784,6 +791,40 @@ public:
         shouldEqualSequence(a->begin(), a->end(), ref.begin());
     }
 
+    void testWriteBehind()
+    {
+        array.reset(0); // close the file if backend is HDF5
+        Shape3 s(64, 65, 66);
+        ArrayPtr a = createArray(s, Shape3(16), (Array *)0, "chunked_test.h5",
+                                 ChunkedArrayOptions().writeBehind(2, 3*16*16*16*sizeof(T)));
+        a->setCacheMaxSize(4);
+
+        PlainArray ref(s);
+        linearSequence(ref.begin(), ref.end());
+        a->commitSubarray(Shape3(), ref);
+        a->flush();
+        shouldEqualSequence(a->cbegin(), a->cend(), ref.begin());
+
+        // concurrent writers evicting chunks
+        threading::atomic_long go;
+        go.store(0);
+
+        threading::thread t1(std::bind(testMultiThreadedRun,a.get(),0,2,&go));
+        threading::thread t2(std::bind(testMultiThreadedRun,a.get(),1,2,&go));
+
+        go.store(1);
+
+        t2.join();
+        t1.join();
+        a->flush();
+
+        shouldEqualSequence(a->begin(), a->end(), ref.begin());
+
+        PlainArray out(s);
+        a->checkoutSubarray(Shape3(), out);
+        should(out == ref);
+    }
+
     // void testIsUnstrided()
     // {
         // typedef difference3_type Shape;
@@ -1512,6 +1553,295 @@ public:
     }
 };
 
+struct ChunkedArrayPyramidTest
+{
+    typedef MultiArray<3, float> PlainArray;
+
+    Shape3 shape;
+    PlainArray data;
+
+    ChunkedArrayPyramidTest()
+    : shape(37, 20, 9),
+      data(shape)
+    {
+        RandomMT19937 random(42);
+        for(PlainArray::iterator i = data.begin(); i != data.end(); ++i)
+            *i = random.uniform(0.0, 100.0);
+    }
+
+    static Shape3 clamped(Shape3 p, Shape3 const & shape)
+    {
+        return min(p, shape - Shape3(1));
+    }
+
+    void testMean()
+    {
+        ChunkedArrayLazy<3, float> base(shape, Shape3(8));
+        base.commitSubarray(Shape3(), data);
+
+        ChunkedArrayPyramid<3, float> pyramid(base);
+        shouldEqual(pyramid.levels(), 7);
+        shouldEqual(&pyramid.level(0), (ChunkedArray<3, float> *)&base);
+        shouldEqual(pyramid.shape(1), Shape3(19, 10, 5));
+        shouldEqual(pyramid.shape(6), Shape3(1));
+        should(pyramid.level(1).isReadOnly());
+
+        PlainArray fine(data);
+        for(int k=1; k<4; ++k)
+        {
+            PlainArray coarse(pyramid.shape(k));
+            for(MultiCoordinateIterator<3> i(coarse.shape()), end(i.getEndIterator()); i != end; ++i)
+            {
+                double sum = 0.0;
+                for(int o=0; o<8; ++o)
+                    sum += fine[clamped(Shape3(2)*(*i) + Shape3(o&1, (o>>1)&1, (o>>2)&1), fine.shape())];
+                coarse[*i] = sum / 8.0;
+            }
+
+            PlainArray level(pyramid.shape(k));
+            pyramid.level(k).checkoutSubarray(Shape3(), level);
+            shouldEqualSequenceTolerance(level.begin(), level.end(), coarse.begin(), 1e-4f);
+            fine.swap(coarse);
+        }
+
+        // only the chunks needed for a request are computed: the first chunk of
+        // level 2 has shape (8, 5, 3) and covers 2x2x1 chunks of level 1
+        ChunkedArrayPyramid<3, float> lazy(base, 3);
+        lazy.level(2).getItem(Shape3(0));
+        shouldEqual(lazy.level(1).dataBytes(), (2*8*8*5 + 2*8*2*5)*sizeof(float));
+    }
+
+    void testGaussian()
+    {
+        ChunkedArrayCompressed<3, float> base(shape, Shape3(8));
+        base.commitSubarray(Shape3(), data);
+        ChunkedArrayPyramid<3, float> pyramid(base, 3, PyramidGaussian);
+
+        Kernel1D<double> burt;
+        burt.initExplicitly(-2, 2) = 0.05, 0.25, 0.4, 0.25, 0.05;
+        burt.setBorderTreatment(BORDER_TREATMENT_REFLECT);
+
+        PlainArray fine(data);
+        for(int k=1; k<3; ++k)
+        {
+            PlainArray smooth(fine.shape()), coarse(pyramid.shape(k));
+            separableConvolveMultiArray(fine, smooth, burt);
+            for(MultiCoordinateIterator<3> i(coarse.shape()), end(i.getEndIterator()); i != end; ++i)
+                coarse[*i] = smooth[Shape3(2)*(*i)];
+
+            PlainArray level(pyramid.shape(k));
+            pyramid.level(k).checkoutSubarray(Shape3(), level);
+            shouldEqualSequenceTolerance(level.begin(), level.end(), coarse.begin(), 1e-3f);
+            fine.swap(coarse);
+        }
+    }
+
+    // reduce all axes by the Burt kernel with reflection at the borders,
+    // repeated until the index is inside the axis
+    static PlainArray gaussianReference(PlainArray const & fine)
+    {
+        static const double burt[5] = { 0.05, 0.25, 0.4, 0.25, 0.05 };
+        PlainArray coarse((fine.shape() + Shape3(1)) / Shape3(2));
+        for(MultiCoordinateIterator<3> i(coarse.shape()), end(i.getEndIterator()); i != end; ++i)
+        {
+            double sum = 0.0;
+            for(int o=0; o<125; ++o)
+            {
+                Shape3 p;
+                double weight = 1.0;
+                for(int d=0, oo=o; d<3; ++d, oo /= 5)
+                {
+                    MultiArrayIndex size = fine.shape(d),
+                                    x = std::abs(2*(*i)[d] + oo%5 - 2);
+                    if(size == 1)
+                        x = 0;
+                    else
+                    {
+                        x %= 2*(size-1);
+                        if(x >= size)
+                            x = 2*(size-1) - x;
+                    }
+                    p[d] = x;
+                    weight *= burt[oo%5];
+                }
+                sum += weight*fine[p];
+            }
+            coarse[*i] = sum;
+        }
+        return coarse;
+    }
+
+    void testGaussianSmallShapes()
+    {
+        // all levels down to shape 1, including thin axes of size 1 and 2
+        Shape3 shapes[] = { Shape3(8, 8, 2), Shape3(37, 3, 1) };
+        for(int s=0; s<2; ++s)
+        {
+            PlainArray fine(shapes[s]);
+            for(int k=0; k<fine.size(); ++k)
+                fine[k] = (float)((k*37) % 101);
+
+            ChunkedArrayCompressed<3, float> base(shapes[s], Shape3(4));
+            base.commitSubarray(Shape3(), fine);
+            ChunkedArrayPyramid<3, float> pyramid(base, -1, PyramidGaussian);
+            shouldEqual(pyramid.shape(pyramid.levels()-1), Shape3(1));
+
+            for(int k=1; k<pyramid.levels(); ++k)
+            {
+                PlainArray coarse = gaussianReference(fine);
+                shouldEqual(pyramid.shape(k), coarse.shape());
+
+                PlainArray level(pyramid.shape(k));
+                pyramid.level(k).checkoutSubarray(Shape3(), level);
+                shouldEqualSequenceTolerance(level.begin(), level.end(), coarse.begin(), 1e-3f);
+                fine.swap(coarse);
+            }
+        }
+    }
+
+    void testMode()
+    {
+        typedef MultiArray<3, UInt32> Labels;
+        Labels labels(shape), expected((shape + Shape3(1)) / Shape3(2));
+        for(MultiCoordinateIterator<3> i(shape), end(i.getEndIterator()); i != end; ++i)
+        {
+            Shape3 block = *i / Shape3(2);
+            labels[*i] = (block[0] + 100*block[1] + 10000*block[2]) % 7;
+            if(*i == Shape3(2)*block) // one outlier per block
+                labels[*i] = 99;
+            expected[block] = labels[*i] == 99 ? expected[block] : labels[*i];
+        }
+
+        ChunkedArrayCompressed<3, UInt32> base(shape, Shape3(8));
+        base.commitSubarray(Shape3(), labels);
+        ChunkedArrayPyramid<3, UInt32> pyramid(base, 2, PyramidMode);
+        Labels level(pyramid.shape(1));
+        pyramid.level(1).checkoutSubarray(Shape3(), level);
+        should(level == expected);
+    }
+
+    void testStoreLevel()
+    {
+        ChunkedArrayLazy<3, float> base(shape, Shape3(8));
+        base.commitSubarray(Shape3(), data);
+        ChunkedArrayPyramid<3, float> pyramid(base, 3);
+        PlainArray level2(pyramid.shape(2));
+        pyramid.level(2).checkoutSubarray(Shape3(), level2);
+
+        ChunkedArrayCompressed<3, float> stored(pyramid.shape(1), Shape3(8));
+        pyramid.storeLevel(1, stored);
+        shouldEqual(&pyramid.level(1), (ChunkedArray<3, float> *)&stored);
+
+        // a fresh pyramid computes level 2 from the stored level 1
+        ChunkedArrayPyramid<3, float> reopened(base, 3);
+        reopened.attachLevel(1, stored);
+        PlainArray level(pyramid.shape(2));
+        reopened.level(2).checkoutSubarray(Shape3(), level);
+        shouldEqualSequence(level.begin(), level.end(), level2.begin());
+        shouldEqual(&reopened.level(1), (ChunkedArray<3, float> *)&stored);
+
+        try
+        {
+            ChunkedArrayCompressed<3, float> wrong(pyramid.shape(2));
+            reopened.attachLevel(1, wrong);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+    }
+};
+
+#ifdef HasHDF5
+struct ChunkedArrayHDF5ModeTest
+{
+    typedef ChunkedArrayHDF5<3, float> Array;
+    typedef MultiArray<3, float> PlainArray;
+
+    Shape3 shape;
+    PlainArray ref;
+
+    ChunkedArrayHDF5ModeTest()
+    : shape(50, 40, 30),
+      ref(shape)
+    {
+        linearSequence(ref.begin(), ref.end());
+        HDF5File file("chunked_modes.h5", HDF5File::New);
+        Array a(file, "data", HDF5File::New, shape, Shape3(16));
+        a.commitSubarray(Shape3(), ref);
+    }
+
+    void testReadOnlyShared()
+    {
+        HDF5File file("chunked_modes.h5", HDF5File::ReadOnlyShared);
+        should(file.isReadOnly());
+
+        // several readers of the same file
+        Array a(file, "data", HDF5File::ReadOnlyShared);
+        Array b(HDF5File("chunked_modes.h5", HDF5File::ReadOnlyShared), "data");
+        should(a.isReadOnly());
+        should(!a.isCopyOnWrite());
+        shouldEqual(a.shape(), shape);
+        a.setCacheMaxSize(2);
+        shouldEqualSequence(a.cbegin(), a.cend(), ref.begin());
+
+        PlainArray out(shape);
+        b.checkoutSubarray(Shape3(), out);
+        should(out == ref);
+
+        try
+        {
+            a.commitSubarray(Shape3(), ref);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+    }
+
+    void testCopyOnWrite()
+    {
+        {
+            HDF5File file("chunked_modes.h5", HDF5File::ReadOnly);
+            Array a(file, "data", HDF5File::CopyOnWrite, shape, Shape3(16));
+            should(!a.isReadOnly());
+            should(a.isCopyOnWrite());
+            a.setCacheMaxSize(2);
+
+            // modify the center of the array and force eviction of all chunks
+            Shape3 start(10, 10, 10), stop(35, 30, 25);
+            PlainArray modified(ref);
+            modified.subarray(start, stop) = -1.0f;
+            a.commitSubarray(start, modified.subarray(start, stop));
+            shouldEqualSequence(a.cbegin(), a.cend(), modified.begin());
+
+            // only modified chunks are kept
+            std::size_t scratch = 0;
+            for(Array::ChunkStorage::iterator h = a.handle_array_.begin(); h != a.handle_array_.end(); ++h)
+                if(h->pointer_ && static_cast<Array::Chunk *>(h->pointer_)->scratch_.size() > 0)
+                    ++scratch;
+            shouldEqual(scratch, 12u);
+
+            a.flushToDisk();
+            PlainArray out(shape);
+            a.checkoutSubarray(Shape3(), out);
+            should(out == modified);
+        }
+
+        // the file is unchanged
+        HDF5File file("chunked_modes.h5", HDF5File::ReadOnly);
+        Array a(file, "data");
+        PlainArray out(shape);
+        a.checkoutSubarray(Shape3(), out);
+        should(out == ref);
+
+        try
+        {
+            HDF5File file("chunked_modes.h5", HDF5File::ReadOnly);
+            Array b(file, "missing", HDF5File::CopyOnWrite);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &) {}
+    }
+};
+#endif
+
 struct ChunkedMultiArrayTestSuite
 : public vigra::test_suite
 {
@@ -1527,6 +1857,7 @@ struct ChunkedMultiArrayTestSuite
         add( testCase( &ChunkedMultiArrayTest<Array>::test_iterator ) );
         add( testCase( &ChunkedMultiArrayTest<Array>::testChunkIterator ) );
         add( testCase( &ChunkedMultiArrayTest<Array>::testMultiThreaded ) );
+        add( testCase( &ChunkedMultiArrayTest<Array>::testWriteBehind ) );
     }
 
     template <class T>
@@ -1576,6 +1907,15 @@ struct ChunkedMultiArrayTestSuite
 #ifdef HasHDF5
         testImpl<ChunkedArrayHDF5<3, TinyVector<float, 3> > >();
 #endif
+        add( testCase( &ChunkedArrayPyramidTest::testMean ) );
+        add( testCase( &ChunkedArrayPyramidTest::testGaussian ) );
+        add( testCase( &ChunkedArrayPyramidTest::testGaussianSmallShapes ) );
+        add( testCase( &ChunkedArrayPyramidTest::testMode ) );
+        add( testCase( &ChunkedArrayPyramidTest::testStoreLevel ) );
+#ifdef HasHDF5
+        add( testCase( &ChunkedArrayHDF5ModeTest::testReadOnlyShared ) );
+        add( testCase( &ChunkedArrayHDF5ModeTest::testCopyOnWrite ) );
+#endif
 
         testSpeedImpl<unsigned char>();
         testSpeedImpl<float>();
@@ -46,6 +46,7 @@
 #include <vigra/vector_distance.hxx>
 #include <vigra/skeleton.hxx>
 #include <vigra/timing.hxx>
+#include <vigra/multi_blockwise.hxx>
 
 
 #include "test_data.hxx"
@@ -362,6 +363,50 @@ struct MultiDistanceTest
         separableMultiDistance(img2, res, true);
         shouldEqualSequence(res.begin(), res.end(), desired);
     }
+
+    void testDistanceParallel()
+    {
+        typedef MultiArrayShape<3>::type Shape;
+        MultiArrayView<3, double> vol(Shape(12,10,35), volume_data);
+        TinyVector<double, 3> pixelPitch(1.2, 1.0, 2.4);
+
+        MultiArray<3, double> res(vol.shape()), ref(vol.shape());
+        MultiArray<3, int> ires(vol.shape()), iref(vol.shape());
+        DoubleVecVolume vecRes(vol.shape()), vecRef(vol.shape());
+
+        for(int threads = 0; threads <= 4; ++threads)
+        {
+            ParallelOptions options = ParallelOptions().numThreads(threads);
+
+            separableMultiDistSquared(vol, res, false, options);
+            shouldEqualSequence(res.data(), res.data()+res.elementCount(), ref_dist2);
+
+            separableMultiDistSquared(vol, iref, true);
+            separableMultiDistSquared(vol, ires, true, options);
+            shouldEqualSequence(ires.begin(), ires.end(), iref.begin());
+
+            separableMultiDistSquared(vol, ref, true, pixelPitch);
+            separableMultiDistSquared(vol, res, true, pixelPitch, options);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            separableMultiDistance(vol, ref, false);
+            separableMultiDistance(vol.transpose(), res.transpose(), false, options);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            separableVectorDistance(vol, vecRef, true, pixelPitch);
+            separableVectorDistance(vol, vecRes, true, pixelPitch, options);
+            shouldEqualSequence(vecRes.begin(), vecRes.end(), vecRef.begin());
+        }
+
+        // BlockwiseOptions are also accepted
+        separableMultiDistance(vol, ref, true);
+        separableMultiDistance(vol, res, true, BlockwiseOptions().numThreads(2));
+        shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+        separableVectorDistance(vol, vecRef, false);
+        separableVectorDistance(vol, vecRes, false, BlockwiseOptions().numThreads(2));
+        shouldEqualSequence(vecRes.begin(), vecRes.end(), vecRef.begin());
+    }
 };
 
 struct BoundaryMultiDistanceTest
@@ -863,6 +908,7 @@ struct DistanceTransformTestSuite
         add( testCase( &MultiDistanceTest::testDistanceVolumesAnisotropic));
         add( testCase( &MultiDistanceTest::distanceTransform2DCompare));
         add( testCase( &MultiDistanceTest::distanceTest1D));
+        add( testCase( &MultiDistanceTest::testDistanceParallel));
         add( testCase( &BoundaryMultiDistanceTest::distanceTest1D));
         add( testCase( &BoundaryMultiDistanceTest::testDistanceVolumes));
         add( testCase( &BoundaryMultiDistanceTest::vectorDistanceTest1D));
@@ -39,6 +39,7 @@
 #include "vigra/multi_morphology.hxx"
 #include "vigra/linear_algebra.hxx"
 #include "vigra/matrix.hxx"
+#include "vigra/random.hxx"
 
 using namespace vigra;
 
@@ -329,6 +330,193 @@ struct MultiMorphologyTest
     IntVolume vol;
 };
 
+struct FlatMorphologyTest
+{
+    // brute-force min/max over the union of (clipped) lines, applied one after the other
+    template <unsigned int N, class T>
+    static void
+    referenceLine(MultiArrayView<N, T> src, MultiArrayView<N, T> dest,
+                  typename MultiArrayShape<N>::type step, MultiArrayIndex length,
+                  bool dilation, bool reflect)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+        MultiArray<N, T> tmp(src);
+        MultiArrayIndex before = reflect ? length - 1 - length / 2 : length / 2;
+        MultiCoordinateIterator<N> p(src.shape()), end = p.getEndIterator();
+        for(; p != end; ++p)
+        {
+            T res = tmp[*p];
+            for(MultiArrayIndex k = -before; k < length - before; ++k)
+            {
+                Shape q = *p + k*step;
+                if(!tmp.isInside(q))
+                    continue;
+                if(dilation ? tmp[q] > res : tmp[q] < res)
+                    res = tmp[q];
+            }
+            dest[*p] = res;
+        }
+    }
+
+    template <unsigned int N, class T>
+    static void
+    referenceBox(MultiArrayView<N, T> src, MultiArrayView<N, T> dest,
+                 typename MultiArrayShape<N>::type windowShape,
+                 bool dilation, bool reflect)
+    {
+        dest = src;
+        for(unsigned int k=0; k<N; ++k)
+            referenceLine(MultiArrayView<N, T>(dest), dest,
+                          MultiArrayShape<N>::type::unitVector(k), windowShape[k], dilation, reflect);
+    }
+
+    template <unsigned int N, class T>
+    void testBox(typename MultiArrayShape<N>::type shape, int maxValue)
+    {
+        typedef typename MultiArrayShape<N>::type Shape;
+        RandomNumberGenerator<> random(42);
+        MultiArray<N, T> src(shape), res(shape), ref(shape), tmp(shape);
+        for(int k=0; k<src.size(); ++k)
+            src[k] = (T)random.uniformInt(maxValue);
+
+        Shape windows[] = { Shape(1), Shape(2), Shape(3), Shape(6), shape + Shape(3) };
+        for(int w=0; w<5; ++w)
+        {
+            Shape window = windows[w];
+            window[0] = std::max<MultiArrayIndex>(1, window[0] - 1);
+
+            multiBoxErosion(src, res, window);
+            referenceBox<N>(src, ref, window, false, false);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBoxDilation(src, res, window);
+            referenceBox<N>(src, ref, window, true, false);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBoxOpening(src, res, window);
+            referenceBox<N>(src, tmp, window, false, false);
+            referenceBox<N>(tmp, ref, window, true, true);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            // opening is anti-extensive and idempotent
+            for(int k=0; k<src.size(); ++k)
+                should(res[k] <= src[k]);
+            multiBoxOpening(res, tmp, window);
+            shouldEqualSequence(res.begin(), res.end(), tmp.begin());
+
+            multiBoxClosing(src, res, window);
+            referenceBox<N>(src, tmp, window, true, false);
+            referenceBox<N>(tmp, ref, window, false, true);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiBoxOpening(src, tmp, window);
+            multiBoxWhiteTopHat(src, res, window);
+            for(int k=0; k<src.size(); ++k)
+                shouldEqual(res[k], src[k] - tmp[k]);
+
+            multiBoxClosing(src, tmp, window);
+            multiBoxBlackTopHat(src, res, window);
+            for(int k=0; k<src.size(); ++k)
+                shouldEqual(res[k], tmp[k] - src[k]);
+
+            // in-place operation
+            res = src;
+            multiBoxErosion(res, res, window);
+            referenceBox<N>(src, ref, window, false, false);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            res = src;
+            multiBoxWhiteTopHat(res, res, window);
+            multiBoxWhiteTopHat(src, ref, window);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+        }
+    }
+
+    template <unsigned int N, class T>
+    void testLine(typename MultiArrayShape<N>::type shape,
+                  typename MultiArrayShape<N>::type step, int maxValue)
+    {
+        RandomNumberGenerator<> random(42);
+        MultiArray<N, T> src(shape), res(shape), ref(shape), tmp(shape);
+        for(int k=0; k<src.size(); ++k)
+            src[k] = (T)random.uniformInt(maxValue);
+
+        for(MultiArrayIndex length = 1; length < 10; length += 2)
+        {
+            multiLineErosion(src, res, step, length);
+            referenceLine<N>(src, ref, step, length, false, false);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiLineDilation(src, res, step, length+1);
+            referenceLine<N>(src, ref, step, length+1, true, false);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiLineOpening(src, res, step, length+1);
+            referenceLine<N>(src, tmp, step, length+1, false, false);
+            referenceLine<N>(tmp, ref, step, length+1, true, true);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiLineClosing(src, res, step, length);
+            referenceLine<N>(src, tmp, step, length, true, false);
+            referenceLine<N>(tmp, ref, step, length, false, true);
+            shouldEqualSequence(res.begin(), res.end(), ref.begin());
+
+            multiLineOpening(src, tmp, step, length);
+            multiLineWhiteTopHat(src, res, step, length);
+            for(int k=0; k<src.size(); ++k)
+                shouldEqual(res[k], src[k] - tmp[k]);
+
+            multiLineClosing(src, tmp, step, length);
+            multiLineBlackTopHat(src, res, step, length);
+            for(int k=0; k<src.size(); ++k)
+                shouldEqual(res[k], tmp[k] - src[k]);
+        }
+    }
+
+    void testBox2D()
+    {
+        testBox<2, UInt8>(Shape2(23, 17), 256);
+        testBox<2, int>(Shape2(1, 17), 1000);
+        testBox<2, float>(Shape2(30, 11), 1000);
+    }
+
+    void testBox3D()
+    {
+        testBox<3, UInt8>(Shape3(13, 9, 7), 256);
+        testBox<3, double>(Shape3(10, 12, 5), 1000);
+    }
+
+    void testLine2D()
+    {
+        testLine<2, UInt8>(Shape2(23, 17), Shape2(1, 0), 256);
+        testLine<2, UInt8>(Shape2(23, 17), Shape2(1, 1), 256);
+        testLine<2, float>(Shape2(23, 17), Shape2(1, -1), 1000);
+        testLine<2, int>(Shape2(23, 17), Shape2(-2, 1), 1000);
+    }
+
+    void testLine3D()
+    {
+        testLine<3, UInt16>(Shape3(13, 9, 7), Shape3(0, 0, 1), 65536);
+        testLine<3, float>(Shape3(13, 9, 7), Shape3(1, -1, 1), 1000);
+    }
+
+    void testStrided()
+    {
+        MultiArray<2, int> src(Shape2(20, 15)), res(Shape2(15, 20)), ref(Shape2(20, 15));
+        RandomNumberGenerator<> random(42);
+        for(int k=0; k<src.size(); ++k)
+            src[k] = random.uniformInt(100);
+
+        multiBoxErosion(src, res.transpose(), Shape2(5, 3));
+        multiBoxErosion(src, ref, Shape2(5, 3));
+        shouldEqualSequence(ref.begin(), ref.end(), res.transpose().begin());
+
+        multiLineDilation(src.transpose(), res, Shape2(1, 1), 4);
+        multiLineDilation(src, ref, Shape2(1, 1), 4);
+        shouldEqualSequence(ref.begin(), ref.end(), res.transpose().begin());
+    }
+};
+
         
 struct MorphologyTestSuite
 : public vigra::test_suite
@@ -344,6 +532,11 @@ struct MorphologyTestSuite
         add( testCase( &MultiMorphologyTest::grayDilationTest2D));
         add( testCase( &MultiMorphologyTest::grayErosionAndDilationTest2D));
         add( testCase( &MultiMorphologyTest::grayClosingTest2D));
+        add( testCase( &FlatMorphologyTest::testBox2D));
+        add( testCase( &FlatMorphologyTest::testBox3D));
+        add( testCase( &FlatMorphologyTest::testLine2D));
+        add( testCase( &FlatMorphologyTest::testLine3D));
+        add( testCase( &FlatMorphologyTest::testStrided));
     }
 };
 
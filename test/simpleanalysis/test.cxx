@@ -1667,6 +1667,27 @@ struct WatershedsTest
         should(5 == watershedsMultiArray(img, res2, IndirectNeighborhood, WatershedOptions().regionGrowing().seedOptions(SeedOptions().extendedMinima())));
         should(res == res2);
 
+        // floating-point data quantized into a bucket queue
+        res2.init(0);
+        generateWatershedSeeds(img, res2, IndirectNeighborhood, SeedOptions().extendedMinima());
+        should(5 == watershedsMultiArray(img, res2, IndirectNeighborhood, WatershedOptions().turboAlgorithm()));
+        should(res == res2);
+
+        // 32-bit integer data use a radix heap
+        MultiArray<2, Int32> iimg(img.width(), img.height());
+        for(int k=0; k<iimg.size(); ++k)
+            iimg[k] = (Int32)roundi(img.begin()[k]);
+        res2.init(0);
+        generateWatershedSeeds(iimg, res2, IndirectNeighborhood, SeedOptions().extendedMinima());
+        should(5 == watershedsMultiArray(iimg, res2, IndirectNeighborhood, WatershedOptions().regionGrowing()));
+        should(res == res2);
+
+        // ... even when quantization was requested (it would merge the levels here)
+        res2.init(0);
+        generateWatershedSeeds(iimg, res2, IndirectNeighborhood, SeedOptions().extendedMinima());
+        should(5 == watershedsMultiArray(iimg, res2, IndirectNeighborhood, WatershedOptions().turboAlgorithm(2)));
+        should(res == res2);
+
 #if 0
         std::cerr << count << "\n";
         for(int y=0;y<9;++y)
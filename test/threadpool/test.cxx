@@ -231,6 +231,27 @@ struct ThreadPoolTests
         size_t const sum = std::accumulate(results.begin(), results.end(), 0);
         shouldEqual(sum, n);
     }
+
+    void test_parallel_sort()
+    {
+        size_t const n = 100003;
+        std::vector<int> input(n);
+        for(size_t i=0; i<n; ++i)
+            input[i] = int((i * 7919) % 1009) - 500;
+        std::vector<int> expected(input);
+        std::sort(expected.begin(), expected.end());
+
+        for(int n_threads = 0; n_threads <= 5; ++n_threads)
+        {
+            std::vector<int> data(input);
+            parallel_sort(n_threads, data.begin(), data.end());
+            shouldEqualSequence(data.begin(), data.end(), expected.begin());
+        }
+
+        std::vector<int> data(input);
+        parallel_sort(3, data.begin(), data.end(), std::greater<int>());
+        shouldEqualSequence(data.begin(), data.end(), expected.rbegin());
+    }
 };
 
 struct ThreadPoolTestSuite : public test_suite
@@ -249,6 +270,7 @@ struct ThreadPoolTestSuite : public test_suite
         add(testCase(&ThreadPoolTests::test_parallel_foreach_sum));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_sum_auto));
         add(testCase(&ThreadPoolTests::test_parallel_foreach_timing));
+        add(testCase(&ThreadPoolTests::test_parallel_sort));
 #endif
     }
 };
@@ -403,6 +403,94 @@ struct BucketQueueTest
         shouldEqual(0u, bqueue.size());
         shouldEqual(true, bqueue.empty());
     }
+
+    void testRadixHeap()
+    {
+        // monotone usage: interleave pushes and pops like in Dijkstra's algorithm
+        std::priority_queue<int, std::vector<int>, std::greater<int> > queue;
+        RadixHeap<int, int> rqueue;
+
+        for(unsigned int k=0; k<idata.size(); ++k)
+        {
+            queue.push(idata[k] - 5);
+            rqueue.push(idata[k] - 5, idata[k] - 5);
+        }
+        shouldEqual(idata.size(), rqueue.size());
+
+        int count = 0;
+        while(!queue.empty())
+        {
+            shouldEqual(queue.top(), rqueue.top());
+            shouldEqual(queue.top(), rqueue.topPriority());
+            int top = queue.top();
+            queue.pop();
+            rqueue.pop();
+            if(count++ < 20)
+            {
+                // push elements not smaller than the current top
+                queue.push(top + count % 7);
+                rqueue.push(top + count % 7, top + count % 7);
+            }
+        }
+        shouldEqual(0u, rqueue.size());
+        shouldEqual(true, rqueue.empty());
+
+        // floating-point priorities, including negative numbers
+        std::priority_queue<double, std::vector<double>, std::greater<double> > fqueue;
+        RadixHeap<double, float> frqueue;
+        for(unsigned int k=0; k<data.size(); ++k)
+        {
+            fqueue.push((float)(data[k] - 4.0));
+            frqueue.push((float)(data[k] - 4.0), (float)(data[k] - 4.0));
+        }
+        for(unsigned int k=0; k<data.size(); ++k)
+        {
+            shouldEqual(fqueue.top(), frqueue.top());
+            fqueue.pop();
+            frqueue.pop();
+        }
+        should(frqueue.empty());
+
+        // negative zero has the same priority as positive zero
+        RadixHeap<double, float> zqueue;
+        zqueue.push(1.0, 0.0f);
+        zqueue.pop();
+        zqueue.push(2.0, -0.0f);
+        shouldEqual(zqueue.top(), 2.0);
+        zqueue.pop();
+        should(zqueue.empty());
+
+        // long plateau: bucket 0 is refilled while being consumed,
+        // elements must still come out in insertion order
+        RadixHeap<int, int> plateau;
+        for(int k=0; k<10; ++k)
+            plateau.push(k, 5);
+        for(int k=0; k<100000; ++k)
+        {
+            shouldEqual(plateau.top(), k);
+            shouldEqual(plateau.topPriority(), 5);
+            plateau.pop();
+            plateau.push(k+10, 5);
+        }
+        shouldEqual(plateau.size(), 10u);
+        for(int k=100000; k<100010; ++k)
+        {
+            shouldEqual(plateau.top(), k);
+            plateau.pop();
+        }
+        should(plateau.empty());
+
+        // non-monotone insertion is detected
+        rqueue.push(100, 100);
+        rqueue.pop();
+        try
+        {
+            rqueue.push(3, 3);
+            failTest("no exception thrown");
+        }
+        catch(PreconditionViolation &)
+        {}
+    }
 };
 
 
@@ -1224,6 +1312,7 @@ struct CompressionTest
     {
         ArrayVector<char> compressed;
     #ifdef HasZLIB
+        should(compressionAvailable(ZLIB));
         compress(data.begin(), data.size(), compressed, ZLIB);
 
         shouldEqual(compressed.size(), 4206);
@@ -1235,6 +1324,7 @@ struct CompressionTest
 
         shouldEqualSequence(data.begin(), data.end(), decompressed.begin());
     #else
+        should(!compressionAvailable(ZLIB));
         try
         {
             compress(data.begin(), data.size(), compressed, ZLIB);
@@ -1253,6 +1343,7 @@ struct CompressionTest
     void testLZ4()
     {
         ArrayVector<char> compressed;
+        should(compressionAvailable(LZ4));
         compress(data.begin(), data.size(), compressed, LZ4);
 
         shouldEqual(compressed.size(), 4187);
@@ -1534,6 +1625,7 @@ struct UtilitiesTestSuite
         add( testCase( &BucketQueueTest::testAscending));
         add( testCase( &BucketQueueTest::testDescendingMapped));
         add( testCase( &BucketQueueTest::testAscendingMapped));
+        add( testCase( &BucketQueueTest::testRadixHeap));
         add( testCase( &ChangeablePriorityQueueTest::testMinQueue));
         add( testCase( &ChangeablePriorityQueueTest::testMaxQueue));
         add( testCase( &SizedIntTest::testSizedInt));